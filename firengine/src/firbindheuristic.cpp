@@ -0,0 +1,10 @@
+
+#include "firbindheuristic.h"
+
+
+FirBindHeuristic::FirBindHeuristic() :
+	m_Name				(),
+	m_vFirOrder			(),
+	m_IsBestFit			(false)
+{
+}
@@ -0,0 +1,30 @@
+#ifndef FIRBINDHEURISTIC_H
+#define FIRBINDHEURISTIC_H
+
+
+#include <string>
+#include <vector>
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// One of the heuristics run by the portfolio binder
+///   FIRs are bound one at a time in the given order, either
+///   first-fit (lowest MAC and TimeSlice origin that can bind)
+///   or best-fit (leaving the fewest free Coefficient-slots)
+/////////////////////////////////////////////////////////////
+
+class FirBindHeuristic
+{
+public:
+	FirBindHeuristic();
+public:
+	/// Name shown in the report
+	string				m_Name;
+	/// FIR indices in the order in which they are bound
+	vector<unsigned>	m_vFirOrder;
+	bool				m_IsBestFit;
+};
+
+
+#endif
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include "firbinding.h"
 
 
@@ -6,6 +7,35 @@ FirBinding::FirBinding() :
 	m_FirIndex				(0),
 	m_FirstFirMacIndex		(0),
 	m_TimeSliceOrigin		(0),
-	m_TimeSliceInterval		(1)
+	m_TimeSliceInterval		(1),
+	m_Decimation			(1),
+	m_vFirMacSection		()
 {
 }
+
+bool FirBinding::isFirstEngine(unsigned sectionIdx) const
+{
+	const FirMacSection& firMacSection = m_vFirMacSection[sectionIdx];
+	return (sectionIdx == 0) || firMacSection.m_IsChainStart || firMacSection.m_IsCrossTerm;
+}
+
+bool FirBinding::isLastEngine(unsigned sectionIdx) const
+{
+	return ((sectionIdx + 1) == getNumFirMacs()) || m_vFirMacSection[sectionIdx + 1].m_IsChainStart;
+}
+
+unsigned FirBinding::getNumCommitDelays() const
+{
+	// (the chains of a complex FIR each start again, with no delay)
+	unsigned maxNumCommitDelays = 0;
+	unsigned numCommitDelays = 0;
+	for (unsigned i = 0; i < getNumFirMacs(); ++i)
+	{
+		if (m_vFirMacSection[i].m_IsChainStart)
+			numCommitDelays = 0;
+		if (m_vFirMacSection[i].m_IsCommitDelayed)
+			++numCommitDelays;
+		maxNumCommitDelays = max(maxNumCommitDelays, numCommitDelays);
+	}
+	return maxNumCommitDelays;
+}
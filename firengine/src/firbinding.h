@@ -2,18 +2,37 @@
 #define FIRBINDING_H
 
 
+#include <vector>
+#include "firmacsection.h"
+using namespace std;
+
+
 class FirBinding
 {
 public:
 	FirBinding();
+public:
+	unsigned getNumFirMacs() const				{ return m_vFirMacSection.size(); }
+	unsigned getOutputTimeSliceInterval() const	{ return m_TimeSliceInterval * m_Decimation; }
+	/// Does the n'th section take its data from the FIR Input (the first of a chain, or one adding cross terms)
+	bool isFirstEngine(unsigned sectionIdx) const;
+	/// Does the n'th section drive the FIR Output (the last of a chain)
+	bool isLastEngine(unsigned sectionIdx) const;
+	/// Number of Updates by which the end of the longest chain commits later than its start (see FirMacSection::m_IsCommitDelayed)
+	unsigned getNumCommitDelays() const;
 public:
 	/// Index of FIR to bind
 	unsigned		m_FirIndex;
 	/// Index of First FirMac to use
 	unsigned		m_FirstFirMacIndex;
-	/// Updates will occur at TimeSliceOrigin + (n * TimeSliceInterval)
+	/// Outputs (and the taps computing them) will occur at TimeSliceOrigin + (n * OutputTimeSliceInterval)
+	///   Updates will occur every TimeSliceInterval, in step with the Outputs
 	unsigned		m_TimeSliceOrigin;
 	unsigned		m_TimeSliceInterval;
+	/// Number of Updates per Output (a decimating FIR advances its Fifo Decimation times per Output)
+	unsigned		m_Decimation;
+	/// One section per FirMac, bound to FirMacs FirstFirMacIndex, FirstFirMacIndex+1, ...
+	vector<FirMacSection>	m_vFirMacSection;
 };
 
 
@@ -0,0 +1,246 @@
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include "fircoeffquantizer.h"
+
+
+// (defined here as well, as std::min and std::max take it by reference)
+const int FirCoeffQuantizer::s_MaxCoeffCode;
+
+static const double s_Pi = 3.14159265358979323846;
+static const double s_PassbandWeight = 0.1;
+
+// Round half away from zero (so that negated Coefficients get negated words)
+static int _roundToNearest(double value)
+{
+	return (value < 0.0) ? -int(floor(-value + 0.5)) : int(floor(value + 0.5));
+}
+
+FirCoeffQuantizer::FirCoeffQuantizer(const vector<double>& vCoeff, double zeroThreshold, int coeffScale, FirSpec::Symmetry symmetry) :
+	m_vCoeff			(vCoeff),
+	m_ZeroThreshold		(zeroThreshold),
+	m_CoeffScale		(coeffScale),
+	m_Symmetry			(symmetry),
+	m_NumFreqSteps		(0),
+	m_vCos				(),
+	m_vSin				(),
+	m_vErrorRe			(),
+	m_vErrorIm			(),
+	m_vWeight			(),
+	m_PeakResponseError	(0.0),
+	m_vCoeffCode		()
+{
+}
+
+bool FirCoeffQuantizer::findCoeffScale(double maxAbsCoeff, double sumAbsCoeff, int* pCoeffScale)
+{
+	for (int coeffScale = 14; coeffScale >= -16; --coeffScale)
+	{
+		if ((_roundToNearest(ldexp(maxAbsCoeff, 17 + coeffScale)) <= s_MaxCoeffCode) && (ldexp(sumAbsCoeff, coeffScale) < 2.0))
+		{
+			*pCoeffScale = coeffScale;
+			return true;
+		}
+	}
+	return false;
+}
+
+double FirCoeffQuantizer::decodeCoeffCode(int coeffCode, int coeffScale)
+{
+	return ldexp(double(coeffCode), -(17 + coeffScale));
+}
+
+void FirCoeffQuantizer::establishFrequencyResponse(const vector<double>& vCoeff, unsigned numPoints, vector<double>* pvResponse)
+{
+	pvResponse->clear();
+	for (unsigned i = 0; i < numPoints; ++i)
+	{
+		double omega = (numPoints > 1) ? (s_Pi * double(i) / double(numPoints - 1)) : 0.0;
+		double re = 0.0;
+		double im = 0.0;
+		for (unsigned j = 0; j < vCoeff.size(); ++j)
+		{
+			re += vCoeff[j] * cos(omega * double(j));
+			im -= vCoeff[j] * sin(omega * double(j));
+		}
+		pvResponse->push_back(sqrt((re * re) + (im * im)));
+	}
+}
+
+double FirCoeffQuantizer::findSnr(const vector<double>& vCoeff, const vector<double>& vQuantizedCoeff)
+{
+	assert(vCoeff.size() == vQuantizedCoeff.size());
+	double signalEnergy = 0.0;
+	double noiseEnergy = 0.0;
+	for (unsigned i = 0; i < vCoeff.size(); ++i)
+	{
+		double error = vQuantizedCoeff[i] - vCoeff[i];
+		signalEnergy += vCoeff[i] * vCoeff[i];
+		noiseEnergy += error * error;
+	}
+	if (noiseEnergy == 0.0)
+		return 200.0;		// (exact)
+	return 10.0 * log10(signalEnergy / noiseEnergy);
+}
+
+double FirCoeffQuantizer::findStopbandAttenuation(const vector<double>& vIdealResponse, const vector<double>& vResponse)
+{
+	assert(vIdealResponse.size() == vResponse.size());
+	unsigned numPoints = vResponse.size();
+	double idealPeak = 0.0;
+	for (unsigned i = 0; i < numPoints; ++i)
+		idealPeak = max(idealPeak, vIdealResponse[i]);
+
+	// The stopband is where the ideal response is well below its peak, but its level is that of the ripples in it
+	//   (the edges of the stopband, falling through the transition band, are not ripples)
+	vector<bool> vIsStopband(numPoints, false);
+	for (unsigned i = 0; i < numPoints; ++i)
+		vIsStopband[i] = (vIdealResponse[i] <= (0.1 * idealPeak));
+
+	bool hasRipple = false;
+	double stopbandPeak = 0.0;
+	for (unsigned i = 0; i < numPoints; ++i) if (vIsStopband[i])
+	{
+		bool isRipple = true;
+		if (i > 0)
+			isRipple = isRipple && vIsStopband[i - 1] && (vResponse[i] >= vResponse[i - 1]);
+		if ((i + 1) < numPoints)
+			isRipple = isRipple && vIsStopband[i + 1] && (vResponse[i] >= vResponse[i + 1]);
+		if (isRipple)
+		{
+			hasRipple = true;
+			stopbandPeak = max(stopbandPeak, vResponse[i]);
+		}
+	}
+	if (!hasRipple || (idealPeak == 0.0))
+		return 0.0;
+	return 20.0 * log10(idealPeak / max(stopbandPeak, idealPeak * 1e-10));
+}
+
+void FirCoeffQuantizer::quantize()
+{
+	unsigned numCoeffs = m_vCoeff.size();
+	double lsb = decodeCoeffCode(1, m_CoeffScale);
+
+	// Start from the nearest words
+	m_vCoeffCode.assign(numCoeffs, 0);
+	for (unsigned i = 0; i < numCoeffs; ++i)
+	{
+		if (fabs(m_vCoeff[i]) > m_ZeroThreshold)
+			m_vCoeffCode[i] = max(-s_MaxCoeffCode, min(s_MaxCoeffCode, _roundToNearest(m_vCoeff[i] / lsb)));
+	}
+
+	// The response is compared at enough frequencies to resolve the ripples of a set of this length
+	m_NumFreqSteps = max(256u, min(4096u, 8 * numCoeffs));
+	m_vCos.resize(2 * m_NumFreqSteps);
+	m_vSin.resize(2 * m_NumFreqSteps);
+	for (unsigned i = 0; i < (2 * m_NumFreqSteps); ++i)
+	{
+		m_vCos[i] = cos(s_Pi * double(i) / double(m_NumFreqSteps));
+		m_vSin[i] = sin(s_Pi * double(i) / double(m_NumFreqSteps));
+	}
+
+	// Errors in the stopband matter most (elsewhere they are hidden by the response itself)
+	vector<double> vIdealRe(m_NumFreqSteps + 1, 0.0);
+	vector<double> vIdealIm(m_NumFreqSteps + 1, 0.0);
+	m_vErrorRe.assign(m_NumFreqSteps + 1, 0.0);
+	m_vErrorIm.assign(m_NumFreqSteps + 1, 0.0);
+	for (unsigned i = 0; i < numCoeffs; ++i)
+	{
+		double error = (double(m_vCoeffCode[i]) * lsb) - m_vCoeff[i];
+		for (unsigned f = 0; f <= m_NumFreqSteps; ++f)
+		{
+			unsigned phase = (i * f) % (2 * m_NumFreqSteps);
+			vIdealRe[f] += m_vCoeff[i] * m_vCos[phase];
+			vIdealIm[f] -= m_vCoeff[i] * m_vSin[phase];
+			m_vErrorRe[f] += error * m_vCos[phase];
+			m_vErrorIm[f] -= error * m_vSin[phase];
+		}
+	}
+	double idealPeak = 0.0;
+	for (unsigned f = 0; f <= m_NumFreqSteps; ++f)
+		idealPeak = max(idealPeak, sqrt((vIdealRe[f] * vIdealRe[f]) + (vIdealIm[f] * vIdealIm[f])));
+	m_vWeight.assign(m_NumFreqSteps + 1, 1.0);
+	for (unsigned f = 0; f <= m_NumFreqSteps; ++f)
+	{
+		if (sqrt((vIdealRe[f] * vIdealRe[f]) + (vIdealIm[f] * vIdealIm[f])) > (0.1 * idealPeak))
+			m_vWeight[f] = s_PassbandWeight;
+	}
+
+	m_PeakResponseError = 0.0;
+	for (unsigned f = 0; f <= m_NumFreqSteps; ++f)
+		m_PeakResponseError = max(m_PeakResponseError, m_vWeight[f] * sqrt((m_vErrorRe[f] * m_vErrorRe[f]) + (m_vErrorIm[f] * m_vErrorIm[f])));
+
+	// Change one word (and its mirror) at a time by a step, keeping the change if it lowers the peak error
+	//   (a lower peak error lowers the floor it puts under the stopband)
+	const unsigned maxNumPasses = 8;
+	int mirrorSign = (m_Symmetry == FirSpec::Symmetry_AntiSymmetric) ? -1 : 1;
+	for (unsigned pass = 0; pass < maxNumPasses; ++pass)
+	{
+		bool isImproved = false;
+		for (unsigned i = 0; i < numCoeffs; ++i)
+		{
+			unsigned mirroredCoeffIdx = (m_Symmetry == FirSpec::Symmetry_None) ? i : (numCoeffs - 1 - i);
+			if (mirroredCoeffIdx < i)
+				continue;		// (changed with its mirror)
+			if (fabs(m_vCoeff[i]) <= m_ZeroThreshold)
+				continue;		// zero taps stay zero
+			if ((mirroredCoeffIdx == i) && (mirrorSign < 0))
+				continue;		// the middle tap of an antisymmetric set is zero
+
+			for (int delta = -1; delta <= 1; delta += 2)
+			{
+				if (abs(m_vCoeffCode[i] + delta) > s_MaxCoeffCode)
+					continue;
+
+				double peakResponseError = findTrialPeakResponseError(i, mirroredCoeffIdx, mirrorSign, delta);
+				if (peakResponseError < (m_PeakResponseError * (1.0 - 1e-9)))
+				{
+					applyChange(i, mirroredCoeffIdx, mirrorSign, delta);
+					m_PeakResponseError = peakResponseError;
+					isImproved = true;
+					break;
+				}
+			}
+		}
+		if (!isImproved)
+			break;
+	}
+}
+
+double FirCoeffQuantizer::findTrialPeakResponseError(unsigned coeffIdx, unsigned mirroredCoeffIdx, int mirrorSign, int delta) const
+{
+	double change = double(delta) * decodeCoeffCode(1, m_CoeffScale);
+	double mirroredChange = (mirroredCoeffIdx != coeffIdx) ? (change * mirrorSign) : 0.0;
+
+	double peakResponseError = 0.0;
+	for (unsigned f = 0; f <= m_NumFreqSteps; ++f)
+	{
+		unsigned phase = (coeffIdx * f) % (2 * m_NumFreqSteps);
+		unsigned mirroredPhase = (mirroredCoeffIdx * f) % (2 * m_NumFreqSteps);
+		double re = m_vErrorRe[f] + (change * m_vCos[phase]) + (mirroredChange * m_vCos[mirroredPhase]);
+		double im = m_vErrorIm[f] - (change * m_vSin[phase]) - (mirroredChange * m_vSin[mirroredPhase]);
+		peakResponseError = max(peakResponseError, m_vWeight[f] * m_vWeight[f] * ((re * re) + (im * im)));
+		if (peakResponseError >= (m_PeakResponseError * m_PeakResponseError))
+			break;		// (no better)
+	}
+	return sqrt(peakResponseError);
+}
+
+void FirCoeffQuantizer::applyChange(unsigned coeffIdx, unsigned mirroredCoeffIdx, int mirrorSign, int delta)
+{
+	double change = double(delta) * decodeCoeffCode(1, m_CoeffScale);
+	double mirroredChange = (mirroredCoeffIdx != coeffIdx) ? (change * mirrorSign) : 0.0;
+
+	m_vCoeffCode[coeffIdx] += delta;
+	if (mirroredCoeffIdx != coeffIdx)
+		m_vCoeffCode[mirroredCoeffIdx] += delta * mirrorSign;
+
+	for (unsigned f = 0; f <= m_NumFreqSteps; ++f)
+	{
+		unsigned phase = (coeffIdx * f) % (2 * m_NumFreqSteps);
+		unsigned mirroredPhase = (mirroredCoeffIdx * f) % (2 * m_NumFreqSteps);
+		m_vErrorRe[f] += (change * m_vCos[phase]) + (mirroredChange * m_vCos[mirroredPhase]);
+		m_vErrorIm[f] -= (change * m_vSin[phase]) + (mirroredChange * m_vSin[mirroredPhase]);
+	}
+}
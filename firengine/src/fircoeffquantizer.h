@@ -0,0 +1,70 @@
+#ifndef FIRCOEFFQUANTIZER_H
+#define FIRCOEFFQUANTIZER_H
+
+
+#include <vector>
+#include "firspec.h"
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// Quantizes a set of FIR Coefficients to the words of the
+///   Coefficient-RAM (18 bits, 1.17 once scaled by 2^CoeffScale)
+///   choosing the words whose frequency response stays closest
+///   to that of the ideal Coefficients
+/////////////////////////////////////////////////////////////
+
+class FirCoeffQuantizer
+{
+public:
+	/// Coefficients no larger than zeroThreshold (in magnitude) are zero taps, and stay zero
+	///   (the words of a symmetric or antisymmetric set stay mirrored, so it can still be folded)
+	FirCoeffQuantizer(const vector<double>& vCoeff, double zeroThreshold, int coeffScale, FirSpec::Symmetry);
+public:
+	/// Largest magnitude of a Coefficient word (the range is kept symmetric, so that any word can be negated)
+	static const int		s_MaxCoeffCode = (1 << 17) - 1;
+	/// Largest power of 2 by which Coefficients can be scaled up (or smallest, scaling them down) to make the most of the Coefficient words
+	///   without the sum of their products overflowing the 36-bit partial sums passed down a chain (at most 2^14, where the Output is the top of the 48-bit result)
+	///   returns false if even the smallest scale does not fit the Coefficients
+	static bool findCoeffScale(double maxAbsCoeff, double sumAbsCoeff, int* pCoeffScale);
+	/// Value of a Coefficient word (removing the scale)
+	static double decodeCoeffCode(int coeffCode, int coeffScale);
+	/// Magnitude of the response of a set of Coefficients at numPoints frequencies, evenly spaced from 0 to Nyquist
+	static void establishFrequencyResponse(const vector<double>& vCoeff, unsigned numPoints, vector<double>* pOut);
+	/// Ratio (in dB) of the energy of the ideal Coefficients to the energy of their quantization error
+	static double findSnr(const vector<double>& vCoeff, const vector<double>& vQuantizedCoeff);
+	/// Attenuation (in dB), below the peak of the ideal response, of the highest ripple of a response in the stopband (where the ideal response is at least 20dB below its peak)
+	///   (0 when the ideal response has no stopband)
+	static double findStopbandAttenuation(const vector<double>& vIdealResponse, const vector<double>& vResponse);
+public:
+	/// Round each Coefficient to the nearest word, then search for single-step changes of the words (keeping any mirroring) which reduce the peak error of the response
+	///   (each accepted change feeds its error back into the choice of the next)
+	void quantize();
+	const vector<int>& getCoeffCodes() const		{ return m_vCoeffCode; }
+	/// Largest magnitude (over all frequencies) of the difference between the quantized and the ideal response
+	double getPeakResponseError() const				{ return m_PeakResponseError; }
+private:
+	/// Peak response error if the word of a Coefficient (and its mirror) were changed by delta
+	double findTrialPeakResponseError(unsigned coeffIdx, unsigned mirroredCoeffIdx, int mirrorSign, int delta) const;
+	void applyChange(unsigned coeffIdx, unsigned mirroredCoeffIdx, int mirrorSign, int delta);
+private:
+	const vector<double>&	m_vCoeff;
+	const double			m_ZeroThreshold;
+	const int				m_CoeffScale;
+	const FirSpec::Symmetry	m_Symmetry;
+	/// Number of frequency steps between 0 and Nyquist at which the response is compared
+	unsigned				m_NumFreqSteps;
+	/// cos and sin of (pi * n / NumFreqSteps), for n < 2 * NumFreqSteps
+	vector<double>			m_vCos;
+	vector<double>			m_vSin;
+	/// Response of the quantization error at each of the NumFreqSteps + 1 frequencies
+	vector<double>			m_vErrorRe;
+	vector<double>			m_vErrorIm;
+	/// Weight of the error at each frequency (errors outside the stopband are weighted less)
+	vector<double>			m_vWeight;
+	double					m_PeakResponseError;
+	vector<int>				m_vCoeffCode;
+};
+
+
+#endif
@@ -0,0 +1,423 @@
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include "intutils.h"
+#include "stringutil.h"
+#include "fircpufilter.h"
+
+
+// A tile of Outputs by a tile of taps: its accumulators, Coefficients and the samples they read fit the L1 cache
+static const unsigned s_NumTileOutputs = 256;
+static const unsigned s_NumTileTaps = 512;
+// Shorter FIRs are filtered directly (the FFTs of overlap-save take more operations than their taps)
+static const unsigned s_MinOverlapSaveTaps = 256;
+static const unsigned s_MaxNumFftPoints = 1u << 20;
+
+static int64_t _signExtend(int64_t value, unsigned numBits)
+{
+	return int64_t(uint64_t(value) << (64 - numBits)) >> (64 - numBits);
+}
+
+// Keep the last numHistorySamples of a delay line, for the next block
+template <typename Sample>
+static void _keepHistory(unsigned numHistorySamples, vector<Sample>* pvPaddedSample)
+{
+	pvPaddedSample->erase(pvPaddedSample->begin(), pvPaddedSample->end() - numHistorySamples);
+}
+
+// Products of a sub-filter (numSubTaps Coefficients) for numOutputs Outputs, Output i reading the samples from pSample + (i * stride)
+//   each tile of taps is applied to every tile of Outputs before the next, the innermost loop running over the Outputs of a tile
+//   (contiguous samples, unless decimating) into accumulators of its own (which alias nothing, so that the loop vectorizes)
+template <typename Sample, typename Accum>
+static void _accumulateSubFilter(const Sample* pCoeff, unsigned numSubTaps, const Sample* pSample, unsigned stride, unsigned numOutputs, Accum* pAccum)
+{
+	Accum vTileAccum[s_NumTileOutputs];
+	fill(pAccum, pAccum + numOutputs, Accum(0));
+	for (unsigned firstTapIdx = 0; firstTapIdx < numSubTaps; firstTapIdx += s_NumTileTaps)
+	{
+		unsigned endTapIdx = min(numSubTaps, firstTapIdx + s_NumTileTaps);
+		for (unsigned firstOutputIdx = 0; firstOutputIdx < numOutputs; firstOutputIdx += s_NumTileOutputs)
+		{
+			unsigned numTileOutputs = min(numOutputs - firstOutputIdx, s_NumTileOutputs);
+			const Sample* pTileSample = pSample + (firstOutputIdx * stride);
+			copy(pAccum + firstOutputIdx, pAccum + firstOutputIdx + numTileOutputs, vTileAccum);
+			for (unsigned tapIdx = firstTapIdx; tapIdx < endTapIdx; ++tapIdx)
+			{
+				Accum coeff = Accum(pCoeff[tapIdx]);
+				const Sample* pTapSample = pTileSample + tapIdx;
+				if (stride == 1)
+				{
+					for (unsigned i = 0; i < numTileOutputs; ++i)
+						vTileAccum[i] += coeff * Accum(pTapSample[i]);
+				}
+				else
+				{
+					for (unsigned i = 0; i < numTileOutputs; ++i)
+						vTileAccum[i] += coeff * Accum(pTapSample[i * stride]);
+				}
+			}
+			copy(vTileAccum, vTileAccum + numTileOutputs, pAccum + firstOutputIdx);
+		}
+	}
+}
+
+// Add the products of each phase's sub-filter (one part of the Coefficients) for numPhaseOutputs Input samples, from firstSampleIdx
+//   of the block, every stride-th, into every Interpolation-th accumulator from the phase
+template <typename Sample, typename Accum>
+static void _accumulatePart(const vector<vector<Sample> >& vvPhaseCoeff, const vector<Sample>& vPaddedSample, unsigned numHistorySamples,
+	unsigned firstSampleIdx, unsigned stride, unsigned numPhaseOutputs, Accum sign, vector<Accum>* pvPhaseAccum, vector<Accum>* pvAccum)
+{
+	unsigned interpolation = vvPhaseCoeff.size();
+	pvPhaseAccum->resize(numPhaseOutputs);
+	for (unsigned phase = 0; phase < interpolation; ++phase)
+	{
+		const vector<Sample>& vPhaseCoeff = vvPhaseCoeff[phase];
+		if (vPhaseCoeff.empty() || (numPhaseOutputs == 0))
+			continue;
+
+		// The window of an Output ends with its Input sample (which follows the history in the delay line)
+		const Sample* pSample = &vPaddedSample[numHistorySamples + firstSampleIdx + 1 - vPhaseCoeff.size()];
+		_accumulateSubFilter(&vPhaseCoeff[0], vPhaseCoeff.size(), pSample, stride, numPhaseOutputs, &(*pvPhaseAccum)[0]);
+		for (unsigned i = 0; i < numPhaseOutputs; ++i)
+			(*pvAccum)[(i * interpolation) + phase] += sign * (*pvPhaseAccum)[i];
+	}
+}
+
+FirCpuFilter::FirCpuFilter() :
+	m_SampleFreq			(0),
+	m_Interpolation			(1),
+	m_Decimation			(1),
+	m_CoeffScale			(0),
+	m_ImagSign				(-1),
+	m_NumHistorySamples		(0),
+	m_NumSkippedOutputs		(0),
+	m_vAccum				(),
+	m_vFloatAccum			(),
+	m_vPhaseAccum			(),
+	m_vFloatPhaseAccum		(),
+	m_Algorithm				(Algorithm_Direct),
+	m_NumSegmentSamples		(0)
+{
+}
+
+void FirCpuFilter::init(const FirEngineSpec& firEngineSpec, unsigned firIdx)
+{
+	// A complex FIR's Quadrature FIR has the Coefficients of its in-phase FIR (the quantized words of its own)
+	const FirSpec& firSpec = firEngineSpec.m_vFirSpec[firIdx];
+	const FirSpec& inPhaseFirSpec = firEngineSpec.m_vFirSpec[firSpec.isQuadrature() ? firSpec.m_InPhaseFirIndex : firIdx];
+	m_SampleFreq = firSpec.m_SampleFreq;
+	m_Interpolation = firSpec.m_Interpolation;
+	m_Decimation = firSpec.m_Decimation;
+	m_CoeffScale = firSpec.m_CoeffScale;
+	m_ImagSign = firSpec.isQuadrature() ? 1 : -1;
+
+	establishPhaseCoeffs(firSpec.m_vCoeffCode, inPhaseFirSpec.m_vCoeff, 0);
+	m_vvPhaseCoeffCode[1].clear();
+	m_vvPhaseCoeff[1].clear();
+	if (!firSpec.m_vCoeffImagCode.empty())
+		establishPhaseCoeffs(firSpec.m_vCoeffImagCode, inPhaseFirSpec.m_vCoeffImag, 1);
+
+	// The fixed-point products (of 18-bit samples and Coefficient words) are summed exactly in double precision
+	//   (whose multiplies vectorize where 64-bit integer ones do not) as long as the sums stay below 2^53
+	assert((firSpec.m_vCoeffCode.size() + firSpec.m_vCoeffImagCode.size()) < (1u << 19));
+
+	m_NumHistorySamples = 0;
+	for (unsigned part = 0; part < 2; ++part)
+	{
+		for (unsigned phase = 0; phase < m_vvPhaseCoeffCode[part].size(); ++phase)
+		{
+			if (!m_vvPhaseCoeffCode[part][phase].empty())
+				m_NumHistorySamples = max(m_NumHistorySamples, unsigned(m_vvPhaseCoeffCode[part][phase].size() - 1));
+		}
+	}
+	m_Algorithm = Algorithm_Direct;
+	reset();
+}
+
+void FirCpuFilter::chooseAlgorithm(double maxLatency)
+{
+	m_Algorithm = Algorithm_Direct;
+	unsigned numTaps = 0;
+	for (unsigned phase = 0; phase < m_vvPhaseCoeff[0].size(); ++phase)
+		numTaps += m_vvPhaseCoeff[0][phase].size();
+	if (numTaps < s_MinOverlapSaveTaps)
+		return;
+
+	// The segments are transformed two at a time, so the new samples of two must have arrived
+	unsigned maxNumSegmentSamples = s_MaxNumFftPoints;
+	if (maxLatency > 0.0)
+		maxNumSegmentSamples = unsigned(floor(maxLatency * double(m_SampleFreq) / 2.0));
+
+	// Larger FFTs take more operations per point, but share them out over more new samples
+	unsigned numSpannedSamples = m_NumHistorySamples + 1;
+	double bestNumFlops = 2.0 * findNumMacsPerSample();
+	unsigned bestNumFftPoints = 0;
+	for (unsigned numFftPoints = IntUtils::roundUpToPowerOfTwo(numSpannedSamples + 1); numFftPoints <= s_MaxNumFftPoints; numFftPoints *= 2)
+	{
+		if ((numFftPoints - m_NumHistorySamples) > maxNumSegmentSamples)
+			break;
+		double numFlops = findOverlapSaveFlopsPerSample(numFftPoints);
+		if (numFlops < bestNumFlops)
+		{
+			bestNumFlops = numFlops;
+			bestNumFftPoints = numFftPoints;
+		}
+	}
+	if (bestNumFftPoints == 0)
+		return;
+
+	m_Algorithm = Algorithm_OverlapSave;
+	m_FirFft.init(bestNumFftPoints);
+	m_NumSegmentSamples = bestNumFftPoints - m_NumHistorySamples;
+	establishPhaseSpectra();
+}
+
+double FirCpuFilter::findOverlapSaveFlopsPerSample(unsigned numFftPoints) const
+{
+	// For each pair of segments: an FFT of each part, then for each phase the products of each part's spectra (a complex multiply-add
+	//   of each point) and an inverse FFT
+	unsigned numParts = hasImagCoeffs() ? 2 : 1;
+	double numFlops = double(numParts + m_Interpolation) * FirFft::findNumFlops(numFftPoints);
+	numFlops += 8.0 * double(m_Interpolation * numParts) * double(numFftPoints);
+	return numFlops / (2.0 * double(numFftPoints - m_NumHistorySamples));
+}
+
+void FirCpuFilter::establishPhaseSpectra()
+{
+	unsigned numFftPoints = m_FirFft.getNumPoints();
+	for (unsigned part = 0; part < 2; ++part)
+	{
+		float scale = ((part == 0) ? 1.0f : float(m_ImagSign)) / float(numFftPoints);
+		m_vvPhaseSpectrum[part].assign(m_vvPhaseCoeff[part].size(), vector<complex<float> >());
+		for (unsigned phase = 0; phase < m_vvPhaseCoeff[part].size(); ++phase)
+		{
+			// The sub-filter's impulse response is its Coefficients in their own order (they are kept reversed)
+			const vector<float>& vPhaseCoeff = m_vvPhaseCoeff[part][phase];
+			if (vPhaseCoeff.empty())
+				continue;
+			vector<complex<float> >& vPhaseSpectrum = m_vvPhaseSpectrum[part][phase];
+			vPhaseSpectrum.assign(numFftPoints, complex<float>(0.0f, 0.0f));
+			for (unsigned i = 0; i < vPhaseCoeff.size(); ++i)
+				vPhaseSpectrum[i] = complex<float>(scale * vPhaseCoeff[vPhaseCoeff.size() - 1 - i], 0.0f);
+			m_FirFft.transform(&vPhaseSpectrum[0], false);
+		}
+	}
+}
+
+void FirCpuFilter::establishPhaseCoeffs(const vector<int>& vCoeffCode, const vector<double>& vCoeff, unsigned part)
+{
+	assert(vCoeffCode.size() == vCoeff.size());
+	m_vvPhaseCoeffCode[part].assign(m_Interpolation, vector<int32_t>());
+	m_vvPhaseCoeff[part].assign(m_Interpolation, vector<float>());
+	for (unsigned phase = 0; phase < m_Interpolation; ++phase)
+	{
+		vector<int32_t>& vPhaseCoeffCode = m_vvPhaseCoeffCode[part][phase];
+		vector<float>& vPhaseCoeff = m_vvPhaseCoeff[part][phase];
+		for (unsigned coeffIdx = phase; coeffIdx < vCoeffCode.size(); coeffIdx += m_Interpolation)
+		{
+			vPhaseCoeffCode.push_back(vCoeffCode[coeffIdx]);
+			vPhaseCoeff.push_back(float(vCoeff[coeffIdx]));
+		}
+		reverse(vPhaseCoeffCode.begin(), vPhaseCoeffCode.end());
+		reverse(vPhaseCoeff.begin(), vPhaseCoeff.end());
+	}
+}
+
+void FirCpuFilter::reset()
+{
+	// The samples before the first are 0
+	unsigned numParts = hasImagCoeffs() ? 2 : 1;
+	for (unsigned part = 0; part < 2; ++part)
+	{
+		m_vPaddedSample[part].assign((part < numParts) ? m_NumHistorySamples : 0, 0);
+		m_vFloatPaddedSample[part].assign((part < numParts) ? m_NumHistorySamples : 0, 0.0f);
+	}
+	m_NumSkippedOutputs = 0;
+}
+
+string FirCpuFilter::getAlgorithmName() const
+{
+	if (m_Algorithm == Algorithm_OverlapSave)
+		return "overlap-save (" + toString(m_FirFft.getNumPoints()) + "-point FFT)";
+	return "direct";
+}
+
+unsigned FirCpuFilter::findNumBlockSamples(unsigned minNumBlockSamples) const
+{
+	if (m_Algorithm == Algorithm_OverlapSave)
+		return IntUtils::roundupToMultipleOf(minNumBlockSamples, 2 * m_NumSegmentSamples);
+	return minNumBlockSamples;
+}
+
+double FirCpuFilter::findNumFlopsPerSample() const
+{
+	if (m_Algorithm == Algorithm_OverlapSave)
+		return findOverlapSaveFlopsPerSample(m_FirFft.getNumPoints());
+	return 2.0 * findNumMacsPerSample();
+}
+
+double FirCpuFilter::findNumMacsPerSample() const
+{
+	double numMacs = 0.0;
+	for (unsigned part = 0; part < 2; ++part)
+	{
+		for (unsigned phase = 0; phase < m_vvPhaseCoeffCode[part].size(); ++phase)
+			numMacs += double(m_vvPhaseCoeffCode[part][phase].size());
+	}
+	// (every phase is computed when interpolating)
+	return (m_Interpolation > 1) ? numMacs : (numMacs / double(m_Decimation));
+}
+
+unsigned FirCpuFilter::findNumKeptOutputs(unsigned numFullRateOutputs) const
+{
+	if (numFullRateOutputs <= m_NumSkippedOutputs)
+		return 0;
+	return IntUtils::ceilDiv(numFullRateOutputs - m_NumSkippedOutputs, m_Decimation);
+}
+
+void FirCpuFilter::advanceDecimation(unsigned numFullRateOutputs)
+{
+	unsigned numKeptOutputs = findNumKeptOutputs(numFullRateOutputs);
+	if (numKeptOutputs == 0)
+		m_NumSkippedOutputs -= numFullRateOutputs;
+	else
+		m_NumSkippedOutputs = (m_NumSkippedOutputs + (numKeptOutputs * m_Decimation)) - numFullRateOutputs;
+}
+
+void FirCpuFilter::filterBlock(const int32_t* pSample, const int32_t* pImagSample, unsigned numSamples, vector<int>* pvOutputSample)
+{
+	assert(!hasImagCoeffs() || pImagSample);
+	m_vPaddedSample[0].insert(m_vPaddedSample[0].end(), pSample, pSample + numSamples);
+	if (hasImagCoeffs())
+		m_vPaddedSample[1].insert(m_vPaddedSample[1].end(), pImagSample, pImagSample + numSamples);
+
+	// When interpolating, every phase of every Input sample is computed (and the Outputs kept picked from them)
+	//   otherwise only the Outputs kept, every Decimation-th Input sample
+	bool isInterpolating = (m_Interpolation > 1);
+	unsigned numFullRateOutputs = numSamples * m_Interpolation;
+	unsigned numKeptOutputs = findNumKeptOutputs(numFullRateOutputs);
+	unsigned numPhaseOutputs = isInterpolating ? numSamples : numKeptOutputs;
+	unsigned firstSampleIdx = isInterpolating ? 0 : m_NumSkippedOutputs;
+	unsigned stride = isInterpolating ? 1 : m_Decimation;
+	m_vAccum.assign(numPhaseOutputs * m_Interpolation, 0.0);
+	_accumulatePart(m_vvPhaseCoeffCode[0], m_vPaddedSample[0], m_NumHistorySamples, firstSampleIdx, stride, numPhaseOutputs, 1.0, &m_vPhaseAccum, &m_vAccum);
+	if (hasImagCoeffs())
+		_accumulatePart(m_vvPhaseCoeffCode[1], m_vPaddedSample[1], m_NumHistorySamples, firstSampleIdx, stride, numPhaseOutputs, double(m_ImagSign), &m_vPhaseAccum, &m_vAccum);
+
+	// The 48-bit result, sliced as the FirMac's Output ([33+CoeffScale:16+CoeffScale])
+	unsigned firstAccumIdx = isInterpolating ? m_NumSkippedOutputs : 0;
+	unsigned accumStride = isInterpolating ? m_Decimation : 1;
+	for (unsigned i = 0; i < numKeptOutputs; ++i)
+	{
+		int64_t result = _signExtend(int64_t(m_vAccum[firstAccumIdx + (i * accumStride)]), 48);
+		pvOutputSample->push_back(int(_signExtend(result >> (16 + m_CoeffScale), 18)));
+	}
+
+	advanceDecimation(numFullRateOutputs);
+	_keepHistory(m_NumHistorySamples, &m_vPaddedSample[0]);
+	if (hasImagCoeffs())
+		_keepHistory(m_NumHistorySamples, &m_vPaddedSample[1]);
+}
+
+void FirCpuFilter::filterBlock(const float* pSample, const float* pImagSample, unsigned numSamples, vector<float>* pvOutputSample)
+{
+	assert(!hasImagCoeffs() || pImagSample);
+	m_vFloatPaddedSample[0].insert(m_vFloatPaddedSample[0].end(), pSample, pSample + numSamples);
+	if (hasImagCoeffs())
+		m_vFloatPaddedSample[1].insert(m_vFloatPaddedSample[1].end(), pImagSample, pImagSample + numSamples);
+
+	// (computed as the fixed-point Outputs are)
+	bool isInterpolating = (m_Interpolation > 1);
+	unsigned numFullRateOutputs = numSamples * m_Interpolation;
+	unsigned numKeptOutputs = findNumKeptOutputs(numFullRateOutputs);
+	unsigned numPhaseOutputs = isInterpolating ? numSamples : numKeptOutputs;
+	unsigned firstSampleIdx = isInterpolating ? 0 : m_NumSkippedOutputs;
+	unsigned stride = isInterpolating ? 1 : m_Decimation;
+	m_vFloatAccum.assign(numPhaseOutputs * m_Interpolation, 0.0f);
+	if (m_Algorithm == Algorithm_OverlapSave)
+	{
+		// Overlap-save computes the Outputs of every Input sample (those of the samples wanted are picked from them)
+		convolveOverlapSave(numSamples);
+		for (unsigned phase = 0; phase < m_Interpolation; ++phase)
+		{
+			for (unsigned i = 0; i < numPhaseOutputs; ++i)
+				m_vFloatAccum[(i * m_Interpolation) + phase] = m_vvFloatPhaseOutput[phase][firstSampleIdx + (i * stride)];
+		}
+	}
+	else
+	{
+		_accumulatePart(m_vvPhaseCoeff[0], m_vFloatPaddedSample[0], m_NumHistorySamples, firstSampleIdx, stride, numPhaseOutputs, 1.0f, &m_vFloatPhaseAccum, &m_vFloatAccum);
+		if (hasImagCoeffs())
+			_accumulatePart(m_vvPhaseCoeff[1], m_vFloatPaddedSample[1], m_NumHistorySamples, firstSampleIdx, stride, numPhaseOutputs, float(m_ImagSign), &m_vFloatPhaseAccum, &m_vFloatAccum);
+	}
+
+	// The FirMacs' Output is twice the sum of the products (see FirEngineReference::establishIdealOutputs)
+	unsigned firstAccumIdx = isInterpolating ? m_NumSkippedOutputs : 0;
+	unsigned accumStride = isInterpolating ? m_Decimation : 1;
+	for (unsigned i = 0; i < numKeptOutputs; ++i)
+		pvOutputSample->push_back(2.0f * m_vFloatAccum[firstAccumIdx + (i * accumStride)]);
+
+	advanceDecimation(numFullRateOutputs);
+	_keepHistory(m_NumHistorySamples, &m_vFloatPaddedSample[0]);
+	if (hasImagCoeffs())
+		_keepHistory(m_NumHistorySamples, &m_vFloatPaddedSample[1]);
+}
+
+void FirCpuFilter::convolveOverlapSave(unsigned numSamples)
+{
+	unsigned numFftPoints = m_FirFft.getNumPoints();
+	unsigned numParts = hasImagCoeffs() ? 2 : 1;
+	m_vvFloatPhaseOutput.resize(m_Interpolation);
+	for (unsigned phase = 0; phase < m_Interpolation; ++phase)
+		m_vvFloatPhaseOutput[phase].assign(numSamples, 0.0f);
+
+	for (unsigned firstSampleIdx = 0; firstSampleIdx < numSamples; firstSampleIdx += 2 * m_NumSegmentSamples)
+	{
+		// Two segments in one FFT, the first in the real parts and the second in the imaginary parts (as the sub-filters are real
+		//   their Outputs come out apart): each segment is its new samples, after the history of the first (zeros past the block)
+		unsigned secondSampleIdx = firstSampleIdx + m_NumSegmentSamples;
+		for (unsigned part = 0; part < numParts; ++part)
+		{
+			const vector<float>& vPaddedSample = m_vFloatPaddedSample[part];
+			vector<complex<float> >& vSegmentSpectrum = m_vSegmentSpectrum[part];
+			vSegmentSpectrum.resize(numFftPoints);
+			for (unsigned i = 0; i < numFftPoints; ++i)
+			{
+				float sample = ((firstSampleIdx + i) < vPaddedSample.size()) ? vPaddedSample[firstSampleIdx + i] : 0.0f;
+				float secondSample = ((secondSampleIdx + i) < vPaddedSample.size()) ? vPaddedSample[secondSampleIdx + i] : 0.0f;
+				vSegmentSpectrum[i] = complex<float>(sample, secondSample);
+			}
+			m_FirFft.transform(&vSegmentSpectrum[0], false);
+		}
+
+		for (unsigned phase = 0; phase < m_Interpolation; ++phase)
+		{
+			m_vOutputSpectrum.assign(numFftPoints, complex<float>(0.0f, 0.0f));
+			bool hasCoeffs = false;
+			for (unsigned part = 0; part < numParts; ++part)
+			{
+				const vector<complex<float> >& vPhaseSpectrum = m_vvPhaseSpectrum[part][phase];
+				if (vPhaseSpectrum.empty())
+					continue;
+				hasCoeffs = true;
+				for (unsigned i = 0; i < numFftPoints; ++i)
+					m_vOutputSpectrum[i] += FirFft::multiply(m_vSegmentSpectrum[part][i], vPhaseSpectrum[i]);
+			}
+			if (!hasCoeffs)
+				continue;
+			m_FirFft.transform(&m_vOutputSpectrum[0], true);
+
+			// The points after the history are the Outputs of the new samples (the first wrap around the circular convolution)
+			vector<float>& vPhaseOutput = m_vvFloatPhaseOutput[phase];
+			for (unsigned i = 0; i < m_NumSegmentSamples; ++i)
+			{
+				const complex<float>& output = m_vOutputSpectrum[m_NumHistorySamples + i];
+				if ((firstSampleIdx + i) < numSamples)
+					vPhaseOutput[firstSampleIdx + i] = output.real();
+				if ((secondSampleIdx + i) < numSamples)
+					vPhaseOutput[secondSampleIdx + i] = output.imag();
+			}
+		}
+	}
+}
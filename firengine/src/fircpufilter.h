@@ -0,0 +1,119 @@
+#ifndef FIRCPUFILTER_H
+#define FIRCPUFILTER_H
+
+
+#include <stdint.h>
+#include <complex>
+#include <string>
+#include <vector>
+#include "firenginespec.h"
+#include "firfft.h"
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// A FIR filtered on the CPU, a block of Input samples at a
+///   time (its delay lines hold the end of the previous block,
+///   so that a stream can be filtered in blocks of any size)
+///   Each polyphase sub-filter is computed a tile of Outputs
+///   by a tile of taps at a time, so that the accumulators,
+///   Coefficients and samples of a tile stay in the L1 cache,
+///   in loops over contiguous words that the compiler can
+///   vectorize
+///   The fixed-point variant has the arithmetic of the FirMacs
+///   (see FirEngineReference, its sums of products carried out
+///   exactly in double precision), the floating-point variant
+///   uses the FIR's Coefficients as specified, in single
+///   precision
+///   A long FIR can instead convolve its floating-point samples
+///   by overlap-save: FFTs of segments of its samples (with the
+///   history its taps span) times the precomputed spectra of its
+///   sub-filters, which take far fewer operations per sample
+///   than its taps
+/////////////////////////////////////////////////////////////
+
+class FirCpuFilter
+{
+public:
+	enum Algorithm
+	{
+		Algorithm_Direct,			///< the products of every tap
+		Algorithm_OverlapSave		///< FFTs of the samples times the sub-filters' spectra (floating point only)
+	};
+	FirCpuFilter();
+public:
+	/// Filter FIR firIdx of the FirEngineSpec (whose Coefficients must have been quantized)
+	void init(const FirEngineSpec&, unsigned firIdx);
+	/// Forget the samples of earlier blocks (as if the stream started again)
+	void reset();
+	/// Filter the floating-point samples by overlap-save if the FIR has at least MinOverlapSaveTaps and that takes fewer operations,
+	///   with the FFT size that takes the fewest whose segments of new samples arrive within maxLatency seconds (0 for no limit)
+	void chooseAlgorithm(double maxLatency);
+	/// Filter a block of Input samples (2.16) into Outputs (2.16), appended to *pvOutputSample
+	///   pImagSample are the samples multiplied by the imaginary Coefficients of a complex FIR (the other part of its Input, NULL otherwise)
+	void filterBlock(const int32_t* pSample, const int32_t* pImagSample, unsigned numSamples, vector<int>* pvOutputSample);
+	/// Filter a block of Input samples (in full-scale units, 1.0 = 2^16 LSBs) into Outputs, appended to *pvOutputSample
+	void filterBlock(const float* pSample, const float* pImagSample, unsigned numSamples, vector<float>* pvOutputSample);
+public:
+	bool hasImagCoeffs() const			{ return !m_vvPhaseCoeffCode[1].empty(); }
+	/// Products per Input sample (taps of every phase, only for the Outputs kept)
+	double findNumMacsPerSample() const;
+	/// Real operations per floating-point Input sample (of the Algorithm)
+	double findNumFlopsPerSample() const;
+	Algorithm getAlgorithm() const		{ return m_Algorithm; }
+	string getAlgorithmName() const;
+	/// Input samples best filtered at a time, at least minNumBlockSamples (whole pairs of segments by overlap-save)
+	unsigned findNumBlockSamples(unsigned minNumBlockSamples) const;
+private:
+	/// Sub-filter of a phase (Coefficients phase, phase + Interpolation, ..., reversed, so that they line up with the samples they multiply)
+	void establishPhaseCoeffs(const vector<int>& vCoeffCode, const vector<double>& vCoeff, unsigned part);
+	/// Outputs kept (every Decimation-th) of numFullRateOutputs, starting NumSkippedOutputs in
+	unsigned findNumKeptOutputs(unsigned numFullRateOutputs) const;
+	/// Move on past a block of numFullRateOutputs (the Outputs then still to skip before the next one kept)
+	void advanceDecimation(unsigned numFullRateOutputs);
+	/// Real operations per Input sample of overlap-save with numFftPoints-point FFTs (each of two segments of samples)
+	double findOverlapSaveFlopsPerSample(unsigned numFftPoints) const;
+	/// Spectrum of each phase's sub-filter (see m_vvPhaseSpectrum)
+	void establishPhaseSpectra();
+	/// Outputs of every phase for each Input sample of the block (into m_vvFloatPhaseOutput) by overlap-save
+	void convolveOverlapSave(unsigned numSamples);
+private:
+	unsigned					m_SampleFreq;
+	unsigned					m_Interpolation;
+	unsigned					m_Decimation;
+	int							m_CoeffScale;
+	/// -1 if the imaginary products are subtracted (the in-phase Output of a complex FIR), +1 if added (its quadrature Output)
+	int							m_ImagSign;
+	/// Sub-filter Coefficients of each phase, of the real [0] and imaginary [1] Coefficients (fixed and floating point)
+	vector<vector<int32_t> >	m_vvPhaseCoeffCode[2];
+	vector<vector<float> >		m_vvPhaseCoeff[2];
+	/// Samples of the previous blocks needed by the longest sub-filter
+	unsigned					m_NumHistorySamples;
+	/// Delay lines of the samples (and of the imaginary samples): the last NumHistorySamples, then the block being filtered
+	vector<int32_t>				m_vPaddedSample[2];
+	vector<float>				m_vFloatPaddedSample[2];
+	/// Full rate Outputs still to skip (at the start of the next block) before the next one kept
+	unsigned					m_NumSkippedOutputs;
+	/// Accumulations of the Outputs of a block (at full rate when interpolating, otherwise only those kept)
+	///   the fixed-point sums of products are integers, held exactly in double precision
+	vector<double>				m_vAccum;
+	vector<float>				m_vFloatAccum;
+	/// Accumulations of one sub-filter (contiguous, so that its tiles vectorize)
+	vector<double>				m_vPhaseAccum;
+	vector<float>				m_vFloatPhaseAccum;
+	Algorithm					m_Algorithm;
+	/// Overlap-save: the FFT, and the new samples of a segment (the FFT's points less the history)
+	FirFft						m_FirFft;
+	unsigned					m_NumSegmentSamples;
+	/// Spectrum of each phase's sub-filter, of the real [0] and imaginary [1] Coefficients
+	///   (scaled by 1/NumFftPoints for the inverse FFT, and those of the imaginary Coefficients by ImagSign)
+	vector<vector<complex<float> > >	m_vvPhaseSpectrum[2];
+	/// Spectra of a pair of segments of the samples (and of the imaginary samples), and of a phase's Outputs
+	vector<complex<float> >		m_vSegmentSpectrum[2];
+	vector<complex<float> >		m_vOutputSpectrum;
+	/// Outputs of each phase, one for each Input sample of a block
+	vector<vector<float> >		m_vvFloatPhaseOutput;
+};
+
+
+#endif
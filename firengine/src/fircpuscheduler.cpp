@@ -0,0 +1,106 @@
+
+#include <assert.h>
+#include <algorithm>
+#include <thread>
+#include "fircpuscheduler.h"
+
+
+FirCpuScheduler::FirCpuScheduler(unsigned numThreads) :
+	m_vThreadQueue			(max(1u, numThreads)),
+	m_NumUnfinishedTasks	(0)
+{
+}
+
+void FirCpuScheduler::addChain(double blockWeight, unsigned numBlocks)
+{
+	m_vBlockWeight.push_back(blockWeight);
+	m_vNumBlocks.push_back(numBlocks);
+	m_NumUnfinishedTasks += numBlocks;
+}
+
+void FirCpuScheduler::dealChains()
+{
+	// Heaviest chain first (ties to the earlier chain), each to the thread with the least weight so far
+	vector<unsigned> vChainIdx;
+	for (unsigned chainIdx = 0; chainIdx < m_vNumBlocks.size(); ++chainIdx)
+	{
+		if (m_vNumBlocks[chainIdx] > 0)
+			vChainIdx.push_back(chainIdx);
+	}
+	stable_sort(vChainIdx.begin(), vChainIdx.end(), [&](unsigned a, unsigned b)
+	{
+		return (m_vBlockWeight[a] * m_vNumBlocks[a]) > (m_vBlockWeight[b] * m_vNumBlocks[b]);
+	});
+
+	for (unsigned i = 0; i < vChainIdx.size(); ++i)
+	{
+		unsigned chainIdx = vChainIdx[i];
+		unsigned threadIdx = 0;
+		for (unsigned j = 1; j < m_vThreadQueue.size(); ++j)
+		{
+			if (m_vThreadQueue[j].m_DealtWeight < m_vThreadQueue[threadIdx].m_DealtWeight)
+				threadIdx = j;
+		}
+		Task task = { chainIdx, 0 };
+		m_vThreadQueue[threadIdx].m_dTask.push_back(task);
+		m_vThreadQueue[threadIdx].m_DealtWeight += m_vBlockWeight[chainIdx] * m_vNumBlocks[chainIdx];
+	}
+}
+
+bool FirCpuScheduler::popTask(unsigned threadIdx, Task* pTask)
+{
+	ThreadQueue& threadQueue = m_vThreadQueue[threadIdx];
+	while (m_NumUnfinishedTasks > 0)
+	{
+		{
+			lock_guard<mutex> lock(threadQueue.m_Mutex);
+			if (!threadQueue.m_dTask.empty())
+			{
+				*pTask = threadQueue.m_dTask.front();
+				threadQueue.m_dTask.pop_front();
+				++threadQueue.m_NumTasksRun;
+				return true;
+			}
+		}
+		if (stealTask(threadIdx, pTask))
+			return true;
+
+		// The tasks left are running (or are the next blocks of the chains running)
+		this_thread::yield();
+	}
+	return false;
+}
+
+bool FirCpuScheduler::stealTask(unsigned threadIdx, Task* pTask)
+{
+	// Victims in turn, starting with the next thread (so that the thieves spread over the victims)
+	for (unsigned i = 1; i < m_vThreadQueue.size(); ++i)
+	{
+		ThreadQueue& victimQueue = m_vThreadQueue[(threadIdx + i) % m_vThreadQueue.size()];
+		lock_guard<mutex> lock(victimQueue.m_Mutex);
+		if (!victimQueue.m_dTask.empty())
+		{
+			*pTask = victimQueue.m_dTask.back();
+			victimQueue.m_dTask.pop_back();
+
+			// (the thief's counts are only updated by the thief)
+			++m_vThreadQueue[threadIdx].m_NumTasksRun;
+			++m_vThreadQueue[threadIdx].m_NumTasksStolen;
+			return true;
+		}
+	}
+	return false;
+}
+
+void FirCpuScheduler::finishTask(unsigned threadIdx, const Task& task)
+{
+	assert(task.m_BlockIdx < m_vNumBlocks[task.m_ChainIdx]);
+	if ((task.m_BlockIdx + 1) < m_vNumBlocks[task.m_ChainIdx])
+	{
+		ThreadQueue& threadQueue = m_vThreadQueue[threadIdx];
+		Task nextTask = { task.m_ChainIdx, task.m_BlockIdx + 1 };
+		lock_guard<mutex> lock(threadQueue.m_Mutex);
+		threadQueue.m_dTask.push_front(nextTask);
+	}
+	--m_NumUnfinishedTasks;
+}
@@ -0,0 +1,74 @@
+#ifndef FIRCPUSCHEDULER_H
+#define FIRCPUSCHEDULER_H
+
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// Work-stealing schedule of the blocks filtered on the CPU
+///   Each FIR is a chain of tasks, one per block of its Input
+///   samples, that must run in order (a block starts from the
+///   delay lines the one before left)
+///   The chains are dealt to the threads heaviest first, each
+///   to the least loaded thread, and a thread runs the next
+///   block of a chain as soon as it finishes one (it goes on
+///   the front of its own queue), so that a FIR's delay lines
+///   stay in the cache of the core filtering it
+///   A thread whose queue runs out steals the task at the back
+///   of another thread's queue (the lightest chain it has not
+///   started)
+/////////////////////////////////////////////////////////////
+
+class FirCpuScheduler
+{
+public:
+	struct Task
+	{
+		unsigned	m_ChainIdx;
+		unsigned	m_BlockIdx;
+	};
+	explicit FirCpuScheduler(unsigned numThreads);
+public:
+	/// A chain of numBlocks tasks, each of the given weight (run in order, see Task::m_BlockIdx)
+	void addChain(double blockWeight, unsigned numBlocks);
+	/// Deal the chains to the threads (before any task is popped)
+	void dealChains();
+	/// The next task thread threadIdx is to run, its own or stolen (waits while the tasks left are all running, false once they have all finished)
+	bool popTask(unsigned threadIdx, Task* pTask);
+	/// Task popped by thread threadIdx has run (its chain's next block becomes that thread's next task)
+	void finishTask(unsigned threadIdx, const Task&);
+public:
+	unsigned getNumThreads() const			{ return m_vThreadQueue.size(); }
+	/// Tasks run by a thread (and, of those, stolen from another thread)
+	unsigned getNumTasksRun(unsigned threadIdx) const		{ return m_vThreadQueue[threadIdx].m_NumTasksRun; }
+	unsigned getNumTasksStolen(unsigned threadIdx) const	{ return m_vThreadQueue[threadIdx].m_NumTasksStolen; }
+	/// Weight of the chains dealt to a thread
+	double getDealtWeight(unsigned threadIdx) const			{ return m_vThreadQueue[threadIdx].m_DealtWeight; }
+private:
+	bool stealTask(unsigned threadIdx, Task* pTask);
+private:
+	struct ThreadQueue
+	{
+		ThreadQueue() : m_NumTasksRun(0), m_NumTasksStolen(0), m_DealtWeight(0.0)	{}
+		mutex			m_Mutex;
+		/// Tasks of the thread: it pops the front, other threads steal the back
+		deque<Task>		m_dTask;
+		unsigned		m_NumTasksRun;
+		unsigned		m_NumTasksStolen;
+		double			m_DealtWeight;
+	};
+	/// Weight of each block and number of blocks of each chain
+	vector<double>			m_vBlockWeight;
+	vector<unsigned>		m_vNumBlocks;
+	vector<ThreadQueue>		m_vThreadQueue;
+	/// Tasks that have not yet finished
+	atomic<unsigned>		m_NumUnfinishedTasks;
+};
+
+
+#endif
@@ -0,0 +1,297 @@
+#include <assert.h>
+#include <stdio.h>
+#include "stringutil.h"
+#include "stringmatchstream.h"
+#include "firenginebindingfile.h"
+
+
+FirEngineBindingFile::FirEngineBindingFile() :
+	m_NumTimeSlots		(0),
+	m_vFirSpec			(),
+	m_vFirBinding		()
+{
+}
+
+void FirEngineBindingFile::readFromFile(istream& stream)
+{
+	unsigned lineNum = 1;
+
+	try
+	{
+		string lineStr;
+		for (; safeGetline(stream, lineStr); ++lineNum) if (!lineStr.empty())
+		{
+			StringMatchStream matchStream(lineStr);
+			matchStream.matchWhitespace();
+
+			if (matchStream.atEnd())
+				;
+			else if (*matchStream == '#')		// comment 
+				;
+			else if (matchStream.matchText("numTimeSlices"))
+			{
+				matchStream.matchWhitespace();
+				if (!matchStream.matchChar('='))
+					throw string("Syntax Error: Expected '='");
+				matchStream.matchWhitespace();
+				if (!matchStream.matchUInt(&m_NumTimeSlots))
+					throw string("Syntax Error: Expected Unsigned-Integer number of TimeSlices");
+				matchStream.matchWhitespace();
+				if (!matchStream.matchChar(';'))
+					throw string("Syntax Error: Expected ';'");
+			}
+			else if (matchStream.matchText("FIR"))
+			{
+				unsigned firIdx = 0;
+				matchStream.matchWhitespace();
+				if (!matchStream.matchChar('['))
+					throw string("Syntax Error: Expected '['");
+				matchStream.matchWhitespace();
+				if (!matchStream.matchUInt(&firIdx))
+					throw string("Syntax Error: Expected FIR-Index");
+				matchStream.matchWhitespace();
+				if (!matchStream.matchChar(']'))
+					throw string("Syntax Error: Expected ']'");
+				matchStream.matchWhitespace();
+				if (!matchStream.matchChar('.'))
+					throw string("Syntax Error: Expected '.'");
+
+				while (m_vFirSpec.size() <= firIdx)
+					m_vFirSpec.push_back(FirSpec());
+				FirSpec& firSpec = m_vFirSpec[firIdx];
+
+				if (matchStream.matchText("sampleRate"))
+				{
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('='))
+						throw string("Syntax Error: Expected '='");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchUInt(&firSpec.m_SampleFreq))
+						throw string("Syntax Error: Expected Unsigned-Integer sample rate");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar(';'))
+						throw string("Syntax Error: Expected ';'");
+				}
+				else if (matchStream.matchText("decimation"))
+				{
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('='))
+						throw string("Syntax Error: Expected '='");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchUInt(&firSpec.m_Decimation))
+						throw string("Syntax Error: Expected Unsigned-Integer decimation");
+					if (firSpec.m_Decimation == 0)
+						throw string("Decimation must be at least 1");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar(';'))
+						throw string("Syntax Error: Expected ';'");
+				}
+				else if (matchStream.matchText("interpolation"))
+				{
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('='))
+						throw string("Syntax Error: Expected '='");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchUInt(&firSpec.m_Interpolation))
+						throw string("Syntax Error: Expected Unsigned-Integer interpolation");
+					if (firSpec.m_Interpolation == 0)
+						throw string("Interpolation must be at least 1");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar(';'))
+						throw string("Syntax Error: Expected ';'");
+				}
+				else if (matchStream.matchText("zeroThreshold"))
+				{
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('='))
+						throw string("Syntax Error: Expected '='");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchFloatingPointNumber(0, &firSpec.m_ZeroThreshold))
+						throw string("Syntax Error: Expected floating point zero threshold");
+					if (firSpec.m_ZeroThreshold < 0.0)
+						throw string("ZeroThreshold must not be negative");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar(';'))
+						throw string("Syntax Error: Expected ';'");
+				}
+				else if (matchStream.matchText("input"))
+				{
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('='))
+						throw string("Syntax Error: Expected '='");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchUInt(&firSpec.m_InputFirIndex))
+						throw string("Syntax Error: Expected FIR-Index of the shared Input");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar(';'))
+						throw string("Syntax Error: Expected ';'");
+				}
+				else if (matchStream.matchText("complex"))
+				{
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('='))
+						throw string("Syntax Error: Expected '='");
+					matchStream.matchWhitespace();
+					if (matchStream.matchText("true"))
+						firSpec.m_IsComplex = true;
+					else if (matchStream.matchText("false"))
+						firSpec.m_IsComplex = false;
+					else
+						throw string("Syntax Error: Expected true or false");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar(';'))
+						throw string("Syntax Error: Expected ';'");
+				}
+				else if (matchStream.matchText("inPhase"))
+				{
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('='))
+						throw string("Syntax Error: Expected '='");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchUInt(&firSpec.m_InPhaseFirIndex))
+						throw string("Syntax Error: Expected FIR-Index of the in-phase FIR");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar(';'))
+						throw string("Syntax Error: Expected ';'");
+				}
+				else if (matchStream.matchText("coeffImag"))		// (before "coeff", which it starts with)
+				{
+					firSpec.m_vCoeffImag.clear();
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('='))
+						throw string("Syntax Error: Expected '='");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('['))
+						throw string("Syntax Error: Expected '['");
+					matchStream.matchWhitespace();
+					while (!matchStream.matchChar(']'))
+					{
+						firSpec.m_vCoeffImag.push_back(0);
+						if (!matchStream.matchFloatingPointNumber(0, &firSpec.m_vCoeffImag.back()))
+							throw string("Syntax Error: Expected floating point number");
+						matchStream.matchWhitespace();
+						matchStream.matchChar(',');
+						matchStream.matchWhitespace();
+					}
+					if (!matchStream.matchChar(';'))
+						throw string("Syntax Error: Expected ';'");
+				}
+				else if (matchStream.matchText("coeff"))
+				{
+					firSpec.m_vCoeff.clear();
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('='))
+						throw string("Syntax Error: Expected '='");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('['))
+						throw string("Syntax Error: Expected '['");
+					matchStream.matchWhitespace();
+					while (!matchStream.matchChar(']'))
+					{
+						firSpec.m_vCoeff.push_back(0);
+						if (!matchStream.matchFloatingPointNumber(0, &firSpec.m_vCoeff.back()))
+							throw string("Syntax Error: Expected floating point number");
+						matchStream.matchWhitespace();
+						matchStream.matchChar(',');
+						matchStream.matchWhitespace();
+					}
+					if (!matchStream.matchChar(';'))
+						throw string("Syntax Error: Expected ';'");
+				}
+				else if (matchStream.matchText("binding"))
+				{
+					FirBinding firBinding;
+					firBinding.m_FirIndex = firIdx;
+					unsigned* pFields[] = { &firBinding.m_FirstFirMacIndex, &firBinding.m_TimeSliceOrigin, &firBinding.m_TimeSliceInterval };
+
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('='))
+						throw string("Syntax Error: Expected '='");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar('['))
+						throw string("Syntax Error: Expected '['");
+					for (unsigned i = 0; i < 3; ++i)
+					{
+						matchStream.matchWhitespace();
+						if (!matchStream.matchUInt(pFields[i]))
+							throw string("Syntax Error: Expected Unsigned-Integer binding field");
+						matchStream.matchWhitespace();
+						if ((i < 2) && !matchStream.matchChar(','))
+							throw string("Syntax Error: Expected ','");
+					}
+					if (!matchStream.matchChar(']'))
+						throw string("Syntax Error: Expected ']'");
+					matchStream.matchWhitespace();
+					if (!matchStream.matchChar(';'))
+						throw string("Syntax Error: Expected ';'");
+
+					m_vFirBinding.push_back(firBinding);
+				}
+				else
+				{
+					throw string("Unrecognized field '") + matchStream.getString() + "'";
+				}
+
+				matchStream.matchWhitespace();
+				if (!matchStream.atEnd() && !matchStream.matchChar('#'))
+				{
+					throw string("Unexpected tokens '") + matchStream.getString() + "'";
+				}
+			}
+			else
+			{
+				throw string("Unrecognized command: '") + matchStream.getString() + "'";
+			}
+		}
+	}
+	catch (const string& str)
+	{
+		throw string("Syntax Error in binding file on line ") + toString(lineNum) + ": " + str;
+	}
+}
+
+void FirEngineBindingFile::writeToFile(ostream& stream) const
+{
+	stream << "# FirEngine binding (read back by 'firenginebuilder -i' to keep unchanged FIRs in place)\n";
+	stream << "numTimeSlices = " << m_NumTimeSlots << ";\n";
+
+	for (unsigned i = 0; i < m_vFirBinding.size(); ++i)
+	{
+		const FirBinding& firBinding = m_vFirBinding[i];
+		const FirSpec& firSpec = m_vFirSpec[firBinding.m_FirIndex];
+
+		stream << "FIR[" << firBinding.m_FirIndex << "].sampleRate = " << firSpec.m_SampleFreq << ";\n";
+		stream << "FIR[" << firBinding.m_FirIndex << "].decimation = " << firSpec.m_Decimation << ";\n";
+		stream << "FIR[" << firBinding.m_FirIndex << "].interpolation = " << firSpec.m_Interpolation << ";\n";
+		if (!firSpec.hasOwnInput())
+			stream << "FIR[" << firBinding.m_FirIndex << "].input = " << firSpec.m_InputFirIndex << ";\n";
+
+		// Note: coefficients (and thresholds) are written so that they read back exactly (and always with a '.', as the parser requires)
+		char str[32];
+		sprintf(str, "%#.17g", firSpec.m_ZeroThreshold);
+		stream << "FIR[" << firBinding.m_FirIndex << "].zeroThreshold = " << str << ";\n";
+		stream << "FIR[" << firBinding.m_FirIndex << "].coeff = [";
+		for (unsigned j = 0; j < firSpec.m_vCoeff.size(); ++j)
+		{
+			sprintf(str, "%#.17g", firSpec.m_vCoeff[j]);
+			stream << ((j > 0) ? ", " : " ") << str;
+		}
+		stream << " ];\n";
+		if (firSpec.m_IsComplex)
+			stream << "FIR[" << firBinding.m_FirIndex << "].complex = true;\n";
+		if (firSpec.isQuadrature())
+			stream << "FIR[" << firBinding.m_FirIndex << "].inPhase = " << firSpec.m_InPhaseFirIndex << ";\n";
+		if (firSpec.hasImagCoeffs())
+		{
+			stream << "FIR[" << firBinding.m_FirIndex << "].coeffImag = [";
+			for (unsigned j = 0; j < firSpec.m_vCoeffImag.size(); ++j)
+			{
+				sprintf(str, "%#.17g", firSpec.m_vCoeffImag[j]);
+				stream << ((j > 0) ? ", " : " ") << str;
+			}
+			stream << " ];\n";
+		}
+
+		stream << "FIR[" << firBinding.m_FirIndex << "].binding = [ " << firBinding.m_FirstFirMacIndex << ", " << firBinding.m_TimeSliceOrigin << ", " << firBinding.m_TimeSliceInterval << " ];\n";
+	}
+}
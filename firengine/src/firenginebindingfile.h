@@ -0,0 +1,45 @@
+#ifndef FIRENGINEBINDINGFILE_H
+#define FIRENGINEBINDINGFILE_H
+
+
+#include <fstream>
+#include <vector>
+#include "firspec.h"
+#include "firbinding.h"
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// The binding of a FirEngine, as persisted next to its outputs
+///   (<firEngineName>.fbd) so that a later build can keep the
+///   FIRs that have not changed on the same MACs and TimeSlots
+///
+///   Same syntax as the FirEngine-Specification file, plus a
+///   binding field per FIR (listed in the order they were bound):
+///     numTimeSlices = 32;
+///     FIR[0].sampleRate = 15000000;
+///     FIR[0].decimation = 1;
+///     FIR[0].interpolation = 1;
+///     FIR[0].zeroThreshold = 0.0;
+///     FIR[0].coeff = [ 0.1, 0.2, ... ];
+///     FIR[0].binding = [ FirstFirMacIndex, TimeSliceOrigin, TimeSliceInterval ];
+/////////////////////////////////////////////////////////////
+
+class FirEngineBindingFile
+{
+public:
+	FirEngineBindingFile();
+public:
+	void readFromFile(istream&);
+	void writeToFile(ostream&) const;
+public:
+	/// Number of TimeSlots the binding was made for
+	unsigned				m_NumTimeSlots;
+	/// Specification of each FIR (by FIR index) at the time it was bound
+	vector<FirSpec>			m_vFirSpec;
+	/// Bindings, in the order they were made (FirMacSections are not persisted)
+	vector<FirBinding>		m_vFirBinding;
+};
+
+
+#endif
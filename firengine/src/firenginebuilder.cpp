@@ -3,9 +3,15 @@
 
 #include <stdio.h>
 #include <fstream>
+#include "stringutil.h"
 #include "firenginespec.h"
 #include "firenginedesc.h"
 #include "firengineglobals.h"
+#include "firenginebindingfile.h"
+#include "firengineexplorer.h"
+#include "firenginesim.h"
+#include "firenginereference.h"
+#include "firenginecpu.h"
 
 
 static void buildFirEngine(int argc, char* argv[])
@@ -13,7 +19,7 @@ static void buildFirEngine(int argc, char* argv[])
 	FirEngineGlobals firEngineGlobals;
 	firEngineGlobals.parseArgs(argc, argv);
 
-	FirEngineSpec firEngineSpec(firEngineGlobals.m_ClockFreq);
+	FirEngineSpec readFirEngineSpec(firEngineGlobals.m_ClockFreq);
 	{
 		string fname(firEngineGlobals.m_FirEngineName + ".fsp");
 		ifstream fstream(fname);
@@ -22,18 +28,155 @@ static void buildFirEngine(int argc, char* argv[])
 			printf("Unable to open FirEngine-Specification file '%s'\n", fname.c_str());
 			exit(1);
 		}
-		firEngineSpec.readFromFile(fstream);
+		readFirEngineSpec.readFromFile(fstream);
 	}
 
-	FirEngineDesc firEngineDesc(firEngineGlobals.m_NumTimeSlices);
+	// The Coefficients alone, for FIRs filtered on other targets
+	if (firEngineGlobals.m_IsKernelHeaderOnly)
+	{
+		bool isChanged = readFirEngineSpec.generateKernelHeader(firEngineGlobals.m_FirEngineName);
+		printf("%s_kernels.h %s\n", firEngineGlobals.m_FirEngineName.c_str(), isChanged ? "written" : "unchanged");
+		return;
+	}
+
+	// Design-space exploration chooses the ClockFreq and NumTimeSlices to build
+	//   (and, within a resource budget, the binder; only the NumTimeSlices are explored unless ExploreClockFreqs are given)
+	FirEngineExplorer firEngineExplorer;
+	const FirResourceBudget& resourceBudget = firEngineGlobals.m_ResourceBudget;
+	bool isExplored = !firEngineGlobals.m_vExploreClockFreq.empty() || resourceBudget.isLimited();
+	if (isExplored)
+	{
+		vector<double> vClockFreq(firEngineGlobals.m_vExploreClockFreq);
+		if (vClockFreq.empty())
+			vClockFreq.push_back(firEngineGlobals.m_ClockFreq);
+		firEngineExplorer.explore(readFirEngineSpec, vClockFreq, firEngineGlobals.m_IsPackedFifos, firEngineGlobals.m_NumBindThreads, resourceBudget);
+		firEngineExplorer.printParetoTable();
+		firEngineGlobals.m_ClockFreq = firEngineExplorer.getChosenPoint().m_ClockFreq;
+		firEngineGlobals.m_NumTimeSlices = firEngineExplorer.getChosenPoint().m_NumTimeSlots;
+		if (resourceBudget.isLimited())
+		{
+			// Rebind exactly as the chosen point was bound, so the build is the one that fits
+			firEngineGlobals.m_IsPortfolioBind = firEngineExplorer.getChosenPoint().m_IsPortfolioBind;
+			firEngineGlobals.m_ExactBindTimeLimit = 0.0;
+		}
+	}
+	FirEngineSpec firEngineSpec(readFirEngineSpec, firEngineGlobals.m_ClockFreq);
+
+	FirEngineDesc firEngineDesc(firEngineGlobals.m_NumTimeSlices, firEngineGlobals.m_IsPackedFifos);
 
 	// Bind all FIRs to the firEngineDesc (creating new MACs as needed)
-	for (unsigned firIdx = 0; firIdx < firEngineSpec.m_vFirSpec.size(); ++firIdx)
+	string bindingFname(firEngineGlobals.m_FirEngineName + ".fbd");
+	ifstream bindingFStream;
+	if (firEngineGlobals.m_IsIncrementalBind)
+	{
+		bindingFStream.open(bindingFname);
+		if (!bindingFStream.is_open())
+			printf("No previous binding '%s': binding all FIRs\n", bindingFname.c_str());
+	}
+
+	if (bindingFStream.is_open())
+	{
+		FirEngineBindingFile prevFirEngineBindingFile;
+		prevFirEngineBindingFile.readFromFile(bindingFStream);
+		bindingFStream.close();
+		firEngineDesc.bindFirsIncremental(firEngineSpec, prevFirEngineBindingFile);
+	}
+	else if (firEngineGlobals.m_ExactBindTimeLimit > 0.0)
+	{
+		firEngineDesc.bindFirsExact(firEngineSpec, firEngineGlobals.m_ExactBindTimeLimit);
+	}
+	else if (firEngineGlobals.m_IsPortfolioBind)
+	{
+		firEngineDesc.bindFirsPortfolio(firEngineSpec, firEngineGlobals.m_NumBindThreads);
+	}
+	else
+	{
+		for (unsigned firIdx = 0; firIdx < firEngineSpec.m_vFirSpec.size(); ++firIdx)
+		{
+			firEngineDesc.bindFir(firEngineSpec, firIdx);
+		}
+		firEngineDesc.establishLowerBoundNumFirMacs(firEngineSpec);
+	}
+
+	// An incremental binding keeps FIRs where they were, so it may not fit the budget the chosen point fits
+	if (!resourceBudget.isWithinBudget(firEngineDesc.m_vFirEngineMacDesc.size(), FirResourceBudget::findNumBram36Equivalents(firEngineDesc.getNumBram36(), firEngineDesc.getNumBram18())))
+	{
+		throw string("The binding uses ") + toString(firEngineDesc.m_vFirEngineMacDesc.size()) + " FirMacs and " + toString(FirResourceBudget::findNumBram36Equivalents(firEngineDesc.getNumBram36(), firEngineDesc.getNumBram18()))
+			+ " BRAM36, over the resource budget of " + resourceBudget.getDescription() + " (rebuild without -i to rebind all FIRs)";
+	}
+
+	// Persist the binding, for a later incremental build
+	{
+		FirEngineBindingFile firEngineBindingFile;
+		firEngineDesc.establishBindingFile(firEngineSpec, &firEngineBindingFile);
+		ofstream fstream(bindingFname);
+		firEngineBindingFile.writeToFile(fstream);
+	}
+
+	unsigned numChangedFirMacs = firEngineDesc.generateRtl(firEngineSpec, firEngineGlobals.m_FirEngineName);
+	printf("%u of %u FirMac RTL files changed\n", numChangedFirMacs, unsigned(firEngineDesc.m_vFirEngineMacDesc.size()));
+
+	// Simulate the FirMacs as built (each FIR with an Input is given a test stimulus of its own)
+	FirEngineSim firEngineSim(firEngineSpec, firEngineDesc);
+	bool isSimulated = (firEngineGlobals.m_NumSimSamples > 0);
+	if (isSimulated)
+	{
+		for (unsigned firIdx = 0; firIdx < firEngineSpec.m_vFirSpec.size(); ++firIdx) if (firEngineDesc.hasInput(firIdx))
+		{
+			vector<int> vSample;
+			FirEngineSim::establishTestSamples(firEngineGlobals.m_NumSimSamples, firIdx + 1, &vSample);
+			firEngineSim.setInputSamples(firIdx, vSample);
+		}
+		firEngineSim.run();
+		printf("Simulated %u cycles: %u Input samples, %u Output samples\n", firEngineSim.getNumCycles(), firEngineSim.getNumInputSamples(), firEngineSim.getNumOutputSamples());
+
+		ofstream fstream(firEngineGlobals.m_FirEngineName + ".sim");
+		firEngineSim.writeToFile(fstream);
+	}
+
+	// Golden vectors from the functional reference (given the same stimulus, so that the simulation can be checked against them)
+	FirEngineReference firEngineReference(firEngineSpec);
+	bool isReferenced = (firEngineGlobals.m_NumRefSamples > 0);
+	if (isReferenced)
+	{
+		for (unsigned firIdx = 0; firIdx < firEngineSpec.m_vFirSpec.size(); ++firIdx) if (firEngineSpec.m_vFirSpec[firIdx].hasOwnInput())
+		{
+			vector<int> vSample;
+			FirEngineSim::establishTestSamples(firEngineGlobals.m_NumRefSamples, firIdx + 1, &vSample);
+			firEngineReference.setInputSamples(firIdx, vSample);
+		}
+		firEngineReference.run();
+
+		ofstream fstream(firEngineGlobals.m_FirEngineName + ".ref");
+		firEngineReference.writeToFile(fstream);
+	}
+
+	// The FIRs filtered in software (given the same stimulus, so that they can be checked against the reference)
+	FirEngineCpu firEngineCpu(firEngineSpec, firEngineGlobals.m_IsCpuFloat ? FirEngineCpu::Arithmetic_Float : FirEngineCpu::Arithmetic_Fixed, firEngineGlobals.m_NumCpuThreads, firEngineGlobals.m_MaxCpuLatency);
+	bool isCpuFiltered = (firEngineGlobals.m_NumCpuSamples > 0) || !firEngineGlobals.m_CpuSampleFname.empty();
+	if (!firEngineGlobals.m_CpuSampleFname.empty())
 	{
-		firEngineDesc.bindFir(firEngineSpec, firIdx);
+		// (streamed a block at a time, through the mappings of the files)
+		FirSampleFile inputFile;
+		inputFile.openForReading(firEngineGlobals.m_CpuSampleFname);
+		string outputFname(firEngineGlobals.m_FirEngineName + "_cpu.fss");
+		firEngineCpu.runStream(inputFile, outputFname);
+		printf("Filtered '%s' on the CPU into '%s': %g MSamples/s per core, %g MSamples/s in all\n", firEngineGlobals.m_CpuSampleFname.c_str(), outputFname.c_str(), firEngineCpu.findTotalThroughput(), firEngineCpu.findParallelThroughput());
 	}
+	else if (isCpuFiltered)
+	{
+		for (unsigned firIdx = 0; firIdx < firEngineSpec.m_vFirSpec.size(); ++firIdx) if (firEngineSpec.m_vFirSpec[firIdx].hasOwnInput())
+		{
+			vector<int> vSample;
+			FirEngineSim::establishTestSamples(firEngineGlobals.m_NumCpuSamples, firIdx + 1, &vSample);
+			firEngineCpu.setInputSamples(firIdx, vSample);
+		}
+		firEngineCpu.run();
+		printf("Filtered %u Input samples per FIR on the CPU: %g MSamples/s per core, %g MSamples/s in all\n", firEngineGlobals.m_NumCpuSamples, firEngineCpu.findTotalThroughput(), firEngineCpu.findParallelThroughput());
 
-	firEngineDesc.generateRtl(firEngineGlobals.m_FirEngineName, firEngineSpec);
+		ofstream fstream(firEngineGlobals.m_FirEngineName + ".cpu");
+		firEngineCpu.writeToFile(fstream);
+	}
 
 	{
 		string fname(firEngineGlobals.m_FirEngineName + ".html");
@@ -41,10 +184,27 @@ static void buildFirEngine(int argc, char* argv[])
 
 		firEngineGlobals.renderHtmlHeader(fstream);
 		firEngineGlobals.generateHtmlReport(fstream);
+		if (isExplored)
+			firEngineExplorer.generateHtmlReport(fstream);
 		firEngineSpec.generateHtmlReport(fstream);
-		firEngineDesc.generateHtmlReport(fstream);
+		firEngineDesc.generateHtmlReport(fstream, firEngineSpec);
+		if (isSimulated)
+			firEngineSim.generateHtmlReport(fstream);
+		if (isReferenced)
+			firEngineReference.generateHtmlReport(fstream, isSimulated ? &firEngineSim : NULL);
+		if (isCpuFiltered)
+			firEngineCpu.generateHtmlReport(fstream, isReferenced ? &firEngineReference : NULL);
 		firEngineGlobals.renderHtmlFooter(fstream);
 	}
+
+	// A simulation that does not match the reference fails the build (once the report shows which FIRs do not)
+	if (isSimulated && isReferenced)
+	{
+		unsigned numMismatchedFirs = firEngineReference.findNumMismatchedFirs(firEngineSim);
+		if (numMismatchedFirs > 0)
+			throw string("Simulated Outputs of ") + toString(numMismatchedFirs) + " FIRs do not match the reference (see " + firEngineGlobals.m_FirEngineName + ".html)";
+		printf("Simulated Outputs of all FIRs match the reference\n");
+	}
 }
 
 
@@ -0,0 +1,439 @@
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include "intutils.h"
+#include "firenginecpu.h"
+#include "fircpuscheduler.h"
+
+
+// (defined here as well, as std::min takes it by reference)
+const unsigned FirEngineCpu::s_NumBlockSamples;
+
+// LSBs (of 2.16 Outputs) by which overlap-save may differ from the direct form (the rounding of single-precision FFTs)
+static const double s_MaxDirectDifference = 1.0;
+
+FirEngineCpu::FirEngineCpu(const FirEngineSpec& firEngineSpec, Arithmetic arithmetic, unsigned numThreads, double maxLatency) :
+	m_FirEngineSpec			(firEngineSpec),
+	m_Arithmetic			(arithmetic),
+	m_NumThreads			((numThreads > 0) ? numThreads : max(1u, thread::hardware_concurrency())),
+	m_vFirCpuFilter			(firEngineSpec.m_vFirSpec.size()),
+	m_vvInputSample			(firEngineSpec.m_vFirSpec.size()),
+	m_vvBlockSample			(firEngineSpec.m_vFirSpec.size()),
+	m_vvFloatBlockSample	(firEngineSpec.m_vFirSpec.size()),
+	m_vvOutputSample		(firEngineSpec.m_vFirSpec.size()),
+	m_vvFloatOutputSample	(firEngineSpec.m_vFirSpec.size()),
+	m_vNumBlockSamples		(firEngineSpec.m_vFirSpec.size(), s_NumBlockSamples),
+	m_vPeakDirectDifference	(firEngineSpec.m_vFirSpec.size(), 0.0),
+	m_vFilterTime			(firEngineSpec.m_vFirSpec.size(), 0.0),
+	m_RunTime				(0.0),
+	m_NumStolenTasks		(0),
+	m_vNumInputSamples		(firEngineSpec.m_vFirSpec.size(), 0),
+	m_vNumOutputSamples		(firEngineSpec.m_vFirSpec.size(), 0),
+	m_IsStreamed			(false),
+	m_pInputFile			(NULL),
+	m_pOutputFile			(NULL),
+	m_vInputChannelIdx		(firEngineSpec.m_vFirSpec.size(), 0),
+	m_vvStreamOutputSample	(firEngineSpec.m_vFirSpec.size()),
+	m_vvFloatStreamOutputSample	(firEngineSpec.m_vFirSpec.size())
+{
+	for (unsigned firIdx = 0; firIdx < m_vFirCpuFilter.size(); ++firIdx)
+	{
+		m_vFirCpuFilter[firIdx].init(firEngineSpec, firIdx);
+		if (arithmetic == Arithmetic_Float)
+			m_vFirCpuFilter[firIdx].chooseAlgorithm(maxLatency);
+		m_vNumBlockSamples[firIdx] = m_vFirCpuFilter[firIdx].findNumBlockSamples(s_NumBlockSamples);
+	}
+}
+
+void FirEngineCpu::setInputSamples(unsigned firIdx, const vector<int>& vSample)
+{
+	assert(firIdx < m_vvInputSample.size());
+	assert(m_FirEngineSpec.m_vFirSpec[firIdx].hasOwnInput() || vSample.empty());
+	m_vvInputSample[firIdx] = vSample;
+}
+
+unsigned FirEngineCpu::findInputFirIndex(unsigned firIdx) const
+{
+	const FirSpec& firSpec = m_FirEngineSpec.m_vFirSpec[firIdx];
+	return firSpec.hasOwnInput() ? firIdx : firSpec.m_InputFirIndex;
+}
+
+unsigned FirEngineCpu::findImagInputFirIndex(unsigned firIdx) const
+{
+	// The in-phase Output multiplies the quadrature samples by the imaginary Coefficients, the quadrature Output the in-phase samples
+	const FirSpec& firSpec = m_FirEngineSpec.m_vFirSpec[firIdx];
+	return findInputFirIndex(firSpec.isQuadrature() ? firSpec.m_InPhaseFirIndex : m_FirEngineSpec.findQuadratureFirIndex(firIdx));
+}
+
+unsigned FirEngineCpu::findNumInputSamples(unsigned firIdx) const
+{
+	return m_vNumInputSamples[findInputFirIndex(firIdx)];
+}
+
+void FirEngineCpu::run()
+{
+	m_IsStreamed = false;
+	establishBlockSamples();
+	for (unsigned firIdx = 0; firIdx < m_vFirCpuFilter.size(); ++firIdx)
+	{
+		m_vvOutputSample[firIdx].clear();
+		m_vvFloatOutputSample[firIdx].clear();
+	}
+	runBlocks();
+
+	for (unsigned firIdx = 0; firIdx < m_vvFloatOutputSample.size(); ++firIdx)
+	{
+		const vector<float>& vFloatOutputSample = m_vvFloatOutputSample[firIdx];
+		for (unsigned i = 0; i < vFloatOutputSample.size(); ++i)
+			m_vvOutputSample[firIdx].push_back(int(floor(ldexp(double(vFloatOutputSample[i]), 16) + 0.5)));
+		m_vNumOutputSamples[firIdx] = m_vvOutputSample[firIdx].size();
+		if (m_vFirCpuFilter[firIdx].getAlgorithm() != FirCpuFilter::Algorithm_Direct)
+			establishPeakDirectDifference(firIdx);
+	}
+}
+
+void FirEngineCpu::runStream(const FirSampleFile& inputFile, const string& outputFname)
+{
+	// (the samples of a channel are indexed by unsigned, as those in memory)
+	unsigned numInputChannels = 0;
+	for (unsigned firIdx = 0; firIdx < m_FirEngineSpec.m_vFirSpec.size(); ++firIdx) if (m_FirEngineSpec.m_vFirSpec[firIdx].hasOwnInput())
+	{
+		if (numInputChannels >= inputFile.getNumChannels())
+			throw string("The sample file has fewer channels than there are FIR Inputs");
+		if (inputFile.getSampleRate(numInputChannels) != double(m_FirEngineSpec.m_vFirSpec[firIdx].m_SampleFreq))
+			throw string("The sample file's channel ") + to_string(numInputChannels) + " is not at the SampleFreq of FIR " + m_FirEngineSpec.getChannelName(firIdx);
+		if (inputFile.getNumSamples(numInputChannels) > uint64_t(UINT_MAX))
+			throw string("The sample file's channel ") + to_string(numInputChannels) + " has too many samples";
+		m_vNumInputSamples[firIdx] = unsigned(inputFile.getNumSamples(numInputChannels));
+		m_vInputChannelIdx[firIdx] = numInputChannels++;
+	}
+	if (numInputChannels != inputFile.getNumChannels())
+		throw string("The sample file has more channels than there are FIR Inputs");
+
+	// Each FIR's Outputs: every Decimation-th of Interpolation for each Input sample
+	vector<double> vOutputSampleRate;
+	vector<uint64_t> vNumOutputSamples;
+	for (unsigned firIdx = 0; firIdx < m_FirEngineSpec.m_vFirSpec.size(); ++firIdx)
+	{
+		const FirSpec& firSpec = m_FirEngineSpec.m_vFirSpec[firIdx];
+		if (m_vFirCpuFilter[firIdx].hasImagCoeffs() &&
+			(inputFile.getNumSamples(m_vInputChannelIdx[findImagInputFirIndex(firIdx)]) != inputFile.getNumSamples(m_vInputChannelIdx[findInputFirIndex(firIdx)])))
+			throw string("The sample file's in-phase and quadrature channels of FIR ") + m_FirEngineSpec.getChannelName(firIdx) + " differ in length";
+		uint64_t numFullRateOutputs = inputFile.getNumSamples(m_vInputChannelIdx[findInputFirIndex(firIdx)]) * firSpec.m_Interpolation;
+		vOutputSampleRate.push_back(double(firSpec.m_SampleFreq) * firSpec.m_Interpolation / firSpec.m_Decimation);
+		vNumOutputSamples.push_back((numFullRateOutputs + firSpec.m_Decimation - 1) / firSpec.m_Decimation);
+	}
+	FirSampleFile outputFile;
+	outputFile.createForWriting(outputFname, (m_Arithmetic == Arithmetic_Fixed) ? FirSampleFile::Format_Fixed : FirSampleFile::Format_Float, vOutputSampleRate, vNumOutputSamples);
+
+	for (unsigned part = 0; part < 2; ++part)
+	{
+		m_vvStreamSample[part].assign(m_vFirCpuFilter.size(), vector<int32_t>());
+		m_vvFloatStreamSample[part].assign(m_vFirCpuFilter.size(), vector<float>());
+	}
+	m_IsStreamed = true;
+	m_pInputFile = &inputFile;
+	m_pOutputFile = &outputFile;
+	runBlocks();
+	for (unsigned firIdx = 0; firIdx < m_vNumOutputSamples.size(); ++firIdx)
+		assert(m_vNumOutputSamples[firIdx] == vNumOutputSamples[firIdx]);
+	m_pInputFile = NULL;
+	m_pOutputFile = NULL;
+	outputFile.close();
+}
+
+void FirEngineCpu::runBlocks()
+{
+	for (unsigned firIdx = 0; firIdx < m_vFirCpuFilter.size(); ++firIdx)
+	{
+		m_vFirCpuFilter[firIdx].reset();
+		m_vNumOutputSamples[firIdx] = 0;
+		m_vFilterTime[firIdx] = 0.0;
+	}
+
+	// A chain of tasks for each FIR, one per block, weighted by the operations it takes
+	FirCpuScheduler firCpuScheduler(m_NumThreads);
+	for (unsigned firIdx = 0; firIdx < m_vFirCpuFilter.size(); ++firIdx)
+	{
+		unsigned numBlockSamples = m_vNumBlockSamples[firIdx];
+		firCpuScheduler.addChain(m_vFirCpuFilter[firIdx].findNumFlopsPerSample() * numBlockSamples, IntUtils::ceilDiv(findNumInputSamples(firIdx), numBlockSamples));
+	}
+	firCpuScheduler.dealChains();
+
+	// (the blocks of a FIR run one after the other, so only one thread at a time updates its filter, Outputs and time)
+	chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+	vector<thread> vThread;
+	for (unsigned threadIdx = 0; threadIdx < firCpuScheduler.getNumThreads(); ++threadIdx)
+	{
+		vThread.push_back(thread([&, threadIdx]()
+		{
+			FirCpuScheduler::Task task;
+			while (firCpuScheduler.popTask(threadIdx, &task))
+			{
+				chrono::steady_clock::time_point blockStartTime = chrono::steady_clock::now();
+				filterBlock(task.m_ChainIdx, task.m_BlockIdx);
+				m_vFilterTime[task.m_ChainIdx] += chrono::duration<double>(chrono::steady_clock::now() - blockStartTime).count();
+				firCpuScheduler.finishTask(threadIdx, task);
+			}
+		}));
+	}
+	for (unsigned i = 0; i < vThread.size(); ++i)
+		vThread[i].join();
+	m_RunTime = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+	m_NumStolenTasks = 0;
+	for (unsigned threadIdx = 0; threadIdx < firCpuScheduler.getNumThreads(); ++threadIdx)
+		m_NumStolenTasks += firCpuScheduler.getNumTasksStolen(threadIdx);
+}
+
+void FirEngineCpu::establishPeakDirectDifference(unsigned firIdx)
+{
+	// The Outputs of the first block's samples (or fewer) filtered again, directly
+	FirCpuFilter directFirCpuFilter;
+	directFirCpuFilter.init(m_FirEngineSpec, firIdx);
+	unsigned numSamples = min(findNumInputSamples(firIdx), s_NumBlockSamples);
+	const float* pSample = &m_vvFloatBlockSample[findInputFirIndex(firIdx)][0];
+	const float* pImagSample = directFirCpuFilter.hasImagCoeffs() ? &m_vvFloatBlockSample[findImagInputFirIndex(firIdx)][0] : NULL;
+	vector<float> vDirectOutputSample;
+	if (numSamples > 0)
+		directFirCpuFilter.filterBlock(pSample, pImagSample, numSamples, &vDirectOutputSample);
+
+	m_vPeakDirectDifference[firIdx] = 0.0;
+	for (unsigned i = 0; i < vDirectOutputSample.size(); ++i)
+		m_vPeakDirectDifference[firIdx] = max(m_vPeakDirectDifference[firIdx], fabs(ldexp(double(m_vvFloatOutputSample[firIdx][i] - vDirectOutputSample[i]), 16)));
+}
+
+void FirEngineCpu::establishBlockSamples()
+{
+	// Floating-point samples in full-scale units (2^16 LSBs)
+	for (unsigned firIdx = 0; firIdx < m_vvInputSample.size(); ++firIdx)
+	{
+		const vector<int>& vSample = m_vvInputSample[firIdx];
+		m_vNumInputSamples[firIdx] = vSample.size();
+		m_vvBlockSample[firIdx].clear();
+		m_vvFloatBlockSample[firIdx].clear();
+		if (m_Arithmetic == Arithmetic_Fixed)
+			m_vvBlockSample[firIdx].assign(vSample.begin(), vSample.end());
+		else for (unsigned i = 0; i < vSample.size(); ++i)
+			m_vvFloatBlockSample[firIdx].push_back(float(ldexp(double(vSample[i]), -16)));
+	}
+}
+
+void FirEngineCpu::filterBlock(unsigned firIdx, unsigned blockIdx)
+{
+	FirCpuFilter& firCpuFilter = m_vFirCpuFilter[firIdx];
+	unsigned inputFirIdx = findInputFirIndex(firIdx);
+	unsigned imagInputFirIdx = firCpuFilter.hasImagCoeffs() ? findImagInputFirIndex(firIdx) : inputFirIdx;
+	assert(m_vNumInputSamples[imagInputFirIdx] == m_vNumInputSamples[inputFirIdx]);
+	unsigned sampleIdx = blockIdx * m_vNumBlockSamples[firIdx];
+	unsigned numSamples = min(findNumInputSamples(firIdx) - sampleIdx, m_vNumBlockSamples[firIdx]);
+	if (m_pInputFile)
+		filterStreamBlock(firIdx, sampleIdx, numSamples);
+	else if (m_Arithmetic == Arithmetic_Fixed)
+	{
+		const int32_t* pImagSample = firCpuFilter.hasImagCoeffs() ? &m_vvBlockSample[imagInputFirIdx][sampleIdx] : NULL;
+		firCpuFilter.filterBlock(&m_vvBlockSample[inputFirIdx][sampleIdx], pImagSample, numSamples, &m_vvOutputSample[firIdx]);
+	}
+	else
+	{
+		const float* pImagSample = firCpuFilter.hasImagCoeffs() ? &m_vvFloatBlockSample[imagInputFirIdx][sampleIdx] : NULL;
+		firCpuFilter.filterBlock(&m_vvFloatBlockSample[inputFirIdx][sampleIdx], pImagSample, numSamples, &m_vvFloatOutputSample[firIdx]);
+	}
+}
+
+void FirEngineCpu::filterStreamBlock(unsigned firIdx, unsigned sampleIdx, unsigned numSamples)
+{
+	FirCpuFilter& firCpuFilter = m_vFirCpuFilter[firIdx];
+	unsigned vChannelIdx[2];
+	vChannelIdx[0] = m_vInputChannelIdx[findInputFirIndex(firIdx)];
+	vChannelIdx[1] = firCpuFilter.hasImagCoeffs() ? m_vInputChannelIdx[findImagInputFirIndex(firIdx)] : vChannelIdx[0];
+	unsigned numParts = firCpuFilter.hasImagCoeffs() ? 2 : 1;
+
+	// The next block is read ahead while this one is filtered
+	for (unsigned part = 0; part < numParts; ++part)
+		m_pInputFile->willNeedSamples(vChannelIdx[part], sampleIdx + numSamples, m_vNumBlockSamples[firIdx]);
+
+	// The mapped samples are filtered where they are if of the Arithmetic, otherwise converted a block at a time
+	//   (the float samples rounded to the nearest LSB, as the Outputs of the floating-point arithmetic)
+	bool isFixedInput = (m_pInputFile->getFormat() == FirSampleFile::Format_Fixed);
+	uint64_t outputSampleIdx = m_vNumOutputSamples[firIdx];
+	unsigned numOutputSamples;
+	if (m_Arithmetic == Arithmetic_Fixed)
+	{
+		const int32_t* vpSample[2] = { NULL, NULL };
+		for (unsigned part = 0; part < numParts; ++part)
+		{
+			if (isFixedInput)
+				vpSample[part] = m_pInputFile->getFixedSamples(vChannelIdx[part]) + sampleIdx;
+			else
+			{
+				const float* pFloatSample = m_pInputFile->getFloatSamples(vChannelIdx[part]) + sampleIdx;
+				vector<int32_t>& vSample = m_vvStreamSample[part][firIdx];
+				vSample.resize(numSamples);
+				for (unsigned i = 0; i < numSamples; ++i)
+					vSample[i] = int32_t(floor(ldexp(double(pFloatSample[i]), 16) + 0.5));
+				vpSample[part] = &vSample[0];
+			}
+		}
+		vector<int>& vOutputSample = m_vvStreamOutputSample[firIdx];
+		vOutputSample.clear();
+		firCpuFilter.filterBlock(vpSample[0], vpSample[1], numSamples, &vOutputSample);
+		numOutputSamples = vOutputSample.size();
+		if (numOutputSamples > 0)
+			copy(vOutputSample.begin(), vOutputSample.end(), m_pOutputFile->getFixedSamples(firIdx) + outputSampleIdx);
+	}
+	else
+	{
+		const float* vpSample[2] = { NULL, NULL };
+		for (unsigned part = 0; part < numParts; ++part)
+		{
+			if (!isFixedInput)
+				vpSample[part] = m_pInputFile->getFloatSamples(vChannelIdx[part]) + sampleIdx;
+			else
+			{
+				const int32_t* pFixedSample = m_pInputFile->getFixedSamples(vChannelIdx[part]) + sampleIdx;
+				vector<float>& vSample = m_vvFloatStreamSample[part][firIdx];
+				vSample.resize(numSamples);
+				for (unsigned i = 0; i < numSamples; ++i)
+					vSample[i] = float(ldexp(double(pFixedSample[i]), -16));
+				vpSample[part] = &vSample[0];
+			}
+		}
+		vector<float>& vOutputSample = m_vvFloatStreamOutputSample[firIdx];
+		vOutputSample.clear();
+		firCpuFilter.filterBlock(vpSample[0], vpSample[1], numSamples, &vOutputSample);
+		numOutputSamples = vOutputSample.size();
+		if (numOutputSamples > 0)
+			copy(vOutputSample.begin(), vOutputSample.end(), m_pOutputFile->getFloatSamples(firIdx) + outputSampleIdx);
+	}
+	m_vNumOutputSamples[firIdx] += numOutputSamples;
+
+	// The Outputs written, and the samples filtered, are done with (other FIRs filtering the same Input fault them back in)
+	m_pOutputFile->releaseSamples(firIdx, outputSampleIdx, numOutputSamples);
+	for (unsigned part = 0; part < numParts; ++part)
+		m_pInputFile->releaseSamples(vChannelIdx[part], sampleIdx, numSamples);
+}
+
+double FirEngineCpu::findThroughput(unsigned firIdx) const
+{
+	if (m_vFilterTime[firIdx] <= 0.0)
+		return 0.0;
+	return double(findNumInputSamples(firIdx)) / m_vFilterTime[firIdx] / 1e6;
+}
+
+double FirEngineCpu::findTotalThroughput() const
+{
+	double numInputSamples = 0.0;
+	double filterTime = 0.0;
+	for (unsigned firIdx = 0; firIdx < m_vFilterTime.size(); ++firIdx)
+	{
+		numInputSamples += double(findNumInputSamples(firIdx));
+		filterTime += m_vFilterTime[firIdx];
+	}
+	if (filterTime <= 0.0)
+		return 0.0;
+	return numInputSamples / filterTime / 1e6;
+}
+
+double FirEngineCpu::findParallelThroughput() const
+{
+	double numInputSamples = 0.0;
+	for (unsigned firIdx = 0; firIdx < m_vFilterTime.size(); ++firIdx)
+		numInputSamples += double(findNumInputSamples(firIdx));
+	if (m_RunTime <= 0.0)
+		return 0.0;
+	return numInputSamples / m_RunTime / 1e6;
+}
+
+double FirEngineCpu::findLoad(unsigned firIdx) const
+{
+	return m_vFirCpuFilter[firIdx].findNumMacsPerSample() * m_FirEngineSpec.m_vFirSpec[firIdx].m_SampleFreq / 1e6;
+}
+
+void FirEngineCpu::writeToFile(ostream& stream) const
+{
+	stream << "# Output samples (2.16) of each FIR, filtered on the CPU (" << ((m_Arithmetic == Arithmetic_Fixed) ? "fixed" : "floating") << " point)\n";
+	for (unsigned firIdx = 0; firIdx < m_vvOutputSample.size(); ++firIdx)
+	{
+		stream << "FIR[" << firIdx << "].output = [ ";
+		for (unsigned i = 0; i < m_vvOutputSample[firIdx].size(); ++i)
+			stream << ((i > 0) ? ", " : "") << m_vvOutputSample[firIdx][i];
+		stream << " ];\n";
+	}
+}
+
+void FirEngineCpu::generateHtmlReport(ostream& stream, const FirEngineReference* pFirEngineReference) const
+{
+	bool isFixed = (m_Arithmetic == Arithmetic_Fixed);
+	bool isOverlapSaved = false;
+	for (unsigned firIdx = 0; firIdx < m_vFirCpuFilter.size(); ++firIdx)
+	{
+		if (m_vFirCpuFilter[firIdx].getAlgorithm() == FirCpuFilter::Algorithm_OverlapSave)
+			isOverlapSaved = true;
+	}
+	bool isDirectCompared = isOverlapSaved && !m_IsStreamed;
+	if (m_IsStreamed)
+		pFirEngineReference = NULL;
+
+	stream << "<h2>FirEngine on the CPU</h2>\n";
+	stream << "<table class=\"t1\">\n";
+	stream << "<tr><th>Arithmetic</th><td>" << (isFixed ? "fixed point" : "floating point") << "</td></tr>\n";
+	stream << "<tr><th>NumBlockSamples</th><td>" << s_NumBlockSamples << ((isOverlapSaved) ? " (whole pairs of FFT segments by overlap-save)" : "") << "</td></tr>\n";
+	stream << "<tr><th>InputThroughput</th><td>" << findTotalThroughput() << " MSamples/s per core</td></tr>\n";
+	stream << "<tr><th>NumThreads</th><td>" << m_NumThreads << "</td></tr>\n";
+	stream << "<tr><th>ParallelInputThroughput</th><td>" << findParallelThroughput() << " MSamples/s</td></tr>\n";
+	stream << "<tr><th>NumStolenTasks</th><td>" << m_NumStolenTasks << "</td></tr>\n";
+	stream << "</table>\n\n";
+
+	// The reference's Outputs (for the Input samples both were given) should be those of the fixed-point arithmetic
+	//   and differ from those of the floating-point arithmetic by no more than the quantization error
+	//   overlap-save's Outputs should differ from the direct form's by no more than MaxDirectDifference
+	stream << "<table class=\"t1\">\n";
+	stream << "<tr><th>Fir#</th><th>NumInputSamples</th><th>NumOutputSamples</th><th>MacsPerSample</th><th>Load</th><th>Algorithm</th><th>Throughput</th>";
+	if (isDirectCompared)
+		stream << "<th>PeakDirectDifference</th>";
+	if (pFirEngineReference)
+		stream << (isFixed ? "<th>ReferenceMatches</th>" : "<th>PeakReferenceDifference</th>");
+	stream << "</tr>\n";
+	for (unsigned firIdx = 0; firIdx < m_vvOutputSample.size(); ++firIdx)
+	{
+		const vector<int>& vOutputSample = m_vvOutputSample[firIdx];
+		stream << "<tr><td>" << m_FirEngineSpec.getChannelName(firIdx) << "</td><td>" << findNumInputSamples(firIdx) << "</td><td>" << m_vNumOutputSamples[firIdx]
+			<< "</td><td>" << m_vFirCpuFilter[firIdx].findNumMacsPerSample() << "</td><td>" << findLoad(firIdx) << " MMacs/s</td><td>" << m_vFirCpuFilter[firIdx].getAlgorithmName() << "</td><td>" << findThroughput(firIdx) << " MSamples/s</td>";
+		if (isDirectCompared)
+		{
+			if (m_vFirCpuFilter[firIdx].getAlgorithm() == FirCpuFilter::Algorithm_Direct)
+				stream << "<td></td>";
+			else
+				stream << "<td>" << m_vPeakDirectDifference[firIdx] << " LSBs" << ((m_vPeakDirectDifference[firIdx] > s_MaxDirectDifference) ? " (exceeds the tolerance)" : "") << "</td>";
+		}
+		if (pFirEngineReference)
+		{
+			const vector<int>& vRefOutputSample = pFirEngineReference->getOutputSamples(firIdx);
+			unsigned numCompared = min(vOutputSample.size(), vRefOutputSample.size());
+			if (isFixed)
+			{
+				unsigned numMatching = 0;
+				for (unsigned i = 0; i < numCompared; ++i)
+				{
+					if (vOutputSample[i] == vRefOutputSample[i])
+						++numMatching;
+				}
+				stream << "<td>" << numMatching << " of " << numCompared << "</td>";
+			}
+			else
+			{
+				double peakDifference = 0.0;
+				for (unsigned i = 0; i < numCompared; ++i)
+					peakDifference = max(peakDifference, fabs(ldexp(double(m_vvFloatOutputSample[firIdx][i]), 16) - double(vRefOutputSample[i])));
+				stream << "<td>" << peakDifference << " LSBs</td>";
+			}
+		}
+		stream << "</tr>\n";
+	}
+	stream << "</table>\n\n";
+}
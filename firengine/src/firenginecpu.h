@@ -0,0 +1,121 @@
+#ifndef FIRENGINECPU_H
+#define FIRENGINECPU_H
+
+
+#include <vector>
+#include <ostream>
+#include "firenginespec.h"
+#include "firenginereference.h"
+#include "fircpufilter.h"
+#include "firsamplefile.h"
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// A FirEngine run in software: every FIR of a FirEngineSpec
+///   is filtered on the CPU (see FirCpuFilter), a block of its
+///   Input samples at a time, so that the same specification
+///   can be deployed where there is no FPGA
+///   The fixed-point arithmetic gives the Outputs of the
+///   FirMacs (as FirEngineReference), the floating-point
+///   arithmetic those of the Coefficients as specified
+///   The blocks are filtered by a pool of threads (see
+///   FirCpuScheduler), and the time spent filtering each FIR
+///   is measured, giving its throughput on one core
+///   The samples can instead be streamed from a sample file to
+///   another (see FirSampleFile), a block at a time through
+///   their mappings, so that recordings larger than the memory
+///   are filtered
+/////////////////////////////////////////////////////////////
+
+class FirEngineCpu
+{
+public:
+	enum Arithmetic
+	{
+		Arithmetic_Fixed,			///< 2.16 samples, Coefficient words and 48-bit accumulation (as the FirMacs)
+		Arithmetic_Float			///< single precision samples and Coefficients
+	};
+	/// The FirEngineSpec's Coefficients must have been quantized (numThreads 0 for one per core)
+	///   in floating point, long FIRs are filtered by overlap-save with FFT segments that arrive within maxLatency seconds (0 for no limit)
+	FirEngineCpu(const FirEngineSpec&, Arithmetic, unsigned numThreads, double maxLatency);
+public:
+	/// Samples on the Input of a FIR (FIRs without an Input of their own, see FirSpec::hasOwnInput, take none)
+	void setInputSamples(unsigned firIdx, const vector<int>& vSample);
+	/// Filter every FIR's Input samples
+	void run();
+	/// Filter the channels of a sample file (one for each FIR with an Input of its own, in order) into a sample file of
+	///   each FIR's Outputs (in the Format of the Arithmetic), a block at a time (throws if the channels do not match the FIRs)
+	void runStream(const FirSampleFile& inputFile, const string& outputFname);
+public:
+	Arithmetic getArithmetic() const								{ return m_Arithmetic; }
+	/// Output samples (2.16) of a FIR (those of the floating-point arithmetic rounded to the nearest)
+	const vector<int>& getOutputSamples(unsigned firIdx) const		{ return m_vvOutputSample[firIdx]; }
+	/// Input samples filtered per second (in millions) by one core, for a FIR and for all the FIRs
+	double findThroughput(unsigned firIdx) const;
+	double findTotalThroughput() const;
+	/// Input samples filtered per second (in millions) by all the threads
+	double findParallelThroughput() const;
+	/// Products per second (in millions) a FIR takes at its SampleFreq (the weight of its blocks, relative to the other FIRs)
+	double findLoad(unsigned firIdx) const;
+	/// Write the Output samples of every FIR, in the syntax of a FirEngine-Specification
+	void writeToFile(ostream&) const;
+	/// The Outputs are compared with those of the reference (when not null) for the Input samples both were given (not when streamed)
+	void generateHtmlReport(ostream&, const FirEngineReference* pFirEngineReference) const;
+private:
+	/// FIR whose Input samples a FIR filters (with its Coefficients, or with the imaginary Coefficients of a complex FIR)
+	unsigned findInputFirIndex(unsigned firIdx) const;
+	unsigned findImagInputFirIndex(unsigned firIdx) const;
+	/// Input samples of every FIR in the words of the Arithmetic
+	void establishBlockSamples();
+	/// Peak difference of overlap-save's Outputs from those of the direct form (for the first block's samples)
+	void establishPeakDirectDifference(unsigned firIdx);
+	/// Filter the blocks of every FIR's Input samples on the pool of threads
+	void runBlocks();
+	/// Filter a FIR's blockIdx-th block of Input samples (its earlier blocks must have been filtered)
+	void filterBlock(unsigned firIdx, unsigned blockIdx);
+	/// Filter a block of a FIR's Input samples from the input file into its channel of the output file
+	void filterStreamBlock(unsigned firIdx, unsigned sampleIdx, unsigned numSamples);
+	/// Number of Input samples filtered by a FIR
+	unsigned findNumInputSamples(unsigned firIdx) const;
+private:
+	/// Input samples filtered by each call of FirCpuFilter::filterBlock (at least, see FirCpuFilter::findNumBlockSamples)
+	static const unsigned		s_NumBlockSamples = 4096;
+	const FirEngineSpec&		m_FirEngineSpec;
+	Arithmetic					m_Arithmetic;
+	unsigned					m_NumThreads;
+	vector<FirCpuFilter>		m_vFirCpuFilter;
+	/// Input samples of each FIR
+	vector<vector<int> >		m_vvInputSample;
+	vector<vector<int32_t> >	m_vvBlockSample;
+	vector<vector<float> >		m_vvFloatBlockSample;
+	/// Output samples of each FIR (and, for the floating-point arithmetic, as computed)
+	vector<vector<int> >		m_vvOutputSample;
+	vector<vector<float> >		m_vvFloatOutputSample;
+	/// Input samples of each FIR's blocks
+	vector<unsigned>			m_vNumBlockSamples;
+	/// LSBs by which each FIR's Outputs differ from those of the direct form (by overlap-save, see establishPeakDirectDifference)
+	vector<double>				m_vPeakDirectDifference;
+	/// Seconds spent filtering each FIR
+	vector<double>				m_vFilterTime;
+	/// Seconds spent filtering all the FIRs (by all the threads), and the tasks a thread stole from another
+	double						m_RunTime;
+	unsigned					m_NumStolenTasks;
+	/// Input samples of each FIR (of its channel, when streaming), and its Output samples (those written to the output file)
+	vector<unsigned>			m_vNumInputSamples;
+	vector<unsigned>			m_vNumOutputSamples;
+	/// The samples were streamed (so the Outputs are in the output file, and are not compared with the direct form)
+	bool						m_IsStreamed;
+	/// Files streamed from and to (NULL unless in runStream), and the input channel of each FIR with an Input of its own
+	const FirSampleFile*		m_pInputFile;
+	FirSampleFile*				m_pOutputFile;
+	vector<unsigned>			m_vInputChannelIdx;
+	/// Samples of each FIR's block (converted when the input file's Format is not that of the Arithmetic), and its Outputs
+	vector<vector<int32_t> >	m_vvStreamSample[2];
+	vector<vector<float> >		m_vvFloatStreamSample[2];
+	vector<vector<int> >		m_vvStreamOutputSample;
+	vector<vector<float> >		m_vvFloatStreamOutputSample;
+};
+
+
+#endif
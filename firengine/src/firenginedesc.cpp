@@ -1,5 +1,6 @@
 
 #include <assert.h>
+#include <algorithm>
 #include "stringutil.h"
 #include "datetime.h"
 #include "firenginedesc.h"
@@ -7,18 +8,51 @@
 #include "firengineglobals.h"
 
 
-FirEngineDesc::FirEngineDesc(unsigned numTimeSlots) :
-	m_FirUpdateLatency		(2),
+FirEngineDesc::FirEngineDesc(unsigned numTimeSlots, bool isPackedFifos) :
+	m_FirUpdateLatency		(3),
+	m_FifoOffsetLatency		(2),
+	m_FifoDescLatency		(6),
+	m_ChainAccumLatency		(2),
+	m_OutputLatency			(10),
+	m_MaxFifoDepth			(1 << 12),
 	m_NumTimeSlots			(numTimeSlots),
+	m_IsPackedFifos			(isPackedFifos),
 	m_NumFirs				(0),
-	m_vFirEngineMacDesc		()
+	m_LowerBoundNumFirMacs	(0),
+	m_BinderName			("First-fit"),
+	m_vFirEngineMacDesc		(),
+	m_vFirBinding			()
 {
 }
 
-void FirEngineDesc::generateRtl(const string& firEngineName, const FirEngineSpec& firEngineSpec) const
+bool FirEngineDesc::hasInput(unsigned firIdx) const
+{
+	for (unsigned firMacIdx = 0; firMacIdx < m_vFirEngineMacDesc.size(); ++firMacIdx)
+	{
+		const vector<unsigned>& vInputFirs = m_vFirEngineMacDesc[firMacIdx].m_vInputFirs;
+		if (find(vInputFirs.begin(), vInputFirs.end(), firIdx) != vInputFirs.end())
+			return true;
+	}
+	return false;
+}
+
+unsigned FirEngineDesc::getWorstCaseLatency() const
+{
+	unsigned worstCaseLatency = 0;
+	for (unsigned i = 0; i < m_vFirBinding.size(); ++i)
+	{
+		const FirBinding& firBinding = m_vFirBinding[i];
+		// (the end of a chain whose sections read their data an Update apart commits that many Updates late)
+		unsigned chainLatency = firBinding.getNumCommitDelays() * firBinding.m_TimeSliceInterval;
+		worstCaseLatency = max(worstCaseLatency, firBinding.m_TimeSliceInterval + firBinding.getOutputTimeSliceInterval() + chainLatency + m_OutputLatency);
+	}
+	return worstCaseLatency;
+}
+
+unsigned FirEngineDesc::generateRtl(const FirEngineSpec& firEngineSpec, const string& firEngineName) const
 {
 	// Generate top-level
-	ofstream fStream(firEngineName + ".v");
+	ostringstream fStream;
 
 	fStream << "`timescale 1ns / 1ps\n";
 	fStream << "//////////////////////////////////////////////////////////////////////////////////\n";
@@ -37,10 +71,12 @@ void FirEngineDesc::generateRtl(const string& firEngineName, const FirEngineSpec
 
 	fStream << "\t// Each Channel has a seperate (data-input, data-changed) pair\n";
 	fStream << "\t//   Data-Changed is flipped every time a new sample arrives\n";
-	for (unsigned i = 0; i < m_NumFirs; ++i)
+	fStream << "\t//   (FIRs sharing the Input of another FIR, as a filter bank, have no Input of their own)\n";
+	fStream << "\t//   (a complex FIR n takes the quadrature parts on Channel nQ, flipping both Data-Changed together)\n";
+	for (unsigned i = 0; i < m_NumFirs; ++i) if (hasInput(i))
 	{
-		fStream << "\tinput             iData" << i << "Changed,\n";
-		fStream << "\tinput [17:0]      iData" << i << ",\n";
+		fStream << "\tinput             iData" << firEngineSpec.getChannelName(i) << "Changed,\n";
+		fStream << "\tinput [17:0]      iData" << firEngineSpec.getChannelName(i) << ",\n";
 	}
 	fStream << "\n";
 
@@ -48,8 +84,8 @@ void FirEngineDesc::generateRtl(const string& firEngineName, const FirEngineSpec
     fStream << "\t//   Data-Changed is flipped every time a new sample appears\n";
 	for (unsigned i = 0; i < m_NumFirs; ++i)
 	{
-		fStream << "\toutput          				oData" << i << "Changed,\n";
-		fStream << "\toutput [17:0]	   		 		oData" << i << ",\n";
+		fStream << "\toutput          				oData" << firEngineSpec.getChannelName(i) << "Changed,\n";
+		fStream << "\toutput [17:0]	   		 		oData" << firEngineSpec.getChannelName(i) << ",\n";
 	}
 	fStream << "\n";
 
@@ -91,13 +127,13 @@ void FirEngineDesc::generateRtl(const string& firEngineName, const FirEngineSpec
 		fStream << "\t.iRst			(iRst),\n";
 		for (unsigned i = 0; i < vInputFirs.size(); ++i)
 		{
-			fStream << "\t.iData" << i << "Changed	(iData" << vInputFirs[i] << "Changed),\n";
-			fStream << "\t.iData" << i << "			(iData" << vInputFirs[i] << "),\n";
+			fStream << "\t.iData" << i << "Changed	(iData" << firEngineSpec.getChannelName(vInputFirs[i]) << "Changed),\n";
+			fStream << "\t.iData" << i << "			(iData" << firEngineSpec.getChannelName(vInputFirs[i]) << "),\n";
 		}
 		for (unsigned i = 0; i < vOutputFirs.size(); ++i)
 		{
-			fStream << "\t.oData" << i << "Changed	(oData" << vOutputFirs[i] << "Changed),\n";
-			fStream << "\t.oData" << i << "			(oData" << vOutputFirs[i] << "),\n";
+			fStream << "\t.oData" << i << "Changed	(oData" << firEngineSpec.getChannelName(vOutputFirs[i]) << "Changed),\n";
+			fStream << "\t.oData" << i << "			(oData" << firEngineSpec.getChannelName(vOutputFirs[i]) << "),\n";
 		}
 		
 		// Chain MACs together
@@ -121,25 +157,86 @@ void FirEngineDesc::generateRtl(const string& firEngineName, const FirEngineSpec
 	
 	fStream << "endmodule\n";
 
+	writeFileIfChanged(firEngineName + ".v", fStream.str());
+
 	//////////////////////////////////////////////////////////
 	// Generate Sub-Modules
 	//////////////////////////////////////////////////////////
+	unsigned numChangedFirMacs = 0;
 	for (unsigned macIdx = 0; macIdx < m_vFirEngineMacDesc.size(); ++macIdx)
 	{
 		const FirEngineMacDesc& firEngineMacDesc = m_vFirEngineMacDesc[macIdx];
-		firEngineMacDesc.generateRtl(firEngineName + "_fir" + toString(macIdx), firEngineSpec);
+		if (firEngineMacDesc.generateRtl(firEngineName + "_fir" + toString(macIdx)))
+			++numChangedFirMacs;
 	}
+	return numChangedFirMacs;
 }
 
-void FirEngineDesc::generateHtmlReport(ostream& stream) const
+void FirEngineDesc::generateHtmlReport(ostream& stream, const FirEngineSpec& firEngineSpec) const
 {
 	stream << "<h2>FirEngine Description</h2>\n";
 
 	stream << "<table class=\"t1\">\n";
-	stream << "<tr><th>Fir#</th><th>Colour</th></tr>\n";
+	stream << "<tr><th>Binder</th><td>" << m_BinderName << "</td></tr>\n";
+	stream << "<tr><th>NumFirMacs</th><td>" << m_vFirEngineMacDesc.size() << "</td></tr>\n";
+	stream << "<tr><th>NumFifoMemWords</th><td>" << getNumFifoMemWords() << "</td></tr>\n";
+	stream << "<tr><th>NumBram36</th><td>" << getNumBram36() << "</td></tr>\n";
+	stream << "<tr><th>NumBram18</th><td>" << getNumBram18() << "</td></tr>\n";
+	stream << "<tr><th>WorstCaseLatency</th><td>" << getWorstCaseLatency() << " cycles</td></tr>\n";
+	stream << "<tr><th>LowerBoundNumFirMacs</th><td>" << m_LowerBoundNumFirMacs << "</td></tr>\n";
+	stream << "<tr><th>Gap</th><td>" << (m_vFirEngineMacDesc.size() - m_LowerBoundNumFirMacs) << "</td></tr>\n";
+	stream << "</table>\n\n";
+
+	stream << "<table class=\"t1\">\n";
+	stream << "<tr><th>Fir#</th><th>Colour</th><th>FirMacs</th></tr>\n";
 	for (unsigned firIdx = 0; firIdx < m_NumFirs; ++firIdx)
 	{
-		stream << "<tr><td>" << firIdx << "</td><td  style=\"background: " << FirEngineGlobals::getHtmlRainbowColor(double(firIdx) / double(m_NumFirs)) << "\"></td></tr>\n";
+		stream << "<tr><td>" << firIdx << "</td><td  style=\"background: " << FirEngineGlobals::getHtmlRainbowColor(double(firIdx) / double(m_NumFirs)) << "\"></td><td>";
+
+		// List the chain of FirMacs computing this FIR
+		bool hasSections = false;
+		bool isFolded = false;
+		bool isFilterBank = false;
+		for (unsigned firMac = 0; firMac < m_vFirEngineMacDesc.size(); ++firMac)
+		{
+			const FirEngineMacDesc& firEngineMacDesc = m_vFirEngineMacDesc[firMac];
+			for (unsigned i = 0; i < firEngineMacDesc.getNumFifos(); ++i)
+			{
+				const FirEngineMacFifoDesc& firEngineMacFifoDesc = firEngineMacDesc.m_vFirEngineMacFifoDesc[i];
+				if ((firEngineMacFifoDesc.m_FirIndex != firIdx) && firEngineMacFifoDesc.isForFirIndex(firIdx))
+					stream << "FirMac" << firMac << " (filter bank of FIR " << firEngineMacFifoDesc.m_FirIndex << ")";
+				if (firEngineMacFifoDesc.m_FirIndex == firIdx)
+				{
+					hasSections = true;
+					isFolded |= (firEngineMacFifoDesc.m_PreAddMode != 0);
+					isFilterBank |= !firEngineMacFifoDesc.m_vBankFirIndex.empty();
+					if (!firEngineMacFifoDesc.m_IsFirstEngine)
+						stream << " &rarr; ";
+					stream << "FirMac" << firMac << " (" << firEngineMacFifoDesc.m_vFirCoeffRef.size() << " taps";
+					if (firEngineMacFifoDesc.m_PreAddMode == 1)
+						stream << ", symmetric";
+					else if (firEngineMacFifoDesc.m_PreAddMode == 2)
+						stream << ", antisymmetric";
+					if (firEngineMacFifoDesc.m_Interpolation > 1)
+						stream << ", " << firEngineMacFifoDesc.m_Interpolation << " phases";
+					if (!firEngineMacFifoDesc.m_vBankFirIndex.empty())
+						stream << ", filter bank of " << (firEngineMacFifoDesc.m_vBankFirIndex.size() + 1) << " FIRs";
+					if (firEngineMacFifoDesc.m_IsCrossTerm)
+						stream << ", cross terms";
+					stream << ")";
+				}
+			}
+		}
+
+		// A linear-phase FIR is only folded onto the pre-adder when it fits on a single FirMac, otherwise it is chained unfolded
+		const FirSpec& firSpec = firEngineSpec.m_vFirSpec[firIdx];
+		if (hasSections && !isFolded && !isFilterBank && (firSpec.m_Interpolation == 1) && !firSpec.hasImagCoeffs())
+		{
+			FirSpec::Symmetry symmetry = firSpec.findSymmetry();
+			if (symmetry != FirSpec::Symmetry_None)
+				stream << " (" << ((symmetry == FirSpec::Symmetry_Symmetric) ? "symmetric" : "antisymmetric") << " but not folded: too many taps for one FirMac)";
+		}
+		stream << "</td></tr>\n";
 	}
 	stream << "</table>\n\n";
 
@@ -174,6 +271,23 @@ void FirEngineDesc::generateHtmlReport(ostream& stream) const
 
 	///////////////////////////////////////////////////////////
 
+	stream << "<h2>FirMac Memory</h2>\n";
+	stream << "<table class=\"t1\">\n";
+	stream << "<tr><th>FirMac</th><th>NumFifos</th><th>WordsUsed</th><th>WordsAllocated</th><th>Utilization</th><th>CoeffWords</th><th>CoeffBanks</th><th>Bram36</th><th>Bram18</th></tr>\n";
+	for (unsigned firMac = 0; firMac < m_vFirEngineMacDesc.size(); ++firMac)
+	{
+		const FirEngineMacDesc& firEngineMacDesc = m_vFirEngineMacDesc[firMac];
+		unsigned numUsedWords = firEngineMacDesc.getNumUsedFifoMemWords();
+		unsigned numAllocatedWords = firEngineMacDesc.getBufferDepth();
+		stream << "<tr><td>FirMac" << firMac << "</td><td>" << firEngineMacDesc.getNumFifos() << "</td><td>" << numUsedWords << "</td><td>" << numAllocatedWords << "</td>";
+		stream << "<td>" << ((numAllocatedWords > 0) ? ((100 * numUsedWords) / numAllocatedWords) : 0) << "%</td>";
+		stream << "<td>" << firEngineMacDesc.getCoeffBufferDepth() << "</td><td>" << firEngineMacDesc.getNumCoeffBanks() << "</td>";
+		stream << "<td>" << firEngineMacDesc.getNumBram36() << "</td><td>" << firEngineMacDesc.getNumBram18() << "</td></tr>\n";
+	}
+	stream << "</table>\n\n";
+
+	///////////////////////////////////////////////////////////
+
 	stream << "<h2>Coefficient Address Map</h2>\n";
 	stream << "TODO";
 }
@@ -6,6 +6,10 @@
 #include "firenginespec.h"
 #include "firenginemacdesc.h"
 
+class FirExactBindSearch;		// forward declaration
+class FirBindHeuristic;			// forward declaration
+class FirEngineBindingFile;		// forward declaration
+
 
 /////////////////////////////////////////////////////////////////////////
 /// Describes a FirEngine block (which will implement a FirEngineSpec)
@@ -14,29 +18,111 @@
 class FirEngineDesc
 {
 public:
-	explicit FirEngineDesc(unsigned numTimeSlots);
+	FirEngineDesc(unsigned numTimeSlots, bool isPackedFifos);
 public:
 	/// Bind all FIRs to the firEngineDesc (creating new MACs as needed)
 	void bindFir(const FirEngineSpec&, unsigned firIdx);
+	/// Bind all FIRs using the fewest MACs (branch-and-bound over all FIRs, MACs and TimeSlice origins)
+	///   Stops after timeLimitSeconds, keeping the best binding found so far (at worst the first-fit binding)
+	void bindFirsExact(const FirEngineSpec&, double timeLimitSeconds);
+	/// Number of MACs needed to hold the Coefficient-slots of all FIRs (no binding can use fewer)
+	void establishLowerBoundNumFirMacs(const FirEngineSpec&);
+	/// Bind all FIRs with several heuristics (run concurrently on numThreads, 0 = all cores)
+	///   keeping the binding with the fewest MACs, then the fewest Block RAMs, then the fewest Fifo words
+	void bindFirsPortfolio(const FirEngineSpec&, unsigned numThreads);
+	unsigned getNumFifoMemWords() const;
+	/// Does a MAC take the FIR's Input (FIRs sharing the Input of another FIR have none)
+	bool hasInput(unsigned firIdx) const;
+	/// Most ClockCycles from an Input sample arriving to the first Output that includes it (over all FIRs)
+	///   (a sample waits up to a TimeSliceInterval for its Update, and is first used by the next Output, up to an OutputTimeSliceInterval later)
+	unsigned getWorstCaseLatency() const;
+	/// Block RAMs needed by the Coefficient and Data RAMs of all MACs
+	unsigned getNumBram36() const;
+	unsigned getNumBram18() const;
+	/// Bind all FIRs, keeping those unchanged since a previous binding on the same MACs and TimeSlots
+	///   (added or changed FIRs are then bound first-fit, and MACs left empty are removed)
+	void bindFirsIncremental(const FirEngineSpec&, const FirEngineBindingFile& prevFirEngineBindingFile);
+	void establishBindingFile(const FirEngineSpec&, FirEngineBindingFile* pOut) const;
 private:
-	FirBinding findValidBinding(const FirSpec&, unsigned firIndex, unsigned timeSliceInterval) const;
-	bool canBind(const FirSpec&, const FirBinding&) const;
-	void bind(const FirSpec&, const FirBinding&);
+	void establishBindHeuristics(const FirEngineSpec&, vector<FirBindHeuristic>* pOut) const;
+	void bindFirsWithHeuristic(const FirEngineSpec&, const FirBindHeuristic&);
+	/// Choose the binding that leaves the fewest free Coefficient-slots on the MACs it uses
+	FirBinding findBestFitBinding(const FirEngineSpec&, unsigned firIndex, unsigned timeSliceInterval) const;
+	/// Each FIR's updates are spaced by a TimeSliceInterval that (multiplied by the FIR's Decimation) evenly divides the NumTimeSlots
+	unsigned findTimeSliceInterval(const FirEngineSpec&, unsigned firIdx) const;
+	/// Number of Coefficient-slots (over all TimeSlots) needed by a FIR
+	unsigned findNumCoeffSlots(const vector<FirMacSection>&) const;
+	/// Number of Coefficient-slots not yet used in the existing MACs
+	unsigned findNumFreeCoeffSlots() const;
+	void searchExactBinding(const FirEngineSpec&, FirExactBindSearch&, unsigned depth) const;
+	/// Split a FIR into sections (one per FirMac in its chain) and place each section's taps relative to the Update TimeSlot
+	///   (zero taps, see FirSpec::m_ZeroThreshold, are given no TimeSlot)
+	///   (a FIR sharing the Input of another FIR has no sections, its taps are in the filter bank section of that FIR)
+	///   (as has the Quadrature FIR of a complex FIR, whose taps are in the second chain of the complex FIR's sections)
+	void establishFirMacSections(const FirEngineSpec&, unsigned firIdx, unsigned timeSliceInterval, vector<FirMacSection>* pOut) const;
+	/// Sections of a FIR filtering real samples (or either part of a complex FIR with real Coefficients)
+	void establishRealFirMacSections(const FirEngineSpec&, unsigned firIdx, unsigned timeSliceInterval, vector<FirMacSection>* pOut) const;
+	/// Lay out the complex products of a complex FIR with complex Coefficients: a chain per Output, each of a section on its own part of the Input and one adding the cross terms
+	///   (returns false if a product does not fit between Updates)
+	bool layoutComplexFirMacSections(const FirSpec&, unsigned timeSliceInterval, vector<FirMacSection>* pOut) const;
+	/// Lay out a FIR over a given number of FirMacs (returns false if a section's Fifo would be overwritten while it is being read)
+	bool layoutFirMacSections(const vector<unsigned>& vTapCoeffIndex, unsigned numFirMacs, unsigned timeSliceInterval, vector<FirMacSection>* pOut) const;
+	/// Occupancy of each section's Update/Read-slots and Coefficient-slots (for TimeSliceOrigin 0)
+	///   (Coefficient-slots only repeat every Decimation-th Update)
+	void establishFirMacSectionSlotMasks(unsigned timeSliceInterval, unsigned decimation, vector<FirMacSection>* pOut) const;
+	/// Lay out a (anti-)symmetric FIR folded onto a single FirMac (returns false if it does not fit)
+	bool layoutFoldedFirMacSection(const vector<unsigned>& vTapCoeffIndex, unsigned numCoeffs, FirSpec::Symmetry, unsigned timeSliceInterval, vector<FirMacSection>* pOut) const;
+	/// Lay out the polyphase sub-filters of an interpolating FIR on a single FirMac (returns false if they do not fit between Updates)
+	bool layoutPolyphaseFirMacSection(const vector<unsigned>& vTapCoeffIndex, unsigned numCoeffs, unsigned interpolation, unsigned timeSliceInterval, vector<FirMacSection>* pOut) const;
+	/// Lay out the FIRs sharing an Input (a filter bank) one after the other on a single FirMac, reading one Fifo (returns false if they do not fit between Updates)
+	bool layoutFilterBankFirMacSection(const FirEngineSpec&, const vector<unsigned>& vBankFirIndex, unsigned timeSliceInterval, vector<FirMacSection>* pOut) const;
+	/// Number of Fifo words needed to hold numEntries (rounded up to a power of 2, unless the Fifos are packed)
+	unsigned findNumFifoMemWords(unsigned numEntries) const;
+	FirBinding findValidBinding(const FirEngineSpec&, unsigned firIndex, unsigned timeSliceInterval) const;
+	/// Quick test: do the MACs of the chain have enough free Coefficient-slots (for any TimeSlice origin)
+	bool hasFreeCoeffSlots(const FirBinding&) const;
+	bool canBind(const FirBinding&) const;
+	void bind(const FirEngineSpec&, const FirBinding&);
+	void removeEmptyFirMacs();
 public:
-	void generateRtl(const string& firEngineName, const FirEngineSpec&) const;
+	/// returns the number of FirMac RTL files that changed (unchanged files are not rewritten)
+	unsigned generateRtl(const FirEngineSpec&, const string& firEngineName) const;
 public:
-	void generateHtmlReport(ostream&) const;
+	/// (the FirEngineSpec is that of the binding, so that the report can tell where a FIR is not bound as it could be)
+	void generateHtmlReport(ostream&, const FirEngineSpec&) const;
 public:
 	/// Number of ClockCycles between Fir-Read and Fir-Write in an Update-Cycle
 	///   (Note: a FirUpdate occurs on a Fir-write timeslot and no FirUpdates can occur on a Fir-Read timeslot)
 	const unsigned				m_FirUpdateLatency;
+	/// Number of ClockCycles after a FirUpdate before a first-tap sees the updated FifoOffset
+	///   (a first-tap any earlier than this computes on the data as it was before the FirUpdate)
+	const unsigned				m_FifoOffsetLatency;
+	/// Number of ClockCycles from the write-back of a FirUpdate's Fifo Description to the read of it ahead of the next FirUpdate of the Fifo
+	///   (it is read FirUpdateLatency ClockCycles ahead of a FirUpdate, without forwarding, and written back as many after it)
+	///   updates of a Fifo any closer than this would move on from a stale FifoOffset
+	const unsigned				m_FifoDescLatency;
+	/// Number of ClockCycles between the last tap of a section and the first tap of the next section in a chain
+	///   (the next FirEngine's ADDPREVENGINEACCUM uses the previous FirEngine's Accumulator from 2-cycles ago)
+	const unsigned				m_ChainAccumLatency;
+	/// Number of ClockCycles between the TimeSlot of a FIR's last tap and its Output (registered from dspout_ps9)
+	const unsigned				m_OutputLatency;
+	/// Largest number of Entries in a Fifo (a FirMac's FIFOSIZES fields are widened to fit its Fifos)
+	const unsigned				m_MaxFifoDepth;
 	/// This FirEngine will be divided into a number of timeslots of the global clock
 	const unsigned				m_NumTimeSlots;
+	/// Fifos take exactly the words they need, instead of a power of 2 (see FirEngineMacDesc::m_IsPackedFifos)
+	const bool					m_IsPackedFifos;
 public:
 	/// Keep track of the number of FIRs mapped to this FirEngine
 	unsigned					m_NumFirs;
+	/// Lower bound on the number of MACs (from the total Coefficient-slot load)
+	unsigned					m_LowerBoundNumFirMacs;
+	/// How the binding was found (for the report)
+	string						m_BinderName;
 	/// Describe each MAC-block's assignments
 	vector<FirEngineMacDesc>	m_vFirEngineMacDesc;
+	/// Bindings made, in the order they were made (persisted for incremental rebinding)
+	vector<FirBinding>			m_vFirBinding;
 };
 
 
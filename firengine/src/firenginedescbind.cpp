@@ -1,121 +1,636 @@
 
 #include <assert.h>
+#include <algorithm>
 #include "intutils.h"
+#include "stringutil.h"
 #include "firenginedesc.h"
 #include "firenginespec.h"
 #include "firengineglobals.h"
 #include "firbinding.h"
 
 
-bool FirEngineDesc::canBind(const FirSpec& firSpec, const FirBinding& firBinding) const
+void FirEngineDesc::establishFirMacSections(const FirEngineSpec& firEngineSpec, unsigned firIdx, unsigned timeSliceInterval, vector<FirMacSection>* pvFirMacSection) const
 {
-	if (firBinding.m_FirstFirMacIndex >= m_vFirEngineMacDesc.size())
-		return true;
+	const FirSpec& firSpec = firEngineSpec.m_vFirSpec[firIdx];
 
-	const FirEngineMacDesc& firEngineMacDesc = m_vFirEngineMacDesc[firBinding.m_FirstFirMacIndex];
+	// The quadrature parts of a complex FIR are computed by the sections of its in-phase FIR (bound with the taps of both)
+	if (firSpec.isQuadrature())
+	{
+		pvFirMacSection->clear();
+		return;
+	}
+	if (firSpec.m_IsComplex)
+	{
+		vector<unsigned> vBankFirIndex;
+		firEngineSpec.establishFilterBankFirs(firIdx, &vBankFirIndex);
+		if (vBankFirIndex.size() > 1)
+			throw string("A complex FIR can not share its Input with other FIRs");
+		if (firSpec.hasImagCoeffs())
+		{
+			if ((firSpec.m_Decimation > 1) || (firSpec.m_Interpolation > 1))
+				throw string("A complex FIR with complex coefficients can neither decimate nor interpolate");
+			if (!layoutComplexFirMacSections(firSpec, timeSliceInterval, pvFirMacSection))
+				throw string("Unable to fit complex FIR: sample rate too high for the number of coefficients");
 
-	// Constraint: number of Inputs to a MAC is limited to 15
-	if (firEngineMacDesc.m_vInputFirs.size() == 15)
-		return false;
-	// Constraint: number of Outputs to a MAC is limited to 15
-	if (firEngineMacDesc.m_vOutputFirs.size() == 15)
-		return false;
-	// Constraint: number of Fifos attached a MAC is limited to 256
-	if (firEngineMacDesc.getNumFifos() == 256)
-		return false;
+			establishFirMacSectionSlotMasks(timeSliceInterval, 1, pvFirMacSection);
+			return;
+		}
+	}
+
+	establishRealFirMacSections(firEngineSpec, firIdx, timeSliceInterval, pvFirMacSection);
 
-	// Check that UpdateSlots are available
-	unsigned timeSliceOffset;
-	for (timeSliceOffset = firBinding.m_TimeSliceOrigin; timeSliceOffset < m_NumTimeSlots; timeSliceOffset += firBinding.m_TimeSliceInterval)
+	// A complex FIR with real Coefficients filters the quadrature parts with a copy of the same chain, on the FirMacs that follow
+	//   (every section Updates on the same TimeSlots, so the two Outputs are aligned)
+	if (firSpec.m_IsComplex)
 	{
-		if (!firEngineMacDesc.m_vFirUpdateSlot[timeSliceOffset].isSlotEmpty())
-			return false;
-		
-		// Constraint: UpdateSlot must be free for 'Read' too
-		unsigned readTimeSliceOffset = IntUtils::modulo(timeSliceOffset - m_FirUpdateLatency, m_NumTimeSlots);
-		if (!firEngineMacDesc.m_vFirUpdateSlot[readTimeSliceOffset].isSlotEmpty())
-			return false;
+		unsigned numSections = pvFirMacSection->size();
+		for (unsigned i = 0; i < numSections; ++i)
+		{
+			FirMacSection firMacSection = (*pvFirMacSection)[i];
+			firMacSection.m_IsQuadratureData = true;
+			firMacSection.m_IsQuadratureOutput = true;
+			firMacSection.m_IsChainStart = (i == 0);
+			pvFirMacSection->push_back(firMacSection);
+		}
 	}
+}
+
+void FirEngineDesc::establishRealFirMacSections(const FirEngineSpec& firEngineSpec, unsigned firIdx, unsigned timeSliceInterval, vector<FirMacSection>* pvFirMacSection) const
+{
+	const FirSpec& firSpec = firEngineSpec.m_vFirSpec[firIdx];
+	unsigned numCoeffs = firSpec.m_vCoeff.size();
 
-	for (timeSliceOffset = firBinding.m_TimeSliceOrigin; timeSliceOffset < m_NumTimeSlots; timeSliceOffset += firBinding.m_TimeSliceInterval)
+	// FIRs filtering the same Input are computed together (as a filter bank) on a single FirMac
+	//   the FIR whose Input is shared is bound with the taps of the whole bank, the others with none
+	if (!firSpec.hasOwnInput())
+	{
+		if (firSpec.m_InputFirIndex >= firEngineSpec.m_vFirSpec.size())
+			throw string("FIR[") + toString(firIdx) + "].input is not a FIR";
+		if (!firEngineSpec.m_vFirSpec[firSpec.m_InputFirIndex].hasOwnInput())
+			throw string("FIR[") + toString(firIdx) + "].input must be a FIR with its own Input";
+		if (firEngineSpec.m_vFirSpec[firSpec.m_InputFirIndex].m_IsComplex)
+			throw string("FIR[") + toString(firIdx) + "].input can not be a complex FIR";
+		pvFirMacSection->clear();
+		return;
+	}
+	vector<unsigned> vBankFirIndex;
+	firEngineSpec.establishFilterBankFirs(firIdx, &vBankFirIndex);
+	if (vBankFirIndex.size() > 1)
 	{
-		// all slots needed for Coefficients leading up to (and including) timeSliceOffset must be Empty
-		for (unsigned i = 0; i < firSpec.m_vCoeff.size(); ++i)
+		if (!layoutFilterBankFirMacSection(firEngineSpec, vBankFirIndex, timeSliceInterval, pvFirMacSection))
+			throw string("Unable to fit filter bank on one FirMac: sample rate too high for the number of coefficients");
+
+		establishFirMacSectionSlotMasks(timeSliceInterval, 1, pvFirMacSection);
+		return;
+	}
+
+	// Zero taps are left out of the sections (but not out of their Fifos)
+	vector<unsigned> vTapCoeffIndex;
+	firSpec.establishTapCoeffIndices(&vTapCoeffIndex);
+	if (vTapCoeffIndex.empty())
+		throw string("FIR has no coefficients larger than its zeroThreshold");
+	unsigned numTaps = vTapCoeffIndex.size();
+
+	// A decimating FIR only computes every Decimation-th Output, so its taps may be spread over all the Updates in between
+	unsigned outputTimeSliceInterval = timeSliceInterval * firSpec.m_Decimation;
+
+	bool isLaidOut = false;
+
+	// Interpolating FIRs compute all their phases on a single FirMac
+	if (firSpec.m_Interpolation > 1)
+	{
+		if (firSpec.m_Decimation > 1)
+			throw string("A FIR can not both decimate and interpolate");
+		if (numCoeffs < (2 * firSpec.m_Interpolation))
+			throw string("Interpolating FIR needs at least two coefficients per phase");
+		if (!layoutPolyphaseFirMacSection(vTapCoeffIndex, numCoeffs, firSpec.m_Interpolation, timeSliceInterval, pvFirMacSection))
+			throw string("Unable to fit interpolating FIR on one FirMac: sample rate too high for the number of coefficients");
+
+		establishFirMacSectionSlotMasks(timeSliceInterval, 1, pvFirMacSection);
+		return;
+	}
+
+	// Linear-phase FIRs that fit on a single FirMac use the pre-adder to compute two taps per TimeSlot
+	FirSpec::Symmetry symmetry = firSpec.findSymmetry();
+	if (symmetry != FirSpec::Symmetry_None)
+		isLaidOut = layoutFoldedFirMacSection(vTapCoeffIndex, numCoeffs, symmetry, timeSliceInterval, pvFirMacSection);
+
+	// Use the fewest FirMacs whose Fifos are not overwritten while being read
+	for (unsigned numFirMacs = IntUtils::ceilDiv(numTaps, outputTimeSliceInterval); !isLaidOut && (numFirMacs <= numTaps); ++numFirMacs)
+		isLaidOut = layoutFirMacSections(vTapCoeffIndex, numFirMacs, timeSliceInterval, pvFirMacSection);
+
+	if (!isLaidOut)
+		throw string("Unable to split FIR into sections: sample rate too high for the number of coefficients");
+
+	establishFirMacSectionSlotMasks(timeSliceInterval, firSpec.m_Decimation, pvFirMacSection);
+}
+
+void FirEngineDesc::establishFirMacSectionSlotMasks(unsigned timeSliceInterval, unsigned decimation, vector<FirMacSection>* pvFirMacSection) const
+{
+	unsigned outputTimeSliceInterval = timeSliceInterval * decimation;
+
+	for (unsigned i = 0; i < pvFirMacSection->size(); ++i)
+	{
+		FirMacSection& firMacSection = (*pvFirMacSection)[i];
+		firMacSection.m_CoeffSlotMask = SlotMask(m_NumTimeSlots);
+		firMacSection.m_UpdateSlotMask = SlotMask(m_NumTimeSlots);
+
+		for (unsigned timeSliceOffset = 0; timeSliceOffset < m_NumTimeSlots; timeSliceOffset += timeSliceInterval)
+		{
+			// the Update, and the Read-Slot ahead of it
+			firMacSection.m_UpdateSlotMask.setSlot(timeSliceOffset);
+			firMacSection.m_UpdateSlotMask.setSlot(IntUtils::modulo(int(timeSliceOffset) - int(m_FirUpdateLatency), m_NumTimeSlots));
+		}
+
+		for (unsigned timeSliceOffset = 0; timeSliceOffset < m_NumTimeSlots; timeSliceOffset += outputTimeSliceInterval)
 		{
-			unsigned coeffTimeSliceOffset = IntUtils::modulo(timeSliceOffset - i, m_NumTimeSlots);
-			if (!firEngineMacDesc.m_vFirCoeffRef[coeffTimeSliceOffset].isNull())
+			for (unsigned j = 0; j < firMacSection.getNumTaps(); ++j)
+				firMacSection.m_CoeffSlotMask.setSlot(IntUtils::modulo(int(timeSliceOffset) + firMacSection.m_FirstTapOffset + int(j), m_NumTimeSlots));
+		}
+	}
+}
+
+bool FirEngineDesc::layoutFirMacSections(const vector<unsigned>& vTapCoeffIndex, unsigned numFirMacs, unsigned timeSliceInterval, vector<FirMacSection>* pvFirMacSection) const
+{
+	unsigned numTaps = vTapCoeffIndex.size();
+
+	pvFirMacSection->clear();
+	pvFirMacSection->resize(numFirMacs);
+
+	// Spread the taps evenly over the chain
+	//   each section covers the Coefficients up to the first tap of the next section (so its Fifo delays the data passed down the chain by the zero taps too)
+	unsigned tapIndex = 0;
+	for (unsigned i = 0; i < numFirMacs; ++i)
+	{
+		FirMacSection& firMacSection = (*pvFirMacSection)[i];
+		unsigned numSectionTaps = (numTaps / numFirMacs) + ((i < (numTaps % numFirMacs)) ? 1 : 0);
+		firMacSection.m_FirstCoeffIndex = (i == 0) ? 0 : vTapCoeffIndex[tapIndex];
+		firMacSection.m_vCoeffIndex.assign(vTapCoeffIndex.begin() + tapIndex, vTapCoeffIndex.begin() + tapIndex + numSectionTaps);
+		tapIndex += numSectionTaps;
+	}
+
+	// The last section finishes on the Update TimeSlot (where the Output is taken)
+	//   each earlier section must finish so that its partial sum is ready for the first tap of the next section
+	int lastTapOffset = 0;
+	for (unsigned i = numFirMacs; i-- > 0; )
+	{
+		FirMacSection& firMacSection = (*pvFirMacSection)[i];
+		firMacSection.m_FirstTapOffset = lastTapOffset - int(firMacSection.getNumTaps() - 1);
+		lastTapOffset = firMacSection.m_FirstTapOffset - int(m_ChainAccumLatency);
+	}
+
+	for (unsigned i = 0; i < numFirMacs; ++i)
+	{
+		FirMacSection& firMacSection = (*pvFirMacSection)[i];
+
+		// Which Update is the data seen by each section's taps relative to (one step per Update)
+		int dataStep = IntUtils::floorDiv(firMacSection.m_FirstTapOffset - int(m_FifoOffsetLatency), timeSliceInterval);
+
+		// The last section's Output is flagged by the Update it finishes on, so its data must be that of the Update before
+		if (((i + 1) == numFirMacs) && (dataStep < -1))
+			return false;
+
+		// If the next section sees data from a later Update, this Fifo must hold the extra entry that has moved on
+		//   and the next section must commit an Update late, so that it sees that Update only if this section saw new data before it
+		//   (Updates need not all commit new data, so a section can not be more than one Update behind the one before it)
+		firMacSection.m_FifoDepth = firMacSection.getReadDepth();
+		if ((i + 1) < numFirMacs)
+		{
+			const FirMacSection& nextFirMacSection = (*pvFirMacSection)[i + 1];
+			int nextDataStep = IntUtils::floorDiv(nextFirMacSection.m_FirstTapOffset - int(m_FifoOffsetLatency), timeSliceInterval);
+			assert(nextDataStep >= dataStep);
+			if ((nextDataStep - dataStep) > 1)
 				return false;
+			firMacSection.m_IsCommitDelayed = (nextDataStep > dataStep);
+			firMacSection.m_FifoDepth = (nextFirMacSection.m_FirstCoeffIndex - firMacSection.m_FirstCoeffIndex) + unsigned(nextDataStep - dataStep);
 		}
+		if (firMacSection.m_FifoDepth > m_MaxFifoDepth)
+			return false;
+
+		// The Fifo Region is derived (by the RTL) from the FifoDepth (unless packed, when its size is given by FIFOREGIONSIZES)
+		firMacSection.m_NumFifoMemWords = findNumFifoMemWords(firMacSection.m_FifoDepth);
+
+		// Updates that occur while this section's taps are being read, write ahead of the FifoOffset they see
+		//   (the Fifo Region must be large enough that these writes do not overwrite entries still to be read)
+		int numUpdatesDuringTaps = IntUtils::floorDiv(firMacSection.getLastTapOffset() - 1, timeSliceInterval) - dataStep;
+		unsigned numReadWords = firMacSection.getReadDepth() + unsigned(numUpdatesDuringTaps);
+		if (m_IsPackedFifos)
+			firMacSection.m_NumFifoMemWords = max(firMacSection.m_NumFifoMemWords, numReadWords);
+		else if (numReadWords > firMacSection.m_NumFifoMemWords)
+			return false;
 	}
 
 	return true;
 }
 
-void FirEngineDesc::bind(const FirSpec& firSpec, const FirBinding& firBinding)
+bool FirEngineDesc::layoutComplexFirMacSections(const FirSpec& firSpec, unsigned timeSliceInterval, vector<FirMacSection>* pvFirMacSection) const
 {
-	if (firBinding.m_FirstFirMacIndex >= m_vFirEngineMacDesc.size())
-		m_vFirEngineMacDesc.push_back(FirEngineMacDesc(m_NumTimeSlots));
+	vector<unsigned> vRealTapCoeffIndex;
+	vector<unsigned> vImagTapCoeffIndex;
+	firSpec.establishTapCoeffIndices(&vRealTapCoeffIndex);
+	firSpec.establishImagTapCoeffIndices(&vImagTapCoeffIndex);
+	if (vRealTapCoeffIndex.empty() && vImagTapCoeffIndex.empty())
+		throw string("FIR has no coefficients larger than its zeroThreshold");
+
+	// Each Output sums the real Coefficients' products with its own part of the Input, and the imaginary Coefficients' with the other part
+	//   I = (Hr * I) - (Hi * Q), Q = (Hr * Q) + (Hi * I)
+	//   so each Output is computed by a chain of (up to) two sections, the second adding the cross terms
+	pvFirMacSection->clear();
+	for (unsigned quadratureOutput = 0; quadratureOutput < 2; ++quadratureOutput)
+	{
+		unsigned chainSectionIdx = pvFirMacSection->size();
+		for (unsigned imagCoeffs = 0; imagCoeffs < 2; ++imagCoeffs)
+		{
+			const vector<unsigned>& vTapCoeffIndex = (imagCoeffs != 0) ? vImagTapCoeffIndex : vRealTapCoeffIndex;
+			if (vTapCoeffIndex.empty())
+				continue;
+
+			FirMacSection firMacSection;
+			firMacSection.m_FirstCoeffIndex = 0;
+			firMacSection.m_vCoeffIndex = vTapCoeffIndex;
+			firMacSection.m_IsImagCoeffs = (imagCoeffs != 0);
+			firMacSection.m_IsQuadratureOutput = (quadratureOutput != 0);
+			firMacSection.m_IsQuadratureData = (firMacSection.m_IsImagCoeffs != firMacSection.m_IsQuadratureOutput);
+			firMacSection.m_IsChainStart = (pvFirMacSection->size() == chainSectionIdx);
+			firMacSection.m_IsCrossTerm = !firMacSection.m_IsChainStart;
+
+			// The products are not split, so the taps of each Output must not overlap those of the next
+			if (firMacSection.getNumTaps() > timeSliceInterval)
+				return false;
+			pvFirMacSection->push_back(firMacSection);
+		}
+
+		// As for any chain, the last section finishes on the Update TimeSlot, and the first in time for its partial sum to be added
+		int lastTapOffset = 0;
+		for (unsigned i = pvFirMacSection->size(); i-- > chainSectionIdx; )
+		{
+			FirMacSection& firMacSection = (*pvFirMacSection)[i];
+			firMacSection.m_FirstTapOffset = lastTapOffset - int(firMacSection.getNumTaps() - 1);
+			lastTapOffset = firMacSection.m_FirstTapOffset - int(m_ChainAccumLatency);
+		}
+
+		// The cross-term section filters the same samples, but may see its Fifo after an Update the first section has not yet seen
+		//   (whose entry it skips, if that Update committed one)
+		int firstDataStep = IntUtils::floorDiv((*pvFirMacSection)[chainSectionIdx].m_FirstTapOffset - int(m_FifoOffsetLatency), timeSliceInterval);
+		for (unsigned i = chainSectionIdx; i < pvFirMacSection->size(); ++i)
+		{
+			FirMacSection& firMacSection = (*pvFirMacSection)[i];
+			int dataStep = IntUtils::floorDiv(firMacSection.m_FirstTapOffset - int(m_FifoOffsetLatency), timeSliceInterval);
+			assert(dataStep >= firstDataStep);
+			if ((dataStep - firstDataStep) > 1)
+				return false;
+			firMacSection.m_DataDelay = unsigned(dataStep - firstDataStep);
+
+			// Updates that occur while the taps are being read must not overwrite entries still to be read
+			//   (a product is not split over more FirMacs, so its Fifo is deepened instead)
+			int numUpdatesDuringTaps = IntUtils::floorDiv(firMacSection.getLastTapOffset() - 1, timeSliceInterval) - dataStep;
+			unsigned numReadWords = firMacSection.getReadDepth() + unsigned(numUpdatesDuringTaps);
+			firMacSection.m_FifoDepth = m_IsPackedFifos ? firMacSection.getReadDepth() : numReadWords;
+			if (firMacSection.m_FifoDepth > m_MaxFifoDepth)
+				return false;
+			firMacSection.m_NumFifoMemWords = max(findNumFifoMemWords(firMacSection.m_FifoDepth), numReadWords);
+		}
+	}
 
-	FirEngineMacDesc& firEngineMacDesc = m_vFirEngineMacDesc[firBinding.m_FirstFirMacIndex];
+	return true;
+}
 
-	firEngineMacDesc.m_vInputFirs.push_back(firBinding.m_FirIndex);
-	firEngineMacDesc.m_vOutputFirs.push_back(firBinding.m_FirIndex);
+bool FirEngineDesc::layoutFoldedFirMacSection(const vector<unsigned>& vTapCoeffIndex, unsigned numCoeffs, FirSpec::Symmetry symmetry, unsigned timeSliceInterval, vector<FirMacSection>* pvFirMacSection) const
+{
+	assert(symmetry != FirSpec::Symmetry_None);
 
-	// Check that UpdateSlots are available
-	unsigned timeSliceOffset;
-	for (timeSliceOffset = firBinding.m_TimeSliceOrigin; timeSliceOffset < m_NumTimeSlots; timeSliceOffset += firBinding.m_TimeSliceInterval)
+	// dataBuffB holds the data that has passed through the Fifo, so the mirrored sample is FifoDepth entries older
+	//   For an odd number of coefficients, the mirrored data starts one entry later (skipping the middle tap).
+	//   The middle tap of a symmetric FIR is computed without the pre-adder, that of an antisymmetric FIR is zero.
+	FirMacSection firMacSection;
+	firMacSection.m_FifoDepth = IntUtils::ceilDiv(numCoeffs, 2);
+	firMacSection.m_IsOddFold = ((numCoeffs % 2) != 0);
+	unsigned numFoldedCoeffs;
+	if (symmetry == FirSpec::Symmetry_Symmetric)
+	{
+		firMacSection.m_PreAddMode = 1;
+		numFoldedCoeffs = firMacSection.m_FifoDepth;
+	}
+	else
 	{
-		FirUpdateSlot firUpdateSlot;
-		firUpdateSlot.m_FirIndex = firBinding.m_FirIndex;
-		firEngineMacDesc.m_vFirUpdateSlot[timeSliceOffset] = firUpdateSlot;
+		firMacSection.m_PreAddMode = 2;
+		numFoldedCoeffs = numCoeffs / 2;
 	}
+	firMacSection.m_FirstCoeffIndex = 0;
+
+	// Zero taps come in mirrored pairs, so only the first half of the taps are needed
+	for (unsigned i = 0; (i < vTapCoeffIndex.size()) && (vTapCoeffIndex[i] < numFoldedCoeffs); ++i)
+		firMacSection.m_vCoeffIndex.push_back(vTapCoeffIndex[i]);
+	firMacSection.m_FirstTapOffset = -int(firMacSection.getNumTaps() - 1);
+
+	// Folded FIRs are not chained, so (like the last section of a chain) their Output is flagged by the Update they finish on
+	//   and their data must be that of the Update before
+	int dataStep = IntUtils::floorDiv(firMacSection.m_FirstTapOffset - int(m_FifoOffsetLatency), timeSliceInterval);
+	if (dataStep < -1)
+		return false;
+	if (firMacSection.m_FifoDepth > m_MaxFifoDepth)
+		return false;
+
+	firMacSection.m_NumFifoMemWords = findNumFifoMemWords(firMacSection.m_FifoDepth);
+
+	// Updates that occur while the taps are being read must overwrite neither the data nor the mirrored data
+	int numUpdatesDuringTaps = IntUtils::floorDiv(firMacSection.getLastTapOffset() - 1, timeSliceInterval) - dataStep;
+	unsigned mirroredReadDepth = firMacSection.m_FifoDepth - (firMacSection.m_IsOddFold ? 1 : 0);
+	unsigned numReadWords = max(firMacSection.getReadDepth(), mirroredReadDepth) + unsigned(numUpdatesDuringTaps);
+	if (m_IsPackedFifos)
+		firMacSection.m_NumFifoMemWords = max(firMacSection.m_NumFifoMemWords, numReadWords);
+	else if (numReadWords > firMacSection.m_NumFifoMemWords)
+		return false;
+
+	pvFirMacSection->clear();
+	pvFirMacSection->push_back(firMacSection);
+	return true;
+}
+
+bool FirEngineDesc::layoutPolyphaseFirMacSection(const vector<unsigned>& vTapCoeffIndex, unsigned numCoeffs, unsigned interpolation, unsigned timeSliceInterval, vector<FirMacSection>* pvFirMacSection) const
+{
+	assert(interpolation > 1);
 
-	for (timeSliceOffset = firBinding.m_TimeSliceOrigin; timeSliceOffset < m_NumTimeSlots; timeSliceOffset += firBinding.m_TimeSliceInterval)
+	// The phases are computed one after the other, each from the same data (and without the inserted zeros)
+	//   phase 0 (the longest) reads the most entries
+	FirMacSection firMacSection;
+	firMacSection.m_Interpolation = interpolation;
+	firMacSection.m_FirstCoeffIndex = 0;
+	firMacSection.m_FifoDepth = IntUtils::ceilDiv(numCoeffs, interpolation);
+	for (unsigned phase = 0; phase < interpolation; ++phase)
 	{
-		// all slots needed for Coefficients leading up to (and including) timeSliceOffset must be Empty
-		for (unsigned i = 0; i < firSpec.m_vCoeff.size(); ++i)
+		unsigned numTaps = firMacSection.getNumTaps();
+		for (unsigned i = 0; i < vTapCoeffIndex.size(); ++i)
 		{
-			FirCoeffRef firCoeffRef;
-			firCoeffRef.m_FirIndex = firBinding.m_FirIndex;
-			firCoeffRef.m_CoeffIndex = (firSpec.m_vCoeff.size() - 1) - i;
+			if ((vTapCoeffIndex[i] % interpolation) == phase)
+				firMacSection.m_vCoeffIndex.push_back(vTapCoeffIndex[i]);
+		}
 
-			unsigned coeffTimeSliceOffset = IntUtils::modulo(timeSliceOffset - i, m_NumTimeSlots);
-			firEngineMacDesc.m_vFirCoeffRef[coeffTimeSliceOffset] = firCoeffRef;
+		// Every phase produces an Output, so keeps at least two taps (even if its Coefficients are zero)
+		//   (the Output's Changed flag follows its data a ClockCycle later, so Outputs on consecutive ClockCycles would overwrite each other)
+		if (firMacSection.getNumTaps() < (numTaps + 2))
+		{
+			for (unsigned coeffIdx = phase; (coeffIdx < numCoeffs) && (firMacSection.getNumTaps() < (numTaps + 2)); coeffIdx += interpolation)
+			{
+				if (find(firMacSection.m_vCoeffIndex.begin() + numTaps, firMacSection.m_vCoeffIndex.end(), coeffIdx) == firMacSection.m_vCoeffIndex.end())
+					firMacSection.m_vCoeffIndex.push_back(coeffIdx);
+			}
+			sort(firMacSection.m_vCoeffIndex.begin() + numTaps, firMacSection.m_vCoeffIndex.end());
 		}
 	}
+	firMacSection.m_FirstTapOffset = -int(firMacSection.getNumTaps() - 1);
 
-	FirEngineMacFifoDesc firEngineMacFifoDesc;
-	firEngineMacFifoDesc.m_FifoDepth = firSpec.m_vCoeff.size();
-	firEngineMacFifoDesc.m_NumFifoMemWords = IntUtils::roundUpToPowerOfTwo(firSpec.m_vCoeff.size());
-	firEngineMacFifoDesc.m_FirIndex = firBinding.m_FirIndex;
-	for (unsigned i = 0; i < firSpec.m_vCoeff.size(); ++i)
+	// Every phase must see the data as it was after the previous Update (and finish by the next Update)
+	//   so the first tap must not be earlier than FifoOffsetLatency cycles after the previous Update
+	if (firMacSection.m_FirstTapOffset < (int(m_FifoOffsetLatency) - int(timeSliceInterval)))
+		return false;
+	if (firMacSection.m_FifoDepth > m_MaxFifoDepth)
+		return false;
+	if (firMacSection.getNumTaps() > (1 << 8))
+		return false;		// Reason: COEFF_OFFSET bitwidth
+
+	// The Coefficients of all phases follow each other in the Fifo's Coefficient bank
+	firMacSection.m_NumFifoMemWords = findNumFifoMemWords(firMacSection.m_FifoDepth);
+
+	pvFirMacSection->clear();
+	pvFirMacSection->push_back(firMacSection);
+	return true;
+}
+
+bool FirEngineDesc::layoutFilterBankFirMacSection(const FirEngineSpec& firEngineSpec, const vector<unsigned>& vBankFirIndex, unsigned timeSliceInterval, vector<FirMacSection>* pvFirMacSection) const
+{
+	assert(vBankFirIndex.size() > 1);
+	const FirSpec& firSpec = firEngineSpec.m_vFirSpec[vBankFirIndex[0]];
+
+	// Like the phases of an interpolating FIR, the FIRs are computed one after the other from the same data
+	//   the longest FIR reads the most entries
+	FirMacSection firMacSection;
+	firMacSection.m_FirstCoeffIndex = 0;
+	firMacSection.m_vBankFirIndex.assign(vBankFirIndex.begin() + 1, vBankFirIndex.end());
+	for (unsigned i = 0; i < vBankFirIndex.size(); ++i)
 	{
-		FirCoeffRef firCoeffRef;
-		firCoeffRef.m_FirIndex = firBinding.m_FirIndex;
-		firCoeffRef.m_CoeffIndex = i;
+		const FirSpec& bankFirSpec = firEngineSpec.m_vFirSpec[vBankFirIndex[i]];
+		if ((bankFirSpec.m_Decimation > 1) || (bankFirSpec.m_Interpolation > 1))
+			throw string("FIRs sharing an Input can neither decimate nor interpolate");
+		if (bankFirSpec.m_SampleFreq != firSpec.m_SampleFreq)
+			throw string("FIRs sharing an Input must have the same sample rate");
 
-		firEngineMacFifoDesc.m_vFirCoeffRef.push_back(firCoeffRef);
+		vector<unsigned> vTapCoeffIndex;
+		bankFirSpec.establishTapCoeffIndices(&vTapCoeffIndex);
+		if (vTapCoeffIndex.empty())
+			throw string("FIR has no coefficients larger than its zeroThreshold");
+
+		firMacSection.m_FifoDepth = max(firMacSection.m_FifoDepth, unsigned(bankFirSpec.m_vCoeff.size()));
+		firMacSection.m_vCoeffIndex.insert(firMacSection.m_vCoeffIndex.end(), vTapCoeffIndex.begin(), vTapCoeffIndex.end());
+		firMacSection.m_vTapFirIndex.insert(firMacSection.m_vTapFirIndex.end(), vTapCoeffIndex.size(), vBankFirIndex[i]);
+	}
+	firMacSection.m_FirstTapOffset = -int(firMacSection.getNumTaps() - 1);
+
+	// Every FIR must see the data as it was after the previous Update (and finish by the next Update)
+	if (firMacSection.m_FirstTapOffset < (int(m_FifoOffsetLatency) - int(timeSliceInterval)))
+		return false;
+	if (firMacSection.m_FifoDepth > m_MaxFifoDepth)
+		return false;
+	if (firMacSection.getNumTaps() > (1 << 8))
+		return false;		// Reason: COEFF_OFFSET bitwidth
+	// Constraint: number of Outputs to a MAC is limited to 15
+	if (firMacSection.getNumOutputs() > 15)
+		return false;
+
+	// The Coefficients of all the FIRs follow each other in the Fifo's Coefficient bank
+	firMacSection.m_NumFifoMemWords = findNumFifoMemWords(firMacSection.m_FifoDepth);
+
+	pvFirMacSection->clear();
+	pvFirMacSection->push_back(firMacSection);
+	return true;
+}
+
+unsigned FirEngineDesc::findNumFifoMemWords(unsigned numEntries) const
+{
+	// Packed Fifos wrap their addresses modulo the Region size, so need no more words than entries
+	if (m_IsPackedFifos)
+		return numEntries;
+	return IntUtils::roundUpToPowerOfTwo(numEntries);
+}
+
+bool FirEngineDesc::hasFreeCoeffSlots(const FirBinding& firBinding) const
+{
+	for (unsigned i = 0; i < firBinding.getNumFirMacs(); ++i)
+	{
+		unsigned firMacIdx = firBinding.m_FirstFirMacIndex + i;
+		if (firMacIdx >= m_vFirEngineMacDesc.size())
+			continue;		// a 'new' MAC is always free
+
+		unsigned numCoeffSlots = firBinding.m_vFirMacSection[i].m_CoeffSlotMask.countSetSlots();
+		if (m_vFirEngineMacDesc[firMacIdx].getNumFreeCoeffSlots() < numCoeffSlots)
+			return false;
+	}
+	return true;
+}
+
+bool FirEngineDesc::canBind(const FirBinding& firBinding) const
+{
+	if (!hasFreeCoeffSlots(firBinding))
+		return false;
+
+	for (unsigned i = 0; i < firBinding.getNumFirMacs(); ++i)
+	{
+		unsigned firMacIdx = firBinding.m_FirstFirMacIndex + i;
+		if (firMacIdx >= m_vFirEngineMacDesc.size())
+			continue;		// a 'new' MAC is always free
+
+		const FirMacSection& firMacSection = firBinding.m_vFirMacSection[i];
+		const FirEngineMacDesc& firEngineMacDesc = m_vFirEngineMacDesc[firMacIdx];
+
+		// Constraint: number of Inputs to a MAC is limited to 15 (only the first MAC in a chain takes the Input, and those adding cross terms)
+		if (firBinding.isFirstEngine(i) && (firEngineMacDesc.m_vInputFirs.size() == 15))
+			return false;
+		// Constraint: number of Outputs to a MAC is limited to 15 (only the last MAC in a chain drives the Output, one per FIR of a filter bank)
+		if (firBinding.isLastEngine(i) && ((firEngineMacDesc.m_vOutputFirs.size() + firMacSection.getNumOutputs()) > 15))
+			return false;
+		// Constraint: number of Fifos attached a MAC is limited to 256
+		if (firEngineMacDesc.getNumFifos() == 256)
+			return false;
+
+		// Check that UpdateSlots (and the 'Read' slots ahead of them) are available (every MAC in the chain updates on the same TimeSlot)
+		if (firEngineMacDesc.m_UpdateSlotMask.intersectsRotated(firMacSection.m_UpdateSlotMask, firBinding.m_TimeSliceOrigin))
+			return false;
+
+		// all slots needed for this section's Coefficients must be Empty
+		if (firEngineMacDesc.m_CoeffSlotMask.intersectsRotated(firMacSection.m_CoeffSlotMask, firBinding.m_TimeSliceOrigin))
+			return false;
+	}
+
+	return true;
+}
+
+void FirEngineDesc::bind(const FirEngineSpec& firEngineSpec, const FirBinding& firBinding)
+{
+	while (m_vFirEngineMacDesc.size() < (firBinding.m_FirstFirMacIndex + firBinding.getNumFirMacs()))
+		m_vFirEngineMacDesc.push_back(FirEngineMacDesc(m_NumTimeSlots, m_IsPackedFifos));
+
+	for (unsigned i = 0; i < firBinding.getNumFirMacs(); ++i)
+	{
+		const FirMacSection& firMacSection = firBinding.m_vFirMacSection[i];
+		FirEngineMacDesc& firEngineMacDesc = m_vFirEngineMacDesc[firBinding.m_FirstFirMacIndex + i];
+
+		bool isFirstEngine = firBinding.isFirstEngine(i);
+		bool isLastEngine = firBinding.isLastEngine(i);
+
+		// The sections of a complex FIR read (and produce) the quadrature parts from the Fifo (and Output) of its Quadrature FIR
+		unsigned dataFirIndex = firBinding.m_FirIndex;
+		unsigned outputFirIndex = firBinding.m_FirIndex;
+		if (firMacSection.m_IsQuadratureData || firMacSection.m_IsQuadratureOutput)
+		{
+			unsigned quadratureFirIndex = firEngineSpec.findQuadratureFirIndex(firBinding.m_FirIndex);
+			if (firMacSection.m_IsQuadratureData)
+				dataFirIndex = quadratureFirIndex;
+			if (firMacSection.m_IsQuadratureOutput)
+				outputFirIndex = quadratureFirIndex;
+		}
+
+		if (isFirstEngine)
+			firEngineMacDesc.m_vInputFirs.push_back(dataFirIndex);
+		if (isLastEngine)
+		{
+			firEngineMacDesc.m_vOutputFirs.push_back(outputFirIndex);
+			firEngineMacDesc.m_vOutputFirs.insert(firEngineMacDesc.m_vOutputFirs.end(), firMacSection.m_vBankFirIndex.begin(), firMacSection.m_vBankFirIndex.end());
+			firEngineMacDesc.m_vOutputCoeffScale.push_back(firEngineSpec.m_vFirSpec[outputFirIndex].m_CoeffScale);
+			for (unsigned j = 0; j < firMacSection.m_vBankFirIndex.size(); ++j)
+				firEngineMacDesc.m_vOutputCoeffScale.push_back(firEngineSpec.m_vFirSpec[firMacSection.m_vBankFirIndex[j]].m_CoeffScale);
+		}
+
+		// Mark the UpdateSlots (and the Read-Slots ahead of them)
+		//   only the Updates in step with the TimeSliceOrigin produce an Output (an interpolating FIR's phases, and a filter bank's FIRs, produce their own)
+		unsigned timeSliceOffset;
+		for (timeSliceOffset = (firBinding.m_TimeSliceOrigin % firBinding.m_TimeSliceInterval); timeSliceOffset < m_NumTimeSlots; timeSliceOffset += firBinding.m_TimeSliceInterval)
+		{
+			FirUpdateSlot firUpdateSlot;
+			firUpdateSlot.m_FirIndex = dataFirIndex;
+			firUpdateSlot.m_IsOutput = !firMacSection.hasPhaseOutputs() && ((timeSliceOffset % firBinding.getOutputTimeSliceInterval()) == (firBinding.m_TimeSliceOrigin % firBinding.getOutputTimeSliceInterval()));
+			firEngineMacDesc.m_vFirUpdateSlot[timeSliceOffset] = firUpdateSlot;
+
+			unsigned readTimeSliceOffset = IntUtils::modulo(timeSliceOffset - m_FirUpdateLatency, m_NumTimeSlots);
+			firEngineMacDesc.m_vFirReadSlot[readTimeSliceOffset] = firUpdateSlot;
+		}
+		firEngineMacDesc.m_UpdateSlotMask.setRotated(firMacSection.m_UpdateSlotMask, firBinding.m_TimeSliceOrigin);
+
+		for (timeSliceOffset = firBinding.m_TimeSliceOrigin; timeSliceOffset < m_NumTimeSlots; timeSliceOffset += firBinding.getOutputTimeSliceInterval())
+		{
+			// this section's Coefficients occupy consecutive slots, starting from its first tap
+			for (unsigned j = 0; j < firMacSection.getNumTaps(); ++j)
+			{
+				FirCoeffRef firCoeffRef;
+				firCoeffRef.m_FirIndex = firMacSection.findTapFirIndex(j, dataFirIndex);
+				firCoeffRef.m_CoeffIndex = firMacSection.m_vCoeffIndex[j];
+
+				unsigned coeffTimeSliceOffset = IntUtils::modulo(int(timeSliceOffset) + firMacSection.m_FirstTapOffset + int(j), m_NumTimeSlots);
+				firEngineMacDesc.m_vFirCoeffRef[coeffTimeSliceOffset] = firCoeffRef;
+			}
+		}
+		firEngineMacDesc.m_CoeffSlotMask.setRotated(firMacSection.m_CoeffSlotMask, firBinding.m_TimeSliceOrigin);
+
+		FirEngineMacFifoDesc firEngineMacFifoDesc;
+		firEngineMacFifoDesc.m_FifoDepth = firMacSection.m_FifoDepth;
+		firEngineMacFifoDesc.m_NumFifoMemWords = firMacSection.m_NumFifoMemWords;
+		firEngineMacFifoDesc.m_FirIndex = dataFirIndex;
+		firEngineMacFifoDesc.m_OutputFirIndex = outputFirIndex;
+		firEngineMacFifoDesc.m_IsFirstEngine = isFirstEngine;
+		firEngineMacFifoDesc.m_IsLastEngine = isLastEngine;
+		firEngineMacFifoDesc.m_IsCrossTerm = firMacSection.m_IsCrossTerm;
+		firEngineMacFifoDesc.m_IsCommitDelayed = firMacSection.m_IsCommitDelayed;
+		firEngineMacFifoDesc.m_IsDataDelayed = (firMacSection.m_DataDelay != 0);
+		firEngineMacFifoDesc.m_PreAddMode = firMacSection.m_PreAddMode;
+		firEngineMacFifoDesc.m_IsOddFold = firMacSection.m_IsOddFold;
+		firEngineMacFifoDesc.m_Interpolation = firMacSection.m_Interpolation;
+		firEngineMacFifoDesc.m_vBankFirIndex = firMacSection.m_vBankFirIndex;
+		for (unsigned j = 0; j < firMacSection.getNumTaps(); ++j)
+		{
+			FirCoeffRef firCoeffRef;
+			firCoeffRef.m_FirIndex = firMacSection.findTapFirIndex(j, dataFirIndex);
+			firCoeffRef.m_CoeffIndex = firMacSection.m_vCoeffIndex[j];
+
+			firEngineMacFifoDesc.m_vFirCoeffRef.push_back(firCoeffRef);
+			firEngineMacFifoDesc.m_vDataIndex.push_back(firMacSection.getDataIndex(j));
+
+			int coeffCode = firMacSection.m_IsImagCoeffs ? firEngineSpec.lookupImagCoeffCode(firCoeffRef) : firEngineSpec.lookupCoeffCode(firCoeffRef);
+			if (firMacSection.m_IsImagCoeffs && firMacSection.m_IsQuadratureData)
+				coeffCode = -coeffCode;		// j * j = -1 (the in-phase Output subtracts Hi * Q)
+			if (firMacSection.m_PreAddMode == 2)
+				coeffCode = -coeffCode;		// PreSub computes (older - newer) data
+			firEngineMacFifoDesc.m_vCoeffValue.push_back(FirEngineMacFifoDesc::encodeCoeffCode(coeffCode));
+		}
+		firEngineMacDesc.m_vFirEngineMacFifoDesc.push_back(firEngineMacFifoDesc);
 	}
-	firEngineMacDesc.m_vFirEngineMacFifoDesc.push_back(firEngineMacFifoDesc);
 
 	// Finally update the number of FIRs
+	m_vFirBinding.push_back(firBinding);
 	++m_NumFirs;
 }
 
-FirBinding FirEngineDesc::findValidBinding(const FirSpec& firSpec, unsigned firIndex, unsigned timeSliceInterval) const
+FirBinding FirEngineDesc::findValidBinding(const FirEngineSpec& firEngineSpec, unsigned firIndex, unsigned timeSliceInterval) const
 {
+	const FirSpec& firSpec = firEngineSpec.m_vFirSpec[firIndex];
+
+	FirBinding firBinding;
+	firBinding.m_FirIndex = firIndex;
+	firBinding.m_TimeSliceInterval = timeSliceInterval;
+	firBinding.m_Decimation = firSpec.m_Decimation;
+	establishFirMacSections(firEngineSpec, firIndex, timeSliceInterval, &firBinding.m_vFirMacSection);
+
 	// try to start from lowest available firMac (up to a 'new' one, which should always bind)
 	for (unsigned firMacIdx = 0; firMacIdx <= m_vFirEngineMacDesc.size(); ++firMacIdx)
 	{
-		for (unsigned timeSliceOffset = 0; timeSliceOffset < timeSliceInterval; ++timeSliceOffset)
+		// skip MACs which are too full for any TimeSlice origin
+		firBinding.m_FirstFirMacIndex = firMacIdx;
+		if (!hasFreeCoeffSlots(firBinding))
+			continue;
+
+		for (unsigned timeSliceOffset = 0; timeSliceOffset < firBinding.getOutputTimeSliceInterval(); ++timeSliceOffset)
 		{
-			FirBinding firBinding;
-			firBinding.m_FirIndex = firIndex;
-			firBinding.m_FirstFirMacIndex = firMacIdx;
 			firBinding.m_TimeSliceOrigin = timeSliceOffset;
-			firBinding.m_TimeSliceInterval = timeSliceInterval;
 
-			if (canBind(firSpec, firBinding))
+			if (canBind(firBinding))
 				return firBinding;
 		}
 	}
@@ -124,24 +639,59 @@ FirBinding FirEngineDesc::findValidBinding(const FirSpec& firSpec, unsigned firI
 	return FirBinding();
 }
 
-void FirEngineDesc::bindFir(const FirEngineSpec& firEngineSpec, unsigned firIdx)
+unsigned FirEngineDesc::findTimeSliceInterval(const FirEngineSpec& firEngineSpec, unsigned firIdx) const
 {
 	const FirSpec& firSpec = firEngineSpec.m_vFirSpec[firIdx];
 
 	if (firSpec.m_SampleFreq > (2.0 * firEngineSpec.m_ClockFreq))
 		throw string("FIR sample frequencies must be less than half of the clock frequency");
 
+	// A decimating FIR drives its Output on every Decimation-th Update, so every Update must take a new sample
+	//   its sample period must be a whole number of clock cycles, and its Output interval must divide the number of TimeSlots
+	//   (say which numbers of TimeSlots would do, as the default rarely does)
+	if (firSpec.m_Decimation > 1)
+	{
+		double samplePeriod = firEngineSpec.m_ClockFreq / firSpec.m_SampleFreq;
+		if (samplePeriod != floor(samplePeriod))
+			throw string("Decimating FIR needs an Update for every sample: its sample period must be a whole number of clock cycles (it is ") + toString(samplePeriod) + ")";
+		unsigned outputTimeSliceInterval = unsigned(samplePeriod) * firSpec.m_Decimation;
+		if (!IntUtils::isMultipleOf(m_NumTimeSlots, outputTimeSliceInterval))
+		{
+			throw string("Decimating FIR needs an Update for every sample: the number of TimeSlots (") + toString(m_NumTimeSlots) + ") must be a multiple of its sample period times its decimation ("
+				+ toString(outputTimeSliceInterval) + "), e.g. -t " + toString(outputTimeSliceInterval) + " or -t " + toString(2 * outputTimeSliceInterval);
+		}
+	}
+
+	// Outputs of a decimating FIR must also repeat every NumTimeSlots
+	if ((firSpec.m_Decimation > m_NumTimeSlots) || !IntUtils::isMultipleOf(m_NumTimeSlots, firSpec.m_Decimation))
+		throw string("FIR decimation must evenly divide the number of TimeSlots");
+	unsigned maxTimeSliceInterval = m_NumTimeSlots / firSpec.m_Decimation;
+
 	unsigned timeSliceInterval = unsigned(floor(firEngineSpec.m_ClockFreq / firSpec.m_SampleFreq));
-	if (timeSliceInterval > m_NumTimeSlots)
-		timeSliceInterval = m_NumTimeSlots;
+	if (timeSliceInterval > maxTimeSliceInterval)
+		timeSliceInterval = maxTimeSliceInterval;
 
-	// need to round down timeSliceInterval to a even-divisor of numTimeSlots
-	unsigned numRepeats = IntUtils::ceilDiv(m_NumTimeSlots, timeSliceInterval);
-	timeSliceInterval = (m_NumTimeSlots / numRepeats);
+	// need to round down timeSliceInterval to a even-divisor of numTimeSlots (once multiplied up to the Output interval)
+	unsigned numRepeats = IntUtils::ceilDiv(maxTimeSliceInterval, timeSliceInterval);
+	timeSliceInterval = (maxTimeSliceInterval / numRepeats);
+	while (!IntUtils::isMultipleOf(maxTimeSliceInterval, timeSliceInterval))
+		--timeSliceInterval;
 
-	if (timeSliceInterval < firSpec.m_vCoeff.size())
-		throw string("Too many coefficients for sample rate required (currently multi-MAC FIR is not supported)");
+	assert((firSpec.m_Decimation == 1) || ((double(timeSliceInterval) * firSpec.m_SampleFreq) == firEngineSpec.m_ClockFreq));
+
+	// the Read-Slot ahead of an Update must not collide with the previous Update, nor read the Fifo Description before the previous Update has written it back
+	unsigned minUpdateInterval = max(m_FirUpdateLatency, m_FifoDescLatency);
+	if (timeSliceInterval <= minUpdateInterval)
+		throw string("FIR sample rate too high: updates must be more than ") + toString(minUpdateInterval) + " clock cycles apart";
+
+	return timeSliceInterval;
+}
+
+void FirEngineDesc::bindFir(const FirEngineSpec& firEngineSpec, unsigned firIdx)
+{
+	unsigned timeSliceInterval = findTimeSliceInterval(firEngineSpec, firIdx);
 
-	FirBinding firBinding = findValidBinding(firSpec, firIdx, timeSliceInterval);
-	bind(firSpec, firBinding);
+	// FIRs with more coefficients than the timeSliceInterval are split over a chain of MACs
+	FirBinding firBinding = findValidBinding(firEngineSpec, firIdx, timeSliceInterval);
+	bind(firEngineSpec, firBinding);
 }
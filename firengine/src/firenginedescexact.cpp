@@ -0,0 +1,145 @@
+#include <assert.h>
+#include <algorithm>
+#include "intutils.h"
+#include "stringutil.h"
+#include "firenginedesc.h"
+#include "firenginespec.h"
+#include "firexactbindsearch.h"
+
+
+unsigned FirEngineDesc::findNumCoeffSlots(const vector<FirMacSection>& vFirMacSection) const
+{
+	unsigned numCoeffSlots = 0;
+	for (unsigned i = 0; i < vFirMacSection.size(); ++i)
+		numCoeffSlots += vFirMacSection[i].m_CoeffSlotMask.countSetSlots();
+	return numCoeffSlots;
+}
+
+unsigned FirEngineDesc::findNumFreeCoeffSlots() const
+{
+	unsigned numFreeCoeffSlots = 0;
+	for (unsigned firMacIdx = 0; firMacIdx < m_vFirEngineMacDesc.size(); ++firMacIdx)
+		numFreeCoeffSlots += m_vFirEngineMacDesc[firMacIdx].getNumFreeCoeffSlots();
+	return numFreeCoeffSlots;
+}
+
+void FirEngineDesc::establishLowerBoundNumFirMacs(const FirEngineSpec& firEngineSpec)
+{
+	// Every Coefficient-slot must be held by some MAC, and a FIR's chain needs that many distinct MACs
+	unsigned numCoeffSlots = 0;
+	unsigned maxChainLength = 0;
+	for (unsigned firIdx = 0; firIdx < firEngineSpec.m_vFirSpec.size(); ++firIdx)
+	{
+		unsigned timeSliceInterval = findTimeSliceInterval(firEngineSpec, firIdx);
+		vector<FirMacSection> vFirMacSection;
+		establishFirMacSections(firEngineSpec, firIdx, timeSliceInterval, &vFirMacSection);
+
+		numCoeffSlots += findNumCoeffSlots(vFirMacSection);
+		maxChainLength = max(maxChainLength, unsigned(vFirMacSection.size()));
+	}
+	m_LowerBoundNumFirMacs = max(maxChainLength, IntUtils::ceilDiv(numCoeffSlots, m_NumTimeSlots));
+}
+
+void FirEngineDesc::bindFirsExact(const FirEngineSpec& firEngineSpec, double timeLimitSeconds)
+{
+	assert(m_NumFirs == 0);
+	unsigned numFirs = firEngineSpec.m_vFirSpec.size();
+
+	FirExactBindSearch search(timeLimitSeconds);
+
+	// The sections of each FIR do not depend on where it is bound
+	vector<unsigned> vNumCoeffSlots(numFirs);
+	for (unsigned firIdx = 0; firIdx < numFirs; ++firIdx)
+	{
+		unsigned timeSliceInterval = findTimeSliceInterval(firEngineSpec, firIdx);
+		search.m_vTimeSliceInterval.push_back(timeSliceInterval);
+		search.m_vvFirMacSection.push_back(vector<FirMacSection>());
+		establishFirMacSections(firEngineSpec, firIdx, timeSliceInterval, &search.m_vvFirMacSection.back());
+		vNumCoeffSlots[firIdx] = findNumCoeffSlots(search.m_vvFirMacSection.back());
+	}
+
+	// Bind the most heavily loaded FIRs first (so that bad partial bindings are pruned early)
+	for (unsigned firIdx = 0; firIdx < numFirs; ++firIdx)
+		search.m_vFirOrder.push_back(firIdx);
+	stable_sort(search.m_vFirOrder.begin(), search.m_vFirOrder.end(),
+		[&vNumCoeffSlots](unsigned a, unsigned b) { return vNumCoeffSlots[a] > vNumCoeffSlots[b]; });
+
+	search.m_vRemainingLoad.resize(numFirs + 1, 0);
+	for (unsigned depth = numFirs; depth-- > 0; )
+		search.m_vRemainingLoad[depth] = search.m_vRemainingLoad[depth + 1] + vNumCoeffSlots[search.m_vFirOrder[depth]];
+
+	establishLowerBoundNumFirMacs(firEngineSpec);
+	search.m_LowerBoundNumFirMacs = m_LowerBoundNumFirMacs;
+
+	// The first-fit binding (in spec order) is the starting point, and the fallback if time runs out
+	{
+		FirEngineDesc firstFitFirEngineDesc(m_NumTimeSlots, m_IsPackedFifos);
+		for (unsigned firIdx = 0; firIdx < numFirs; ++firIdx)
+			firstFitFirEngineDesc.bindFir(firEngineSpec, firIdx);
+		search.m_vBestFirEngineMacDesc = firstFitFirEngineDesc.m_vFirEngineMacDesc;
+		search.m_vBestFirBinding = firstFitFirEngineDesc.m_vFirBinding;
+	}
+
+	if (search.m_vBestFirEngineMacDesc.size() > search.m_LowerBoundNumFirMacs)
+		searchExactBinding(firEngineSpec, search, 0);
+
+	m_vFirEngineMacDesc = search.m_vBestFirEngineMacDesc;
+	m_vFirBinding = search.m_vBestFirBinding;
+	m_NumFirs = numFirs;
+	m_BinderName = string("Exact (") + toString(search.m_NumNodes) + " nodes explored" + (search.m_IsTimeUp ? ", time limit reached, best found)" : ")");
+}
+
+void FirEngineDesc::searchExactBinding(const FirEngineSpec& firEngineSpec, FirExactBindSearch& search, unsigned depth) const
+{
+	if (search.isTimeUp())
+		return;
+
+	if (depth == search.m_vFirOrder.size())
+	{
+		search.offerBinding(m_vFirEngineMacDesc, m_vFirBinding);
+		return;
+	}
+
+	// Prune if the remaining Coefficient-slots cannot fit in fewer MACs than the best binding
+	unsigned numFreeCoeffSlots = findNumFreeCoeffSlots();
+	unsigned numExtraCoeffSlots = (search.m_vRemainingLoad[depth] > numFreeCoeffSlots) ? (search.m_vRemainingLoad[depth] - numFreeCoeffSlots) : 0;
+	unsigned lowerBoundNumFirMacs = m_vFirEngineMacDesc.size() + IntUtils::ceilDiv(numExtraCoeffSlots, m_NumTimeSlots);
+	if (lowerBoundNumFirMacs >= search.m_vBestFirEngineMacDesc.size())
+		return;
+
+	unsigned firIdx = search.m_vFirOrder[depth];
+	const FirSpec& firSpec = firEngineSpec.m_vFirSpec[firIdx];
+	unsigned timeSliceInterval = search.m_vTimeSliceInterval[firIdx];
+
+	FirBinding firBinding;
+	firBinding.m_FirIndex = firIdx;
+	firBinding.m_TimeSliceInterval = timeSliceInterval;
+	firBinding.m_Decimation = firSpec.m_Decimation;
+	firBinding.m_vFirMacSection = search.m_vvFirMacSection[firIdx];
+
+	for (unsigned firMacIdx = 0; firMacIdx <= m_vFirEngineMacDesc.size(); ++firMacIdx)
+	{
+		// A chain starting on a 'new' MAC only uses new MACs, so every TimeSlice origin is equivalent
+		unsigned numOrigins = (firMacIdx == m_vFirEngineMacDesc.size()) ? 1 : firBinding.getOutputTimeSliceInterval();
+		for (unsigned timeSliceOffset = 0; timeSliceOffset < numOrigins; ++timeSliceOffset)
+		{
+			firBinding.m_FirstFirMacIndex = firMacIdx;
+			firBinding.m_TimeSliceOrigin = timeSliceOffset;
+
+			if (!canBind(firBinding))
+				continue;
+
+			FirEngineDesc nextFirEngineDesc(*this);
+			nextFirEngineDesc.bind(firEngineSpec, firBinding);
+			nextFirEngineDesc.searchExactBinding(firEngineSpec, search, depth + 1);
+
+			// A FIR sharing the Input of another FIR has no sections (so every binding of it is the same)
+			if (firBinding.getNumFirMacs() == 0)
+				return;
+
+			// Stop as soon as the best binding cannot be improved upon (or time is up)
+			if (search.m_IsTimeUp || (search.m_vBestFirEngineMacDesc.size() <= search.m_LowerBoundNumFirMacs))
+				return;
+		}
+	}
+}
@@ -0,0 +1,108 @@
+#include <assert.h>
+#include <algorithm>
+#include "stringutil.h"
+#include "firenginedesc.h"
+#include "firenginespec.h"
+#include "firenginebindingfile.h"
+
+
+static bool _isFirUnchanged(const FirSpec& firSpec, const FirSpec& prevFirSpec)
+{
+	return (firSpec.m_SampleFreq == prevFirSpec.m_SampleFreq) && (firSpec.m_Decimation == prevFirSpec.m_Decimation) && (firSpec.m_Interpolation == prevFirSpec.m_Interpolation) && (firSpec.m_ZeroThreshold == prevFirSpec.m_ZeroThreshold) && (firSpec.m_vCoeff == prevFirSpec.m_vCoeff) && (firSpec.m_InputFirIndex == prevFirSpec.m_InputFirIndex) &&
+		(firSpec.m_IsComplex == prevFirSpec.m_IsComplex) && (firSpec.m_vCoeffImag == prevFirSpec.m_vCoeffImag) && (firSpec.m_InPhaseFirIndex == prevFirSpec.m_InPhaseFirIndex);
+}
+
+// A FIR is bound with the taps of all the FIRs sharing its Input, so none of them may have changed (been added or removed)
+static bool _isFilterBankUnchanged(const vector<FirSpec>& vFirSpec, const vector<FirSpec>& vPrevFirSpec, unsigned firIdx)
+{
+	if (!_isFirUnchanged(vFirSpec[firIdx], vPrevFirSpec[firIdx]))
+		return false;
+	for (unsigned i = 0; i < max(vFirSpec.size(), vPrevFirSpec.size()); ++i)
+	{
+		bool isBankFir = (i < vFirSpec.size()) && (vFirSpec[i].m_InputFirIndex == firIdx);
+		bool isPrevBankFir = (i < vPrevFirSpec.size()) && (vPrevFirSpec[i].m_InputFirIndex == firIdx);
+		if ((isBankFir != isPrevBankFir) || (isBankFir && !_isFirUnchanged(vFirSpec[i], vPrevFirSpec[i])))
+			return false;
+	}
+	return true;
+}
+
+void FirEngineDesc::bindFirsIncremental(const FirEngineSpec& firEngineSpec, const FirEngineBindingFile& prevFirEngineBindingFile)
+{
+	assert(m_NumFirs == 0);
+	unsigned numFirs = firEngineSpec.m_vFirSpec.size();
+
+	vector<bool> vIsBound(numFirs, false);
+	unsigned numKeptFirs = 0;
+
+	// Re-make the previous bindings (in their original order) of FIRs which have not changed
+	//   (a different number of TimeSlots moves every FIR)
+	if (prevFirEngineBindingFile.m_NumTimeSlots == m_NumTimeSlots)
+	{
+		for (unsigned i = 0; i < prevFirEngineBindingFile.m_vFirBinding.size(); ++i)
+		{
+			const FirBinding& prevFirBinding = prevFirEngineBindingFile.m_vFirBinding[i];
+			unsigned firIdx = prevFirBinding.m_FirIndex;
+			if ((firIdx >= numFirs) || vIsBound[firIdx])
+				continue;		// FIR has been removed
+
+			const FirSpec& firSpec = firEngineSpec.m_vFirSpec[firIdx];
+			if (!_isFilterBankUnchanged(firEngineSpec.m_vFirSpec, prevFirEngineBindingFile.m_vFirSpec, firIdx))
+				continue;		// FIR has changed
+
+			// e.g. the clock frequency has changed
+			unsigned timeSliceInterval = findTimeSliceInterval(firEngineSpec, firIdx);
+			if (timeSliceInterval != prevFirBinding.m_TimeSliceInterval)
+				continue;
+
+			FirBinding firBinding(prevFirBinding);
+			firBinding.m_Decimation = firSpec.m_Decimation;
+			establishFirMacSections(firEngineSpec, firIdx, timeSliceInterval, &firBinding.m_vFirMacSection);
+			if (!canBind(firBinding))
+				continue;
+
+			bind(firEngineSpec, firBinding);
+			vIsBound[firIdx] = true;
+			++numKeptFirs;
+		}
+	}
+
+	// Added and changed FIRs go wherever they fit (starting with the slots freed by removed FIRs)
+	for (unsigned firIdx = 0; firIdx < numFirs; ++firIdx)
+	{
+		if (!vIsBound[firIdx])
+			bindFir(firEngineSpec, firIdx);
+	}
+
+	removeEmptyFirMacs();
+	establishLowerBoundNumFirMacs(firEngineSpec);
+	m_BinderName = string("Incremental (kept ") + toString(numKeptFirs) + " of " + toString(numFirs) + " FIRs in place)";
+}
+
+void FirEngineDesc::removeEmptyFirMacs()
+{
+	// Note: a chain never includes an empty MAC, so chains stay on consecutive MACs
+	vector<unsigned> vNewFirMacIdx(m_vFirEngineMacDesc.size());
+	unsigned numFirMacs = 0;
+	for (unsigned firMacIdx = 0; firMacIdx < m_vFirEngineMacDesc.size(); ++firMacIdx)
+	{
+		vNewFirMacIdx[firMacIdx] = numFirMacs;
+		if (m_vFirEngineMacDesc[firMacIdx].getNumFifos() > 0)
+		{
+			if (numFirMacs != firMacIdx)
+				m_vFirEngineMacDesc[numFirMacs] = m_vFirEngineMacDesc[firMacIdx];
+			++numFirMacs;
+		}
+	}
+	m_vFirEngineMacDesc.erase(m_vFirEngineMacDesc.begin() + numFirMacs, m_vFirEngineMacDesc.end());
+
+	for (unsigned i = 0; i < m_vFirBinding.size(); ++i)
+		m_vFirBinding[i].m_FirstFirMacIndex = vNewFirMacIdx[m_vFirBinding[i].m_FirstFirMacIndex];
+}
+
+void FirEngineDesc::establishBindingFile(const FirEngineSpec& firEngineSpec, FirEngineBindingFile* pFirEngineBindingFile) const
+{
+	pFirEngineBindingFile->m_NumTimeSlots = m_NumTimeSlots;
+	pFirEngineBindingFile->m_vFirSpec = firEngineSpec.m_vFirSpec;
+	pFirEngineBindingFile->m_vFirBinding = m_vFirBinding;
+}
@@ -0,0 +1,223 @@
+#include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include "intutils.h"
+#include "stringutil.h"
+#include "firenginedesc.h"
+#include "firenginespec.h"
+#include "firbindheuristic.h"
+
+
+unsigned FirEngineDesc::getNumFifoMemWords() const
+{
+	unsigned numFifoMemWords = 0;
+	for (unsigned firMacIdx = 0; firMacIdx < m_vFirEngineMacDesc.size(); ++firMacIdx)
+		numFifoMemWords += m_vFirEngineMacDesc[firMacIdx].getNumFifoMemWords();
+	return numFifoMemWords;
+}
+
+unsigned FirEngineDesc::getNumBram36() const
+{
+	unsigned numBram36 = 0;
+	for (unsigned firMacIdx = 0; firMacIdx < m_vFirEngineMacDesc.size(); ++firMacIdx)
+		numBram36 += m_vFirEngineMacDesc[firMacIdx].getNumBram36();
+	return numBram36;
+}
+
+unsigned FirEngineDesc::getNumBram18() const
+{
+	unsigned numBram18 = 0;
+	for (unsigned firMacIdx = 0; firMacIdx < m_vFirEngineMacDesc.size(); ++firMacIdx)
+		numBram18 += m_vFirEngineMacDesc[firMacIdx].getNumBram18();
+	return numBram18;
+}
+
+FirBinding FirEngineDesc::findBestFitBinding(const FirEngineSpec& firEngineSpec, unsigned firIndex, unsigned timeSliceInterval) const
+{
+	const FirSpec& firSpec = firEngineSpec.m_vFirSpec[firIndex];
+
+	vector<unsigned> vNumFreeCoeffSlots;
+	for (unsigned firMacIdx = 0; firMacIdx < m_vFirEngineMacDesc.size(); ++firMacIdx)
+		vNumFreeCoeffSlots.push_back(m_vFirEngineMacDesc[firMacIdx].getNumFreeCoeffSlots());
+
+	FirBinding bestFirBinding;
+	unsigned bestNumFreeCoeffSlots = 0;
+	bool isBestFound = false;
+
+	FirBinding firBinding;
+	firBinding.m_FirIndex = firIndex;
+	firBinding.m_TimeSliceInterval = timeSliceInterval;
+	firBinding.m_Decimation = firSpec.m_Decimation;
+	establishFirMacSections(firEngineSpec, firIndex, timeSliceInterval, &firBinding.m_vFirMacSection);
+
+	// a 'new' MAC always binds, but is only the best fit when nothing else does
+	for (unsigned firMacIdx = 0; firMacIdx <= m_vFirEngineMacDesc.size(); ++firMacIdx)
+	{
+		// Free Coefficient-slots left on the MACs used by the chain (new MACs are entirely free)
+		unsigned numFreeCoeffSlots = 0;
+		for (unsigned i = 0; i < firBinding.getNumFirMacs(); ++i)
+		{
+			unsigned chainFirMacIdx = firMacIdx + i;
+			numFreeCoeffSlots += (chainFirMacIdx < vNumFreeCoeffSlots.size()) ? vNumFreeCoeffSlots[chainFirMacIdx] : m_NumTimeSlots;
+		}
+		if (isBestFound && (numFreeCoeffSlots >= bestNumFreeCoeffSlots))
+			continue;
+
+		for (unsigned timeSliceOffset = 0; timeSliceOffset < firBinding.getOutputTimeSliceInterval(); ++timeSliceOffset)
+		{
+			firBinding.m_FirstFirMacIndex = firMacIdx;
+			firBinding.m_TimeSliceOrigin = timeSliceOffset;
+
+			if (canBind(firBinding))
+			{
+				bestFirBinding = firBinding;
+				bestNumFreeCoeffSlots = numFreeCoeffSlots;
+				isBestFound = true;
+				break;
+			}
+		}
+	}
+
+	assert(isBestFound);		// Should always be able to bind!
+	return bestFirBinding;
+}
+
+void FirEngineDesc::bindFirsWithHeuristic(const FirEngineSpec& firEngineSpec, const FirBindHeuristic& firBindHeuristic)
+{
+	for (unsigned i = 0; i < firBindHeuristic.m_vFirOrder.size(); ++i)
+	{
+		unsigned firIdx = firBindHeuristic.m_vFirOrder[i];
+		unsigned timeSliceInterval = findTimeSliceInterval(firEngineSpec, firIdx);
+
+		FirBinding firBinding;
+		if (firBindHeuristic.m_IsBestFit)
+			firBinding = findBestFitBinding(firEngineSpec, firIdx, timeSliceInterval);
+		else
+			firBinding = findValidBinding(firEngineSpec, firIdx, timeSliceInterval);
+		bind(firEngineSpec, firBinding);
+	}
+	m_BinderName = firBindHeuristic.m_Name;
+}
+
+void FirEngineDesc::establishBindHeuristics(const FirEngineSpec& firEngineSpec, vector<FirBindHeuristic>* pvFirBindHeuristic) const
+{
+	const unsigned numRandomRestarts = 16;
+	unsigned numFirs = firEngineSpec.m_vFirSpec.size();
+
+	// Per FIR: Coefficient-slot load (taps x rate) and number of taps
+	vector<unsigned> vNumCoeffSlots;
+	vector<unsigned> vNumTaps;
+	for (unsigned firIdx = 0; firIdx < numFirs; ++firIdx)
+	{
+		unsigned timeSliceInterval = findTimeSliceInterval(firEngineSpec, firIdx);
+		vector<FirMacSection> vFirMacSection;
+		establishFirMacSections(firEngineSpec, firIdx, timeSliceInterval, &vFirMacSection);
+		vNumCoeffSlots.push_back(findNumCoeffSlots(vFirMacSection));
+		vNumTaps.push_back(firEngineSpec.m_vFirSpec[firIdx].m_vCoeff.size());
+	}
+
+	vector<unsigned> vSpecOrder;
+	for (unsigned firIdx = 0; firIdx < numFirs; ++firIdx)
+		vSpecOrder.push_back(firIdx);
+
+	vector<unsigned> vLoadOrder(vSpecOrder);
+	stable_sort(vLoadOrder.begin(), vLoadOrder.end(), [&vNumCoeffSlots](unsigned a, unsigned b) { return vNumCoeffSlots[a] > vNumCoeffSlots[b]; });
+
+	vector<unsigned> vTapsOrder(vSpecOrder);
+	stable_sort(vTapsOrder.begin(), vTapsOrder.end(), [&vNumTaps](unsigned a, unsigned b) { return vNumTaps[a] > vNumTaps[b]; });
+
+	pvFirBindHeuristic->clear();
+	const vector<unsigned>* pvOrders[] = { &vSpecOrder, &vLoadOrder, &vTapsOrder };
+	const char* orderNames[] = { "spec order", "descending load", "descending taps" };
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		for (unsigned j = 0; j < 2; ++j)
+		{
+			FirBindHeuristic firBindHeuristic;
+			firBindHeuristic.m_vFirOrder = *pvOrders[i];
+			firBindHeuristic.m_IsBestFit = (j == 1);
+			firBindHeuristic.m_Name = string(orderNames[i]) + (firBindHeuristic.m_IsBestFit ? ", best-fit" : ", first-fit");
+			pvFirBindHeuristic->push_back(firBindHeuristic);
+		}
+	}
+
+	// Randomized restarts (seeded, so that builds are reproducible)
+	for (unsigned i = 0; i < numRandomRestarts; ++i)
+	{
+		FirBindHeuristic firBindHeuristic;
+		firBindHeuristic.m_vFirOrder = vSpecOrder;
+		mt19937 randomGenerator(i + 1);
+		shuffle(firBindHeuristic.m_vFirOrder.begin(), firBindHeuristic.m_vFirOrder.end(), randomGenerator);
+		firBindHeuristic.m_IsBestFit = ((i % 2) == 1);
+		firBindHeuristic.m_Name = string("random order #") + toString(i + 1) + (firBindHeuristic.m_IsBestFit ? ", best-fit" : ", first-fit");
+		pvFirBindHeuristic->push_back(firBindHeuristic);
+	}
+}
+
+void FirEngineDesc::bindFirsPortfolio(const FirEngineSpec& firEngineSpec, unsigned numThreads)
+{
+	assert(m_NumFirs == 0);
+
+	// Note: also reports any FIR that cannot be bound, before any threads are started
+	establishLowerBoundNumFirMacs(firEngineSpec);
+
+	vector<FirBindHeuristic> vFirBindHeuristic;
+	establishBindHeuristics(firEngineSpec, &vFirBindHeuristic);
+
+	if (numThreads == 0)
+		numThreads = max(1u, thread::hardware_concurrency());
+	numThreads = min(numThreads, unsigned(vFirBindHeuristic.size()));
+
+	// Each heuristic binds into its own copy of this (empty) FirEngineDesc
+	vector<FirEngineDesc> vFirEngineDesc(vFirBindHeuristic.size(), *this);
+	vector<string> vErrMsg(vFirBindHeuristic.size());
+	atomic<unsigned> nextHeuristicIdx(0);
+
+	vector<thread> vThread;
+	for (unsigned i = 0; i < numThreads; ++i)
+	{
+		vThread.push_back(thread([&]()
+		{
+			for (unsigned heuristicIdx = nextHeuristicIdx++; heuristicIdx < vFirBindHeuristic.size(); heuristicIdx = nextHeuristicIdx++)
+			{
+				try
+				{
+					vFirEngineDesc[heuristicIdx].bindFirsWithHeuristic(firEngineSpec, vFirBindHeuristic[heuristicIdx]);
+				}
+				catch (const string& errMsg)
+				{
+					vErrMsg[heuristicIdx] = errMsg;
+				}
+			}
+		}));
+	}
+	for (unsigned i = 0; i < vThread.size(); ++i)
+		vThread[i].join();
+
+	// Fewest MACs, then fewest Block RAMs (counted as BRAM18s), then fewest Fifo words
+	//   (ties go to the earlier heuristic, so the result does not depend on numThreads)
+	unsigned bestIdx = 0;
+	for (unsigned i = 0; i < vFirEngineDesc.size(); ++i)
+	{
+		if (!vErrMsg[i].empty())
+			throw vErrMsg[i];
+
+		unsigned numFirMacs = vFirEngineDesc[i].m_vFirEngineMacDesc.size();
+		unsigned bestNumFirMacs = vFirEngineDesc[bestIdx].m_vFirEngineMacDesc.size();
+		unsigned numBram18 = (2 * vFirEngineDesc[i].getNumBram36()) + vFirEngineDesc[i].getNumBram18();
+		unsigned bestNumBram18 = (2 * vFirEngineDesc[bestIdx].getNumBram36()) + vFirEngineDesc[bestIdx].getNumBram18();
+		if ((numFirMacs < bestNumFirMacs) ||
+			((numFirMacs == bestNumFirMacs) && (numBram18 < bestNumBram18)) ||
+			((numFirMacs == bestNumFirMacs) && (numBram18 == bestNumBram18) && (vFirEngineDesc[i].getNumFifoMemWords() < vFirEngineDesc[bestIdx].getNumFifoMemWords())))
+		{
+			bestIdx = i;
+		}
+	}
+
+	m_vFirEngineMacDesc = vFirEngineDesc[bestIdx].m_vFirEngineMacDesc;
+	m_vFirBinding = vFirEngineDesc[bestIdx].m_vFirBinding;
+	m_NumFirs = vFirEngineDesc[bestIdx].m_NumFirs;
+	m_BinderName = string("Portfolio (") + vFirBindHeuristic[bestIdx].m_Name + ")";
+}
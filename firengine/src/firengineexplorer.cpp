@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <math.h>
+#include <assert.h>
+#include <limits.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "intutils.h"
+#include "stringutil.h"
+#include "firengineexplorer.h"
+#include "firenginedesc.h"
+
+
+FirEngineExplorer::FirEngineExplorer() :
+	m_MinNumTimeSlots	(16),
+	m_MaxNumTimeSlots	(1024),
+	m_vFirExplorePoint	(),
+	m_ResourceBudget	(),
+	m_ChosenPointIndex	(0)
+{
+}
+
+void FirEngineExplorer::establishCandidateNumTimeSlots(const FirEngineSpec& firEngineSpec, vector<unsigned>* pvNumTimeSlots) const
+{
+	pvNumTimeSlots->clear();
+	for (unsigned numTimeSlots = m_MinNumTimeSlots; numTimeSlots <= m_MaxNumTimeSlots; numTimeSlots *= 2)
+		pvNumTimeSlots->push_back(numTimeSlots);
+
+	for (unsigned firIdx = 0; firIdx < firEngineSpec.m_vFirSpec.size(); ++firIdx)
+	{
+		const FirSpec& firSpec = firEngineSpec.m_vFirSpec[firIdx];
+		unsigned outputTimeSliceInterval = unsigned(floor(firEngineSpec.m_ClockFreq / firSpec.m_SampleFreq)) * firSpec.m_Decimation;
+		if (outputTimeSliceInterval == 0)
+			continue;		// sample rate too high (reported by the binding)
+
+		for (unsigned numTimeSlots = IntUtils::roundupToMultipleOf(m_MinNumTimeSlots, outputTimeSliceInterval); numTimeSlots <= m_MaxNumTimeSlots; numTimeSlots += outputTimeSliceInterval)
+			pvNumTimeSlots->push_back(numTimeSlots);
+	}
+
+	sort(pvNumTimeSlots->begin(), pvNumTimeSlots->end());
+	pvNumTimeSlots->erase(unique(pvNumTimeSlots->begin(), pvNumTimeSlots->end()), pvNumTimeSlots->end());
+}
+
+void FirEngineExplorer::explore(const FirEngineSpec& firEngineSpec, const vector<double>& vClockFreq, bool isPackedFifos, unsigned numThreads, const FirResourceBudget& resourceBudget)
+{
+	assert(!vClockFreq.empty());
+	m_ResourceBudget = resourceBudget;
+
+	// Within a budget, the portfolio binder may fit where first-fit does not
+	unsigned numBinders = m_ResourceBudget.isLimited() ? 2 : 1;
+
+	// The same FIRs at each ClockFreq
+	vector<FirEngineSpec> vFirEngineSpec;
+	vector<unsigned> vPointClockIdx;
+	m_vFirExplorePoint.clear();
+	for (unsigned clockIdx = 0; clockIdx < vClockFreq.size(); ++clockIdx)
+	{
+		vFirEngineSpec.push_back(FirEngineSpec(firEngineSpec, vClockFreq[clockIdx]));
+
+		vector<unsigned> vNumTimeSlots;
+		establishCandidateNumTimeSlots(vFirEngineSpec.back(), &vNumTimeSlots);
+		for (unsigned i = 0; i < vNumTimeSlots.size(); ++i)
+		{
+			for (unsigned binderIdx = 0; binderIdx < numBinders; ++binderIdx)
+			{
+				FirExplorePoint firExplorePoint;
+				firExplorePoint.m_ClockFreq = vClockFreq[clockIdx];
+				firExplorePoint.m_NumTimeSlots = vNumTimeSlots[i];
+				firExplorePoint.m_IsPortfolioBind = (binderIdx == 1);
+				m_vFirExplorePoint.push_back(firExplorePoint);
+				vPointClockIdx.push_back(clockIdx);
+			}
+		}
+	}
+
+	if (numThreads == 0)
+		numThreads = max(1u, thread::hardware_concurrency());
+	numThreads = min(numThreads, unsigned(m_vFirExplorePoint.size()));
+
+	// Each point binds into its own FirEngineDesc (kept only for as long as it takes to measure it)
+	atomic<unsigned> nextPointIdx(0);
+	vector<thread> vThread;
+	for (unsigned i = 0; i < numThreads; ++i)
+	{
+		vThread.push_back(thread([&]()
+		{
+			for (unsigned pointIdx = nextPointIdx++; pointIdx < m_vFirExplorePoint.size(); pointIdx = nextPointIdx++)
+			{
+				FirExplorePoint& firExplorePoint = m_vFirExplorePoint[pointIdx];
+				const FirEngineSpec& clockFirEngineSpec = vFirEngineSpec[vPointClockIdx[pointIdx]];
+				try
+				{
+					FirEngineDesc firEngineDesc(firExplorePoint.m_NumTimeSlots, isPackedFifos);
+
+					// Fail fast: no binding fits a budget of fewer MACs than the lower bound
+					firEngineDesc.establishLowerBoundNumFirMacs(clockFirEngineSpec);
+					firExplorePoint.m_LowerBoundNumFirMacs = firEngineDesc.m_LowerBoundNumFirMacs;
+					if ((m_ResourceBudget.m_MaxNumFirMacs > 0) && (firExplorePoint.m_LowerBoundNumFirMacs > m_ResourceBudget.m_MaxNumFirMacs))
+						throw string("needs at least ") + toString(firExplorePoint.m_LowerBoundNumFirMacs) + " FirMacs";
+
+					// (the points already run concurrently, so each portfolio runs its heuristics on this thread)
+					if (firExplorePoint.m_IsPortfolioBind)
+						firEngineDesc.bindFirsPortfolio(clockFirEngineSpec, 1);
+					else for (unsigned firIdx = 0; firIdx < clockFirEngineSpec.m_vFirSpec.size(); ++firIdx)
+						firEngineDesc.bindFir(clockFirEngineSpec, firIdx);
+
+					firExplorePoint.m_NumFirMacs = firEngineDesc.m_vFirEngineMacDesc.size();
+					firExplorePoint.m_NumFifoMemWords = firEngineDesc.getNumFifoMemWords();
+					firExplorePoint.m_NumBram36 = firEngineDesc.getNumBram36();
+					firExplorePoint.m_NumBram18 = firEngineDesc.getNumBram18();
+					firExplorePoint.m_WorstCaseLatency = firEngineDesc.getWorstCaseLatency();
+				}
+				catch (const string& errMsg)
+				{
+					firExplorePoint.m_ErrMsg = errMsg;
+				}
+			}
+		}));
+	}
+	for (unsigned i = 0; i < vThread.size(); ++i)
+		vThread[i].join();
+
+	establishParetoFrontier();
+	if (m_ResourceBudget.isLimited())
+		chooseWithinResourceBudget();
+}
+
+bool FirEngineExplorer::isBetterChoice(const FirExplorePoint& firExplorePoint, const FirExplorePoint& chosenPoint) const
+{
+	// Most headroom (all points have the same when nothing is limited), then fewest MACs, then fewest Block RAMs (counted as BRAM18s), then lowest latency
+	//   (ties go to the earlier point, the lower ClockFreq and NumTimeSlots, and first-fit)
+	double headroom = m_ResourceBudget.findHeadroom(firExplorePoint.m_NumFirMacs, firExplorePoint.getNumBram36Equivalents());
+	double chosenHeadroom = m_ResourceBudget.findHeadroom(chosenPoint.m_NumFirMacs, chosenPoint.getNumBram36Equivalents());
+	if (headroom != chosenHeadroom)
+		return headroom > chosenHeadroom;
+	if (firExplorePoint.m_NumFirMacs != chosenPoint.m_NumFirMacs)
+		return firExplorePoint.m_NumFirMacs < chosenPoint.m_NumFirMacs;
+	if (firExplorePoint.getNumBram18Equivalents() != chosenPoint.getNumBram18Equivalents())
+		return firExplorePoint.getNumBram18Equivalents() < chosenPoint.getNumBram18Equivalents();
+	return firExplorePoint.getWorstCaseLatencySeconds() < chosenPoint.getWorstCaseLatencySeconds();
+}
+
+void FirEngineExplorer::establishParetoFrontier()
+{
+	bool isChosen = false;
+	for (unsigned i = 0; i < m_vFirExplorePoint.size(); ++i)
+	{
+		FirExplorePoint& firExplorePoint = m_vFirExplorePoint[i];
+		firExplorePoint.m_IsParetoOptimal = firExplorePoint.isBound();
+		for (unsigned j = 0; firExplorePoint.m_IsParetoOptimal && (j < m_vFirExplorePoint.size()); ++j)
+		{
+			if (m_vFirExplorePoint[j].dominates(firExplorePoint) || ((j < i) && m_vFirExplorePoint[j].isEquivalent(firExplorePoint)))
+				firExplorePoint.m_IsParetoOptimal = false;
+		}
+		if (!firExplorePoint.m_IsParetoOptimal)
+			continue;
+
+		if (!isChosen || isBetterChoice(firExplorePoint, m_vFirExplorePoint[m_ChosenPointIndex]))
+		{
+			m_ChosenPointIndex = i;
+			isChosen = true;
+		}
+	}
+
+	// (within a budget, chooseWithinResourceBudget reports why nothing fits)
+	if (!isChosen && !m_ResourceBudget.isLimited())
+	{
+		string errMsg = m_vFirExplorePoint.empty() ? string("no candidate points") : m_vFirExplorePoint[0].m_ErrMsg;
+		throw string("Unable to bind the FIRs at any explored ClockFreq and NumTimeSlots (") + errMsg + ")";
+	}
+}
+
+void FirEngineExplorer::chooseWithinResourceBudget()
+{
+	// Any bound point within the budget may be chosen (its headroom matters more than being on the frontier)
+	bool isChosen = false;
+	bool isSmallestBound = false;
+	unsigned smallestPointIdx = 0;
+	unsigned lowerBoundNumFirMacs = UINT_MAX;
+	for (unsigned i = 0; i < m_vFirExplorePoint.size(); ++i)
+	{
+		const FirExplorePoint& firExplorePoint = m_vFirExplorePoint[i];
+		if (firExplorePoint.m_LowerBoundNumFirMacs > 0)
+			lowerBoundNumFirMacs = min(lowerBoundNumFirMacs, firExplorePoint.m_LowerBoundNumFirMacs);
+		if (!firExplorePoint.isBound())
+			continue;
+
+		const FirExplorePoint& smallestPoint = m_vFirExplorePoint[smallestPointIdx];
+		if (!isSmallestBound ||
+			(firExplorePoint.m_NumFirMacs < smallestPoint.m_NumFirMacs) ||
+			((firExplorePoint.m_NumFirMacs == smallestPoint.m_NumFirMacs) && (firExplorePoint.getNumBram36Equivalents() < smallestPoint.getNumBram36Equivalents())))
+		{
+			smallestPointIdx = i;
+			isSmallestBound = true;
+		}
+
+		if (!m_ResourceBudget.isWithinBudget(firExplorePoint.m_NumFirMacs, firExplorePoint.getNumBram36Equivalents()))
+			continue;
+		if (!isChosen || isBetterChoice(firExplorePoint, m_vFirExplorePoint[m_ChosenPointIndex]))
+		{
+			m_ChosenPointIndex = i;
+			isChosen = true;
+		}
+	}
+
+	if (!isChosen)
+	{
+		string errMsg = string("The FIRs do not fit the resource budget of ") + m_ResourceBudget.getDescription();
+		if ((lowerBoundNumFirMacs != UINT_MAX) && (lowerBoundNumFirMacs > m_ResourceBudget.m_MaxNumFirMacs) && (m_ResourceBudget.m_MaxNumFirMacs > 0))
+		{
+			errMsg += string(": no binding can use fewer than ") + toString(lowerBoundNumFirMacs) + " FirMacs";
+		}
+		else if (isSmallestBound)
+		{
+			const FirExplorePoint& smallestPoint = m_vFirExplorePoint[smallestPointIdx];
+			errMsg += string(": the smallest binding found uses ") + toString(smallestPoint.m_NumFirMacs) + " FirMacs and " + toString(smallestPoint.getNumBram36Equivalents()) + " BRAM36"
+				+ " (ClockFreq " + toString(unsigned(smallestPoint.m_ClockFreq)) + ", NumTimeSlices " + toString(smallestPoint.m_NumTimeSlots) + ", " + smallestPoint.getBinderName() + " binder)";
+		}
+		else
+		{
+			errMsg += string(" (") + (m_vFirExplorePoint.empty() ? string("no candidate points") : m_vFirExplorePoint[0].m_ErrMsg) + ")";
+		}
+		throw errMsg;
+	}
+}
+
+void FirEngineExplorer::printParetoTable() const
+{
+	unsigned numBoundPoints = 0;
+	for (unsigned i = 0; i < m_vFirExplorePoint.size(); ++i)
+		numBoundPoints += m_vFirExplorePoint[i].isBound() ? 1 : 0;
+	printf("Explored %u points (%u could bind the FIRs), Pareto frontier:\n", unsigned(m_vFirExplorePoint.size()), numBoundPoints);
+	if (m_ResourceBudget.isLimited())
+		printf("Resource budget: %s\n", m_ResourceBudget.getDescription().c_str());
+
+	printf("  %12s %13s %10s %10s %15s %9s %9s %16s %8s\n", "ClockFreq", "NumTimeSlices", "Binder", "NumFirMacs", "NumFifoMemWords", "NumBram36", "NumBram18", "WorstCaseLatency", "Headroom");
+	for (unsigned i = 0; i < m_vFirExplorePoint.size(); ++i)
+	{
+		// (the chosen point is shown even when a point outside the budget dominates it)
+		const FirExplorePoint& firExplorePoint = m_vFirExplorePoint[i];
+		if (!firExplorePoint.m_IsParetoOptimal && (i != m_ChosenPointIndex))
+			continue;
+		printf("%s %12u %13u %10s %10u %15u %9u %9u %13.0f ns %7.0f%%\n", (i == m_ChosenPointIndex) ? "*" : " ",
+			unsigned(firExplorePoint.m_ClockFreq), firExplorePoint.m_NumTimeSlots, firExplorePoint.getBinderName().c_str(), firExplorePoint.m_NumFirMacs, firExplorePoint.m_NumFifoMemWords,
+			firExplorePoint.m_NumBram36, firExplorePoint.m_NumBram18, 1e9 * firExplorePoint.getWorstCaseLatencySeconds(),
+			100.0 * m_ResourceBudget.findHeadroom(firExplorePoint.m_NumFirMacs, firExplorePoint.getNumBram36Equivalents()));
+	}
+}
+
+void FirEngineExplorer::generateHtmlReport(ostream& stream) const
+{
+	unsigned numBoundPoints = 0;
+	for (unsigned i = 0; i < m_vFirExplorePoint.size(); ++i)
+		numBoundPoints += m_vFirExplorePoint[i].isBound() ? 1 : 0;
+
+	stream << "<h2>Design-Space Exploration</h2>\n";
+	stream << "<table class=\"t1\">\n";
+	stream << "<tr><th>NumPoints</th><td>" << m_vFirExplorePoint.size() << "</td></tr>\n";
+	stream << "<tr><th>NumBoundPoints</th><td>" << numBoundPoints << "</td></tr>\n";
+	stream << "<tr><th>ChosenClockFreq</th><td>" << unsigned(getChosenPoint().m_ClockFreq) << "</td></tr>\n";
+	stream << "<tr><th>ChosenNumTimeSlices</th><td>" << getChosenPoint().m_NumTimeSlots << "</td></tr>\n";
+	stream << "<tr><th>ChosenBinder</th><td>" << getChosenPoint().getBinderName() << "</td></tr>\n";
+	if (m_ResourceBudget.isLimited())
+	{
+		stream << "<tr><th>ResourceBudget</th><td>" << m_ResourceBudget.getDescription() << "</td></tr>\n";
+		stream << "<tr><th>ChosenHeadroom</th><td>" << unsigned(100.0 * m_ResourceBudget.findHeadroom(getChosenPoint().m_NumFirMacs, getChosenPoint().getNumBram36Equivalents())) << "%</td></tr>\n";
+	}
+	stream << "</table>\n\n";
+
+	// The Pareto frontier (the points no other point beats in MACs, Fifo words and latency)
+	stream << "<table class=\"t1\">\n";
+	stream << "<tr><th>ClockFreq</th><th>NumTimeSlices</th><th>Binder</th><th>NumFirMacs</th><th>NumFifoMemWords</th><th>NumBram36</th><th>NumBram18</th><th>WorstCaseLatency</th><th>Chosen</th></tr>\n";
+	for (unsigned i = 0; i < m_vFirExplorePoint.size(); ++i)
+	{
+		const FirExplorePoint& firExplorePoint = m_vFirExplorePoint[i];
+		if (!firExplorePoint.m_IsParetoOptimal && (i != m_ChosenPointIndex))
+			continue;
+		stream << "<tr><td>" << unsigned(firExplorePoint.m_ClockFreq) << "</td><td>" << firExplorePoint.m_NumTimeSlots << "</td><td>" << firExplorePoint.getBinderName() << "</td><td>" << firExplorePoint.m_NumFirMacs
+			<< "</td><td>" << firExplorePoint.m_NumFifoMemWords << "</td><td>" << firExplorePoint.m_NumBram36 << "</td><td>" << firExplorePoint.m_NumBram18
+			<< "</td><td>" << firExplorePoint.m_WorstCaseLatency << " cycles (" << unsigned(1e9 * firExplorePoint.getWorstCaseLatencySeconds()) << " ns)</td><td>"
+			<< ((i == m_ChosenPointIndex) ? "&#9733;" : "") << "</td></tr>\n";
+	}
+	stream << "</table>\n\n";
+}
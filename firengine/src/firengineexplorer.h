@@ -0,0 +1,52 @@
+#ifndef FIRENGINEEXPLORER_H
+#define FIRENGINEEXPLORER_H
+
+
+#include <vector>
+#include <ostream>
+#include "firenginespec.h"
+#include "firexplorepoint.h"
+#include "firresourcebudget.h"
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// Design-space exploration over ClockFreq and NumTimeSlots
+///   The FIRs are bound (in memory) at every candidate point,
+///   and the points which no other point beats in MACs, Fifo
+///   words and worst-case latency form the Pareto frontier
+///   With a ResourceBudget the portfolio binder is tried too,
+///   and the point with the most headroom in the budget wins
+/////////////////////////////////////////////////////////////
+
+class FirEngineExplorer
+{
+public:
+	FirEngineExplorer();
+public:
+	/// Bind the FIRs (first-fit) at every candidate ClockFreq and NumTimeSlots (run concurrently on numThreads, 0 = all cores)
+	///   then choose the frontier point with the fewest MACs, then the fewest Block RAMs, then the lowest latency
+	///   (when the ResourceBudget is limited, the point within it with the most headroom, or throw if there is none)
+	void explore(const FirEngineSpec&, const vector<double>& vClockFreq, bool isPackedFifos, unsigned numThreads, const FirResourceBudget&);
+	const FirExplorePoint& getChosenPoint() const		{ return m_vFirExplorePoint[m_ChosenPointIndex]; }
+	void printParetoTable() const;
+	void generateHtmlReport(ostream&) const;
+private:
+	/// Candidate NumTimeSlots: powers of 2, and the multiples of each FIR's Output interval (so that its Updates need not be rounded down)
+	void establishCandidateNumTimeSlots(const FirEngineSpec&, vector<unsigned>* pOut) const;
+	void establishParetoFrontier();
+	void chooseWithinResourceBudget();
+	/// Is the point chosen before the chosen point (within the budget: more headroom, then fewer MACs, Block RAMs and lower latency)
+	bool isBetterChoice(const FirExplorePoint&, const FirExplorePoint& chosenPoint) const;
+public:
+	/// Range of NumTimeSlots explored
+	const unsigned				m_MinNumTimeSlots;
+	const unsigned				m_MaxNumTimeSlots;
+	/// Every point explored (in ClockFreq, then NumTimeSlots order)
+	vector<FirExplorePoint>		m_vFirExplorePoint;
+	FirResourceBudget			m_ResourceBudget;
+	unsigned					m_ChosenPointIndex;
+};
+
+
+#endif
@@ -1,5 +1,6 @@
 
 #include <stdlib.h>
+#include <sstream>
 #include "getopt.h"
 #include "firengineglobals.h"
 
@@ -7,15 +8,30 @@
 FirEngineGlobals::FirEngineGlobals() :
 	m_FirEngineName		("unknown"),
 	m_ClockFreq			(400e6),
-	m_NumTimeSlices		(16)
+	m_NumTimeSlices		(16),
+	m_ExactBindTimeLimit	(0.0),
+	m_IsKernelHeaderOnly	(false),
+	m_IsPortfolioBind	(false),
+	m_NumBindThreads	(0),
+	m_IsIncrementalBind	(false),
+	m_IsPackedFifos		(false),
+	m_vExploreClockFreq	(),
+	m_ResourceBudget	(),
+	m_NumSimSamples		(0),
+	m_NumRefSamples		(0),
+	m_NumCpuSamples		(0),
+	m_IsCpuFloat		(false),
+	m_NumCpuThreads		(0),
+	m_MaxCpuLatency		(0.0),
+	m_CpuSampleFname	()
 {
 }
 
 void FirEngineGlobals::parseArgs(int argc, char* argv[])
 {
-	static char usage[] = "usage: %s [-f ClockFreq] [-t timeSlices] firEngineName";
+	static char usage[] = "usage: %s [-f ClockFreq] [-t timeSlices] [-x exactBindTimeLimitSeconds] [-j numBindThreads] [-i] [-p] [-e exploreClockFreq,...] [-m maxFirMacs] [-b maxBram36] [-s numSimSamples] [-r numRefSamples] [-c numCpuSamples] [-a fixed|float] [-w numCpuThreads] [-l maxCpuLatencySeconds] [-d cpuSampleFile] [-k] firEngineName";
 	char c;
-	while ((c = getopt(argc, argv, "-f:-t:")) != -1)
+	while ((c = getopt(argc, argv, "-f:-t:-x:-j:-i-p-e:-m:-b:-s:-r:-c:-a:-w:-l:-d:-k")) != -1)
 	{
 		switch (c)
 		{
@@ -25,6 +41,66 @@ void FirEngineGlobals::parseArgs(int argc, char* argv[])
 		case 't':
 			m_NumTimeSlices = stoi(optarg);
 			break;
+		case 'x':
+			m_ExactBindTimeLimit = stod(optarg);
+			break;
+		case 'j':
+			m_IsPortfolioBind = true;
+			m_NumBindThreads = stoi(optarg);
+			break;
+		case 'i':
+			m_IsIncrementalBind = true;
+			break;
+		case 'p':
+			m_IsPackedFifos = true;
+			break;
+		case 'e':
+			{
+				// comma separated list of clock frequencies
+				istringstream stream(optarg);
+				string clockFreqStr;
+				while (getline(stream, clockFreqStr, ','))
+					m_vExploreClockFreq.push_back(stod(clockFreqStr));
+			}
+			break;
+		case 'm':
+			m_ResourceBudget.m_MaxNumFirMacs = stoi(optarg);
+			break;
+		case 'b':
+			m_ResourceBudget.m_MaxNumBram36 = stoi(optarg);
+			break;
+		case 's':
+			m_NumSimSamples = stoi(optarg);
+			break;
+		case 'r':
+			m_NumRefSamples = stoi(optarg);
+			break;
+		case 'c':
+			m_NumCpuSamples = stoi(optarg);
+			break;
+		case 'a':
+			if (string(optarg) == "float")
+				m_IsCpuFloat = true;
+			else if (string(optarg) == "fixed")
+				m_IsCpuFloat = false;
+			else
+			{
+				fprintf(stderr, usage, argv[0]);
+				exit(1);
+			}
+			break;
+		case 'w':
+			m_NumCpuThreads = stoi(optarg);
+			break;
+		case 'l':
+			m_MaxCpuLatency = stod(optarg);
+			break;
+		case 'd':
+			m_CpuSampleFname = optarg;
+			break;
+		case 'k':
+			m_IsKernelHeaderOnly = true;
+			break;
 		case '?':
 			fprintf(stderr, usage, argv[0]);
 			exit(1);
@@ -52,5 +128,35 @@ void FirEngineGlobals::generateHtmlReport(ostream& stream) const
 	stream << "<tr><th>FirEngineName</th><td>" << m_FirEngineName << "</td></tr>\n";
 	stream << "<tr><th>ClockFreq</th><td>" << unsigned(m_ClockFreq) << "</td></tr>\n";
 	stream << "<tr><th>NumTimeSlices</th><td>" << m_NumTimeSlices << "</td></tr>\n";
+	if (m_ExactBindTimeLimit > 0.0)
+		stream << "<tr><th>ExactBindTimeLimit</th><td>" << m_ExactBindTimeLimit << "s</td></tr>\n";
+	if (m_IsPortfolioBind)
+		stream << "<tr><th>NumBindThreads</th><td>" << m_NumBindThreads << "</td></tr>\n";
+	if (m_IsIncrementalBind)
+		stream << "<tr><th>IncrementalBind</th><td>yes</td></tr>\n";
+	if (m_IsPackedFifos)
+		stream << "<tr><th>PackedFifos</th><td>yes</td></tr>\n";
+	if (!m_vExploreClockFreq.empty())
+	{
+		stream << "<tr><th>ExploreClockFreqs</th><td>";
+		for (unsigned i = 0; i < m_vExploreClockFreq.size(); ++i)
+			stream << ((i > 0) ? ", " : "") << unsigned(m_vExploreClockFreq[i]);
+		stream << "</td></tr>\n";
+	}
+	if (m_ResourceBudget.isLimited())
+		stream << "<tr><th>ResourceBudget</th><td>" << m_ResourceBudget.getDescription() << "</td></tr>\n";
+	if (m_NumSimSamples > 0)
+		stream << "<tr><th>NumSimSamples</th><td>" << m_NumSimSamples << "</td></tr>\n";
+	if (m_NumRefSamples > 0)
+		stream << "<tr><th>NumRefSamples</th><td>" << m_NumRefSamples << "</td></tr>\n";
+	if (m_NumCpuSamples > 0)
+		stream << "<tr><th>NumCpuSamples</th><td>" << m_NumCpuSamples << (m_IsCpuFloat ? " (floating point)" : " (fixed point)") << "</td></tr>\n";
+	if (!m_CpuSampleFname.empty())
+		stream << "<tr><th>CpuSampleFile</th><td>" << m_CpuSampleFname << (m_IsCpuFloat ? " (floating point)" : " (fixed point)") << "</td></tr>\n";
+	bool isCpuFiltered = (m_NumCpuSamples > 0) || !m_CpuSampleFname.empty();
+	if (isCpuFiltered && (m_NumCpuThreads > 0))
+		stream << "<tr><th>NumCpuThreads</th><td>" << m_NumCpuThreads << "</td></tr>\n";
+	if (isCpuFiltered && (m_MaxCpuLatency > 0.0))
+		stream << "<tr><th>MaxCpuLatency</th><td>" << m_MaxCpuLatency << " s</td></tr>\n";
 	stream << "</table>\n\n";
 }
@@ -3,6 +3,8 @@
 
 
 #include <string>
+#include <vector>
+#include "firresourcebudget.h"
 using namespace std;
 
 
@@ -26,6 +28,41 @@ public:
 	string				m_FirEngineName;
 	double				m_ClockFreq;
 	unsigned			m_NumTimeSlices;
+	/// Time limit (in seconds) for the exact binder (0 = use the first-fit binder)
+	double				m_ExactBindTimeLimit;
+	/// Only write <firEngineName>_kernels.h, the compile-time FIR kernels of the spec (see firkernel.h), instead of building the FirEngine
+	bool				m_IsKernelHeaderOnly;
+	/// Use the portfolio binder, running its heuristics on NumBindThreads (0 = all cores)
+	bool				m_IsPortfolioBind;
+	unsigned			m_NumBindThreads;
+	/// Keep unchanged FIRs where the previous build bound them (read from <firEngineName>.fbd)
+	bool				m_IsIncrementalBind;
+	/// Fifos take exactly the words they need (their addresses wrap modulo the Region size, instead of within a power of 2)
+	bool				m_IsPackedFifos;
+	/// Clock frequencies swept by the design-space exploration (empty = build at ClockFreq and NumTimeSlices)
+	///   the exploration chooses the ClockFreq and NumTimeSlices that are built
+	vector<double>		m_vExploreClockFreq;
+	/// FirMacs and Block RAMs the FirEngine must fit in (when limited, the NumTimeSlices and binder are chosen to fit it
+	///   with the most headroom, exploring at ClockFreq unless ExploreClockFreqs are given)
+	FirResourceBudget	m_ResourceBudget;
+	/// Input samples per FIR for a cycle-accurate simulation of the built FirEngine (0 = no simulation)
+	///   the Outputs are written to <firEngineName>.sim
+	unsigned			m_NumSimSamples;
+	/// Input samples per FIR for the functional reference (0 = none), the same samples as a simulation's
+	///   the Inputs and Outputs are written to <firEngineName>.ref, and a simulation is checked against them
+	unsigned			m_NumRefSamples;
+	/// Input samples per FIR filtered on the CPU (0 = none), the same samples as a simulation's
+	///   the Outputs are written to <firEngineName>.cpu, and checked against the reference's
+	unsigned			m_NumCpuSamples;
+	/// Filter on the CPU in floating point (otherwise in the fixed-point arithmetic of the FirMacs)
+	bool				m_IsCpuFloat;
+	/// Threads filtering on the CPU (0 = all cores)
+	unsigned			m_NumCpuThreads;
+	/// Seconds within which the samples of a floating-point FIR's FFT segments must arrive (0 = no limit, see FirCpuFilter::chooseAlgorithm)
+	double				m_MaxCpuLatency;
+	/// Sample file (see FirSampleFile) streamed through the FIRs on the CPU (empty = none), instead of NumCpuSamples test samples
+	///   the Outputs are written to <firEngineName>_cpu.fss
+	string				m_CpuSampleFname;
 };
 
 
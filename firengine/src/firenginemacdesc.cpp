@@ -5,14 +5,19 @@
 #include "intutils.h"
 #include "datetime.h"
 #include "firenginemacdesc.h"
-#include "firenginespec.h"
+#include "firfifomemallocator.h"
 
 
-FirEngineMacDesc::FirEngineMacDesc(unsigned numTimeSlots) :
+FirEngineMacDesc::FirEngineMacDesc(unsigned numTimeSlots, bool isPackedFifos) :
 	m_vInputFirs			(),
 	m_vOutputFirs			(),
+	m_vOutputCoeffScale		(),
 	m_vFirCoeffRef			(numTimeSlots),
 	m_vFirUpdateSlot		(numTimeSlots),
+	m_vFirReadSlot			(numTimeSlots),
+	m_UpdateSlotMask		(numTimeSlots),
+	m_CoeffSlotMask			(numTimeSlots),
+	m_IsPackedFifos			(isPackedFifos),
 	m_vFirEngineMacFifoDesc	()
 {
 }
@@ -28,17 +33,51 @@ unsigned FirEngineMacDesc::findInputIndexForFirIndex(unsigned firIndex) const
 	return 0;
 }
 
+unsigned FirEngineMacDesc::findOutputIndexForFirIndex(unsigned firIndex) const
+{
+	for (unsigned i = 0; i < m_vOutputFirs.size(); ++i)
+	{
+		if (m_vOutputFirs[i] == firIndex)
+			return i;
+	}
+	assert(false);		// Output not found!
+	return 0;
+}
+
 unsigned FirEngineMacDesc::findFifoIndexForFirIndex(unsigned firIndex) const
 {
 	for (unsigned i = 0; i < m_vFirEngineMacFifoDesc.size(); ++i)
 	{
-		if (m_vFirEngineMacFifoDesc[i].m_FirIndex == firIndex)
+		if (m_vFirEngineMacFifoDesc[i].isForFirIndex(firIndex))
 			return i;
 	}
 	assert(false);		// Fifo not found!
 	return 0;
 }
 
+const FirEngineMacFifoDesc& FirEngineMacDesc::findFifoDescForFirIndex(unsigned firIndex) const
+{
+	return m_vFirEngineMacFifoDesc[findFifoIndexForFirIndex(firIndex)];
+}
+
+bool FirEngineMacDesc::isFirstTap(const FirCoeffRef& firCoeffRef) const
+{
+	if (firCoeffRef.isNull())
+		return false;
+	const FirEngineMacFifoDesc& firEngineMacFifoDesc = findFifoDescForFirIndex(firCoeffRef.m_FirIndex);
+	return firEngineMacFifoDesc.isPhaseFirstTap(firEngineMacFifoDesc.findTapIndex(firCoeffRef));
+}
+
+bool FirEngineMacDesc::isPhaseOutputTap(const FirCoeffRef& firCoeffRef) const
+{
+	if (firCoeffRef.isNull())
+		return false;
+	const FirEngineMacFifoDesc& firEngineMacFifoDesc = findFifoDescForFirIndex(firCoeffRef.m_FirIndex);
+	if (!firEngineMacFifoDesc.hasPhaseOutputs())
+		return false;
+	return firEngineMacFifoDesc.isPhaseLastTap(firEngineMacFifoDesc.findTapIndex(firCoeffRef));
+}
+
 //////////////////////////////////////////////////////////////////
 
 
@@ -51,13 +90,41 @@ void FirEngineMacDesc::establishChannelSelectCtrl(vector<unsigned>* pvValues) co
 	for (unsigned i = 0; i < m_vFirUpdateSlot.size(); ++i)
 	{
 		const FirUpdateSlot& firUpdateSlot = m_vFirUpdateSlot[i];
-		if (!firUpdateSlot.isSlotEmpty())
+		if (!firUpdateSlot.isSlotEmpty() && findFifoDescForFirIndex(firUpdateSlot.m_FirIndex).m_IsFirstEngine)
 		{
 			(*pvValues)[i] = findInputIndexForFirIndex(firUpdateSlot.m_FirIndex);
 		}
 	}
 }
 
+/// Each Control is 4 bits	- Selects which Output channel to drive in this timeSlot (0xF = None) Only set on the last FirEngine in a chain\n";
+void FirEngineMacDesc::establishOutputSelectCtrl(vector<unsigned>* pvValues) const
+{
+	pvValues->clear();
+	pvValues->resize(getNumTimeSlots(), 0xF);
+
+	for (unsigned i = 0; i < m_vFirUpdateSlot.size(); ++i)
+	{
+		const FirUpdateSlot& firUpdateSlot = m_vFirUpdateSlot[i];
+		if (!firUpdateSlot.isSlotEmpty() && firUpdateSlot.m_IsOutput && findFifoDescForFirIndex(firUpdateSlot.m_FirIndex).m_IsLastEngine)
+		{
+			// (the cross terms of a complex FIR are read from the other Input than the one whose Output they complete)
+			(*pvValues)[i] = findOutputIndexForFirIndex(findFifoDescForFirIndex(firUpdateSlot.m_FirIndex).m_OutputFirIndex);
+		}
+	}
+
+	// Each phase of an interpolating FIR (and each FIR of a filter bank) is output on its last tap
+	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
+	{
+		const FirCoeffRef& firCoeffRef = m_vFirCoeffRef[i];
+		if (isPhaseOutputTap(firCoeffRef) && findFifoDescForFirIndex(firCoeffRef.m_FirIndex).m_IsLastEngine)
+		{
+			assert((*pvValues)[i] == 0xF);		// Output slots can not collide, as they are all Coefficient-slots
+			(*pvValues)[i] = findOutputIndexForFirIndex(firCoeffRef.m_FirIndex);
+		}
+	}
+}
+
 /// Each Control is 1 bit	- '1' when updating the first FirEngine in a chain. Valid on DOUPDATE cycle\n";
 void FirEngineMacDesc::establishFirstEngineCtrl(vector<unsigned>* pvValues) const
 {
@@ -67,7 +134,7 @@ void FirEngineMacDesc::establishFirstEngineCtrl(vector<unsigned>* pvValues) cons
 	for (unsigned i = 0; i < m_vFirUpdateSlot.size(); ++i)
 	{
 		const FirUpdateSlot& firUpdateSlot = m_vFirUpdateSlot[i];
-		if (!firUpdateSlot.isSlotEmpty())
+		if (!firUpdateSlot.isSlotEmpty() && findFifoDescForFirIndex(firUpdateSlot.m_FirIndex).m_IsFirstEngine)
 		{
 			(*pvValues)[i] = 1;
 		}
@@ -83,7 +150,7 @@ void FirEngineMacDesc::establishLastEngineCtrl(vector<unsigned>* pvValues) const
 	for (unsigned i = 0; i < m_vFirUpdateSlot.size(); ++i)
 	{
 		const FirUpdateSlot& firUpdateSlot = m_vFirUpdateSlot[i];
-		if (!firUpdateSlot.isSlotEmpty())
+		if (!firUpdateSlot.isSlotEmpty() && findFifoDescForFirIndex(firUpdateSlot.m_FirIndex).m_IsLastEngine)
 		{
 			(*pvValues)[i] = 1;
 		}
@@ -98,8 +165,7 @@ void FirEngineMacDesc::establishFirstTapCtrl(vector<unsigned>* pvValues) const
 
 	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
 	{
-		const FirCoeffRef& firCoeffRef = m_vFirCoeffRef[i];
-		if (!firCoeffRef.isNull() && (firCoeffRef.m_CoeffIndex == 0))
+		if (isFirstTap(m_vFirCoeffRef[i]))
 		{
 			(*pvValues)[i] = 1;
 		}
@@ -111,6 +177,125 @@ void FirEngineMacDesc::establishPreAddModeCtrl(vector<unsigned>* pvValues) const
 {
 	pvValues->clear();
 	pvValues->resize(getNumTimeSlots(), 0);
+
+	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
+	{
+		const FirCoeffRef& firCoeffRef = m_vFirCoeffRef[i];
+		if (!firCoeffRef.isNull())
+		{
+			const FirEngineMacFifoDesc& firEngineMacFifoDesc = findFifoDescForFirIndex(firCoeffRef.m_FirIndex);
+
+			// The middle tap of an odd-length symmetric FIR has no mirrored partner
+			bool isMiddleTap = firEngineMacFifoDesc.m_IsOddFold && (firCoeffRef.m_CoeffIndex == (firEngineMacFifoDesc.m_FifoDepth - 1));
+			if (!isMiddleTap)
+				(*pvValues)[i] = firEngineMacFifoDesc.m_PreAddMode;
+		}
+	}
+}
+
+/// Each Control is 1 bit	- '1' on the first tap of a folded FIR with an odd number of coefficients (mirrored data skips the middle tap)\n";
+void FirEngineMacDesc::establishMirrorSkipCtrl(vector<unsigned>* pvValues) const
+{
+	pvValues->clear();
+	pvValues->resize(getNumTimeSlots(), 0);
+
+	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
+	{
+		const FirCoeffRef& firCoeffRef = m_vFirCoeffRef[i];
+		if (isFirstTap(firCoeffRef) && findFifoDescForFirIndex(firCoeffRef.m_FirIndex).m_IsOddFold)
+		{
+			(*pvValues)[i] = 1;
+		}
+	}
+}
+
+/// Each Control is 1 bit	- '1' on the first tap of a section read an Update later than the first section of its chain (skips the entry its Fifo's last Update committed, if any)\n";
+void FirEngineMacDesc::establishCommitSkipCtrl(vector<unsigned>* pvValues) const
+{
+	pvValues->clear();
+	pvValues->resize(getNumTimeSlots(), 0);
+
+	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
+	{
+		const FirCoeffRef& firCoeffRef = m_vFirCoeffRef[i];
+		if (isFirstTap(firCoeffRef) && findFifoDescForFirIndex(firCoeffRef.m_FirIndex).m_IsDataDelayed)
+		{
+			(*pvValues)[i] = 1;
+		}
+	}
+}
+
+/// Each Control is 1 bit	- '1' when the next FirEngine in a chain reads its data an Update later (it commits on this Fifo's previous Update). Valid on DOUPDATE cycle\n";
+void FirEngineMacDesc::establishCommitDelayCtrl(vector<unsigned>* pvValues) const
+{
+	pvValues->clear();
+	pvValues->resize(getNumTimeSlots(), 0);
+
+	for (unsigned i = 0; i < m_vFirUpdateSlot.size(); ++i)
+	{
+		const FirUpdateSlot& firUpdateSlot = m_vFirUpdateSlot[i];
+		if (!firUpdateSlot.isSlotEmpty() && findFifoDescForFirIndex(firUpdateSlot.m_FirIndex).m_IsCommitDelayed)
+		{
+			(*pvValues)[i] = 1;
+		}
+	}
+}
+
+/// Each Control is 8 bits	- Offset (from the start of the Fifo's Coefficient bank) of the first Coefficient, valid on FIRST_TAP\n";
+void FirEngineMacDesc::establishCoeffOffsetCtrl(vector<unsigned>* pvValues) const
+{
+	pvValues->clear();
+	pvValues->resize(getNumTimeSlots(), 0);
+
+	// The Coefficients of each phase (or FIR of a filter bank) follow those of the previous one
+	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
+	{
+		const FirCoeffRef& firCoeffRef = m_vFirCoeffRef[i];
+		if (isFirstTap(firCoeffRef))
+		{
+			(*pvValues)[i] = findFifoDescForFirIndex(firCoeffRef.m_FirIndex).findTapIndex(firCoeffRef);
+		}
+	}
+}
+
+/// Each Control is 8 bits	- Number of Fifo entries (of zero taps) skipped before reading this tap's data\n";
+void FirEngineMacDesc::establishDataSkipCtrl(vector<unsigned>* pvValues) const
+{
+	pvValues->clear();
+	pvValues->resize(getNumTimeSlots(), 0);
+
+	// The first tap (of each phase) reads from the newest entry, the others from the entry after the previous tap
+	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
+	{
+		const FirCoeffRef& firCoeffRef = m_vFirCoeffRef[i];
+		if (!firCoeffRef.isNull())
+		{
+			const FirEngineMacFifoDesc& firEngineMacFifoDesc = findFifoDescForFirIndex(firCoeffRef.m_FirIndex);
+			unsigned tapIdx = firEngineMacFifoDesc.findTapIndex(firCoeffRef);
+			unsigned dataIndex = firEngineMacFifoDesc.m_vDataIndex[tapIdx];
+			if (firEngineMacFifoDesc.isPhaseFirstTap(tapIdx))
+				(*pvValues)[i] = dataIndex;
+			else
+				(*pvValues)[i] = dataIndex - firEngineMacFifoDesc.m_vDataIndex[tapIdx - 1] - 1;
+			assert((*pvValues)[i] < firEngineMacFifoDesc.m_FifoDepth);
+		}
+	}
+}
+
+/// Each Control is 1 bit	- '1' on the last tap of each phase of an interpolating FIR, or of each FIR of a filter bank (Output is not tied to an Update)\n";
+void FirEngineMacDesc::establishPhaseOutputCtrl(vector<unsigned>* pvValues) const
+{
+	pvValues->clear();
+	pvValues->resize(getNumTimeSlots(), 0);
+
+	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
+	{
+		const FirCoeffRef& firCoeffRef = m_vFirCoeffRef[i];
+		if (isPhaseOutputTap(firCoeffRef) && findFifoDescForFirIndex(firCoeffRef.m_FirIndex).m_IsLastEngine)
+		{
+			(*pvValues)[i] = 1;
+		}
+	}
 }
 
 /// Each Control is 4 bits	- 0=MUL, 1=MADD, 2=MSUB\n";
@@ -121,8 +306,7 @@ void FirEngineMacDesc::establishMulModeCtrl(vector<unsigned>* pvValues) const
 
 	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
 	{
-		const FirCoeffRef& firCoeffRef = m_vFirCoeffRef[i];
-		if (!firCoeffRef.isNull() && (firCoeffRef.m_CoeffIndex == 0))
+		if (isFirstTap(m_vFirCoeffRef[i]))
 		{
 			(*pvValues)[i] = 0;
 		}
@@ -134,6 +318,19 @@ void FirEngineMacDesc::establishAddPrevEngineAccumCtrl(vector<unsigned>* pvValue
 {
 	pvValues->clear();
 	pvValues->resize(getNumTimeSlots(), 0);
+
+	// The first tap of every section (other than the first) picks up the partial sum of the previous FirEngine in the chain
+	//   (as does a section adding the cross terms of a complex FIR, though it takes its data from the FIR Input)
+	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
+	{
+		const FirCoeffRef& firCoeffRef = m_vFirCoeffRef[i];
+		if (!isFirstTap(firCoeffRef))
+			continue;
+
+		const FirEngineMacFifoDesc& firEngineMacFifoDesc = findFifoDescForFirIndex(firCoeffRef.m_FirIndex);
+		if (!firEngineMacFifoDesc.m_IsFirstEngine || firEngineMacFifoDesc.m_IsCrossTerm)
+			(*pvValues)[i] = 1;
+	}
 }
 
 /// Each Control is 8 bits	- Selects which Data Fifo to use\n";
@@ -166,6 +363,16 @@ void FirEngineMacDesc::establishUpdateFifoNumCtrl(vector<unsigned>* pvValues) co
 			(*pvValues)[i] = findFifoIndexForFirIndex(firUpdateSlot.m_FirIndex);
 		}
 	}
+
+	// The oldest data entry is read ahead of the Update (to be passed along the chain)
+	for (unsigned i = 0; i < m_vFirReadSlot.size(); ++i)
+	{
+		const FirUpdateSlot& firReadSlot = m_vFirReadSlot[i];
+		if (!firReadSlot.isSlotEmpty())
+		{
+			(*pvValues)[i] = findFifoIndexForFirIndex(firReadSlot.m_FirIndex);
+		}
+	}
 }
 
 /// Each Control is 1 bits	- High at the same time on all FirEngines involved in a firfilter for the last tap of the fir-filter\n";
@@ -194,56 +401,96 @@ void FirEngineMacDesc::sortFifosInDescendingSizeOrder()
 }
 
 
-// 16 bits Foreach Fifo: 	- [FifoOffset : 10 bits, Len-1: 6 bits]
-void FirEngineMacDesc::establishFifoSizes(vector<unsigned>* pvValues) const
+// First address of each Fifo's Region
+void FirEngineMacDesc::establishFifoOrigins(vector<unsigned>* pvValues) const
 {
 	pvValues->clear();
 	pvValues->resize(getNumFifos(), 0);
 
-	unsigned offset = 0;
+	// Allocate the largest Fifos first (whatever order they are numbered in)
+	vector<unsigned> vFifoOrder;
 	for (unsigned i = 0; i < m_vFirEngineMacFifoDesc.size(); ++i)
+		vFifoOrder.push_back(i);
+	stable_sort(vFifoOrder.begin(), vFifoOrder.end(),
+		[this](unsigned a, unsigned b) { return m_vFirEngineMacFifoDesc[a].m_NumFifoMemWords > m_vFirEngineMacFifoDesc[b].m_NumFifoMemWords; });
+
+	FirFifoMemAllocator firFifoMemAllocator;
+	for (unsigned i = 0; i < vFifoOrder.size(); ++i)
 	{
-		// Align Fifos to their 2^N Size
-		offset = IntUtils::alignAddressOnOrAfter(offset, m_vFirEngineMacFifoDesc[i].m_NumFifoMemWords);
+		// Align Fifos to their 2^N Size (packed Fifos need no alignment)
+		const FirEngineMacFifoDesc& firEngineMacFifoDesc = m_vFirEngineMacFifoDesc[vFifoOrder[i]];
+		unsigned alignment = m_IsPackedFifos ? 1 : firEngineMacFifoDesc.m_NumFifoMemWords;
+		(*pvValues)[vFifoOrder[i]] = firFifoMemAllocator.allocate(firEngineMacFifoDesc.m_NumFifoMemWords, alignment);
+	}
+}
 
-		unsigned fifoDepth = m_vFirEngineMacFifoDesc[i].m_FifoDepth;
-		assert(fifoDepth <= (1 << 6));		// check range
-		(*pvValues)[i] = (offset << 6) | (fifoDepth - 1);
+// FifoOffsetBitWidth + FifoLengthBitWidth bits Foreach Fifo: 	- [FifoOffset, Len-1]
+void FirEngineMacDesc::establishFifoSizes(vector<unsigned>* pvValues) const
+{
+	establishFifoOrigins(pvValues);
+
+	unsigned fifoLengthBits = getFifoLengthBitWidth();
 
-		// advance offset to end of this FIFO
-		offset += m_vFirEngineMacFifoDesc[i].m_NumFifoMemWords;	
+	for (unsigned i = 0; i < m_vFirEngineMacFifoDesc.size(); ++i)
+	{
+		// The FifoOffset starts at the origin of the Fifo Region
+		unsigned fifoDepth = m_vFirEngineMacFifoDesc[i].m_FifoDepth;
+		assert(fifoDepth <= (1u << fifoLengthBits));		// check range
+		(*pvValues)[i] = ((*pvValues)[i] << fifoLengthBits) | (fifoDepth - 1);
 	}
 }
 
-// 24 bits for every slot in Coeff-Buffer - (1.17 representation)
-void FirEngineMacDesc::establishCoeffValues(vector<unsigned>* pvValues, const FirEngineSpec& firEngineSpec) const
+// FifoOffsetBitWidth + 1 bits Foreach Fifo: - Number of words in the Fifo Region
+void FirEngineMacDesc::establishFifoRegionSizes(vector<unsigned>* pvValues) const
+{
+	pvValues->clear();
+	for (unsigned i = 0; i < m_vFirEngineMacFifoDesc.size(); ++i)
+		pvValues->push_back(m_vFirEngineMacFifoDesc[i].m_NumFifoMemWords);
+}
+
+// First address of each Fifo's Coefficient bank
+void FirEngineMacDesc::establishCoeffOrigins(vector<unsigned>* pvValues) const
 {
 	pvValues->clear();
 
 	unsigned offset = 0;
 	for (unsigned i = 0; i < m_vFirEngineMacFifoDesc.size(); ++i)
 	{
-		// Align Fifos to their 2^N Size
-		offset = IntUtils::alignAddressOnOrAfter(offset, m_vFirEngineMacFifoDesc[i].m_NumFifoMemWords);
-
-		pvValues->resize(offset + m_vFirEngineMacFifoDesc[i].m_NumFifoMemWords, 0);
+		// Share the bank of an earlier Fifo with the same Coefficients
+		unsigned sameIdx = 0;
+		while ((sameIdx < i) && (m_vFirEngineMacFifoDesc[sameIdx].m_vCoeffValue != m_vFirEngineMacFifoDesc[i].m_vCoeffValue))
+			++sameIdx;
 
-		for (unsigned j = 0; j < m_vFirEngineMacFifoDesc[i].m_vFirCoeffRef.size(); ++j)
+		if (sameIdx < i)
 		{
-			const FirCoeffRef& firCoeffRef = m_vFirEngineMacFifoDesc[i].m_vFirCoeffRef[j];
-			double coeffVal = firEngineSpec.lookupCoeff(firCoeffRef);
-			assert(coeffVal <= 1.0);
-			assert(coeffVal > -1.0);
-			unsigned coeffVal1p17 = int(coeffVal * double(1 << 17)) & ((1 << 18) - 1);
-			(*pvValues)[offset + j] = coeffVal1p17;
+			pvValues->push_back((*pvValues)[sameIdx]);
 		}
+		else
+		{
+			pvValues->push_back(offset);
+			offset += m_vFirEngineMacFifoDesc[i].m_vCoeffValue.size();
+		}
+	}
+}
+
+// 24 bits for every slot in Coeff-Buffer - (1.17 representation)
+void FirEngineMacDesc::establishCoeffValues(vector<unsigned>* pvValues) const
+{
+	pvValues->clear();
+	pvValues->resize(getCoeffBufferDepth(), 0);
+
+	vector<unsigned> vCoeffOrigins;
+	establishCoeffOrigins(&vCoeffOrigins);
 
-		// advance offset to end of this FIFO
-		offset += m_vFirEngineMacFifoDesc[i].m_NumFifoMemWords;	
+	// (a shared bank is simply written again with the same Coefficients)
+	for (unsigned i = 0; i < m_vFirEngineMacFifoDesc.size(); ++i)
+	{
+		const vector<unsigned>& vCoeffValue = m_vFirEngineMacFifoDesc[i].m_vCoeffValue;
+		for (unsigned j = 0; j < vCoeffValue.size(); ++j)
+			(*pvValues)[vCoeffOrigins[i] + j] = vCoeffValue[j];
 	}
 }
 
-/*
 unsigned FirEngineMacDesc::getNumFifoMemWords() const
 {
 	unsigned numFifoMemWords = 0;
@@ -251,5 +498,77 @@ unsigned FirEngineMacDesc::getNumFifoMemWords() const
 		numFifoMemWords += m_vFirEngineMacFifoDesc[i].m_NumFifoMemWords;
 	return numFifoMemWords;
 }
-*/
 
+unsigned FirEngineMacDesc::getFifoLengthBitWidth() const
+{
+	unsigned maxFifoDepth = 0;
+	for (unsigned i = 0; i < m_vFirEngineMacFifoDesc.size(); ++i)
+		maxFifoDepth = max(maxFifoDepth, m_vFirEngineMacFifoDesc[i].m_FifoDepth);
+	return max(6u, IntUtils::bitWidthForEncodingValues(maxFifoDepth));
+}
+
+unsigned FirEngineMacDesc::getFifoOffsetBitWidth() const
+{
+	return max(10u, IntUtils::bitWidthForEncodingValues(getBufferDepth()));
+}
+
+unsigned FirEngineMacDesc::getNumUsedFifoMemWords() const
+{
+	unsigned numUsedFifoMemWords = 0;
+	for (unsigned i = 0; i < m_vFirEngineMacFifoDesc.size(); ++i)
+		numUsedFifoMemWords += m_vFirEngineMacFifoDesc[i].m_FifoDepth;
+	return numUsedFifoMemWords;
+}
+
+unsigned FirEngineMacDesc::getBufferDepth() const
+{
+	vector<unsigned> vFifoOrigins;
+	establishFifoOrigins(&vFifoOrigins);
+
+	unsigned bufferDepth = 0;
+	for (unsigned i = 0; i < m_vFirEngineMacFifoDesc.size(); ++i)
+		bufferDepth = max(bufferDepth, vFifoOrigins[i] + m_vFirEngineMacFifoDesc[i].m_NumFifoMemWords);
+	return bufferDepth;
+}
+
+unsigned FirEngineMacDesc::getCoeffBufferDepth() const
+{
+	vector<unsigned> vCoeffOrigins;
+	establishCoeffOrigins(&vCoeffOrigins);
+
+	unsigned coeffBufferDepth = 0;
+	for (unsigned i = 0; i < m_vFirEngineMacFifoDesc.size(); ++i)
+		coeffBufferDepth = max(coeffBufferDepth, vCoeffOrigins[i] + unsigned(m_vFirEngineMacFifoDesc[i].m_vCoeffValue.size()));
+	return coeffBufferDepth;
+}
+
+unsigned FirEngineMacDesc::getNumCoeffBanks() const
+{
+	vector<unsigned> vCoeffOrigins;
+	establishCoeffOrigins(&vCoeffOrigins);
+	sort(vCoeffOrigins.begin(), vCoeffOrigins.end());
+	return unique(vCoeffOrigins.begin(), vCoeffOrigins.end()) - vCoeffOrigins.begin();
+}
+
+// Each RAM is filled with BRAM36s (2048 x 18 bits), a last part of at most 1024 words fits a BRAM18
+static unsigned _findNumBram36(unsigned depth)
+{
+	return (depth / 2048) + (((depth % 2048) > 1024) ? 1 : 0);
+}
+
+static unsigned _findNumBram18(unsigned depth)
+{
+	unsigned numSpareWords = depth % 2048;
+	return ((numSpareWords > 0) && (numSpareWords <= 1024)) ? 1 : 0;
+}
+
+// The two Data RAMs (dataBuffA, dataBuffB) are BufferDepth deep, the Coefficient RAM is CoeffBufferDepth deep
+unsigned FirEngineMacDesc::getNumBram36() const
+{
+	return (2 * _findNumBram36(getBufferDepth())) + _findNumBram36(getCoeffBufferDepth());
+}
+
+unsigned FirEngineMacDesc::getNumBram18() const
+{
+	return (2 * _findNumBram18(getBufferDepth())) + _findNumBram18(getCoeffBufferDepth());
+}
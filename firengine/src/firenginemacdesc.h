@@ -3,13 +3,13 @@
 
 
 #include <vector>
+#include <string>
 #include "fircoeffref.h"
 #include "firupdateslot.h"
 #include "firenginemacfifodesc.h"
+#include "slotmask.h"
 using namespace std;
 
-class FirEngineSpec;		// forward declaration
-
 
 /////////////////////////////////////////////////////////////
 /// Describes a FirMac block
@@ -19,18 +19,47 @@ class FirEngineSpec;		// forward declaration
 class FirEngineMacDesc
 {
 public:
-	explicit FirEngineMacDesc(unsigned numTimeSlots);
+	FirEngineMacDesc(unsigned numTimeSlots, bool isPackedFifos);
 public:
 	unsigned getNumTimeSlots() const			{ return m_vFirCoeffRef.size(); }
 	unsigned getNumFifos() const				{ return m_vFirEngineMacFifoDesc.size(); }
+	/// Fifos are power of 2 sized (or packed), so (in descending size order) they pack without alignment gaps
+	unsigned getNumFifoMemWords() const;
+	/// Words of the Fifo memory holding data (the rest is rounding of the Fifo Regions)
+	unsigned getNumUsedFifoMemWords() const;
+	/// Words spanned by the allocated Fifo Regions (the depth of each of the Data RAMs)
+	unsigned getBufferDepth() const;
+	/// Words of the Coefficient RAM (Fifos with the same Coefficients share a bank)
+	unsigned getCoeffBufferDepth() const;
+	unsigned getNumCoeffBanks() const;
+	/// Block RAMs needed for the Coefficient and Data RAMs (each 18 bits wide, as BRAM36 of 2048 words and BRAM18 of 1024 words)
+	unsigned getNumBram36() const;
+	unsigned getNumBram18() const;
+	unsigned getNumFreeCoeffSlots() const		{ return getNumTimeSlots() - m_CoeffSlotMask.countSetSlots(); }
+	/// Width of the Len-1 field of FIFOSIZES (at least 6 bits, wider to fit the longest Fifo)
+	unsigned getFifoLengthBitWidth() const;
+	/// Width of the FifoOffset field of FIFOSIZES (at least 10 bits, wider to address all the Fifo words)
+	unsigned getFifoOffsetBitWidth() const;
 public:
 	/// Lookup which Input corresponds to a particular FIR
 	unsigned findInputIndexForFirIndex(unsigned firIndex) const;
-	/// Lookup which Fifo is used for a particular FIR
+	/// Lookup which Output corresponds to a particular FIR
+	unsigned findOutputIndexForFirIndex(unsigned firIndex) const;
+	/// Lookup which Fifo is used for a particular FIR (the FIRs of a filter bank share a Fifo)
 	unsigned findFifoIndexForFirIndex(unsigned firIndex) const;
+	/// Lookup the Fifo used for a particular FIR
+	const FirEngineMacFifoDesc& findFifoDescForFirIndex(unsigned firIndex) const;
+	/// Is this the first tap of the section of the FIR computed by this MAC (or of one of its phases)
+	bool isFirstTap(const FirCoeffRef&) const;
+	/// Is this the last tap of a phase of an interpolating FIR, or of a FIR of a filter bank (where its Output is taken)
+	bool isPhaseOutputTap(const FirCoeffRef&) const;
 public:
 	/// Each Control is 4 bits	- Selects which Input channel to use in this timeSlot (0 = None) This should only be non-zero during Fir Update-Write cycle\n";
 	void establishChannelSelectCtrl(vector<unsigned>* pOut) const;
+	/// Each Control is 4 bits	- Selects which Output channel to drive in this timeSlot (0xF = None) Only set on the last FirEngine in a chain\n";
+	///   (and only on the Updates which produce an Output, every Decimation-th Update of a decimating FIR)
+	///   (an interpolating FIR instead drives its Output on the last tap of each phase, as does each FIR of a filter bank)
+	void establishOutputSelectCtrl(vector<unsigned>* pOut) const;
 	/// Each Control is 1 bit	- '1' when updating the first FirEngine in a chain. Valid on DOUPDATE cycle\n";
 	void establishFirstEngineCtrl(vector<unsigned>* pOut) const;
 	/// Each Control is 1 bit	- '1' when updating the last FirEngine in a chain. Valid on DOUPDATE cycle\n";
@@ -39,6 +68,18 @@ public:
 	void establishFirstTapCtrl(vector<unsigned>* pOut) const;
 	/// Each Control is 4 bits	- 0=NoPreadder(B*A), 1=PreAdd((D+B)*A), 2=PreSub((D-B)*A)\n";
 	void establishPreAddModeCtrl(vector<unsigned>* pOut) const;
+	/// Each Control is 1 bit	- '1' on the first tap of a folded FIR with an odd number of coefficients (mirrored data skips the middle tap)\n";
+	void establishMirrorSkipCtrl(vector<unsigned>* pOut) const;
+	/// Each Control is 1 bit	- '1' on the first tap of a section read an Update later than the first section of its chain (skips the entry its Fifo's last Update committed, if any)\n";
+	void establishCommitSkipCtrl(vector<unsigned>* pOut) const;
+	/// Each Control is 1 bit	- '1' when the next FirEngine in a chain reads its data an Update later (it commits on this Fifo's previous Update). Valid on DOUPDATE cycle\n";
+	void establishCommitDelayCtrl(vector<unsigned>* pOut) const;
+	/// Each Control is 8 bits	- Offset (from the start of the Fifo's Coefficient bank) of the first Coefficient, valid on FIRST_TAP\n";
+	void establishCoeffOffsetCtrl(vector<unsigned>* pOut) const;
+	/// Each Control is 8 bits	- Number of Fifo entries (of zero taps) skipped before reading this tap's data\n";
+	void establishDataSkipCtrl(vector<unsigned>* pOut) const;
+	/// Each Control is 1 bit	- '1' on the last tap of each phase of an interpolating FIR, or of each FIR of a filter bank (Output is not tied to an Update)\n";
+	void establishPhaseOutputCtrl(vector<unsigned>* pOut) const;
 	/// Each Control is 4 bits	- 0=MUL, 1=MADD, 2=MSUB\n";
 	void establishMulModeCtrl(vector<unsigned>* pOut) const;
 	/// Each Control is 1 bit   - Use value of previous Fir Engine's Accumulator from 2-cycles ago\n";
@@ -52,24 +93,42 @@ public:
 public:
 	// Sort Fifos in descending size order
 	void sortFifosInDescendingSizeOrder();
-	// 16 bits Foreach Fifo: 	- [FifoOffset : 10 bits, Len-1: 6 bits]		(sortFifosInDescendingSizeOrder must be called first)
+	// First address of each Fifo's Region (aligned to its size, unless the Fifos are packed)		(see FirFifoMemAllocator)
+	void establishFifoOrigins(vector<unsigned>* pOut) const;
+	// FifoOffsetBitWidth + FifoLengthBitWidth bits Foreach Fifo: 	- [FifoOffset, Len-1]		(sortFifosInDescendingSizeOrder must be called first)
 	void establishFifoSizes(vector<unsigned>* pOut) const;
+	// FifoOffsetBitWidth + 1 bits Foreach Fifo: - Number of words in the Fifo Region (packed Fifos wrap their addresses modulo this size)
+	void establishFifoRegionSizes(vector<unsigned>* pOut) const;
+	// First address of each Fifo's Coefficient bank (a bank is shared by the Fifos with the same Coefficients)		(sortFifosInDescendingSizeOrder must be called first)
+	void establishCoeffOrigins(vector<unsigned>* pOut) const;
 	// 24 bits for every slot in Coeff-Buffer - (1.17 representation)		(sortFifosInDescendingSizeOrder must be called first)
-	void establishCoeffValues(vector<unsigned>* pOut, const FirEngineSpec&) const;
+	void establishCoeffValues(vector<unsigned>* pOut) const;
 public:
-	void generateRtl(const string& firEngineMacName, const FirEngineSpec&) const;
+	/// returns true if the RTL file changed
+	bool generateRtl(const string& firEngineMacName) const;
 public:
 	/// list of FIRs needed as Inputs to this MAC (limited to 15)
+	///   (a filter bank only needs the Input of its first FIR)
 	vector<unsigned>				m_vInputFirs; 
 	/// list of FIRs whose Outputs are computed by this MAC (limited to 15)
-	///   (currently: FIRs are not split across MACs so this is the same as the Inputs)
+	///   (FIRs split across MACs only have their Input on the first MAC and their Output on the last)
 	vector<unsigned>				m_vOutputFirs; 
+	/// CoeffScale of the FIR of each Output (its Output is taken that many bits higher in the result)
+	vector<int>						m_vOutputCoeffScale;
 	/// Reference to which Coefficients map to each TimeSlot
 	vector<FirCoeffRef>				m_vFirCoeffRef;
 	/// TimeSlots -> Which FIR's data inputs are being updated
 	vector<FirUpdateSlot>			m_vFirUpdateSlot;
-	/// Description of Fifos required for this MAC (in Address order)
-	///  (TODO: must be aligned to size!!)
+	/// TimeSlots -> Which FIR's oldest data is being read (FirUpdateLatency cycles ahead of its Update)
+	vector<FirUpdateSlot>			m_vFirReadSlot;
+	/// TimeSlots used by Updates or Reads (m_vFirUpdateSlot / m_vFirReadSlot not empty)
+	SlotMask						m_UpdateSlotMask;
+	/// TimeSlots used by Coefficients (m_vFirCoeffRef not null)
+	SlotMask						m_CoeffSlotMask;
+	/// Fifos take exactly the words they need, instead of being rounded up to a power of 2
+	///   (the RTL then reads each Fifo's Region from FIFOORIGINS/FIFOREGIONSIZES, rather than decoding it from Len-1)
+	bool							m_IsPackedFifos;
+	/// Description of Fifos required for this MAC (in descending size order once sorted, see establishFifoOrigins for their Addresses)
 	vector<FirEngineMacFifoDesc>	m_vFirEngineMacFifoDesc;
 };
 
@@ -1,6 +1,7 @@
 
 #include <fstream>
 #include <assert.h>
+#include <algorithm>
 #include "datetime.h"
 #include "intutils.h"
 #include "stringutil.h"
@@ -35,6 +36,12 @@ static void _renderVectorAsHexString(ostream& stream, unsigned bitsPerValue, con
 		maxAllowedValue = 0xFF;
 		numDigits = 2;
 	}
+	else if (bitsPerValue == 16)
+	{
+		stream << "'h";
+		maxAllowedValue = 0xFFFF;
+		numDigits = 4;
+	}
 	else
 	{
 		assert(false);		// unexpected bitsPerValue
@@ -67,40 +74,91 @@ static void _renderVectorAsConcat(ostream& stream, unsigned bitsPerValue, const
 }
 
 
-void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngineSpec& firEngineSpec) const
+// Decode the Fifo Region from Len-1 (a mask of the lowest power of 2 >= Len)
+static void _renderFifoRegionDecoder(ostream& stream, const string& fifoName, unsigned fifoLengthBits, unsigned fifoOffsetBits)
+{
+	for (unsigned bit = fifoLengthBits; bit-- > 0; )
+	{
+		if (bit == 0)
+			stream << "    else\n";
+		else if ((bit + 1) == fifoLengthBits)
+			stream << "    if (" << fifoName << "LengthMinusOne[" << bit << "])\n";
+		else
+			stream << "    else if (" << fifoName << "LengthMinusOne[" << bit << "])\n";
+
+		// the Region for a Len-1 with its top bit set at 'bit' has bit+1 ones (and at least one)
+		unsigned numOnes = (bit == 0) ? 1 : (bit + 1);
+		stream << "        " << fifoName << "Region = " << fifoOffsetBits << "'b" << string(fifoOffsetBits - numOnes, '0') << string(numOnes, '1') << ";\n";
+	}
+}
+
+
+bool FirEngineMacDesc::generateRtl(const string& firEngineMacName) const
 {
 	vector<unsigned> vChannelSelectCtrl;
+	vector<unsigned> vOutputSelectCtrl;
 	vector<unsigned> vFirstEngineCtrl;
 	vector<unsigned> vLastEngineCtrl;
 	vector<unsigned> vFirstTapCtrl;
 	vector<unsigned> vPreAddModeCtrl;
+	vector<unsigned> vMirrorSkipCtrl;
+	vector<unsigned> vCommitSkipCtrl;
+	vector<unsigned> vCommitDelayCtrl;
+	vector<unsigned> vCoeffOffsetCtrl;
+	vector<unsigned> vDataSkipCtrl;
+	vector<unsigned> vPhaseOutputCtrl;
 	vector<unsigned> vMulModeCtrl;
 	vector<unsigned> vAddPrevEngineAccumCtrl;
 	vector<unsigned> vRdFifoNumCtrl;
 	vector<unsigned> vUpdateFifoNumCtrl;
 	vector<unsigned> vDoUpdateCtrl;
 
+	// Note: Fifos must be in their final order before Fifo numbers are taken
+	const_cast<FirEngineMacDesc*>(this)->sortFifosInDescendingSizeOrder();
+
 	establishChannelSelectCtrl(&vChannelSelectCtrl);
+	establishOutputSelectCtrl(&vOutputSelectCtrl);
 	establishFirstEngineCtrl(&vFirstEngineCtrl);
 	establishLastEngineCtrl(&vLastEngineCtrl);
 	establishFirstTapCtrl(&vFirstTapCtrl);
 	establishPreAddModeCtrl(&vPreAddModeCtrl);
+	establishMirrorSkipCtrl(&vMirrorSkipCtrl);
+	establishCommitSkipCtrl(&vCommitSkipCtrl);
+	establishCommitDelayCtrl(&vCommitDelayCtrl);
+	establishCoeffOffsetCtrl(&vCoeffOffsetCtrl);
+	establishDataSkipCtrl(&vDataSkipCtrl);
+	establishPhaseOutputCtrl(&vPhaseOutputCtrl);
 	establishMulModeCtrl(&vMulModeCtrl);
 	establishAddPrevEngineAccumCtrl(&vAddPrevEngineAccumCtrl);
 	establishRdFifoNumCtrl(&vRdFifoNumCtrl);
 	establishUpdateFifoNumCtrl(&vUpdateFifoNumCtrl);
 	establishDoUpdateCtrl(&vDoUpdateCtrl);
 
-	const_cast<FirEngineMacDesc*>(this)->sortFifosInDescendingSizeOrder();
-
 	vector<unsigned> vFifoSizes;
 	establishFifoSizes(&vFifoSizes);
+	unsigned fifoLengthBits = getFifoLengthBitWidth();
+	unsigned fifoOffsetBits = getFifoOffsetBitWidth();
+
+	// Packed Fifos are not aligned, so the RTL can not derive a Fifo's Region from its Len-1
+	vector<unsigned> vFifoOrigins;
+	vector<unsigned> vFifoRegionSizes;
+	if (m_IsPackedFifos)
+	{
+		establishFifoOrigins(&vFifoOrigins);
+		establishFifoRegionSizes(&vFifoRegionSizes);
+	}
+
+	// DATA_SKIP is widened for long runs of zero taps
+	unsigned dataSkipBits = (*max_element(vDataSkipCtrl.begin(), vDataSkipCtrl.end()) < (1 << 8)) ? 8 : 16;
 	
 	vector<unsigned> vCoeffValues;
-	establishCoeffValues(&vCoeffValues, firEngineSpec);
+	establishCoeffValues(&vCoeffValues);
+	vector<unsigned> vCoeffOrigins;
+	establishCoeffOrigins(&vCoeffOrigins);
+	unsigned coeffAddressBits = max(1u, IntUtils::bitWidthForEncodingValues(vCoeffValues.size()));
 	
 
-	ofstream fStream(firEngineMacName + ".v");
+	ostringstream fStream;
 
 	fStream << "`timescale 1ns / 1ps\n";
 	fStream << "//////////////////////////////////////////////////////////////////////////////////\n";
@@ -156,53 +214,88 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	//////////////////////////////////////////////////////////
 	// Module Implementation
 	//////////////////////////////////////////////////////////
-	assert(vCoeffValues.size() <= 1024);		// Reason: FIFOSIZES offset bitwidth
-	fStream << "parameter LOG2BUFFERDEPTH = " << IntUtils::bitWidthForEncodingValues(vCoeffValues.size()) << ";\n";
-	fStream << "parameter BUFFERDEPTH = " << vCoeffValues.size() << ";          // Maximum of 1024 currently supported\n";
+	fStream << "parameter LOG2BUFFERDEPTH = " << IntUtils::bitWidthForEncodingValues(getBufferDepth()) << ";\n";
+	fStream << "parameter BUFFERDEPTH = " << getBufferDepth() << ";          // RAMs are not rounded up to a power of 2 (so fill as few Block RAMs as possible)\n";
+	fStream << "parameter LOG2COEFFBUFFERDEPTH = " << coeffAddressBits << ";\n";
+	fStream << "parameter COEFFBUFFERDEPTH = " << vCoeffValues.size() << ";          // Fifos with the same Coefficients share a bank (NumCoeffBanks = " << getNumCoeffBanks() << ")\n";
+	fStream << "\n";
+	fStream << "// Fifo Descriptor fields (widened to fit the longest Fifo and the BufferDepth)\n";
+	fStream << "parameter FIFOLENBITS = " << fifoLengthBits << ";\n";
+	fStream << "parameter FIFOOFFSETBITS = " << fifoOffsetBits << ";\n";
+	fStream << "parameter FIFODESCBITS = " << (fifoOffsetBits + fifoLengthBits) << ";\n";
 	fStream << "\n";
 	assert(getNumFifos() <= 256);			// Reason: RDFIFONUM / UPDATEFIFONUM bitwidth
 	fStream << "parameter LOG2NUMFIFOS = " << IntUtils::bitWidthForEncodingValues(getNumFifos()) << ";\n";
 	fStream << "parameter NUMFIFOS = " << getNumFifos() << ";          // Maximum of 256 currently supported\n";
 	fStream << "\n";
-	assert(getNumTimeSlots() <= 256);			// Reason: formatting of SlotNumbers limited to 2 hex digits
 	fStream << "parameter LOG2TIMESLICES = " << IntUtils::bitWidthForEncodingValues(getNumTimeSlots()) << ";\n";
-	fStream << "parameter TIMESLICES = " << getNumTimeSlots() << ";          // Maximum of 256 currently supported\n";
+	fStream << "parameter TIMESLICES = " << getNumTimeSlots() << ";\n";
 	fStream << "\n";
 
 	fStream << "/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////\n";
 	fStream << "// FirEngine Configuration\n";
 	fStream << "//   CHANNEL_SELECT			4 bits	- Selects which Input channel to use in this timeSlot (0 = None) This should only be non-zero during Fir Update-Write cycle\n";
+	fStream << "//   OUTPUT_SELECT			4 bits	- Selects which Output channel to drive in this timeSlot (F = None) Only set on the last FirEngine in a chain\n";
+	fStream << "//                          	  (a decimating FIR only drives its Output on every Decimation-th Update, its Fifo still advances on every Update)\n";
+	fStream << "//                          	  (an interpolating FIR drives its Output on the last tap of each phase instead, as does each FIR of a filter bank)\n";
 	fStream << "//   FIRST_ENGINE			1 bit	- '1' when updating the first FirEngine in a chain. Valid on DOUPDATE cycle\n";
 	fStream << "//   LAST_ENGINE			1 bit	- '1' when updating the last FirEngine in a chain. Valid on DOUPDATE cycle\n";
 	fStream << "//   FIRST_TAP     			1 bit	- '1' for first tap of the section of FIR in this FirEngine\n";
 	fStream << "//   PREADD_MODE			4 bits	- 0=NoPreadder(B*A), 1=PreAdd((D+B)*A), 2=PreSub((D-B)*A)\n";
+	fStream << "//   MIRROR_SKIP			1 bit	- '1' on the first tap of a folded FIR with an odd number of coefficients (mirrored data skips the middle tap)\n";
+	fStream << "//   COMMIT_SKIP			1 bit	- '1' on the first tap of a section read an Update later than the first section of its chain (skips the entry its Fifo's last Update committed, if any)\n";
+	fStream << "//   COMMIT_DELAY			1 bit	- '1' when the next FirEngine in a chain reads its data an Update later (it commits on this Fifo's previous Update). Valid on DOUPDATE cycle\n";
+	fStream << "//   COEFF_OFFSET			8 bits	- Offset (from the start of the Fifo's Coefficient bank) of the first Coefficient, valid on FIRST_TAP (each phase of an interpolating FIR, and each FIR of a filter bank, has its own Coefficients)\n";
+	fStream << "//   DATA_SKIP				" << dataSkipBits << " bits	- Number of Fifo entries skipped before reading this tap's data (the data of zero taps, which have no TimeSlot)\n";
+	fStream << "//   PHASE_OUTPUT			1 bit	- '1' on the last tap of each phase of an interpolating FIR, or of each FIR of a filter bank (the Output is flagged as changed if the Fifo's last Update committed new data)\n";
 	fStream << "//   MUL_MODE				4 bits	- 0=MUL, 1=MADD, 2=MSUB\n";
 	fStream << "//   ADDPREVENGINEACCUM 	1 bit   - Use value of previous Fir Engine's Accumulator from 2-cycles ago\n";
 	fStream << "//   RDFIFONUM  			8 bits	- Selects which Data Fifo to use\n";
 	fStream << "//   UPDATEFIFONUM			8 bits	- Selects which Data Fifo to update (valid on doUpdate cycle and 3 cycles earlier)\n";
 	fStream << "//   DOUPDATE	      		1 bits	- High at the same time on all FirEngines involved in a firfilter for the last tap of the fir-filter\n";
 	fStream << "//\n";
-	fStream << "//   FIFOSIZES      		16 bits	- Foreach Fifo [FifoOffset : 10 bits, Len-1: 6 bits]\n";
+	fStream << "//   FIFOSIZES      		" << (fifoOffsetBits + fifoLengthBits) << " bits	- Foreach Fifo [FifoOffset : " << fifoOffsetBits << " bits, Len-1: " << fifoLengthBits << " bits]\n";
+	if (m_IsPackedFifos)
+	{
+		fStream << "//   FIFOORIGINS      		" << fifoOffsetBits << " bits	- Foreach Fifo, the first address of its Region (packed Fifos are not aligned)\n";
+		fStream << "//   FIFOREGIONSIZES  		" << (fifoOffsetBits + 1) << " bits	- Foreach Fifo, the number of words in its Region (Fifo addresses wrap modulo this size)\n";
+	}
 	fStream << "//\n";
+	fStream << "//   COEFFORIGINS			" << coeffAddressBits << " bits	- Foreach Fifo, the first address of its Coefficient bank\n";
 	fStream << "//   COEFF_VALUES           24 bits for every slot in Coeff-Buffer\n";
 	fStream << "//\n";
-	// Print Slot Numbers (each Slot is 3 characters wide)
+	// Print Slot Numbers (each Slot is 3 characters wide, so only the low 2 hex digits fit)
+	if (getNumTimeSlots() > 256)
+		fStream << "//                        	  (Slot numbers are modulo 256)\n";
 	fStream << "//                        	  Slot:    ";
 	for (unsigned i = 0; i < getNumTimeSlots(); ++i)
-		fStream << toHexDigits(getNumTimeSlots() - i - 1, 2) << " ";
+		fStream << toHexDigits((getNumTimeSlots() - i - 1) & 0xFF, 2) << " ";
 	fStream << "\n";
 	fStream << "parameter CHANNEL_SELECT		= "; _renderVectorAsHexString(fStream, 4, vChannelSelectCtrl); fStream << ";\n";
+	fStream << "parameter OUTPUT_SELECT		= "; _renderVectorAsHexString(fStream, 4, vOutputSelectCtrl); fStream << ";\n";
 	fStream << "parameter FIRST_ENGINE	 		= "; _renderVectorAsHexString(fStream, 1, vFirstEngineCtrl); fStream << ";\n";
 	fStream << "parameter LAST_ENGINE 		    = "; _renderVectorAsHexString(fStream, 1, vLastEngineCtrl); fStream << ";\n";
 	fStream << "parameter FIRST_TAP		        = "; _renderVectorAsHexString(fStream, 1, vFirstTapCtrl); fStream << ";\n";
 	fStream << "parameter PREADD_MODE			= "; _renderVectorAsHexString(fStream, 4, vPreAddModeCtrl); fStream << ";\n";
+	fStream << "parameter MIRROR_SKIP			= "; _renderVectorAsHexString(fStream, 1, vMirrorSkipCtrl); fStream << ";\n";
+	fStream << "parameter COMMIT_SKIP			= "; _renderVectorAsHexString(fStream, 1, vCommitSkipCtrl); fStream << ";\n";
+	fStream << "parameter COMMIT_DELAY			= "; _renderVectorAsHexString(fStream, 1, vCommitDelayCtrl); fStream << ";\n";
+	fStream << "parameter COEFF_OFFSET			= "; _renderVectorAsHexString(fStream, 8, vCoeffOffsetCtrl); fStream << ";\n";
+	fStream << "parameter DATA_SKIP				= "; _renderVectorAsHexString(fStream, dataSkipBits, vDataSkipCtrl); fStream << ";\n";
+	fStream << "parameter PHASE_OUTPUT			= "; _renderVectorAsHexString(fStream, 1, vPhaseOutputCtrl); fStream << ";\n";
 	fStream << "parameter MUL_MODE				= "; _renderVectorAsHexString(fStream, 4, vMulModeCtrl); fStream << ";\n";
 	fStream << "parameter ADDPREVENGINEACCUM    = "; _renderVectorAsHexString(fStream, 1, vAddPrevEngineAccumCtrl); fStream << ";\n";
 	fStream << "parameter RDFIFONUM 			= "; _renderVectorAsHexString(fStream, 8, vRdFifoNumCtrl); fStream << ";\n";
 	fStream << "parameter UPDATEFIFONUM      	= "; _renderVectorAsHexString(fStream, 8, vUpdateFifoNumCtrl); fStream << ";\n";
 	fStream << "parameter DOUPDATE		        = "; _renderVectorAsHexString(fStream, 1, vDoUpdateCtrl); fStream << ";\n";
 	fStream << "\n";
-	fStream << "parameter FIFOSIZES 			= "; _renderVectorAsConcat(fStream, 16, vFifoSizes); fStream << "; \n";
+	fStream << "parameter FIFOSIZES 			= "; _renderVectorAsConcat(fStream, fifoOffsetBits + fifoLengthBits, vFifoSizes); fStream << "; \n";
+	if (m_IsPackedFifos)
+	{
+		fStream << "parameter FIFOORIGINS 			= "; _renderVectorAsConcat(fStream, fifoOffsetBits, vFifoOrigins); fStream << "; \n";
+		fStream << "parameter FIFOREGIONSIZES 		= "; _renderVectorAsConcat(fStream, fifoOffsetBits + 1, vFifoRegionSizes); fStream << "; \n";
+	}
+	fStream << "parameter COEFFORIGINS 			= "; _renderVectorAsConcat(fStream, coeffAddressBits, vCoeffOrigins); fStream << "; \n";
 	fStream << "parameter COEFF_VALUES 			= "; _renderVectorAsConcat(fStream, 24, vCoeffValues); fStream << ";\n";
 	fStream << "\n";
 
@@ -240,7 +333,7 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "        timeSlice_ps8 <= 0;\n";
 	fStream << "        timeSlice_ps9 <= 0;\n";
 	fStream << "      end else begin\n";
-	fStream << "        timeSlice_psm1 <= timeSlice_psm1 + 1;\n";
+	fStream << "        timeSlice_psm1 <= (timeSlice_psm1 == (TIMESLICES - 1)) ? 0 : (timeSlice_psm1 + 1);     // (TIMESLICES need not be a power of 2)\n";
 	fStream << "        timeSlice_ps0 <= timeSlice_psm1;\n";
 	fStream << "        timeSlice_ps1 <= timeSlice_ps0;\n";
 	fStream << "        timeSlice_ps2 <= timeSlice_ps1;\n";
@@ -346,14 +439,14 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "///////////////////////////////////////////////////////////////\n";
 	fStream << "// create the Coefficient RAM\n";
 	fStream << "///////////////////////////////////////////////////////////////\n";
-	fStream << "reg [LOG2BUFFERDEPTH-1:0] coefBuff_rdaddr;\n";
+	fStream << "reg [LOG2COEFFBUFFERDEPTH-1:0] coefBuff_rdaddr;\n";
 	fStream << "reg [17:0] coefBuff_rddata = 0;\n";
 	fStream << "reg [17:0] coefBuff_rddata_int = 0;\n";
-	fStream << "reg [17:0] coefBuff_contents[(1 << LOG2BUFFERDEPTH)-1:0];\n";
+	fStream << "reg [17:0] coefBuff_contents[COEFFBUFFERDEPTH-1:0];\n";
 	fStream << "\n";
 	fStream << "initial\n";
 	fStream << "begin\n";
-	fStream << "	for (i = 0; i < (1 << LOG2BUFFERDEPTH); i = i + 1)\n";
+	fStream << "	for (i = 0; i < COEFFBUFFERDEPTH; i = i + 1)\n";
 	fStream << "		coefBuff_contents[i] <= COEFF_VALUES >> (24 * i);\n";
 	fStream << "end\n";
 	fStream << "\n";
@@ -377,11 +470,11 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "\n";
 	fStream << "reg [17:0] dataBuffA0_rddata_int = 0;\n";
 	fStream << "reg [17:0] dataBuffA1_rddata_int = 0;\n";
-	fStream << "reg [17:0] dataBuffA_contents[(1 << LOG2BUFFERDEPTH)-1:0];\n";
+	fStream << "reg [17:0] dataBuffA_contents[BUFFERDEPTH-1:0];\n";
 	fStream << "\n";
 	fStream << "initial \n";
 	fStream << "begin\n";
-	fStream << "	for (i = 0; i < (1 << LOG2BUFFERDEPTH); i = i + 1)\n";
+	fStream << "	for (i = 0; i < BUFFERDEPTH; i = i + 1)\n";
 	fStream << "		dataBuffA_contents[i] <= 0;\n";
 	fStream << "end\n";
 	fStream << "\n";
@@ -406,11 +499,11 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "\n";
 	fStream << "reg [17:0] dataBuffB0_rddata_int = 0;\n";
 	fStream << "reg [17:0] dataBuffB1_rddata_int = 0;\n";
-	fStream << "reg [17:0] dataBuffB_contents[(1 << LOG2BUFFERDEPTH)-1:0];\n";
+	fStream << "reg [17:0] dataBuffB_contents[BUFFERDEPTH-1:0];\n";
 	fStream << "\n";
 	fStream << "initial\n";
 	fStream << "begin\n";
-	fStream << "	for (i = 0; i < (1 << LOG2BUFFERDEPTH); i = i + 1)\n";
+	fStream << "	for (i = 0; i < BUFFERDEPTH; i = i + 1)\n";
 	fStream << "		dataBuffB_contents[i] <= 0;\n";
 	fStream << "end\n";
 	fStream << "\n";
@@ -459,7 +552,6 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "\n";
 	fStream << "wire doCommit_ps2;\n";
 	fStream << "assign doCommit_ps2 = firstEngine_ps2 ? chosenDataChanged_ps2 : (chosenDataChanged_ps2 | iInputChangeChain);\n";
-	fStream << "assign oInputChangeChain = doCommit_ps2;\n";
 	fStream << "\n";
 	fStream << "always @(posedge iClk or posedge iRst)\n";
 	fStream << "begin\n";
@@ -578,11 +670,11 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "      .INMODE(dsp48e_inmode_ps5),      	// 5-bit input: INMODE control\n";
 	fStream << "      .OPMODE(dsp48e_opmode_ps7),      	// 9-bit input: Operation mode\n";
 	fStream << "      // Data inputs: Data Ports\n";
-	fStream << "      .A({12'b0, coefBuff_rddata}),  	// 30-bit input: A data\n";
+	fStream << "      .A({{12{coefBuff_rddata[17]}}, coefBuff_rddata}),	// 30-bit input: A data (sign extended coefficient)\n";
 	fStream << "      .B(dataBuffA0_rddata),          	// 18-bit input: B data\n";
-	fStream << "      .C({12'b0, iChainS}),            	// 48-bit input: C data\n";
+	fStream << "      .C({{12{iChainS[35]}}, iChainS}),	// 48-bit input: C data (sign extended partial sum)\n";
 	fStream << "      .CARRYIN(1'b0),                  	// 1-bit input: Carry-in\n";
-	fStream << "      .D({9'b0, dataBuffB0_rddata}),  	// 27-bit input: D data\n";
+	fStream << "      .D({{9{dataBuffB0_rddata[17]}}, dataBuffB0_rddata}),	// 27-bit input: D data (sign extended mirrored data)\n";
 	fStream << "      // Reset/Clock Enable inputs: Reset/Clock Enable Inputs\n";
 	fStream << "      .CEA1(1'b1),                     	// 1-bit input: Clock enable for 1st stage AREG\n";
 	fStream << "      .CEA2(1'b1),            			// 1-bit input: Clock enable for 2nd stage AREG\n";
@@ -657,13 +749,33 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "///////////////////////////////////////////////////////////////\n";
 	fStream << "// Data Outputs\n";
 	fStream << "///////////////////////////////////////////////////////////////\n";
+	fStream << "// (the Output of a FIR whose Coefficients are scaled by 2^CoeffScale is taken CoeffScale bits higher)\n";
 	fStream << "wire [17:0] dspout_ps9 = dsp48e_result_ps9[33:16];\n";
-	fStream << "wire dspoutchanged_ps9 = commit_ps9;\n";
+	fStream << "\n";
+	fStream << "// Remember whether each Fifo's last Update committed new data\n";
+	fStream << "//   the phases of an interpolating FIR (and the FIRs of a filter bank) are computed between Updates, so only produce new Outputs when it did\n";
+	fStream << "reg [NUMFIFOS-1:0] fifoCommitted_ps9 = 0;\n";
+	fStream << "reg [LOG2NUMFIFOS-1:0] rdFifoNum_ps9;\n";
+	fStream << "reg [LOG2NUMFIFOS-1:0] updateFifoNum_ps9;\n";
+	fStream << "reg doUpdate_ps9;\n";
+	fStream << "reg phaseOutput_ps9;\n";
+	fStream << "\n";
+	fStream << "always @(posedge iClk)\n";
+	fStream << "begin\n";
+	fStream << "    rdFifoNum_ps9 <= RDFIFONUM >> {timeSlice_ps8, 3'b0};\n";
+	fStream << "    updateFifoNum_ps9 <= UPDATEFIFONUM >> {timeSlice_ps8, 3'b0};\n";
+	fStream << "    doUpdate_ps9 <= DOUPDATE >> timeSlice_ps8;\n";
+	fStream << "    phaseOutput_ps9 <= PHASE_OUTPUT >> timeSlice_ps8;\n";
+	fStream << "    if (doUpdate_ps9)\n";
+	fStream << "        fifoCommitted_ps9[updateFifoNum_ps9] <= commit_ps9;\n";
+	fStream << "end\n";
+	fStream << "\n";
+	fStream << "wire dspoutchanged_ps9 = phaseOutput_ps9 ? fifoCommitted_ps9[rdFifoNum_ps9] : commit_ps9;\n";
 	fStream << "\n";
 	fStream << "reg [3:0] channelSel_ps9;\n";
 	fStream << "always @(posedge iClk)\n";
 	fStream << "begin\n";
-	fStream << "    channelSel_ps9 <= CHANNEL_SELECT >> {timeSlice_ps8, 2'b0};\n";
+	fStream << "    channelSel_ps9 <= OUTPUT_SELECT >> {timeSlice_ps8, 2'b0};\n";
 	fStream << "end\n";
 	fStream << "\n";
 	for (unsigned i = 0; i < m_vOutputFirs.size(); ++i)
@@ -686,7 +798,11 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "       case (channelSel_ps9)\n";
 	for (unsigned i = 0; i < m_vOutputFirs.size(); ++i)
 	{
-		fStream << "            " << i << ": begin oData" << i << " <= dspout_ps9; dataOut" << i << "Changed <= dspoutchanged_ps9; end\n";
+		int coeffScale = m_vOutputCoeffScale[i];
+		if (coeffScale == 0)
+			fStream << "            " << i << ": begin oData" << i << " <= dspout_ps9; dataOut" << i << "Changed <= dspoutchanged_ps9; end\n";
+		else
+			fStream << "            " << i << ": begin oData" << i << " <= dsp48e_result_ps9[" << (33 + coeffScale) << ":" << (16 + coeffScale) << "]; dataOut" << i << "Changed <= dspoutchanged_ps9; end\n";
 	}
 	fStream << "            default: ;\n";
 	fStream << "       endcase\n";
@@ -707,38 +823,47 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "reg [LOG2NUMFIFOS-1:0] fifoDescBuffA_rdaddr;\n";
 	fStream << "reg [LOG2NUMFIFOS-1:0] fifoDescBuffB_rdaddr;\n";
 	fStream << "reg [LOG2NUMFIFOS-1:0] fifoDescBuff_wraddr;\n";
-	fStream << "wire [15:0] fifoDescBuff_wrdata;\n";
+	fStream << "wire [FIFODESCBITS-1:0] fifoDescBuff_wrdata;\n";
 	fStream << "wire fifoDescBuff_wren;\n";
 	fStream << "\n";
-	fStream << "reg [15:0] fifoDescBuffA_rddata;\n";
-	fStream << "reg [15:0] fifoDescBuffB_rddata;\n";
+	fStream << "reg [FIFODESCBITS-1:0] fifoDescBuffA_rddata;\n";
+	fStream << "reg [FIFODESCBITS-1:0] fifoDescBuffB_rddata;\n";
 	fStream << "\n";
 	fStream << "\n";
-	fStream << "reg [15:0] fifoDescBuffA_rddata_int = 0;\n";
-	fStream << "reg [15:0] fifoDescBuffA_contents[(1 << LOG2NUMFIFOS)-1:0];\n";
+	fStream << "reg [FIFODESCBITS-1:0] fifoDescBuffA_rddata_int = 0;\n";
+	fStream << "reg [LOG2NUMFIFOS-1:0] fifoDescBuffA_rdaddr_int;\n";
+	fStream << "reg [FIFODESCBITS-1:0] fifoDescBuffA_contents[(1 << LOG2NUMFIFOS)-1:0];\n";
 	fStream << "\n";
 	fStream << "initial\n";
 	fStream << "begin\n";
 	fStream << "	for (i = 0; i < NUMFIFOS; i = i + 1)\n";
-	fStream << "		fifoDescBuffA_contents[i] <= FIFOSIZES >> (16 * i);\n";
+	fStream << "		fifoDescBuffA_contents[i] <= FIFOSIZES >> (FIFODESCBITS * i);\n";
 	fStream << "end\n";
 	fStream << "\n";
 	fStream << "always @(posedge iClk)\n";
 	fStream << "begin\n";
 	fStream << "    if (fifoDescBuff_wren)\n";
 	fStream << "    	fifoDescBuffA_contents[fifoDescBuff_wraddr] <= fifoDescBuff_wrdata;\n";
-	fStream << "    fifoDescBuffA_rddata_int <= fifoDescBuffA_contents[fifoDescBuffA_rdaddr];\n";
-	fStream << "  	fifoDescBuffA_rddata <= fifoDescBuffA_rddata_int;\n";
+	fStream << "    fifoDescBuffA_rdaddr_int <= fifoDescBuffA_rdaddr;\n";
+	fStream << "    // a first tap just after an Update reads the Fifo Description that Update is writing back: forward it\n";
+	fStream << "    if (fifoDescBuff_wren && (fifoDescBuff_wraddr == fifoDescBuffA_rdaddr))\n";
+	fStream << "    	fifoDescBuffA_rddata_int <= fifoDescBuff_wrdata;\n";
+	fStream << "    else\n";
+	fStream << "    	fifoDescBuffA_rddata_int <= fifoDescBuffA_contents[fifoDescBuffA_rdaddr];\n";
+	fStream << "    if (fifoDescBuff_wren && (fifoDescBuff_wraddr == fifoDescBuffA_rdaddr_int))\n";
+	fStream << "    	fifoDescBuffA_rddata <= fifoDescBuff_wrdata;\n";
+	fStream << "    else\n";
+	fStream << "    	fifoDescBuffA_rddata <= fifoDescBuffA_rddata_int;\n";
 	fStream << "end\n";
 	fStream << "\n";
 	fStream << "\n";
-	fStream << "reg [15:0] fifoDescBuffB_rddata_int = 0;\n";
-	fStream << "reg [15:0] fifoDescBuffB_contents[(1 << LOG2NUMFIFOS)-1:0];\n";
+	fStream << "reg [FIFODESCBITS-1:0] fifoDescBuffB_rddata_int = 0;\n";
+	fStream << "reg [FIFODESCBITS-1:0] fifoDescBuffB_contents[(1 << LOG2NUMFIFOS)-1:0];\n";
 	fStream << "\n";
 	fStream << "initial\n";
 	fStream << "begin\n";
 	fStream << "	for (i = 0; i < NUMFIFOS; i = i + 1)\n";
-	fStream << "		fifoDescBuffB_contents[i] <= FIFOSIZES >> (16 * i);\n";
+	fStream << "		fifoDescBuffB_contents[i] <= FIFOSIZES >> (FIFODESCBITS * i);\n";
 	fStream << "end\n";
 	fStream << "\n";
 	fStream << "always @(posedge iClk)\n";
@@ -750,10 +875,117 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "end\n";
 	fStream << "\n";
 	fStream << "\n";
+	if (m_IsPackedFifos)
+	{
+		fStream << "///////////////////////////////////////////////////////////////\n";
+		fStream << "// Fifo Region Roms (read alongside the Fifo Description Rams)\n";
+		fStream << "//   (packed Fifos are not aligned, so their Regions can not be decoded from Len-1)\n";
+		fStream << "///////////////////////////////////////////////////////////////\n";
+		fStream << "reg [FIFOOFFSETBITS-1:0] fifoOriginA_rddata_int = 0;\n";
+		fStream << "reg [FIFOOFFSETBITS-1:0] fifoOriginA_rddata;\n";
+		fStream << "reg [FIFOOFFSETBITS:0] fifoRegionSizeA_rddata_int = 0;\n";
+		fStream << "reg [FIFOOFFSETBITS:0] fifoRegionSizeA_rddata;\n";
+		fStream << "reg [FIFOOFFSETBITS-1:0] fifoOriginB_rddata_int = 0;\n";
+		fStream << "reg [FIFOOFFSETBITS-1:0] fifoOriginB_rddata;\n";
+		fStream << "reg [FIFOOFFSETBITS:0] fifoRegionSizeB_rddata_int = 0;\n";
+		fStream << "reg [FIFOOFFSETBITS:0] fifoRegionSizeB_rddata;\n";
+		fStream << "\n";
+		fStream << "always @(posedge iClk)\n";
+		fStream << "begin\n";
+		fStream << "    fifoOriginA_rddata_int <= FIFOORIGINS >> (FIFOOFFSETBITS * fifoDescBuffA_rdaddr);\n";
+		fStream << "    fifoOriginA_rddata <= fifoOriginA_rddata_int;\n";
+		fStream << "    fifoRegionSizeA_rddata_int <= FIFOREGIONSIZES >> ((FIFOOFFSETBITS + 1) * fifoDescBuffA_rdaddr);\n";
+		fStream << "    fifoRegionSizeA_rddata <= fifoRegionSizeA_rddata_int;\n";
+		fStream << "    fifoOriginB_rddata_int <= FIFOORIGINS >> (FIFOOFFSETBITS * fifoDescBuffB_rdaddr);\n";
+		fStream << "    fifoOriginB_rddata <= fifoOriginB_rddata_int;\n";
+		fStream << "    fifoRegionSizeB_rddata_int <= FIFOREGIONSIZES >> ((FIFOOFFSETBITS + 1) * fifoDescBuffB_rdaddr);\n";
+		fStream << "    fifoRegionSizeB_rddata <= fifoRegionSizeB_rddata_int;\n";
+		fStream << "end\n";
+		fStream << "\n";
+		fStream << "// Step a Fifo address back by 'dec' (at most the Region size) wrapping modulo the Region size\n";
+		fStream << "function [FIFOOFFSETBITS-1:0] fifoAddrSub;\n";
+		fStream << "    input [FIFOOFFSETBITS-1:0] addr;\n";
+		fStream << "    input [FIFOOFFSETBITS-1:0] origin;\n";
+		fStream << "    input [FIFOOFFSETBITS:0] size;\n";
+		fStream << "    input [FIFOOFFSETBITS:0] dec;\n";
+		fStream << "    begin\n";
+		fStream << "        if ((addr - origin) < dec)\n";
+		fStream << "            fifoAddrSub = addr + size - dec;\n";
+		fStream << "        else\n";
+		fStream << "            fifoAddrSub = addr - dec;\n";
+		fStream << "    end\n";
+		fStream << "endfunction\n";
+		fStream << "\n";
+		fStream << "// Step a Fifo address forward by 'inc' (at most the Region size) wrapping modulo the Region size\n";
+		fStream << "function [FIFOOFFSETBITS-1:0] fifoAddrAdd;\n";
+		fStream << "    input [FIFOOFFSETBITS-1:0] addr;\n";
+		fStream << "    input [FIFOOFFSETBITS-1:0] origin;\n";
+		fStream << "    input [FIFOOFFSETBITS:0] size;\n";
+		fStream << "    input [FIFOOFFSETBITS:0] inc;\n";
+		fStream << "    begin\n";
+		fStream << "        if ((addr - origin + inc) >= size)\n";
+		fStream << "            fifoAddrAdd = addr + inc - size;\n";
+		fStream << "        else\n";
+		fStream << "            fifoAddrAdd = addr + inc;\n";
+		fStream << "    end\n";
+		fStream << "endfunction\n";
+		fStream << "\n";
+		fStream << "\n";
+	}
+	fStream << "///////////////////////////////////////////////////////////////\n";
+	fStream << "// Whether each Fifo's last Update committed new data (written, read and forwarded alongside its Fifo Description)\n";
+	fStream << "//   a section read an Update later than the first section of its chain skips the entry committed by that Update\n";
+	fStream << "//   and the next FirEngine in a chain commits an Update late, when it reads its data an Update later\n";
+	fStream << "///////////////////////////////////////////////////////////////\n";
+	fStream << "reg [NUMFIFOS-1:0] fifoUpdateCommitted = 0;\n";
+	fStream << "reg doUpdate_ps3;\n";
+	fStream << "reg fifoUpdateCommittedA_rddata_int = 0;\n";
+	fStream << "reg fifoUpdateCommittedA_rddata;\n";
+	fStream << "reg fifoUpdateCommittedB_rddata_int = 0;\n";
+	fStream << "reg fifoUpdateCommittedB_rddata;\n";
+	fStream << "reg commitDelay_ps2;\n";
+	fStream << "\n";
+	fStream << "always @(posedge iClk)\n";
+	fStream << "begin\n";
+	fStream << "    doUpdate_ps3 <= doUpdate_ps2;\n";
+	fStream << "    if (doUpdate_ps3)\n";
+	fStream << "    	fifoUpdateCommitted[fifoDescBuff_wraddr] <= commit_ps3;\n";
+	fStream << "    if (doUpdate_ps3 && (fifoDescBuff_wraddr == fifoDescBuffA_rdaddr))\n";
+	fStream << "    	fifoUpdateCommittedA_rddata_int <= commit_ps3;\n";
+	fStream << "    else\n";
+	fStream << "    	fifoUpdateCommittedA_rddata_int <= fifoUpdateCommitted[fifoDescBuffA_rdaddr];\n";
+	fStream << "    if (doUpdate_ps3 && (fifoDescBuff_wraddr == fifoDescBuffA_rdaddr_int))\n";
+	fStream << "    	fifoUpdateCommittedA_rddata <= commit_ps3;\n";
+	fStream << "    else\n";
+	fStream << "    	fifoUpdateCommittedA_rddata <= fifoUpdateCommittedA_rddata_int;\n";
+	fStream << "    fifoUpdateCommittedB_rddata_int <= fifoUpdateCommitted[fifoDescBuffB_rdaddr];\n";
+	fStream << "  	fifoUpdateCommittedB_rddata <= fifoUpdateCommittedB_rddata_int;\n";
+	fStream << "    commitDelay_ps2 <= COMMIT_DELAY >> timeSlice_ps1;\n";
+	fStream << "end\n";
+	fStream << "\n";
+	fStream << "assign oInputChangeChain = commitDelay_ps2 ? fifoUpdateCommittedB_rddata : doCommit_ps2;\n";
+	fStream << "\n";
+	fStream << "///////////////////////////////////////////////////////////////\n";
+	fStream << "// Coefficient Bank Rom (read alongside Fifo Description Ram A)\n";
+	fStream << "///////////////////////////////////////////////////////////////\n";
+	fStream << "reg [LOG2COEFFBUFFERDEPTH-1:0] coeffOriginA_rddata_int = 0;\n";
+	fStream << "reg [LOG2COEFFBUFFERDEPTH-1:0] coeffOriginA_rddata;\n";
+	fStream << "\n";
+	fStream << "always @(posedge iClk)\n";
+	fStream << "begin\n";
+	fStream << "    coeffOriginA_rddata_int <= COEFFORIGINS >> (LOG2COEFFBUFFERDEPTH * fifoDescBuffA_rdaddr);\n";
+	fStream << "    coeffOriginA_rddata <= coeffOriginA_rddata_int;\n";
+	fStream << "end\n";
+	fStream << "\n";
+	fStream << "\n";
 	fStream << "///////////////////////////////////////////////////////////////\n";
 	fStream << "// Fifo Controls\n";
 	fStream << "///////////////////////////////////////////////////////////////\n";
 	fStream << "reg firstTap_ps2;\n";
+	fStream << "reg mirrorSkip_ps2;\n";
+	fStream << "reg commitSkip_ps2;\n";
+	fStream << "reg [7:0] coeffOffset_ps2;\n";
+	fStream << "reg [" << (dataSkipBits - 1) << ":0] dataSkip_ps2;\n";
 	fStream << "\n";
 	fStream << "always @(posedge iClk) \n";
 	fStream << "begin\n";
@@ -761,96 +993,126 @@ void FirEngineMacDesc::generateRtl(const string& firEngineMacName, const FirEngi
 	fStream << "    fifoDescBuffB_rdaddr <= UPDATEFIFONUM >> {timeSlice_psm1, 3'b0};\n";
 	fStream << "    fifoDescBuff_wraddr <= UPDATEFIFONUM >> {timeSlice_ps2, 3'b0};\n";
 	fStream << "    firstTap_ps2 <= FIRST_TAP >> timeSlice_ps1;\n";
+	fStream << "    mirrorSkip_ps2 <= MIRROR_SKIP >> timeSlice_ps1;\n";
+	fStream << "    commitSkip_ps2 <= COMMIT_SKIP >> timeSlice_ps1;\n";
+	fStream << "    coeffOffset_ps2 <= COEFF_OFFSET >> {timeSlice_ps1, 3'b0};\n";
+	fStream << "    dataSkip_ps2 <= DATA_SKIP >> {timeSlice_ps1, " << IntUtils::bitWidthForEncodingValues(dataSkipBits) << "'b0};\n";
 	fStream << "end\n";
 	fStream << "\n";
 	fStream << "assign fifoDescBuff_wren = commit_ps3;\n";
 	fStream << "\n";
 	fStream << "\n";
-	fStream << "wire [9:0] currFifoOffset = fifoDescBuffA_rddata[15:6];\n";
-	fStream << "wire [9:0] currFifoLengthMinusOne = {4'b0, fifoDescBuffA_rddata[5:0]};\n";
-	fStream << "reg  [9:0] currFifoRegion;        // lowest power of 2 >= currFifoLengthMinusOne\n";
-	fStream << "wire [9:0] currFifoRegionOrigin = currFifoOffset & ~currFifoRegion;\n";
-	fStream << "\n";
-	fStream << "always @(currFifoLengthMinusOne) begin\n";
-	fStream << "    if (currFifoLengthMinusOne[5])\n";
-	fStream << "        currFifoRegion = 10'b0000111111;\n";
-	fStream << "    else if (currFifoLengthMinusOne[4])\n";
-	fStream << "        currFifoRegion = 10'b0000011111;\n";
-	fStream << "    else if (currFifoLengthMinusOne[3])\n";
-	fStream << "        currFifoRegion = 10'b0000001111;\n";
-	fStream << "    else if (currFifoLengthMinusOne[2])\n";
-	fStream << "        currFifoRegion = 10'b0000000111;\n";
-	fStream << "    else if (currFifoLengthMinusOne[1])\n";
-	fStream << "        currFifoRegion = 10'b0000000011;\n";
-	fStream << "    else\n";
-	fStream << "        currFifoRegion = 10'b0000000001;\n";
-	fStream << "end\n";
-	fStream << "\n";
-	fStream << "// The coefficient buffer is always read from the Fifo-origin address\n";
-	fStream << "always @(posedge iClk) \n";
-	fStream << "begin\n";
-	fStream << "    if (firstTap_ps2) begin\n";
-	fStream << "        coefBuff_rdaddr <= currFifoRegionOrigin;            // Start of Fifo Region\n";
-	fStream << "        dataBuffA0_rdaddr <= currFifoOffset;\n";
-	fStream << "        dataBuffB0_rdaddr <= currFifoRegionOrigin | ((currFifoOffset - currFifoLengthMinusOne) & currFifoRegion);\n";
-	fStream << "    end else begin\n";
-	fStream << "        coefBuff_rdaddr <= coefBuff_rdaddr + 1;\n";
-	fStream << "        dataBuffA0_rdaddr <= currFifoRegionOrigin | ((dataBuffA0_rdaddr - 1) & currFifoRegion);\n";
-	fStream << "        dataBuffB0_rdaddr <= currFifoRegionOrigin | ((dataBuffB0_rdaddr + 1) & currFifoRegion);\n";
-	fStream << "    end\n";
-	fStream << "end\n";
+	// Fifo lengths are zero-extended to the width of an offset (only when narrower: a zero-width replication is illegal in Verilog-2001)
+	assert(fifoLengthBits <= fifoOffsetBits);
+	string fifoLengthExtension = (fifoLengthBits < fifoOffsetBits) ? "{(FIFOOFFSETBITS-FIFOLENBITS){1'b0}}, " : "";
+	fStream << "wire [FIFOOFFSETBITS-1:0] currFifoOffset = fifoDescBuffA_rddata[FIFODESCBITS-1:FIFOLENBITS];\n";
+	fStream << "wire [FIFOOFFSETBITS-1:0] currFifoLengthMinusOne = {" << fifoLengthExtension << "fifoDescBuffA_rddata[FIFOLENBITS-1:0]};\n";
+	fStream << "wire [FIFOOFFSETBITS-1:0] firstTapSkip = dataSkip_ps2 + (commitSkip_ps2 & fifoUpdateCommittedA_rddata);\n";
+	if (m_IsPackedFifos)
+	{
+		fStream << "wire [FIFOOFFSETBITS-1:0] currFifoRegionOrigin = fifoOriginA_rddata;\n";
+		fStream << "wire [FIFOOFFSETBITS:0] currFifoRegionSize = fifoRegionSizeA_rddata;\n";
+		fStream << "\n";
+		fStream << "// The coefficient buffer is read from the Fifo's Coefficient bank\n";
+		fStream << "always @(posedge iClk) \n";
+		fStream << "begin\n";
+		fStream << "    if (firstTap_ps2) begin\n";
+		fStream << "        coefBuff_rdaddr <= coeffOriginA_rddata + coeffOffset_ps2;     // Start of the Coefficient bank (plus the offset of this phase's Coefficients)\n";
+		fStream << "        dataBuffA0_rdaddr <= fifoAddrSub(currFifoOffset, currFifoRegionOrigin, currFifoRegionSize, firstTapSkip);\n";
+		fStream << "        dataBuffB0_rdaddr <= fifoAddrAdd(fifoAddrSub(currFifoOffset, currFifoRegionOrigin, currFifoRegionSize, currFifoLengthMinusOne), currFifoRegionOrigin, currFifoRegionSize, mirrorSkip_ps2 + dataSkip_ps2);\n";
+		fStream << "    end else begin\n";
+		fStream << "        // Coefficients of zero taps are not stored, but their data is skipped\n";
+		fStream << "        coefBuff_rdaddr <= coefBuff_rdaddr + 1;\n";
+		fStream << "        dataBuffA0_rdaddr <= fifoAddrSub(dataBuffA0_rdaddr, currFifoRegionOrigin, currFifoRegionSize, 1 + dataSkip_ps2);\n";
+		fStream << "        dataBuffB0_rdaddr <= fifoAddrAdd(dataBuffB0_rdaddr, currFifoRegionOrigin, currFifoRegionSize, 1 + dataSkip_ps2);\n";
+		fStream << "    end\n";
+		fStream << "end\n";
+	}
+	else
+	{
+		fStream << "reg  [FIFOOFFSETBITS-1:0] currFifoRegion;        // lowest power of 2 >= currFifoLengthMinusOne\n";
+		fStream << "wire [FIFOOFFSETBITS-1:0] currFifoRegionOrigin = currFifoOffset & ~currFifoRegion;\n";
+		fStream << "\n";
+		fStream << "always @(currFifoLengthMinusOne) begin\n";
+		_renderFifoRegionDecoder(fStream, "currFifo", fifoLengthBits, fifoOffsetBits);
+		fStream << "end\n";
+		fStream << "\n";
+		fStream << "// The coefficient buffer is read from the Fifo's Coefficient bank\n";
+		fStream << "always @(posedge iClk) \n";
+		fStream << "begin\n";
+		fStream << "    if (firstTap_ps2) begin\n";
+		fStream << "        coefBuff_rdaddr <= coeffOriginA_rddata + coeffOffset_ps2;     // Start of the Coefficient bank (plus the offset of this phase's Coefficients)\n";
+		fStream << "        dataBuffA0_rdaddr <= currFifoRegionOrigin | ((currFifoOffset - firstTapSkip) & currFifoRegion);\n";
+		fStream << "        dataBuffB0_rdaddr <= currFifoRegionOrigin | ((currFifoOffset - currFifoLengthMinusOne + mirrorSkip_ps2 + dataSkip_ps2) & currFifoRegion);\n";
+		fStream << "    end else begin\n";
+		fStream << "        // Coefficients of zero taps are not stored, but their data is skipped\n";
+		fStream << "        coefBuff_rdaddr <= coefBuff_rdaddr + 1;\n";
+		fStream << "        dataBuffA0_rdaddr <= currFifoRegionOrigin | ((dataBuffA0_rdaddr - 1 - dataSkip_ps2) & currFifoRegion);\n";
+		fStream << "        dataBuffB0_rdaddr <= currFifoRegionOrigin | ((dataBuffB0_rdaddr + 1 + dataSkip_ps2) & currFifoRegion);\n";
+		fStream << "    end\n";
+		fStream << "end\n";
+	}
 	fStream << "\n";
 	fStream << "\n";
-	fStream << "wire [9:0] updateFifoOffset = fifoDescBuffB_rddata[15:6];\n";
-	fStream << "wire [9:0] updateFifoLengthMinusOne = {4'b0, fifoDescBuffB_rddata[5:0]};\n";
-	fStream << "reg  [9:0] updateFifoRegion;        // lowest power of 2 >= currFifoLengthMinusOne\n";
-	fStream << "wire [9:0] updateFifoRegionOrigin = updateFifoOffset & ~updateFifoRegion;\n";
-	fStream << "\n";
-	fStream << "always @(updateFifoLengthMinusOne) begin\n";
-	fStream << "    if (updateFifoLengthMinusOne[5])\n";
-	fStream << "        updateFifoRegion = 10'b0000111111;\n";
-	fStream << "    else if (updateFifoLengthMinusOne[4])\n";
-	fStream << "        updateFifoRegion = 10'b0000011111;\n";
-	fStream << "    else if (updateFifoLengthMinusOne[3])\n";
-	fStream << "        updateFifoRegion = 10'b0000001111;\n";
-	fStream << "    else if (updateFifoLengthMinusOne[2])\n";
-	fStream << "        updateFifoRegion = 10'b0000000111;\n";
-	fStream << "    else if (updateFifoLengthMinusOne[1])\n";
-	fStream << "        updateFifoRegion = 10'b0000000011;\n";
-	fStream << "    else\n";
-	fStream << "        updateFifoRegion = 10'b0000000001;\n";
-	fStream << "end\n";
+	fStream << "wire [FIFOOFFSETBITS-1:0] updateFifoOffset = fifoDescBuffB_rddata[FIFODESCBITS-1:FIFOLENBITS];\n";
+	fStream << "wire [FIFOOFFSETBITS-1:0] updateFifoLengthMinusOne = {" << fifoLengthExtension << "fifoDescBuffB_rddata[FIFOLENBITS-1:0]};\n";
+	if (m_IsPackedFifos)
+	{
+		fStream << "wire [FIFOOFFSETBITS-1:0] updateFifoRegionOrigin = fifoOriginB_rddata;\n";
+		fStream << "wire [FIFOOFFSETBITS:0] updateFifoRegionSize = fifoRegionSizeB_rddata;\n";
+	}
+	else
+	{
+		fStream << "reg  [FIFOOFFSETBITS-1:0] updateFifoRegion;        // lowest power of 2 >= currFifoLengthMinusOne\n";
+		fStream << "wire [FIFOOFFSETBITS-1:0] updateFifoRegionOrigin = updateFifoOffset & ~updateFifoRegion;\n";
+		fStream << "\n";
+		fStream << "always @(updateFifoLengthMinusOne) begin\n";
+		_renderFifoRegionDecoder(fStream, "updateFifo", fifoLengthBits, fifoOffsetBits);
+		fStream << "end\n";
+	}
 	fStream << "\n";
 	fStream << "// The coefficient buffer is always read from the Fifo-origin address\n";
-	fStream << "reg [9:0] dataBuffAB1UpdateAddr;\n";
-	fStream << "reg [9:0] dataBuffAB1NextAddr;\n";
-	fStream << "reg [9:0] dataBuffAB1FifoLengthMinusOne;\n";
-	fStream << "reg [9:0] dataBuffAB1NextAddr_delay1;\n";
-	fStream << "reg [9:0] dataBuffAB1FifoLengthMinusOne_delay1;\n";
-	fStream << "reg [9:0] dataBuffAB1NextAddr_delay2;\n";
-	fStream << "reg [9:0] dataBuffAB1FifoLengthMinusOne_delay2;\n";
+	fStream << "reg [FIFOOFFSETBITS-1:0] dataBuffAB1UpdateAddr;\n";
+	fStream << "reg [FIFOOFFSETBITS-1:0] dataBuffAB1NextAddr;\n";
+	fStream << "reg [FIFOOFFSETBITS-1:0] dataBuffAB1FifoLengthMinusOne;\n";
+	fStream << "reg [FIFOOFFSETBITS-1:0] dataBuffAB1NextAddr_delay1;\n";
+	fStream << "reg [FIFOOFFSETBITS-1:0] dataBuffAB1FifoLengthMinusOne_delay1;\n";
+	fStream << "reg [FIFOOFFSETBITS-1:0] dataBuffAB1NextAddr_delay2;\n";
+	fStream << "reg [FIFOOFFSETBITS-1:0] dataBuffAB1FifoLengthMinusOne_delay2;\n";
+	fStream << "reg [FIFOOFFSETBITS-1:0] dataBuffAB1FifoLengthMinusOne_delay3;\n";
 	fStream << "\n";
 	fStream << "always @(posedge iClk)\n";
 	fStream << "begin\n";
 	fStream << "    if (doUpdate_ps2)           // Update Data in DataBuffers\n";
 	fStream << "        dataBuffAB1UpdateAddr <= dataBuffAB1NextAddr_delay2;\n";
 	fStream << "    else                    // Read Data about to be popped from DataBuffers\n";
-	fStream << "        dataBuffAB1UpdateAddr <= updateFifoRegionOrigin | ((updateFifoOffset - updateFifoLengthMinusOne) & updateFifoRegion);\n";
+	if (m_IsPackedFifos)
+		fStream << "        dataBuffAB1UpdateAddr <= fifoAddrSub(updateFifoOffset, updateFifoRegionOrigin, updateFifoRegionSize, updateFifoLengthMinusOne);\n";
+	else
+		fStream << "        dataBuffAB1UpdateAddr <= updateFifoRegionOrigin | ((updateFifoOffset - updateFifoLengthMinusOne) & updateFifoRegion);\n";
 	fStream << "\n";
 	fStream << "    // this is the address in the circular buffer where the next data entry should go (push)\n";
-	fStream << "    dataBuffAB1NextAddr <= currFifoRegionOrigin | ((currFifoOffset + 1) & currFifoRegion);\n";
-	fStream << "    dataBuffAB1FifoLengthMinusOne <= currFifoLengthMinusOne;\n";
+	fStream << "    //   (taken from the Update Fifo on the Read cycle, 3 cycles ahead of the Update)\n";
+	if (m_IsPackedFifos)
+		fStream << "    dataBuffAB1NextAddr <= fifoAddrAdd(updateFifoOffset, updateFifoRegionOrigin, updateFifoRegionSize, 1);\n";
+	else
+		fStream << "    dataBuffAB1NextAddr <= updateFifoRegionOrigin | ((updateFifoOffset + 1) & updateFifoRegion);\n";
+	fStream << "    dataBuffAB1FifoLengthMinusOne <= updateFifoLengthMinusOne;\n";
 	fStream << "\n";
 	fStream << "    dataBuffAB1NextAddr_delay1 <= dataBuffAB1NextAddr;\n";
 	fStream << "    dataBuffAB1FifoLengthMinusOne_delay1 <= dataBuffAB1FifoLengthMinusOne;\n";
 	fStream << "    dataBuffAB1NextAddr_delay2 <= dataBuffAB1NextAddr_delay1;\n";
 	fStream << "    dataBuffAB1FifoLengthMinusOne_delay2 <= dataBuffAB1FifoLengthMinusOne_delay1;\n";
+	fStream << "    dataBuffAB1FifoLengthMinusOne_delay3 <= dataBuffAB1FifoLengthMinusOne_delay2;\n";
 	fStream << "end\n";
 	fStream << "\n";
 	fStream << "assign dataBuffA1_rwaddr = dataBuffAB1UpdateAddr;\n";
 	fStream << "assign dataBuffB1_rwaddr = dataBuffAB1UpdateAddr;\n";
-	fStream << "assign fifoDescBuff_wrdata = { dataBuffAB1NextAddr_delay2, dataBuffAB1FifoLengthMinusOne_delay2[5:0] };\n";
+	fStream << "// The Fifo Description written back is that of the Fifo just Updated (UPDATEFIFONUM 3 cycles earlier)\n";
+	fStream << "assign fifoDescBuff_wrdata = { dataBuffAB1UpdateAddr, dataBuffAB1FifoLengthMinusOne_delay3[FIFOLENBITS-1:0] };\n";
 	fStream << "\n";
 	fStream << "\n";
 	fStream << "endmodule\n";
+
+	return writeFileIfChanged(firEngineMacName + ".v", fStream.str());
 }
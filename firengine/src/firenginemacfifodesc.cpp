@@ -1,12 +1,26 @@
 
+#include <assert.h>
+#include <algorithm>
 #include "firenginemacfifodesc.h"
 
 
 FirEngineMacFifoDesc::FirEngineMacFifoDesc() :
 	m_FirIndex			(0),
+	m_OutputFirIndex	(0),
 	m_FifoDepth			(0),
 	m_NumFifoMemWords	(1),
-	m_vFirCoeffRef		()
+	m_IsFirstEngine		(true),
+	m_IsLastEngine		(true),
+	m_IsCrossTerm		(false),
+	m_IsCommitDelayed	(false),
+	m_IsDataDelayed		(false),
+	m_PreAddMode		(0),
+	m_IsOddFold			(false),
+	m_Interpolation		(1),
+	m_vBankFirIndex		(),
+	m_vFirCoeffRef		(),
+	m_vDataIndex		(),
+	m_vCoeffValue		()
 {
 }
 	
@@ -14,3 +28,45 @@ bool FirEngineMacFifoDesc::memWordsLessThan(const FirEngineMacFifoDesc& d0, cons
 {
 	return d0.m_NumFifoMemWords < d1.m_NumFifoMemWords;
 }
+
+unsigned FirEngineMacFifoDesc::encodeCoeffCode(int coeffCode)
+{
+	assert(coeffCode < (1 << 17));
+	assert(coeffCode >= -(1 << 17));
+	return unsigned(coeffCode) & ((1 << 18) - 1);
+}
+
+bool FirEngineMacFifoDesc::isForFirIndex(unsigned firIndex) const
+{
+	if (m_FirIndex == firIndex)
+		return true;
+	return find(m_vBankFirIndex.begin(), m_vBankFirIndex.end(), firIndex) != m_vBankFirIndex.end();
+}
+
+unsigned FirEngineMacFifoDesc::findTapIndex(const FirCoeffRef& firCoeffRef) const
+{
+	for (unsigned i = 0; i < m_vFirCoeffRef.size(); ++i)
+	{
+		if ((m_vFirCoeffRef[i].m_FirIndex == firCoeffRef.m_FirIndex) && (m_vFirCoeffRef[i].m_CoeffIndex == firCoeffRef.m_CoeffIndex))
+			return i;
+	}
+	assert(false);		// Coefficient not found!
+	return 0;
+}
+
+bool FirEngineMacFifoDesc::isPhaseFirstTap(unsigned tapIdx) const
+{
+	// phase p holds coefficients p, p+Interpolation, p+2*Interpolation, ... (and the FIRs of a filter bank follow each other)
+	if (tapIdx == 0)
+		return true;
+	if (m_vFirCoeffRef[tapIdx].m_FirIndex != m_vFirCoeffRef[tapIdx - 1].m_FirIndex)
+		return true;
+	return (m_vFirCoeffRef[tapIdx].m_CoeffIndex % m_Interpolation) != (m_vFirCoeffRef[tapIdx - 1].m_CoeffIndex % m_Interpolation);
+}
+
+bool FirEngineMacFifoDesc::isPhaseLastTap(unsigned tapIdx) const
+{
+	if ((tapIdx + 1) == m_vFirCoeffRef.size())
+		return true;
+	return isPhaseFirstTap(tapIdx + 1);
+}
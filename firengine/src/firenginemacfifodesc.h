@@ -17,15 +17,56 @@ public:
 	FirEngineMacFifoDesc();
 public:
 	static bool memWordsLessThan(const FirEngineMacFifoDesc& d0, const FirEngineMacFifoDesc& d1);
+	/// Coefficient-RAM contents (18 bits) for a Coefficient word (see FirSpec::m_vCoeffCode)
+	static unsigned encodeCoeffCode(int coeffCode);
+public:
+	/// Is this Fifo used for a particular FIR (its own, or one of its filter bank)
+	bool isForFirIndex(unsigned firIndex) const;
+	/// Outputs are driven on the last tap of each phase (or of each FIR of a filter bank) rather than on the Update
+	bool hasPhaseOutputs() const		{ return (m_Interpolation > 1) || !m_vBankFirIndex.empty(); }
+	/// Position of a Coefficient in m_vFirCoeffRef
+	unsigned findTapIndex(const FirCoeffRef&) const;
+	/// Is the n'th tap the first of the section (or of one of its phases, or of a FIR of its filter bank)
+	bool isPhaseFirstTap(unsigned tapIdx) const;
+	/// Is the n'th tap the last of the section (or of one of its phases, or of a FIR of its filter bank)
+	bool isPhaseLastTap(unsigned tapIdx) const;
 public:
 	/// FIR Index that this Fifo is used for
 	unsigned				m_FirIndex;
+	/// FIR whose Output this Fifo's chain produces (m_FirIndex, unless adding the cross terms of a complex FIR)
+	unsigned				m_OutputFirIndex;
 	/// Number of Entries required by this Fifo
 	unsigned				m_FifoDepth;
-	/// Number of Words needed for this Fifo (must be a power of 2, greater than or equal to FifoDepth)
+	/// Number of Words needed for this Fifo (must be greater than or equal to FifoDepth, and a power of 2 unless the Fifos are packed)
+	///   (Coefficients use the same addresses, so a polyphase Fifo may need more Words than Entries)
 	unsigned				m_NumFifoMemWords;
-	/// FIR Coefficients used in the Coeff-Fifo
+	/// This Fifo is at the start of the FIR's MAC-chain (takes its data from the FIR Input)
+	bool					m_IsFirstEngine;
+	/// This Fifo is at the end of the FIR's MAC-chain (produces the FIR Output)
+	bool					m_IsLastEngine;
+	/// This Fifo adds the cross terms of a complex FIR, taking its data from the FIR Input but adding the partial sum of the previous MAC
+	bool					m_IsCrossTerm;
+	/// The next Fifo in the FIR's MAC-chain is read an Update later than this one (it commits the entries passed to it an Update late)
+	bool					m_IsCommitDelayed;
+	/// This Fifo is read an Update later than the first Fifo of its chain (its first tap skips the entry committed by that Update, if any)
+	bool					m_IsDataDelayed;
+	/// Pre-adder mode used by the taps of a folded FIR: 0=NoPreadder(B*A), 1=PreAdd((D+B)*A), 2=PreSub((D-B)*A)
+	///   (the mirrored data is read from dataBuffB, which holds the data that has passed through dataBuffA)
+	unsigned				m_PreAddMode;
+	/// Folded FIR has an odd number of coefficients (the middle tap is not pre-added)
+	bool					m_IsOddFold;
+	/// Number of polyphase sub-filters reading this Fifo (each phase starts with FIRST_TAP and ends with an Output)
+	unsigned				m_Interpolation;
+	/// Other FIRs filtering the same Input (a filter bank), computed from this Fifo's data after the FIR's own taps
+	vector<unsigned>		m_vBankFirIndex;
+	/// FIR Coefficients used in the Coeff-Fifo (grouped by phase or by FIR of the filter bank, without zero taps)
 	vector<FirCoeffRef>		m_vFirCoeffRef;
+	/// Fifo entry (0 = newest) read with each of the Coefficients
+	///   (entries between the taps belong to zero taps, and are skipped)
+	vector<unsigned>		m_vDataIndex;
+	/// Coefficient-RAM contents for each of the Coefficients (the FIR's Coefficient words, negated for PreSub)
+	///   (Fifos of a MAC with the same contents share a Coefficient bank)
+	vector<unsigned>		m_vCoeffValue;
 };
 
 
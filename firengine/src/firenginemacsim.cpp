@@ -0,0 +1,401 @@
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include "intutils.h"
+#include "firenginemacsim.h"
+
+
+static unsigned _mask(unsigned numBits)
+{
+	return (numBits >= 32) ? ~0u : ((1u << numBits) - 1);
+}
+
+FirEngineMacSim::FirEngineMacSim(const FirEngineMacDesc& firEngineMacDesc) :
+	m_NumInputs					(firEngineMacDesc.m_vInputFirs.size()),
+	m_NumOutputs				(firEngineMacDesc.m_vOutputFirs.size()),
+	m_IsPackedFifos				(firEngineMacDesc.m_IsPackedFifos),
+	m_NumTimeSlots				(firEngineMacDesc.getNumTimeSlots()),
+	m_NumFifosMask				(0),
+	m_BufferDepthMask			(0),
+	m_CoeffBufferDepthMask		(0),
+	m_FifoLengthBits			(0),
+	m_FifoOffsetBits			(0),
+	m_DataSkipMask				(0),
+	m_vChannelSelectCtrl		(),
+	m_vOutputSelectCtrl			(),
+	m_vFirstEngineCtrl			(),
+	m_vLastEngineCtrl			(),
+	m_vFirstTapCtrl				(),
+	m_vPreAddModeCtrl			(),
+	m_vMirrorSkipCtrl			(),
+	m_vCommitSkipCtrl			(),
+	m_vCommitDelayCtrl			(),
+	m_vCoeffOffsetCtrl			(),
+	m_vDataSkipCtrl				(),
+	m_vPhaseOutputCtrl			(),
+	m_vMulModeCtrl				(),
+	m_vAddPrevEngineAccumCtrl	(),
+	m_vRdFifoNumCtrl			(),
+	m_vUpdateFifoNumCtrl		(),
+	m_vDoUpdateCtrl				(),
+	m_vFifoOrigins				(),
+	m_vFifoRegionSizes			(),
+	m_vCoeffOrigins				(),
+	m_vOutputCoeffScale			(firEngineMacDesc.m_vOutputCoeffScale),
+	m_vCoefBuff					(),
+	m_vDataBuffA				(),
+	m_vDataBuffB				(),
+	m_vFifoDescBuffA			(),
+	m_vFifoDescBuffB			(),
+	m_vFifoCommitted			(),
+	m_vFifoUpdateCommitted		()
+{
+	assert(m_NumInputs < s_MaxNumChannels);
+	assert(m_NumOutputs < s_MaxNumChannels);
+
+	// Note: Fifos must be in their final order before Fifo numbers are taken
+	const_cast<FirEngineMacDesc&>(firEngineMacDesc).sortFifosInDescendingSizeOrder();
+
+	firEngineMacDesc.establishChannelSelectCtrl(&m_vChannelSelectCtrl);
+	firEngineMacDesc.establishOutputSelectCtrl(&m_vOutputSelectCtrl);
+	firEngineMacDesc.establishFirstEngineCtrl(&m_vFirstEngineCtrl);
+	firEngineMacDesc.establishLastEngineCtrl(&m_vLastEngineCtrl);
+	firEngineMacDesc.establishFirstTapCtrl(&m_vFirstTapCtrl);
+	firEngineMacDesc.establishPreAddModeCtrl(&m_vPreAddModeCtrl);
+	firEngineMacDesc.establishMirrorSkipCtrl(&m_vMirrorSkipCtrl);
+	firEngineMacDesc.establishCommitSkipCtrl(&m_vCommitSkipCtrl);
+	firEngineMacDesc.establishCommitDelayCtrl(&m_vCommitDelayCtrl);
+	firEngineMacDesc.establishCoeffOffsetCtrl(&m_vCoeffOffsetCtrl);
+	firEngineMacDesc.establishDataSkipCtrl(&m_vDataSkipCtrl);
+	firEngineMacDesc.establishPhaseOutputCtrl(&m_vPhaseOutputCtrl);
+	firEngineMacDesc.establishMulModeCtrl(&m_vMulModeCtrl);
+	firEngineMacDesc.establishAddPrevEngineAccumCtrl(&m_vAddPrevEngineAccumCtrl);
+	firEngineMacDesc.establishRdFifoNumCtrl(&m_vRdFifoNumCtrl);
+	firEngineMacDesc.establishUpdateFifoNumCtrl(&m_vUpdateFifoNumCtrl);
+	firEngineMacDesc.establishDoUpdateCtrl(&m_vDoUpdateCtrl);
+
+	// The widths of the RTL's registers (as in generateRtl)
+	m_NumFifosMask = _mask(max(1u, IntUtils::bitWidthForEncodingValues(firEngineMacDesc.getNumFifos())));
+	m_BufferDepthMask = _mask(IntUtils::bitWidthForEncodingValues(firEngineMacDesc.getBufferDepth()));
+	m_FifoLengthBits = firEngineMacDesc.getFifoLengthBitWidth();
+	m_FifoOffsetBits = firEngineMacDesc.getFifoOffsetBitWidth();
+	m_DataSkipMask = (*max_element(m_vDataSkipCtrl.begin(), m_vDataSkipCtrl.end()) < (1 << 8)) ? 0xFF : 0xFFFF;
+
+	// Coefficient RAM (18 bits of each 24 bit COEFF_VALUES slot)
+	vector<unsigned> vCoeffValues;
+	firEngineMacDesc.establishCoeffValues(&vCoeffValues);
+	firEngineMacDesc.establishCoeffOrigins(&m_vCoeffOrigins);
+	m_CoeffBufferDepthMask = _mask(max(1u, IntUtils::bitWidthForEncodingValues(vCoeffValues.size())));
+	for (unsigned i = 0; i < vCoeffValues.size(); ++i)
+		m_vCoefBuff.push_back(int(_signExtend(vCoeffValues[i], 18)));
+
+	// Data RAMs start cleared, Fifo Description RAMs hold FIFOSIZES
+	m_vDataBuffA.assign(firEngineMacDesc.getBufferDepth(), 0);
+	m_vDataBuffB.assign(firEngineMacDesc.getBufferDepth(), 0);
+	firEngineMacDesc.establishFifoSizes(&m_vFifoDescBuffA);
+	m_vFifoDescBuffA.resize(m_NumFifosMask + 1, 0);
+	m_vFifoDescBuffB = m_vFifoDescBuffA;
+	if (m_IsPackedFifos)
+	{
+		firEngineMacDesc.establishFifoOrigins(&m_vFifoOrigins);
+		firEngineMacDesc.establishFifoRegionSizes(&m_vFifoRegionSizes);
+	}
+	m_vFifoCommitted.assign(firEngineMacDesc.getNumFifos(), false);
+	m_vFifoUpdateCommitted.assign(m_NumFifosMask + 1, false);
+
+	// Registers start as they are left by iRst (those without a reset are taken as 0)
+	memset(&m_Reg, 0, sizeof(m_Reg));
+	memset(m_InputData, 0, sizeof(m_InputData));
+	memset(m_InputDataChanged, 0, sizeof(m_InputDataChanged));
+}
+
+void FirEngineMacSim::setInput(unsigned inputIdx, int data, bool isDataChanged)
+{
+	assert(inputIdx < m_NumInputs);
+	m_InputData[inputIdx] = int(_signExtend(data, 18));
+	m_InputDataChanged[inputIdx] = isDataChanged;
+}
+
+bool FirEngineMacSim::findInputChangeChain(bool isInputChangeChain) const
+{
+	return m_Reg.m_CommitDelay_ps2 ? m_Reg.m_FifoUpdateCommittedBRdData : findCommit(isInputChangeChain);
+}
+
+bool FirEngineMacSim::findCommit(bool isInputChangeChain) const
+{
+	return m_Reg.m_FirstEngine_ps2 ? m_Reg.m_ChosenDataChanged_ps2 : (m_Reg.m_ChosenDataChanged_ps2 || isInputChangeChain);
+}
+
+unsigned FirEngineMacSim::_findFifoRegion(unsigned fifoLengthMinusOne)
+{
+	if (fifoLengthMinusOne <= 1)
+		return 1;
+	return _mask(IntUtils::bitWidthToRepresentUnsignedValue(fifoLengthMinusOne));
+}
+
+unsigned FirEngineMacSim::fifoAddrSub(unsigned addr, unsigned origin, unsigned size, unsigned dec) const
+{
+	unsigned wideMask = _mask(m_FifoOffsetBits + 1);
+	dec &= wideMask;
+	if (((addr - origin) & wideMask) < dec)
+		return (addr + size - dec) & _mask(m_FifoOffsetBits);
+	return (addr - dec) & _mask(m_FifoOffsetBits);
+}
+
+unsigned FirEngineMacSim::fifoAddrAdd(unsigned addr, unsigned origin, unsigned size, unsigned inc) const
+{
+	unsigned wideMask = _mask(m_FifoOffsetBits + 1);
+	inc &= wideMask;
+	if (((addr - origin + inc) & wideMask) >= size)
+		return (addr + inc - size) & _mask(m_FifoOffsetBits);
+	return (addr + inc) & _mask(m_FifoOffsetBits);
+}
+
+void FirEngineMacSim::clock(int chainD, int chainR, int64_t chainS, bool isInputChangeChain)
+{
+	const Registers& cur = m_Reg;
+	Registers next = m_Reg;
+	const unsigned* timeSlice = cur.m_TimeSlice;		// [0] = psm1, [n+1] = psn
+
+	// TimeSliceCounter at different pipeline stages
+	next.m_TimeSlice[0] = (cur.m_TimeSlice[0] == (m_NumTimeSlots - 1)) ? 0 : (cur.m_TimeSlice[0] + 1);
+	for (unsigned i = 1; i < 11; ++i)
+		next.m_TimeSlice[i] = cur.m_TimeSlice[i - 1];
+
+	// Latch all input data as it arrives
+	for (unsigned i = 0; i < m_NumInputs; ++i)
+	{
+		if (cur.m_PrevDataChanged[i] != m_InputDataChanged[i])
+			next.m_Data_ps1[i] = m_InputData[i];
+		next.m_DataChanged_ps1[i] = m_InputDataChanged[i];
+	}
+
+	// Select one of the channels (only then is its prevDataChanged flag updated)
+	next.m_ChannelSel_ps1 = _lookupCtrl(m_vChannelSelectCtrl, timeSlice[1]) & 0xF;
+	if (cur.m_ChannelSel_ps1 < m_NumInputs)
+	{
+		unsigned channel = cur.m_ChannelSel_ps1;
+		next.m_ChosenData_ps2 = cur.m_Data_ps1[channel];
+		next.m_ChosenDataChanged_ps2 = (cur.m_DataChanged_ps1[channel] != cur.m_PrevDataChanged[channel]);
+		next.m_PrevDataChanged[channel] = cur.m_DataChanged_ps1[channel];
+	}
+	else
+	{
+		next.m_ChosenData_ps2 = 0;			// (18'hx)
+		next.m_ChosenDataChanged_ps2 = false;
+	}
+
+	// DoUpdate is disabled for a few cycles after reset
+	next.m_DoUpdate_ps2 = (_lookupCtrl(m_vDoUpdateCtrl, timeSlice[2]) & 1) != 0;
+	if (cur.m_DoUpdateEnableCounter != 3)
+	{
+		next.m_DoUpdateEnableCounter = cur.m_DoUpdateEnableCounter + 1;
+		next.m_DoUpdate_ps2 = false;
+	}
+
+	// Coefficient RAM
+	next.m_CoefBuffRdDataInt = (cur.m_CoefBuffRdAddr < m_vCoefBuff.size()) ? m_vCoefBuff[cur.m_CoefBuffRdAddr] : 0;
+	next.m_CoefBuffRdData = cur.m_CoefBuffRdDataInt;
+
+	// Data RAMs (read before write)
+	unsigned dataBuffAB1Addr = cur.m_DataBuffAB1UpdateAddr & m_BufferDepthMask;
+	bool isDataBuffAB1Addr = (dataBuffAB1Addr < m_vDataBuffA.size());
+	next.m_DataBuffA1RdDataInt = isDataBuffAB1Addr ? m_vDataBuffA[dataBuffAB1Addr] : 0;
+	next.m_DataBuffA1RdData = cur.m_DataBuffA1RdDataInt;
+	next.m_DataBuffA0RdDataInt = (cur.m_DataBuffA0RdAddr < m_vDataBuffA.size()) ? m_vDataBuffA[cur.m_DataBuffA0RdAddr] : 0;
+	next.m_DataBuffA0RdData = cur.m_DataBuffA0RdDataInt;
+	next.m_DataBuffB1RdDataInt = isDataBuffAB1Addr ? m_vDataBuffB[dataBuffAB1Addr] : 0;
+	next.m_DataBuffB1RdData = cur.m_DataBuffB1RdDataInt;
+	next.m_DataBuffB0RdDataInt = (cur.m_DataBuffB0RdAddr < m_vDataBuffB.size()) ? m_vDataBuffB[cur.m_DataBuffB0RdAddr] : 0;
+	next.m_DataBuffB0RdData = cur.m_DataBuffB0RdDataInt;
+	if (cur.m_Commit[0] && isDataBuffAB1Addr)
+	{
+		m_vDataBuffA[dataBuffAB1Addr] = cur.m_DataBuffA1WrData;
+		m_vDataBuffB[dataBuffAB1Addr] = cur.m_DataBuffB1WrData;
+	}
+
+	// Mux in data to update the Data RAMs
+	next.m_FirstEngine_ps2 = (_lookupCtrl(m_vFirstEngineCtrl, timeSlice[2]) & 1) != 0;
+	next.m_LastEngine_ps2 = (_lookupCtrl(m_vLastEngineCtrl, timeSlice[2]) & 1) != 0;
+	next.m_DataBuffA1WrData = cur.m_FirstEngine_ps2 ? cur.m_ChosenData_ps2 : chainD;
+	next.m_DataBuffB1WrData = cur.m_LastEngine_ps2 ? cur.m_DataBuffA1RdData : chainR;
+
+	// Data Commit chain
+	for (unsigned i = 1; i < 7; ++i)
+		next.m_Commit[i] = cur.m_Commit[i - 1];
+	next.m_Commit[0] = cur.m_DoUpdate_ps2 && findCommit(isInputChangeChain);
+
+	// DSP48E2: A/B/D/INMODE registers, then the pre-adder (AD), then the multiplier (M), then the ALU (P)
+	next.m_PreAddMode_ps5 = _lookupCtrl(m_vPreAddModeCtrl, timeSlice[5]) & 0x3;
+	next.m_MulMode_ps7 = _lookupCtrl(m_vMulModeCtrl, timeSlice[7]) & 0x3;
+	next.m_AddPrevEngineAccum_ps7 = (_lookupCtrl(m_vAddPrevEngineAccumCtrl, timeSlice[7]) & 1) != 0;
+
+	next.m_DspA_ps6 = cur.m_CoefBuffRdData;
+	next.m_DspB_ps6 = cur.m_DataBuffA0RdData;
+	next.m_DspD_ps6 = cur.m_DataBuffB0RdData;
+	next.m_DspPreAddMode_ps6 = cur.m_PreAddMode_ps5;
+
+	next.m_DspA_ps7 = cur.m_DspA_ps6;
+	switch (cur.m_DspPreAddMode_ps6)
+	{
+	case 1:		next.m_DspAD_ps7 = int(_signExtend(cur.m_DspD_ps6 + cur.m_DspB_ps6, 27));	break;		// (D+B)*A
+	case 2:		next.m_DspAD_ps7 = int(_signExtend(cur.m_DspD_ps6 - cur.m_DspB_ps6, 27));	break;		// (D-B)*A
+	default:	next.m_DspAD_ps7 = cur.m_DspB_ps6;											break;		// +B*A
+	}
+
+	next.m_DspM_ps8 = int64_t(cur.m_DspA_ps7) * _signExtend(cur.m_DspAD_ps7, 18);
+	next.m_DspMulMode_ps8 = cur.m_MulMode_ps7;
+	next.m_DspAddPrevEngineAccum_ps8 = cur.m_AddPrevEngineAccum_ps7;
+	next.m_DspC_ps8 = _signExtend(chainS, 36);
+
+	// OPMODE: W=SUMIN (C) when adding the previous FirEngine's Accumulator, Z=P for MADD and MSUB, ALUMODE subtracts for MSUB
+	if (cur.m_DspMulMode_ps8 <= 2)
+	{
+		int64_t w = cur.m_DspAddPrevEngineAccum_ps8 ? cur.m_DspC_ps8 : 0;
+		int64_t z = (cur.m_DspMulMode_ps8 != 0) ? cur.m_DspP : 0;
+		int64_t p = (cur.m_DspMulMode_ps8 == 2) ? (z - (w + cur.m_DspM_ps8)) : (z + w + cur.m_DspM_ps8);
+		next.m_DspP = _signExtend(p, 48);
+	}
+	else
+	{
+		next.m_DspP = 0;		// (OPMODE 0)
+	}
+
+	// Data Outputs (each FIR's Output taken CoeffScale bits higher in the result)
+	next.m_RdFifoNum_ps9 = _lookupCtrl(m_vRdFifoNumCtrl, timeSlice[9]) & m_NumFifosMask;
+	next.m_UpdateFifoNum_ps9 = _lookupCtrl(m_vUpdateFifoNumCtrl, timeSlice[9]) & m_NumFifosMask;
+	next.m_DoUpdate_ps9 = (_lookupCtrl(m_vDoUpdateCtrl, timeSlice[9]) & 1) != 0;
+	next.m_PhaseOutput_ps9 = (_lookupCtrl(m_vPhaseOutputCtrl, timeSlice[9]) & 1) != 0;
+	next.m_ChannelSel_ps9 = _lookupCtrl(m_vOutputSelectCtrl, timeSlice[9]) & 0xF;
+
+	bool isRdFifoCommitted = (cur.m_RdFifoNum_ps9 < m_vFifoCommitted.size()) && m_vFifoCommitted[cur.m_RdFifoNum_ps9];
+	bool isDspOutChanged = cur.m_PhaseOutput_ps9 ? isRdFifoCommitted : cur.m_Commit[6];
+	if (cur.m_DoUpdate_ps9 && (cur.m_UpdateFifoNum_ps9 < m_vFifoCommitted.size()))
+		m_vFifoCommitted[cur.m_UpdateFifoNum_ps9] = cur.m_Commit[6];
+
+	for (unsigned i = 0; i < m_NumOutputs; ++i)
+	{
+		next.m_DataOutChanged[i] = false;
+		if (cur.m_DataOutChanged[i])
+			next.m_OutputDataChanged[i] = !cur.m_OutputDataChanged[i];
+	}
+	if (cur.m_ChannelSel_ps9 < m_NumOutputs)
+	{
+		unsigned channel = cur.m_ChannelSel_ps9;
+		next.m_OutputData[channel] = int(_signExtend(cur.m_DspP >> (16 + m_vOutputCoeffScale[channel]), 18));
+		next.m_DataOutChanged[channel] = isDspOutChanged;
+	}
+
+	// Fifo Description RAMs (read before write, the A port forwarding the written Fifo Description) and Roms
+	unsigned fifoDescBuffWrData = ((cur.m_DataBuffAB1UpdateAddr << m_FifoLengthBits) | (cur.m_DataBuffAB1FifoLengthMinusOne_delay3 & _mask(m_FifoLengthBits))) & _mask(m_FifoOffsetBits + m_FifoLengthBits);
+	bool isFifoDescBuffARdAddrWritten = cur.m_DoUpdate_ps3 && (cur.m_FifoDescBuffWrAddr == cur.m_FifoDescBuffARdAddr);
+	bool isFifoDescBuffARdAddrIntWritten = cur.m_DoUpdate_ps3 && (cur.m_FifoDescBuffWrAddr == cur.m_FifoDescBuffARdAddrInt);
+	next.m_FifoDescBuffARdAddrInt = cur.m_FifoDescBuffARdAddr;
+	next.m_FifoDescBuffARdDataInt = (isFifoDescBuffARdAddrWritten && cur.m_Commit[0]) ? fifoDescBuffWrData : m_vFifoDescBuffA[cur.m_FifoDescBuffARdAddr];
+	next.m_FifoDescBuffARdData = (isFifoDescBuffARdAddrIntWritten && cur.m_Commit[0]) ? fifoDescBuffWrData : cur.m_FifoDescBuffARdDataInt;
+	next.m_FifoDescBuffBRdDataInt = m_vFifoDescBuffB[cur.m_FifoDescBuffBRdAddr];
+	next.m_FifoDescBuffBRdData = cur.m_FifoDescBuffBRdDataInt;
+	if (cur.m_Commit[0])
+	{
+		m_vFifoDescBuffA[cur.m_FifoDescBuffWrAddr] = fifoDescBuffWrData;
+		m_vFifoDescBuffB[cur.m_FifoDescBuffWrAddr] = fifoDescBuffWrData;
+	}
+	next.m_FifoUpdateCommittedARdDataInt = isFifoDescBuffARdAddrWritten ? cur.m_Commit[0] : bool(m_vFifoUpdateCommitted[cur.m_FifoDescBuffARdAddr]);
+	next.m_FifoUpdateCommittedARdData = isFifoDescBuffARdAddrIntWritten ? cur.m_Commit[0] : cur.m_FifoUpdateCommittedARdDataInt;
+	next.m_FifoUpdateCommittedBRdDataInt = m_vFifoUpdateCommitted[cur.m_FifoDescBuffBRdAddr];
+	next.m_FifoUpdateCommittedBRdData = cur.m_FifoUpdateCommittedBRdDataInt;
+	next.m_DoUpdate_ps3 = cur.m_DoUpdate_ps2;
+	if (cur.m_DoUpdate_ps3)
+		m_vFifoUpdateCommitted[cur.m_FifoDescBuffWrAddr] = cur.m_Commit[0];
+	if (m_IsPackedFifos)
+	{
+		next.m_FifoOriginARdDataInt = _lookupCtrl(m_vFifoOrigins, cur.m_FifoDescBuffARdAddr);
+		next.m_FifoOriginARdData = cur.m_FifoOriginARdDataInt;
+		next.m_FifoRegionSizeARdDataInt = _lookupCtrl(m_vFifoRegionSizes, cur.m_FifoDescBuffARdAddr);
+		next.m_FifoRegionSizeARdData = cur.m_FifoRegionSizeARdDataInt;
+		next.m_FifoOriginBRdDataInt = _lookupCtrl(m_vFifoOrigins, cur.m_FifoDescBuffBRdAddr);
+		next.m_FifoOriginBRdData = cur.m_FifoOriginBRdDataInt;
+		next.m_FifoRegionSizeBRdDataInt = _lookupCtrl(m_vFifoRegionSizes, cur.m_FifoDescBuffBRdAddr);
+		next.m_FifoRegionSizeBRdData = cur.m_FifoRegionSizeBRdDataInt;
+	}
+	next.m_CoeffOriginARdDataInt = _lookupCtrl(m_vCoeffOrigins, cur.m_FifoDescBuffARdAddr) & m_CoeffBufferDepthMask;
+	next.m_CoeffOriginARdData = cur.m_CoeffOriginARdDataInt;
+
+	// Fifo Controls
+	next.m_FifoDescBuffARdAddr = _lookupCtrl(m_vRdFifoNumCtrl, timeSlice[0]) & m_NumFifosMask;
+	next.m_FifoDescBuffBRdAddr = _lookupCtrl(m_vUpdateFifoNumCtrl, timeSlice[0]) & m_NumFifosMask;
+	next.m_FifoDescBuffWrAddr = _lookupCtrl(m_vUpdateFifoNumCtrl, timeSlice[3]) & m_NumFifosMask;
+	next.m_FirstTap_ps2 = (_lookupCtrl(m_vFirstTapCtrl, timeSlice[2]) & 1) != 0;
+	next.m_MirrorSkip_ps2 = (_lookupCtrl(m_vMirrorSkipCtrl, timeSlice[2]) & 1) != 0;
+	next.m_CommitSkip_ps2 = (_lookupCtrl(m_vCommitSkipCtrl, timeSlice[2]) & 1) != 0;
+	next.m_CommitDelay_ps2 = (_lookupCtrl(m_vCommitDelayCtrl, timeSlice[2]) & 1) != 0;
+	next.m_CoeffOffset_ps2 = _lookupCtrl(m_vCoeffOffsetCtrl, timeSlice[2]) & 0xFF;
+	next.m_DataSkip_ps2 = _lookupCtrl(m_vDataSkipCtrl, timeSlice[2]) & m_DataSkipMask;
+
+	unsigned offsetMask = _mask(m_FifoOffsetBits);
+	unsigned currFifoOffset = (cur.m_FifoDescBuffARdData >> m_FifoLengthBits) & offsetMask;
+	unsigned currFifoLengthMinusOne = cur.m_FifoDescBuffARdData & _mask(m_FifoLengthBits);
+	unsigned firstTapSkip = (cur.m_DataSkip_ps2 + unsigned(cur.m_CommitSkip_ps2 && cur.m_FifoUpdateCommittedARdData)) & offsetMask;
+	if (cur.m_FirstTap_ps2)
+		next.m_CoefBuffRdAddr = (cur.m_CoeffOriginARdData + cur.m_CoeffOffset_ps2) & m_CoeffBufferDepthMask;
+	else
+		next.m_CoefBuffRdAddr = (cur.m_CoefBuffRdAddr + 1) & m_CoeffBufferDepthMask;
+	if (m_IsPackedFifos)
+	{
+		unsigned origin = cur.m_FifoOriginARdData;
+		unsigned size = cur.m_FifoRegionSizeARdData;
+		if (cur.m_FirstTap_ps2)
+		{
+			next.m_DataBuffA0RdAddr = fifoAddrSub(currFifoOffset, origin, size, firstTapSkip);
+			next.m_DataBuffB0RdAddr = fifoAddrAdd(fifoAddrSub(currFifoOffset, origin, size, currFifoLengthMinusOne), origin, size, unsigned(cur.m_MirrorSkip_ps2) + cur.m_DataSkip_ps2);
+		}
+		else
+		{
+			next.m_DataBuffA0RdAddr = fifoAddrSub(cur.m_DataBuffA0RdAddr, origin, size, 1 + cur.m_DataSkip_ps2);
+			next.m_DataBuffB0RdAddr = fifoAddrAdd(cur.m_DataBuffB0RdAddr, origin, size, 1 + cur.m_DataSkip_ps2);
+		}
+	}
+	else
+	{
+		unsigned region = _findFifoRegion(currFifoLengthMinusOne);
+		unsigned origin = currFifoOffset & ~region & offsetMask;
+		if (cur.m_FirstTap_ps2)
+		{
+			next.m_DataBuffA0RdAddr = origin | ((currFifoOffset - firstTapSkip) & region);
+			next.m_DataBuffB0RdAddr = origin | ((currFifoOffset - currFifoLengthMinusOne + unsigned(cur.m_MirrorSkip_ps2) + cur.m_DataSkip_ps2) & region);
+		}
+		else
+		{
+			next.m_DataBuffA0RdAddr = origin | ((cur.m_DataBuffA0RdAddr - 1 - cur.m_DataSkip_ps2) & region);
+			next.m_DataBuffB0RdAddr = origin | ((cur.m_DataBuffB0RdAddr + 1 + cur.m_DataSkip_ps2) & region);
+		}
+	}
+	next.m_DataBuffA0RdAddr &= m_BufferDepthMask;
+	next.m_DataBuffB0RdAddr &= m_BufferDepthMask;
+
+	// The Update address: the next entry of the Update Fifo (on the Update), otherwise its oldest entry (about to be popped)
+	unsigned updateFifoOffset = (cur.m_FifoDescBuffBRdData >> m_FifoLengthBits) & offsetMask;
+	unsigned updateFifoLengthMinusOne = cur.m_FifoDescBuffBRdData & _mask(m_FifoLengthBits);
+	if (m_IsPackedFifos)
+	{
+		unsigned origin = cur.m_FifoOriginBRdData;
+		unsigned size = cur.m_FifoRegionSizeBRdData;
+		next.m_DataBuffAB1UpdateAddr = cur.m_DoUpdate_ps2 ? cur.m_DataBuffAB1NextAddr_delay2 : fifoAddrSub(updateFifoOffset, origin, size, updateFifoLengthMinusOne);
+		next.m_DataBuffAB1NextAddr = fifoAddrAdd(updateFifoOffset, origin, size, 1);
+	}
+	else
+	{
+		unsigned region = _findFifoRegion(updateFifoLengthMinusOne);
+		unsigned origin = updateFifoOffset & ~region & offsetMask;
+		next.m_DataBuffAB1UpdateAddr = cur.m_DoUpdate_ps2 ? cur.m_DataBuffAB1NextAddr_delay2 : (origin | ((updateFifoOffset - updateFifoLengthMinusOne) & region));
+		next.m_DataBuffAB1NextAddr = origin | ((updateFifoOffset + 1) & region);
+	}
+	next.m_DataBuffAB1FifoLengthMinusOne = updateFifoLengthMinusOne;
+	next.m_DataBuffAB1NextAddr_delay1 = cur.m_DataBuffAB1NextAddr;
+	next.m_DataBuffAB1FifoLengthMinusOne_delay1 = cur.m_DataBuffAB1FifoLengthMinusOne;
+	next.m_DataBuffAB1NextAddr_delay2 = cur.m_DataBuffAB1NextAddr_delay1;
+	next.m_DataBuffAB1FifoLengthMinusOne_delay2 = cur.m_DataBuffAB1FifoLengthMinusOne_delay1;
+	next.m_DataBuffAB1FifoLengthMinusOne_delay3 = cur.m_DataBuffAB1FifoLengthMinusOne_delay2;
+
+	m_Reg = next;
+}
@@ -0,0 +1,204 @@
+#ifndef FIRENGINEMACSIM_H
+#define FIRENGINEMACSIM_H
+
+
+#include <stdint.h>
+#include <vector>
+#include "firenginemacdesc.h"
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// Cycle-accurate model of the RTL of a FirMac (see
+///   FirEngineMacDesc::generateRtl), built from the same
+///   control tables and stepping every register of its
+///   pipeline (ps0 - ps9) on each clock edge
+///   The DSP48E2 is modelled as the RTL stages it: A, B, D and
+///   INMODE presented in ps5, OPMODE, ALUMODE and C in ps7, P
+///   in ps9 (the multiplier takes AD[17:0], as BMULTSEL = "AD")
+/////////////////////////////////////////////////////////////
+
+class FirEngineMacSim
+{
+public:
+	/// The FirMac's Fifos are sorted into their RTL order (as by generateRtl)
+	explicit FirEngineMacSim(const FirEngineMacDesc&);
+public:
+	unsigned getNumInputs() const						{ return m_NumInputs; }
+	unsigned getNumOutputs() const						{ return m_NumOutputs; }
+	/// Drive an Input (iDataN, iDataNChanged) until the next clock edge
+	void setInput(unsigned inputIdx, int data, bool isDataChanged);
+	/// oInputChangeChain, from this cycle's iInputChangeChain (combinational, so it ripples along the chain within a cycle)
+	///   (or whether the Fifo's previous Update committed, when the next FirMac commits an Update late)
+	bool findInputChangeChain(bool isInputChangeChain) const;
+	/// Registered chain outputs (oChainD, oChainR, oChainS)
+	int getChainD() const								{ return m_Reg.m_DataBuffA1RdData; }
+	int getChainR() const								{ return m_Reg.m_DataBuffB1RdData; }
+	int64_t getChainS() const							{ return _signExtend(m_Reg.m_DspP, 36); }
+	/// Output (oDataN, oDataNChanged)
+	int getOutputData(unsigned outputIdx) const			{ return m_Reg.m_OutputData[outputIdx]; }
+	bool getOutputDataChanged(unsigned outputIdx) const	{ return m_Reg.m_OutputDataChanged[outputIdx]; }
+	/// Clock edge, given the chain inputs from the previous FirMac (all zero on the first FirMac of the FirEngine)
+	void clock(int chainD, int chainR, int64_t chainS, bool isInputChangeChain);
+private:
+	static int64_t _signExtend(int64_t value, unsigned numBits)		{ return int64_t(uint64_t(value) << (64 - numBits)) >> (64 - numBits); }
+	/// Region of a Fifo (lowest power of 2 mask covering Len-1, as decoded by the RTL of unpacked Fifos)
+	static unsigned _findFifoRegion(unsigned fifoLengthMinusOne);
+	/// Step a packed Fifo address back or forward (wrapping modulo the Region size, as fifoAddrSub / fifoAddrAdd)
+	unsigned fifoAddrSub(unsigned addr, unsigned origin, unsigned size, unsigned dec) const;
+	unsigned fifoAddrAdd(unsigned addr, unsigned origin, unsigned size, unsigned inc) const;
+	/// doCommit_ps2, from this cycle's iInputChangeChain
+	bool findCommit(bool isInputChangeChain) const;
+	/// Control of a TimeSlice
+	static unsigned _lookupCtrl(const vector<unsigned>& vCtrl, unsigned timeSlice)	{ return (timeSlice < vCtrl.size()) ? vCtrl[timeSlice] : 0; }
+private:
+	static const unsigned	s_MaxNumChannels = 16;
+	/// Registers of the FirMac (all updated together on a clock edge)
+	struct Registers
+	{
+		/// timeSlice_psm1 .. timeSlice_ps9
+		unsigned	m_TimeSlice[11];
+		int			m_Data_ps1[s_MaxNumChannels];
+		bool		m_DataChanged_ps1[s_MaxNumChannels];
+		bool		m_PrevDataChanged[s_MaxNumChannels];
+		unsigned	m_ChannelSel_ps1;
+		int			m_ChosenData_ps2;
+		bool		m_ChosenDataChanged_ps2;
+		bool		m_DoUpdate_ps2;
+		unsigned	m_DoUpdateEnableCounter;
+		unsigned	m_CoefBuffRdAddr;
+		int			m_CoefBuffRdDataInt;
+		int			m_CoefBuffRdData;
+		unsigned	m_DataBuffA0RdAddr;
+		unsigned	m_DataBuffB0RdAddr;
+		int			m_DataBuffA0RdDataInt;
+		int			m_DataBuffA0RdData;
+		int			m_DataBuffB0RdDataInt;
+		int			m_DataBuffB0RdData;
+		int			m_DataBuffA1RdDataInt;
+		int			m_DataBuffA1RdData;
+		int			m_DataBuffB1RdDataInt;
+		int			m_DataBuffB1RdData;
+		int			m_DataBuffA1WrData;
+		int			m_DataBuffB1WrData;
+		bool		m_FirstEngine_ps2;
+		bool		m_LastEngine_ps2;
+		/// commit_ps3 .. commit_ps9
+		bool		m_Commit[7];
+		/// DSP48E2 controls (preadd_mode_ps5, mul_mode_ps7, add_prevengine_accum_ps7)
+		unsigned	m_PreAddMode_ps5;
+		unsigned	m_MulMode_ps7;
+		bool		m_AddPrevEngineAccum_ps7;
+		/// DSP48E2 internal registers (A/B/D/INMODE, A/AD, M/OPMODE/ALUMODE/C, P)
+		int			m_DspA_ps6;
+		int			m_DspB_ps6;
+		int			m_DspD_ps6;
+		unsigned	m_DspPreAddMode_ps6;
+		int			m_DspA_ps7;
+		int			m_DspAD_ps7;
+		int64_t		m_DspM_ps8;
+		unsigned	m_DspMulMode_ps8;
+		bool		m_DspAddPrevEngineAccum_ps8;
+		int64_t		m_DspC_ps8;
+		int64_t		m_DspP;
+		unsigned	m_RdFifoNum_ps9;
+		unsigned	m_UpdateFifoNum_ps9;
+		bool		m_DoUpdate_ps9;
+		bool		m_PhaseOutput_ps9;
+		unsigned	m_ChannelSel_ps9;
+		int			m_OutputData[s_MaxNumChannels];
+		bool		m_DataOutChanged[s_MaxNumChannels];
+		bool		m_OutputDataChanged[s_MaxNumChannels];
+		unsigned	m_FifoDescBuffARdAddr;
+		unsigned	m_FifoDescBuffBRdAddr;
+		unsigned	m_FifoDescBuffWrAddr;
+		unsigned	m_FifoDescBuffARdAddrInt;
+		unsigned	m_FifoDescBuffARdDataInt;
+		unsigned	m_FifoDescBuffARdData;
+		unsigned	m_FifoDescBuffBRdDataInt;
+		unsigned	m_FifoDescBuffBRdData;
+		unsigned	m_FifoOriginARdDataInt;
+		unsigned	m_FifoOriginARdData;
+		unsigned	m_FifoRegionSizeARdDataInt;
+		unsigned	m_FifoRegionSizeARdData;
+		unsigned	m_FifoOriginBRdDataInt;
+		unsigned	m_FifoOriginBRdData;
+		unsigned	m_FifoRegionSizeBRdDataInt;
+		unsigned	m_FifoRegionSizeBRdData;
+		unsigned	m_CoeffOriginARdDataInt;
+		unsigned	m_CoeffOriginARdData;
+		bool		m_FirstTap_ps2;
+		bool		m_MirrorSkip_ps2;
+		bool		m_CommitSkip_ps2;
+		bool		m_CommitDelay_ps2;
+		bool		m_DoUpdate_ps3;
+		bool		m_FifoUpdateCommittedARdDataInt;
+		bool		m_FifoUpdateCommittedARdData;
+		bool		m_FifoUpdateCommittedBRdDataInt;
+		bool		m_FifoUpdateCommittedBRdData;
+		unsigned	m_CoeffOffset_ps2;
+		unsigned	m_DataSkip_ps2;
+		unsigned	m_DataBuffAB1UpdateAddr;
+		unsigned	m_DataBuffAB1NextAddr;
+		unsigned	m_DataBuffAB1FifoLengthMinusOne;
+		unsigned	m_DataBuffAB1NextAddr_delay1;
+		unsigned	m_DataBuffAB1FifoLengthMinusOne_delay1;
+		unsigned	m_DataBuffAB1NextAddr_delay2;
+		unsigned	m_DataBuffAB1FifoLengthMinusOne_delay2;
+		unsigned	m_DataBuffAB1FifoLengthMinusOne_delay3;
+	};
+private:
+	const unsigned			m_NumInputs;
+	const unsigned			m_NumOutputs;
+	const bool				m_IsPackedFifos;
+	/// The TimeSlice counter wraps after NumTimeSlots
+	const unsigned			m_NumTimeSlots;
+	/// Register widths (masks) of the RTL
+	unsigned				m_NumFifosMask;
+	unsigned				m_BufferDepthMask;
+	unsigned				m_CoeffBufferDepthMask;
+	unsigned				m_FifoLengthBits;
+	unsigned				m_FifoOffsetBits;
+	unsigned				m_DataSkipMask;
+	/// Control tables (one entry per TimeSlot)
+	vector<unsigned>		m_vChannelSelectCtrl;
+	vector<unsigned>		m_vOutputSelectCtrl;
+	vector<unsigned>		m_vFirstEngineCtrl;
+	vector<unsigned>		m_vLastEngineCtrl;
+	vector<unsigned>		m_vFirstTapCtrl;
+	vector<unsigned>		m_vPreAddModeCtrl;
+	vector<unsigned>		m_vMirrorSkipCtrl;
+	vector<unsigned>		m_vCommitSkipCtrl;
+	vector<unsigned>		m_vCommitDelayCtrl;
+	vector<unsigned>		m_vCoeffOffsetCtrl;
+	vector<unsigned>		m_vDataSkipCtrl;
+	vector<unsigned>		m_vPhaseOutputCtrl;
+	vector<unsigned>		m_vMulModeCtrl;
+	vector<unsigned>		m_vAddPrevEngineAccumCtrl;
+	vector<unsigned>		m_vRdFifoNumCtrl;
+	vector<unsigned>		m_vUpdateFifoNumCtrl;
+	vector<unsigned>		m_vDoUpdateCtrl;
+	/// Roms (one entry per Fifo)
+	vector<unsigned>		m_vFifoOrigins;
+	vector<unsigned>		m_vFifoRegionSizes;
+	vector<unsigned>		m_vCoeffOrigins;
+	/// Output slice of each Output (dsp48e_result_ps9[33+CoeffScale:16+CoeffScale])
+	vector<int>				m_vOutputCoeffScale;
+	/// Rams (Coefficient RAM, Data RAMs A and B, Fifo Description RAMs A and B)
+	vector<int>				m_vCoefBuff;
+	vector<int>				m_vDataBuffA;
+	vector<int>				m_vDataBuffB;
+	vector<unsigned>		m_vFifoDescBuffA;
+	vector<unsigned>		m_vFifoDescBuffB;
+	/// fifoCommitted_ps9 (whether each Fifo's last Update committed new data)
+	vector<bool>			m_vFifoCommitted;
+	/// fifoUpdateCommitted (the same, written and read alongside the Fifo Descriptions)
+	vector<bool>			m_vFifoUpdateCommitted;
+	/// Inputs driven for the next clock edge
+	int						m_InputData[s_MaxNumChannels];
+	bool					m_InputDataChanged[s_MaxNumChannels];
+	Registers				m_Reg;
+};
+
+
+#endif
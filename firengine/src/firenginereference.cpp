@@ -0,0 +1,262 @@
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include "firenginereference.h"
+#include "firenginesim.h"
+
+
+static int64_t _signExtend(int64_t value, unsigned numBits)
+{
+	return int64_t(uint64_t(value) << (64 - numBits)) >> (64 - numBits);
+}
+
+FirEngineReference::FirEngineReference(const FirEngineSpec& firEngineSpec) :
+	m_FirEngineSpec			(firEngineSpec),
+	m_vvInputSample			(firEngineSpec.m_vFirSpec.size()),
+	m_vvOutputSample		(firEngineSpec.m_vFirSpec.size())
+{
+}
+
+void FirEngineReference::setInputSamples(unsigned firIdx, const vector<int>& vSample)
+{
+	assert(firIdx < m_vvInputSample.size());
+	assert(m_FirEngineSpec.m_vFirSpec[firIdx].hasOwnInput() || vSample.empty());
+	m_vvInputSample[firIdx] = vSample;
+}
+
+unsigned FirEngineReference::findInputFirIndex(unsigned firIdx) const
+{
+	const FirSpec& firSpec = m_FirEngineSpec.m_vFirSpec[firIdx];
+	return firSpec.hasOwnInput() ? firIdx : firSpec.m_InputFirIndex;
+}
+
+void FirEngineReference::_establishPhaseCoeffs(const vector<int>& vCoeffCode, unsigned interpolation, unsigned phase, vector<int32_t>* pvPhaseCoeff)
+{
+	pvPhaseCoeff->clear();
+	for (unsigned coeffIdx = phase; coeffIdx < vCoeffCode.size(); coeffIdx += interpolation)
+		pvPhaseCoeff->push_back(vCoeffCode[coeffIdx]);
+	reverse(pvPhaseCoeff->begin(), pvPhaseCoeff->end());
+}
+
+void FirEngineReference::_establishPaddedSamples(const vector<int>& vSample, unsigned numSubTaps, vector<int32_t>* pvPaddedSample)
+{
+	pvPaddedSample->assign(numSubTaps - 1, 0);
+	pvPaddedSample->insert(pvPaddedSample->end(), vSample.begin(), vSample.end());
+}
+
+void FirEngineReference::_accumulatePhase(const vector<int32_t>& vPhaseCoeff, const vector<int32_t>& vPaddedSample, int sign, unsigned interpolation, unsigned phase, vector<int64_t>* pvAccum)
+{
+	// A dot product of contiguous words per Output (with no dependence between Outputs), which vectorizes
+	unsigned numSubTaps = vPhaseCoeff.size();
+	unsigned numOutputs = vPaddedSample.size() - (numSubTaps - 1);
+	const int32_t* pCoeff = &vPhaseCoeff[0];
+	for (unsigned outputIdx = 0; outputIdx < numOutputs; ++outputIdx)
+	{
+		const int32_t* pSample = &vPaddedSample[outputIdx];
+		int64_t accum = 0;
+		for (unsigned i = 0; i < numSubTaps; ++i)
+			accum += int64_t(pCoeff[i]) * int64_t(pSample[i]);
+		(*pvAccum)[(outputIdx * interpolation) + phase] += sign * accum;
+	}
+}
+
+void FirEngineReference::run()
+{
+	for (unsigned firIdx = 0; firIdx < m_FirEngineSpec.m_vFirSpec.size(); ++firIdx)
+	{
+		const FirSpec& firSpec = m_FirEngineSpec.m_vFirSpec[firIdx];
+
+		// A complex FIR sums the products of its Coefficients with the in-phase samples, and of its imaginary Coefficients with the
+		//   quadrature samples (subtracted for the in-phase Output, added for the quadrature Output, which swaps the two)
+		unsigned inPhaseFirIdx = firSpec.isQuadrature() ? firSpec.m_InPhaseFirIndex : firIdx;
+		const vector<int>& vInPhaseSample = m_vvInputSample[findInputFirIndex(inPhaseFirIdx)];
+		const vector<int>* pvQuadratureSample = NULL;
+		if (m_FirEngineSpec.m_vFirSpec[inPhaseFirIdx].m_IsComplex)
+			pvQuadratureSample = &m_vvInputSample[findInputFirIndex(firSpec.isQuadrature() ? firIdx : m_FirEngineSpec.findQuadratureFirIndex(firIdx))];
+		const vector<int>& vRealSample = firSpec.isQuadrature() ? *pvQuadratureSample : vInPhaseSample;
+		assert(!pvQuadratureSample || (pvQuadratureSample->size() == vInPhaseSample.size()));
+
+		unsigned interpolation = firSpec.m_Interpolation;
+		vector<int64_t> vAccum(vRealSample.size() * interpolation, 0);
+		vector<int32_t> vPhaseCoeff;
+		vector<int32_t> vPaddedSample;
+		for (unsigned phase = 0; phase < interpolation; ++phase)
+		{
+			_establishPhaseCoeffs(firSpec.m_vCoeffCode, interpolation, phase, &vPhaseCoeff);
+			if (vPhaseCoeff.empty())
+				continue;
+			_establishPaddedSamples(vRealSample, vPhaseCoeff.size(), &vPaddedSample);
+			_accumulatePhase(vPhaseCoeff, vPaddedSample, 1, interpolation, phase, &vAccum);
+
+			if (firSpec.m_vCoeffImagCode.empty())
+				continue;
+			_establishPhaseCoeffs(firSpec.m_vCoeffImagCode, interpolation, phase, &vPhaseCoeff);
+			if (firSpec.isQuadrature())
+			{
+				_establishPaddedSamples(vInPhaseSample, vPhaseCoeff.size(), &vPaddedSample);
+				_accumulatePhase(vPhaseCoeff, vPaddedSample, 1, interpolation, phase, &vAccum);
+			}
+			else
+			{
+				_establishPaddedSamples(*pvQuadratureSample, vPhaseCoeff.size(), &vPaddedSample);
+				_accumulatePhase(vPhaseCoeff, vPaddedSample, -1, interpolation, phase, &vAccum);
+			}
+		}
+		establishOutputs(firIdx, vAccum);
+	}
+}
+
+void FirEngineReference::establishOutputs(unsigned firIdx, const vector<int64_t>& vAccum)
+{
+	const FirSpec& firSpec = m_FirEngineSpec.m_vFirSpec[firIdx];
+	vector<int> vFullRateSample;
+	for (unsigned i = 0; i < vAccum.size(); ++i)
+	{
+		// The 48-bit result, sliced as the FirMac's Output ([33+CoeffScale:16+CoeffScale])
+		int64_t result = _signExtend(vAccum[i], 48);
+		vFullRateSample.push_back(int(_signExtend(result >> (16 + firSpec.m_CoeffScale), 18)));
+	}
+
+	vector<int>& vOutputSample = m_vvOutputSample[firIdx];
+	vOutputSample.clear();
+	for (unsigned i = 0; i < vFullRateSample.size(); i += firSpec.m_Decimation)
+		vOutputSample.push_back(vFullRateSample[i]);
+}
+
+void FirEngineReference::establishIdealOutputs(unsigned firIdx, vector<double>* pvIdealSample) const
+{
+	// Coefficient words are scaled by 2^(17+CoeffScale) and the Output is taken from bit 16+CoeffScale, so an Output is twice the sum of
+	//   the products of the Coefficients and the Input samples
+	const FirSpec& firSpec = m_FirEngineSpec.m_vFirSpec[firIdx];
+	unsigned inPhaseFirIdx = firSpec.isQuadrature() ? firSpec.m_InPhaseFirIndex : firIdx;
+	const FirSpec& inPhaseFirSpec = m_FirEngineSpec.m_vFirSpec[inPhaseFirIdx];
+	const vector<int>& vInPhaseSample = m_vvInputSample[findInputFirIndex(inPhaseFirIdx)];
+	const vector<int>* pvQuadratureSample = NULL;
+	if (inPhaseFirSpec.m_IsComplex)
+		pvQuadratureSample = &m_vvInputSample[findInputFirIndex(firSpec.isQuadrature() ? firIdx : m_FirEngineSpec.findQuadratureFirIndex(firIdx))];
+	const vector<int>& vRealSample = firSpec.isQuadrature() ? *pvQuadratureSample : vInPhaseSample;
+	const vector<int>* pvImagSample = firSpec.isQuadrature() ? &vInPhaseSample : pvQuadratureSample;
+	double imagSign = firSpec.isQuadrature() ? 1.0 : -1.0;
+
+	unsigned interpolation = firSpec.m_Interpolation;
+	unsigned numFullRateSamples = vRealSample.size() * interpolation;
+	pvIdealSample->clear();
+	for (unsigned m = 0; m < numFullRateSamples; m += firSpec.m_Decimation)
+	{
+		double sum = 0.0;
+		for (unsigned coeffIdx = (m % interpolation); (coeffIdx < inPhaseFirSpec.m_vCoeff.size()) && (coeffIdx <= m); coeffIdx += interpolation)
+		{
+			unsigned sampleIdx = (m - coeffIdx) / interpolation;
+			sum += inPhaseFirSpec.m_vCoeff[coeffIdx] * double(vRealSample[sampleIdx]);
+			if (inPhaseFirSpec.hasImagCoeffs())
+				sum += imagSign * inPhaseFirSpec.m_vCoeffImag[coeffIdx] * double((*pvImagSample)[sampleIdx]);
+		}
+		pvIdealSample->push_back(2.0 * sum);
+	}
+}
+
+double FirEngineReference::findQuantizationSnr(unsigned firIdx) const
+{
+	vector<double> vIdealSample;
+	establishIdealOutputs(firIdx, &vIdealSample);
+	const vector<int>& vOutputSample = m_vvOutputSample[firIdx];
+	double signalEnergy = 0.0;
+	double errorEnergy = 0.0;
+	for (unsigned i = 0; i < vOutputSample.size(); ++i)
+	{
+		signalEnergy += vIdealSample[i] * vIdealSample[i];
+		errorEnergy += (double(vOutputSample[i]) - vIdealSample[i]) * (double(vOutputSample[i]) - vIdealSample[i]);
+	}
+	if (errorEnergy == 0.0)
+		return INFINITY;
+	return 10.0 * log10(signalEnergy / errorEnergy);
+}
+
+double FirEngineReference::findPeakQuantizationError(unsigned firIdx) const
+{
+	vector<double> vIdealSample;
+	establishIdealOutputs(firIdx, &vIdealSample);
+	const vector<int>& vOutputSample = m_vvOutputSample[firIdx];
+	double peakError = 0.0;
+	for (unsigned i = 0; i < vOutputSample.size(); ++i)
+		peakError = max(peakError, fabs(double(vOutputSample[i]) - vIdealSample[i]));
+	return peakError;
+}
+
+unsigned FirEngineReference::findNumMatchingSamples(unsigned firIdx, const vector<int>& vSample, unsigned lag, unsigned* pNumCompared) const
+{
+	const vector<int>& vOutputSample = m_vvOutputSample[firIdx];
+	unsigned numMatching = 0;
+	*pNumCompared = 0;
+	for (unsigned i = 0; i < vSample.size(); ++i)
+	{
+		int outputIdx = int(i) - int(lag);
+		if (outputIdx >= int(vOutputSample.size()))
+			break;
+		++*pNumCompared;
+		if (vSample[i] == ((outputIdx < 0) ? 0 : vOutputSample[outputIdx]))
+			++numMatching;
+	}
+	return numMatching;
+}
+
+unsigned FirEngineReference::findNumMismatchedFirs(const FirEngineSim& firEngineSim) const
+{
+	// (a FIR with reference Outputs, but no simulated Outputs to compare with them, does not match either)
+	unsigned numMismatchedFirs = 0;
+	for (unsigned firIdx = 0; firIdx < m_vvOutputSample.size(); ++firIdx)
+	{
+		unsigned numCompared = 0;
+		unsigned numMatching = findNumMatchingSamples(firIdx, firEngineSim.getOutputSamples(firIdx), firEngineSim.findOutputLag(firIdx), &numCompared);
+		if ((numMatching != numCompared) || ((numCompared == 0) && !m_vvOutputSample[firIdx].empty()))
+			++numMismatchedFirs;
+	}
+	return numMismatchedFirs;
+}
+
+void FirEngineReference::writeToFile(ostream& stream) const
+{
+	stream << "# Input and Output samples (2.16) of each FIR\n";
+	for (unsigned firIdx = 0; firIdx < m_vvOutputSample.size(); ++firIdx)
+	{
+		if (!m_vvInputSample[firIdx].empty())
+		{
+			stream << "FIR[" << firIdx << "].input = [ ";
+			for (unsigned i = 0; i < m_vvInputSample[firIdx].size(); ++i)
+				stream << ((i > 0) ? ", " : "") << m_vvInputSample[firIdx][i];
+			stream << " ];\n";
+		}
+		stream << "FIR[" << firIdx << "].output = [ ";
+		for (unsigned i = 0; i < m_vvOutputSample[firIdx].size(); ++i)
+			stream << ((i > 0) ? ", " : "") << m_vvOutputSample[firIdx][i];
+		stream << " ];\n";
+	}
+}
+
+void FirEngineReference::generateHtmlReport(ostream& stream, const FirEngineSim* pFirEngineSim) const
+{
+	stream << "<h2>FirEngine Reference</h2>\n";
+	stream << "<table class=\"t1\">\n";
+	stream << "<tr><th>Fir#</th><th>NumOutputSamples</th><th>QuantizationSnr</th><th>PeakQuantizationError</th>";
+	if (pFirEngineSim)
+		stream << "<th>SimulationMatches</th><th>SimulationLag</th>";
+	stream << "</tr>\n";
+	for (unsigned firIdx = 0; firIdx < m_vvOutputSample.size(); ++firIdx)
+	{
+		stream << "<tr><td>" << m_FirEngineSpec.getChannelName(firIdx) << "</td><td>" << m_vvOutputSample[firIdx].size() << "</td><td>";
+		if (!m_vvOutputSample[firIdx].empty())
+			stream << findQuantizationSnr(firIdx) << " dB</td><td>" << findPeakQuantizationError(firIdx) << " LSBs";
+		else
+			stream << "</td><td>";
+		stream << "</td>";
+		if (pFirEngineSim)
+		{
+			unsigned lag = pFirEngineSim->findOutputLag(firIdx);
+			unsigned numCompared = 0;
+			unsigned numMatching = findNumMatchingSamples(firIdx, pFirEngineSim->getOutputSamples(firIdx), lag, &numCompared);
+			stream << "<td>" << numMatching << " of " << numCompared << ((numMatching != numCompared) ? " (mismatched)" : "") << "</td><td>" << lag << "</td>";
+		}
+		stream << "</tr>\n";
+	}
+	stream << "</table>\n\n";
+}
@@ -0,0 +1,77 @@
+#ifndef FIRENGINEREFERENCE_H
+#define FIRENGINEREFERENCE_H
+
+
+#include <stdint.h>
+#include <vector>
+#include <ostream>
+#include "firenginespec.h"
+using namespace std;
+
+class FirEngineSim;		// forward declaration
+
+
+/////////////////////////////////////////////////////////////
+/// Functional reference of a FirEngine: the Outputs each FIR
+///   computes, with the arithmetic of the FirMacs (2.16 data,
+///   1.17 Coefficient words, 48-bit accumulation, Output taken
+///   from bits [33+CoeffScale:16+CoeffScale]) but none of their
+///   timing, so that golden vectors can be made without a
+///   binding, and a simulation checked against them
+///   Each FIR filters a whole buffer of samples at a time, one
+///   polyphase sub-filter at a time, in loops over contiguous
+///   words that the compiler can vectorize
+/////////////////////////////////////////////////////////////
+
+class FirEngineReference
+{
+public:
+	/// The FirEngineSpec's Coefficients must have been quantized
+	explicit FirEngineReference(const FirEngineSpec&);
+public:
+	/// Samples on the Input of a FIR (FIRs without an Input of their own, see FirSpec::hasOwnInput, take none)
+	void setInputSamples(unsigned firIdx, const vector<int>& vSample);
+	/// Filter every FIR's Input samples
+	void run();
+public:
+	/// Output samples of a FIR (every Decimation-th of the Interpolation Outputs per Input sample)
+	const vector<int>& getOutputSamples(unsigned firIdx) const	{ return m_vvOutputSample[firIdx]; }
+	/// Ratio (in dB) of the energy of a FIR's Outputs, as computed with its ideal Coefficients, to that of the
+	///   difference made by quantizing them (and by truncating the Output)
+	double findQuantizationSnr(unsigned firIdx) const;
+	/// Largest difference (in Output LSBs) between a FIR's Outputs and those of its ideal Coefficients
+	double findPeakQuantizationError(unsigned firIdx) const;
+	/// Number of Output samples (of a simulation of a FIR) that match its reference Outputs, sample n lining up with
+	///   reference Output (n - lag), the Outputs before the first being 0 (see FirEngineSim::findOutputLag)
+	///   (only samples whose lined-up reference Output was computed are counted in *pNumCompared)
+	unsigned findNumMatchingSamples(unsigned firIdx, const vector<int>& vSample, unsigned lag, unsigned* pNumCompared) const;
+	/// Number of FIRs whose simulated Outputs are not all those of the reference, lined up as the binding makes them
+	unsigned findNumMismatchedFirs(const FirEngineSim&) const;
+	/// Write the Input and Output samples of every FIR, in the syntax of a FirEngine-Specification
+	void writeToFile(ostream&) const;
+	/// The simulated Outputs of each FIR are compared with the reference Outputs (when not null)
+	void generateHtmlReport(ostream&, const FirEngineSim* pFirEngineSim) const;
+private:
+	/// FIR whose Input samples a FIR filters
+	unsigned findInputFirIndex(unsigned firIdx) const;
+	/// Sub-filter of a phase of a FIR (Coefficients phase, phase + Interpolation, ..., reversed, so that they line up
+	///   with the samples they multiply)
+	static void _establishPhaseCoeffs(const vector<int>& vCoeffCode, unsigned interpolation, unsigned phase, vector<int32_t>* pOut);
+	/// Samples of an Input, preceded by numSubTaps - 1 zeros (the samples before the first one)
+	static void _establishPaddedSamples(const vector<int>& vSample, unsigned numSubTaps, vector<int32_t>* pOut);
+	/// Accumulate the products of a sub-filter and each window of padded samples into vAccum[outputIdx * interpolation + phase]
+	static void _accumulatePhase(const vector<int32_t>& vPhaseCoeff, const vector<int32_t>& vPaddedSample, int sign, unsigned interpolation, unsigned phase, vector<int64_t>* pvAccum);
+	/// Outputs of one FIR, from its full rate accumulations
+	void establishOutputs(unsigned firIdx, const vector<int64_t>& vAccum);
+	/// Outputs of one FIR with ideal Coefficients (in Output LSBs, neither truncated nor wrapped)
+	void establishIdealOutputs(unsigned firIdx, vector<double>* pOut) const;
+private:
+	const FirEngineSpec&		m_FirEngineSpec;
+	/// Input samples of each FIR
+	vector<vector<int> >		m_vvInputSample;
+	/// Output samples of each FIR
+	vector<vector<int> >		m_vvOutputSample;
+};
+
+
+#endif
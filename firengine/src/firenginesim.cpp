@@ -0,0 +1,239 @@
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include "firenginesim.h"
+#include "intutils.h"
+
+
+FirEngineSim::FirEngineSim(const FirEngineSpec& firEngineSpec, const FirEngineDesc& firEngineDesc) :
+	m_FirEngineSpec				(firEngineSpec),
+	m_FirEngineDesc				(firEngineDesc),
+	m_vFirEngineMacSim			(),
+	m_vvInputSample				(firEngineSpec.m_vFirSpec.size()),
+	m_vvOutputSample			(firEngineSpec.m_vFirSpec.size()),
+	m_vvOutputCycle				(firEngineSpec.m_vFirSpec.size()),
+	m_vvPrevOutputDataChanged	(),
+	m_vFirstInputCycle			(),
+	m_vNumPresentedSamples		(),
+	m_NumCycles					(0)
+{
+	for (unsigned firMacIdx = 0; firMacIdx < firEngineDesc.m_vFirEngineMacDesc.size(); ++firMacIdx)
+	{
+		m_vFirEngineMacSim.push_back(FirEngineMacSim(firEngineDesc.m_vFirEngineMacDesc[firMacIdx]));
+		m_vvPrevOutputDataChanged.push_back(vector<bool>(m_vFirEngineMacSim.back().getNumOutputs(), false));
+	}
+	for (unsigned firIdx = 0; firIdx < firEngineSpec.m_vFirSpec.size(); ++firIdx)
+		m_vFirstInputCycle.push_back(findFirstInputCycle(firIdx));
+}
+
+void FirEngineSim::setInputSamples(unsigned firIdx, const vector<int>& vSample)
+{
+	assert(firIdx < m_vvInputSample.size());
+	assert(m_FirEngineDesc.hasInput(firIdx) || vSample.empty());
+	m_vvInputSample[firIdx] = vSample;
+}
+
+void FirEngineSim::establishTestSamples(unsigned numSamples, unsigned seed, vector<int>* pvSample)
+{
+	pvSample->clear();
+	uint32_t state = seed;
+	for (unsigned i = 0; i < numSamples; ++i)
+	{
+		if (i == 0)
+		{
+			pvSample->push_back(1 << 15);		// (0.5)
+			continue;
+		}
+		state = (state * 1664525u) + 1013904223u;
+		pvSample->push_back(int(state >> 16) - (1 << 15));			// [-0.5 .. 0.5)
+	}
+}
+
+unsigned FirEngineSim::findFirstInputCycle(unsigned firIdx) const
+{
+	const FirSpec& firSpec = m_FirEngineSpec.m_vFirSpec[firIdx];
+	if (firSpec.isQuadrature())
+		return findFirstInputCycle(firSpec.m_InPhaseFirIndex);
+	if ((firSpec.m_Decimation == 1) || !m_FirEngineDesc.hasInput(firIdx))
+		return s_FirstInputCycle;
+
+	// The Output Updates are those on the binding's TimeSliceOrigin (every OutputTimeSliceInterval)
+	//   an Output is of the samples committed up to the Update ahead of its own, and the end of a chain whose sections read
+	//   their data an Update apart commits as many Updates late, so the first sample is presented for the Update that much earlier
+	for (unsigned i = 0; i < m_FirEngineDesc.m_vFirBinding.size(); ++i)
+	{
+		const FirBinding& firBinding = m_FirEngineDesc.m_vFirBinding[i];
+		if (firBinding.m_FirIndex != firIdx)
+			continue;
+		int updateTimeSlot = int(firBinding.m_TimeSliceOrigin) - int((1 + firBinding.getNumCommitDelays()) * firBinding.m_TimeSliceInterval);
+
+		// The Update on a TimeSlot (on the ClockCycles the TimeSlice counter reads it) commits the sample presented by the ClockCycle after it
+		return s_FirstInputCycle + IntUtils::modulo(updateTimeSlot + 1 - int(s_FirstInputCycle), m_FirEngineDesc.m_NumTimeSlots);
+	}
+	assert(false);
+	return s_FirstInputCycle;
+}
+
+unsigned FirEngineSim::findOutputLag(unsigned firIdx) const
+{
+	const FirSpec& firSpec = m_FirEngineSpec.m_vFirSpec[firIdx];
+	vector<unsigned> vBankFirIndex;
+	m_FirEngineSpec.establishFilterBankFirs(firSpec.hasOwnInput() ? firIdx : firSpec.m_InputFirIndex, &vBankFirIndex);
+	if ((firSpec.m_Interpolation > 1) || (vBankFirIndex.size() > 1))
+		return 0;
+	return (firSpec.m_Decimation > 1) ? 0 : 1;
+}
+
+unsigned FirEngineSim::findInputCycle(unsigned firIdx, unsigned sampleIdx) const
+{
+	const FirSpec& firSpec = m_FirEngineSpec.m_vFirSpec[firIdx];
+	return m_vFirstInputCycle[firIdx] + unsigned(floor(double(sampleIdx) * m_FirEngineSpec.m_ClockFreq / double(firSpec.m_SampleFreq)));
+}
+
+unsigned FirEngineSim::getNumInputSamples() const
+{
+	unsigned numInputSamples = 0;
+	for (unsigned firIdx = 0; firIdx < m_vvInputSample.size(); ++firIdx)
+		numInputSamples += m_vvInputSample[firIdx].size();
+	return numInputSamples;
+}
+
+unsigned FirEngineSim::getNumOutputSamples() const
+{
+	unsigned numOutputSamples = 0;
+	for (unsigned firIdx = 0; firIdx < m_vvOutputSample.size(); ++firIdx)
+		numOutputSamples += m_vvOutputSample[firIdx].size();
+	return numOutputSamples;
+}
+
+void FirEngineSim::run()
+{
+	// Run until the last Input sample has had its Update, and every Output using it has been computed
+	unsigned lastInputCycle = 0;
+	for (unsigned firIdx = 0; firIdx < m_vvInputSample.size(); ++firIdx)
+	{
+		if (!m_vvInputSample[firIdx].empty())
+			lastInputCycle = max(lastInputCycle, findInputCycle(firIdx, m_vvInputSample[firIdx].size() - 1));
+	}
+	unsigned numCycles = lastInputCycle + m_FirEngineDesc.getWorstCaseLatency() + m_FirEngineDesc.m_NumTimeSlots;
+
+	m_vNumPresentedSamples.assign(m_vvInputSample.size(), 0);
+	for (unsigned firIdx = 0; firIdx < m_vvOutputSample.size(); ++firIdx)
+	{
+		m_vvOutputSample[firIdx].clear();
+		m_vvOutputCycle[firIdx].clear();
+	}
+	for (m_NumCycles = 0; m_NumCycles < numCycles; ++m_NumCycles)
+	{
+		presentInputs(m_NumCycles);
+		clock();
+		recordOutputs();
+	}
+}
+
+void FirEngineSim::presentInputs(unsigned cycle)
+{
+	// Each FIR's latest sample presented so far (Data-Changed is flipped by each one)
+	for (unsigned firIdx = 0; firIdx < m_vvInputSample.size(); ++firIdx)
+	{
+		while ((m_vNumPresentedSamples[firIdx] < m_vvInputSample[firIdx].size()) && (findInputCycle(firIdx, m_vNumPresentedSamples[firIdx]) <= cycle))
+			++m_vNumPresentedSamples[firIdx];
+	}
+
+	for (unsigned firMacIdx = 0; firMacIdx < m_vFirEngineMacSim.size(); ++firMacIdx)
+	{
+		FirEngineMacSim& firEngineMacSim = m_vFirEngineMacSim[firMacIdx];
+		const vector<unsigned>& vInputFirs = m_FirEngineDesc.m_vFirEngineMacDesc[firMacIdx].m_vInputFirs;
+		for (unsigned i = 0; i < vInputFirs.size(); ++i)
+		{
+			unsigned numPresentedSamples = m_vNumPresentedSamples[vInputFirs[i]];
+			int data = (numPresentedSamples > 0) ? m_vvInputSample[vInputFirs[i]][numPresentedSamples - 1] : 0;
+			firEngineMacSim.setInput(i, data, (numPresentedSamples & 1) != 0);
+		}
+	}
+}
+
+void FirEngineSim::clock()
+{
+	// The chain inputs of each FirMac are the previous FirMac's outputs before the clock edge
+	//   (oInputChangeChain is combinational, rippling along the chain within the cycle)
+	unsigned numFirMacs = m_vFirEngineMacSim.size();
+	vector<int> vChainD(numFirMacs, 0);
+	vector<int> vChainR(numFirMacs, 0);
+	vector<int64_t> vChainS(numFirMacs, 0);
+	vector<bool> vInputChangeChain(numFirMacs, false);
+	for (unsigned firMacIdx = 1; firMacIdx < numFirMacs; ++firMacIdx)
+	{
+		const FirEngineMacSim& prevFirEngineMacSim = m_vFirEngineMacSim[firMacIdx - 1];
+		vChainD[firMacIdx] = prevFirEngineMacSim.getChainD();
+		vChainR[firMacIdx] = prevFirEngineMacSim.getChainR();
+		vChainS[firMacIdx] = prevFirEngineMacSim.getChainS();
+		vInputChangeChain[firMacIdx] = prevFirEngineMacSim.findInputChangeChain(vInputChangeChain[firMacIdx - 1]);
+	}
+	for (unsigned firMacIdx = 0; firMacIdx < numFirMacs; ++firMacIdx)
+		m_vFirEngineMacSim[firMacIdx].clock(vChainD[firMacIdx], vChainR[firMacIdx], vChainS[firMacIdx], vInputChangeChain[firMacIdx]);
+}
+
+void FirEngineSim::recordOutputs()
+{
+	for (unsigned firMacIdx = 0; firMacIdx < m_vFirEngineMacSim.size(); ++firMacIdx)
+	{
+		const FirEngineMacSim& firEngineMacSim = m_vFirEngineMacSim[firMacIdx];
+		const vector<unsigned>& vOutputFirs = m_FirEngineDesc.m_vFirEngineMacDesc[firMacIdx].m_vOutputFirs;
+		for (unsigned i = 0; i < vOutputFirs.size(); ++i)
+		{
+			// A new Output sample each time Data-Changed flips (the data is already stable)
+			bool isOutputDataChanged = firEngineMacSim.getOutputDataChanged(i);
+			if (isOutputDataChanged != m_vvPrevOutputDataChanged[firMacIdx][i])
+			{
+				m_vvOutputSample[vOutputFirs[i]].push_back(firEngineMacSim.getOutputData(i));
+				m_vvOutputCycle[vOutputFirs[i]].push_back(m_NumCycles);
+			}
+			m_vvPrevOutputDataChanged[firMacIdx][i] = isOutputDataChanged;
+		}
+	}
+}
+
+void FirEngineSim::writeToFile(ostream& stream) const
+{
+	stream << "# Output samples (2.16) of each FIR, and the ClockCycle each appeared on\n";
+	for (unsigned firIdx = 0; firIdx < m_vvOutputSample.size(); ++firIdx)
+	{
+		stream << "FIR[" << firIdx << "].output = [ ";
+		for (unsigned i = 0; i < m_vvOutputSample[firIdx].size(); ++i)
+			stream << ((i > 0) ? ", " : "") << m_vvOutputSample[firIdx][i];
+		stream << " ];\n";
+		stream << "FIR[" << firIdx << "].outputCycle = [ ";
+		for (unsigned i = 0; i < m_vvOutputCycle[firIdx].size(); ++i)
+			stream << ((i > 0) ? ", " : "") << m_vvOutputCycle[firIdx][i];
+		stream << " ];\n";
+	}
+}
+
+void FirEngineSim::generateHtmlReport(ostream& stream) const
+{
+	double runTime = double(m_NumCycles) / m_FirEngineSpec.m_ClockFreq;
+
+	stream << "<h2>FirEngine Simulation</h2>\n";
+	stream << "<table class=\"t1\">\n";
+	stream << "<tr><th>NumCycles</th><td>" << m_NumCycles << "</td></tr>\n";
+	stream << "<tr><th>NumInputSamples</th><td>" << getNumInputSamples() << "</td></tr>\n";
+	stream << "<tr><th>NumOutputSamples</th><td>" << getNumOutputSamples() << "</td></tr>\n";
+	stream << "<tr><th>OutputThroughput</th><td>" << (double(getNumOutputSamples()) / runTime / 1e6) << " MSamples/s</td></tr>\n";
+	stream << "</table>\n\n";
+
+	stream << "<table class=\"t1\">\n";
+	stream << "<tr><th>Fir#</th><th>NumInputSamples</th><th>NumOutputSamples</th><th>FirstOutputLatency</th><th>OutputInterval</th></tr>\n";
+	for (unsigned firIdx = 0; firIdx < m_vvOutputSample.size(); ++firIdx)
+	{
+		const vector<unsigned>& vOutputCycle = m_vvOutputCycle[firIdx];
+		stream << "<tr><td>" << m_FirEngineSpec.getChannelName(firIdx) << "</td><td>" << m_vvInputSample[firIdx].size() << "</td><td>" << vOutputCycle.size() << "</td><td>";
+		if (!vOutputCycle.empty())
+			stream << (vOutputCycle.front() - m_vFirstInputCycle[firIdx]) << " cycles";
+		stream << "</td><td>";
+		if (vOutputCycle.size() > 1)
+			stream << (double(vOutputCycle.back() - vOutputCycle.front()) / double(vOutputCycle.size() - 1)) << " cycles";
+		stream << "</td></tr>\n";
+	}
+	stream << "</table>\n\n";
+}
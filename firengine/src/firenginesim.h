@@ -0,0 +1,82 @@
+#ifndef FIRENGINESIM_H
+#define FIRENGINESIM_H
+
+
+#include <vector>
+#include <ostream>
+#include "firenginespec.h"
+#include "firenginedesc.h"
+#include "firenginemacsim.h"
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// Cycle-accurate simulation of a FirEngine (the FirMacs of
+///   a FirEngineDesc, chained as by its generateRtl), so that
+///   a binding can be checked, and its throughput and latency
+///   measured, without an HDL simulator
+///   Samples (2.16) are presented on each FIR's Input at its
+///   SampleFreq, and each Output sample is recorded with the
+///   ClockCycle it appeared on
+/////////////////////////////////////////////////////////////
+
+class FirEngineSim
+{
+public:
+	/// The FirEngineDesc's RTL must have been generated (its FirMacs' Fifos are in their RTL order)
+	FirEngineSim(const FirEngineSpec&, const FirEngineDesc&);
+public:
+	/// Samples to present on the Input of a FIR (FIRs without an Input, see FirEngineDesc::hasInput, take none)
+	void setInputSamples(unsigned firIdx, const vector<int>& vSample);
+	/// Test stimulus: an impulse, then pseudo-random samples (seeded, within +/-0.5 so that the pre-adder of a folded FIR cannot overflow)
+	static void establishTestSamples(unsigned numSamples, unsigned seed, vector<int>* pOut);
+	/// Clock the FirEngine until every Input sample has been presented and had time to reach the Outputs
+	void run();
+public:
+	unsigned getNumCycles() const								{ return m_NumCycles; }
+	unsigned getNumInputSamples() const;
+	unsigned getNumOutputSamples() const;
+	const vector<int>& getOutputSamples(unsigned firIdx) const		{ return m_vvOutputSample[firIdx]; }
+	const vector<unsigned>& getOutputCycles(unsigned firIdx) const	{ return m_vvOutputCycle[firIdx]; }
+	/// Number of Outputs by which a FIR's Outputs trail those of FirEngineReference (given the same Input samples)
+	///   an Output flagged by an Update is of the samples committed before that Update, so the first is of none (unless the
+	///   FIR decimates, when the first sample is presented for the first Output, see findFirstInputCycle)
+	///   an Output driven on the last tap of a phase (or of a FIR of a filter bank) is of the samples committed up to then
+	unsigned findOutputLag(unsigned firIdx) const;
+	/// Write the Output samples (and their ClockCycles) of every FIR, in the syntax of a FirEngine-Specification
+	void writeToFile(ostream&) const;
+	void generateHtmlReport(ostream&) const;
+private:
+	/// ClockCycle on which the first Input sample of a FIR is presented
+	///   a decimating FIR has an Output on every Decimation-th Update only, so its first sample is presented for
+	///   the Update of an Output (as its binding places them), and the Outputs are those of every Decimation-th
+	///   sample from the first, as computed by FirEngineReference (the Quadrature FIR of a complex FIR starts with
+	///   its in-phase FIR)
+	unsigned findFirstInputCycle(unsigned firIdx) const;
+	/// ClockCycle on which Input sample n of a FIR is presented
+	unsigned findInputCycle(unsigned firIdx, unsigned sampleIdx) const;
+	void presentInputs(unsigned cycle);
+	void clock();
+	void recordOutputs();
+private:
+	/// Cycles after reset before the first Input sample (the FirMacs' Updates are disabled for the first few)
+	static const unsigned		s_FirstInputCycle = 4;
+	const FirEngineSpec&		m_FirEngineSpec;
+	const FirEngineDesc&		m_FirEngineDesc;
+	vector<FirEngineMacSim>		m_vFirEngineMacSim;
+	/// Input samples of each FIR
+	vector<vector<int> >		m_vvInputSample;
+	/// Output samples of each FIR, and the ClockCycle each appeared on
+	vector<vector<int> >		m_vvOutputSample;
+	vector<vector<unsigned> >	m_vvOutputCycle;
+	/// oDataChanged of each FirMac Output, as last seen
+	vector<vector<bool> >		m_vvPrevOutputDataChanged;
+	/// ClockCycle on which each FIR's first Input sample is presented (see findFirstInputCycle)
+	vector<unsigned>			m_vFirstInputCycle;
+	/// Number of each FIR's Input samples presented so far
+	vector<unsigned>			m_vNumPresentedSamples;
+	unsigned					m_NumCycles;
+};
+
+
+#endif
@@ -1,9 +1,13 @@
 
 #include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
 #include "stringutil.h"
 #include "stringmatchstream.h"
 #include "firenginespec.h"
 #include "fircoeffref.h"
+#include "fircoeffquantizer.h"
 
 
 FirEngineSpec::FirEngineSpec(double clockFreq) :
@@ -11,13 +15,180 @@ FirEngineSpec::FirEngineSpec(double clockFreq) :
 	m_vFirSpec			()
 {
 }
+
+FirEngineSpec::FirEngineSpec(const FirEngineSpec& firEngineSpec, double clockFreq) :
+	m_ClockFreq			(clockFreq),
+	m_vFirSpec			(firEngineSpec.m_vFirSpec)
+{
+}
 	
-double FirEngineSpec::lookupCoeff(const FirCoeffRef& firCoeffRef) const
+int FirEngineSpec::lookupCoeffCode(const FirCoeffRef& firCoeffRef) const
 {
 	assert(!firCoeffRef.isNull());
 	const FirSpec& firSpec = m_vFirSpec[firCoeffRef.m_FirIndex];
-	double coeffVal = firSpec.m_vCoeff[firCoeffRef.m_CoeffIndex];
-	return coeffVal;
+	assert(firSpec.m_vCoeffCode.size() == firSpec.m_vCoeff.size());		// (quantizeCoeffs must be called first)
+	return firSpec.m_vCoeffCode[firCoeffRef.m_CoeffIndex];
+}
+
+int FirEngineSpec::lookupImagCoeffCode(const FirCoeffRef& firCoeffRef) const
+{
+	assert(!firCoeffRef.isNull());
+	const FirSpec& firSpec = m_vFirSpec[firCoeffRef.m_FirIndex];
+	assert(firSpec.m_vCoeffImagCode.size() == firSpec.m_vCoeffImag.size());
+	return firSpec.m_vCoeffImagCode[firCoeffRef.m_CoeffIndex];
+}
+
+void FirEngineSpec::establishFilterBankFirs(unsigned firIdx, vector<unsigned>* pvFirIndex) const
+{
+	pvFirIndex->clear();
+	pvFirIndex->push_back(firIdx);
+	for (unsigned i = 0; i < m_vFirSpec.size(); ++i)
+	{
+		if (m_vFirSpec[i].m_InputFirIndex == firIdx)
+			pvFirIndex->push_back(i);
+	}
+}
+
+unsigned FirEngineSpec::findQuadratureFirIndex(unsigned firIdx) const
+{
+	for (unsigned i = 0; i < m_vFirSpec.size(); ++i)
+	{
+		if (m_vFirSpec[i].m_InPhaseFirIndex == firIdx)
+			return i;
+	}
+	assert(false);		// only complex FIRs have a Quadrature FIR
+	return FirSpec::s_NoFir;
+}
+
+string FirEngineSpec::getChannelName(unsigned firIdx) const
+{
+	const FirSpec& firSpec = m_vFirSpec[firIdx];
+	if (firSpec.isQuadrature())
+		return toString(firSpec.m_InPhaseFirIndex) + "Q";
+	return toString(firIdx);
+}
+
+// Read a list of Coefficients '= [ c0, c1, ... ];'
+static void _readCoeffs(StringMatchStream& matchStream, vector<double>* pvCoeff)
+{
+	pvCoeff->clear();
+	matchStream.matchWhitespace();
+	if (!matchStream.matchChar('='))
+		throw string("Syntax Error: Expected '='");
+	matchStream.matchWhitespace();
+	if (!matchStream.matchChar('['))
+		throw string("Syntax Error: Expected '['");
+	matchStream.matchWhitespace();
+	while (!matchStream.matchChar(']'))
+	{
+		pvCoeff->push_back(0);
+		if (!matchStream.matchFloatingPointNumber(0, &pvCoeff->back()))
+			throw string("Syntax Error: Expected floating point number");
+		matchStream.matchWhitespace();
+		matchStream.matchChar(',');
+		matchStream.matchWhitespace();
+	}
+	if (!matchStream.matchChar(';'))
+		throw string("Syntax Error: Expected ';'");
+}
+
+// Read the value of a field of FIR[n] (matchStream is just after the '.')
+static void _readFirField(StringMatchStream& matchStream, FirSpec* pFirSpec)
+{
+	if (matchStream.matchText("sampleRate"))
+	{
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar('='))
+			throw string("Syntax Error: Expected '='");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchUInt(&pFirSpec->m_SampleFreq))
+			throw string("Syntax Error: Expected Unsigned-Integer sample rate");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar(';'))
+			throw string("Syntax Error: Expected ';'");
+	}
+	else if (matchStream.matchText("decimation"))
+	{
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar('='))
+			throw string("Syntax Error: Expected '='");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchUInt(&pFirSpec->m_Decimation))
+			throw string("Syntax Error: Expected Unsigned-Integer decimation");
+		if (pFirSpec->m_Decimation == 0)
+			throw string("Decimation must be at least 1");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar(';'))
+			throw string("Syntax Error: Expected ';'");
+	}
+	else if (matchStream.matchText("interpolation"))
+	{
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar('='))
+			throw string("Syntax Error: Expected '='");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchUInt(&pFirSpec->m_Interpolation))
+			throw string("Syntax Error: Expected Unsigned-Integer interpolation");
+		if (pFirSpec->m_Interpolation == 0)
+			throw string("Interpolation must be at least 1");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar(';'))
+			throw string("Syntax Error: Expected ';'");
+	}
+	else if (matchStream.matchText("zeroThreshold"))
+	{
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar('='))
+			throw string("Syntax Error: Expected '='");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchFloatingPointNumber(0, &pFirSpec->m_ZeroThreshold))
+			throw string("Syntax Error: Expected floating point zero threshold");
+		if (pFirSpec->m_ZeroThreshold < 0.0)
+			throw string("ZeroThreshold must not be negative");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar(';'))
+			throw string("Syntax Error: Expected ';'");
+	}
+	else if (matchStream.matchText("input"))
+	{
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar('='))
+			throw string("Syntax Error: Expected '='");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchUInt(&pFirSpec->m_InputFirIndex))
+			throw string("Syntax Error: Expected FIR-Index of the shared Input");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar(';'))
+			throw string("Syntax Error: Expected ';'");
+	}
+	else if (matchStream.matchText("complex"))
+	{
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar('='))
+			throw string("Syntax Error: Expected '='");
+		matchStream.matchWhitespace();
+		if (matchStream.matchText("true"))
+			pFirSpec->m_IsComplex = true;
+		else if (matchStream.matchText("false"))
+			pFirSpec->m_IsComplex = false;
+		else
+			throw string("Syntax Error: Expected true or false");
+		matchStream.matchWhitespace();
+		if (!matchStream.matchChar(';'))
+			throw string("Syntax Error: Expected ';'");
+	}
+	else if (matchStream.matchText("coeffImag"))		// (before "coeff", which it starts with)
+	{
+		_readCoeffs(matchStream, &pFirSpec->m_vCoeffImag);
+	}
+	else if (matchStream.matchText("coeff"))
+	{
+		_readCoeffs(matchStream, &pFirSpec->m_vCoeff);
+	}
+	else
+	{
+		throw string("Unrecognized field '") + matchStream.getString() + "'";
+	}
 }
 
 void FirEngineSpec::readFromFile(istream& stream)
@@ -46,54 +217,33 @@ void FirEngineSpec::readFromFile(istream& stream)
 				if (!matchStream.matchUInt(&firIdx))
 					throw string("Syntax Error: Expected FIR-Index");
 				matchStream.matchWhitespace();
+				unsigned lastFirIdx = firIdx;
+				if (matchStream.matchText(".."))		// FIR[first..last]
+				{
+					matchStream.matchWhitespace();
+					if (!matchStream.matchUInt(&lastFirIdx))
+						throw string("Syntax Error: Expected last FIR-Index");
+					if (lastFirIdx < firIdx)
+						throw string("Last FIR-Index must not be less than the first");
+					matchStream.matchWhitespace();
+				}
 				if (!matchStream.matchChar(']'))
 					throw string("Syntax Error: Expected ']'");
 				matchStream.matchWhitespace();
 				if (!matchStream.matchChar('.'))
 					throw string("Syntax Error: Expected '.'");
 
-				while (m_vFirSpec.size() <= firIdx)
+				while (m_vFirSpec.size() <= lastFirIdx)
 					m_vFirSpec.push_back(FirSpec());
-				FirSpec& firSpec = m_vFirSpec[firIdx];
 
-				if (matchStream.matchText("sampleRate"))
+				// a group of FIRs (e.g. a bank of channels with the same Coefficients) sets the same field of each FIR
+				StringMatchStream fieldStream(matchStream);
+				for (unsigned i = firIdx; i <= lastFirIdx; ++i)
 				{
-					matchStream.matchWhitespace();
-					if (!matchStream.matchChar('='))
-						throw string("Syntax Error: Expected '='");
-					matchStream.matchWhitespace();
-					if (!matchStream.matchUInt(&firSpec.m_SampleFreq))
-						throw string("Syntax Error: Expected Unsigned-Integer sample rate");
-					matchStream.matchWhitespace();
-					if (!matchStream.matchChar(';'))
-						throw string("Syntax Error: Expected ';'");
-				}
-				else if (matchStream.matchText("coeff"))
-				{
-					firSpec.m_vCoeff.clear();
-					matchStream.matchWhitespace();
-					if (!matchStream.matchChar('='))
-						throw string("Syntax Error: Expected '='");
-					matchStream.matchWhitespace();
-					if (!matchStream.matchChar('['))
-						throw string("Syntax Error: Expected '['");
-					matchStream.matchWhitespace();
-					while (!matchStream.matchChar(']'))
-					{
-						firSpec.m_vCoeff.push_back(0);
-						if (!matchStream.matchFloatingPointNumber(0, &firSpec.m_vCoeff.back()))
-							throw string("Syntax Error: Expected floating point number");
-						matchStream.matchWhitespace();
-						matchStream.matchChar(',');
-						matchStream.matchWhitespace();
-					}
-					if (!matchStream.matchChar(';'))
-						throw string("Syntax Error: Expected ';'");
-				}
-				else
-				{
-					throw string("Unrecognized field '") + matchStream.getString() + "'";
+					fieldStream = matchStream;
+					_readFirField(fieldStream, &m_vFirSpec[i]);
 				}
+				matchStream = fieldStream;
 
 				matchStream.matchWhitespace();
 				if (!matchStream.atEnd() && !matchStream.matchChar('#'))
@@ -111,6 +261,68 @@ void FirEngineSpec::readFromFile(istream& stream)
 	{
 		throw string("Syntax Error on line ") + toString(lineNum) + ": " + str;
 	}
+
+	appendQuadratureFirs();
+	quantizeCoeffs();
+}
+
+void FirEngineSpec::appendQuadratureFirs()
+{
+	unsigned numFirs = m_vFirSpec.size();
+	for (unsigned firIdx = 0; firIdx < numFirs; ++firIdx)
+	{
+		const FirSpec& firSpec = m_vFirSpec[firIdx];
+		if (firSpec.hasImagCoeffs() && !firSpec.m_IsComplex)
+			throw string("FIR[") + toString(firIdx) + "].coeffImag needs FIR[" + toString(firIdx) + "].complex = true";
+		if (!firSpec.m_IsComplex || firSpec.isQuadrature())
+			continue;
+		if (firSpec.hasImagCoeffs() && (firSpec.m_vCoeffImag.size() != firSpec.m_vCoeff.size()))
+			throw string("FIR[") + toString(firIdx) + "].coeffImag must have as many Coefficients as FIR[" + toString(firIdx) + "].coeff";
+
+		// the quadrature parts are filtered with the same Coefficients (at the same rate) as the in-phase parts
+		FirSpec quadratureFirSpec = firSpec;
+		quadratureFirSpec.m_InPhaseFirIndex = firIdx;
+		m_vFirSpec.push_back(quadratureFirSpec);
+	}
+}
+
+void FirEngineSpec::quantizeCoeffs()
+{
+	for (unsigned firIdx = 0; firIdx < m_vFirSpec.size(); ++firIdx)
+	{
+		try
+		{
+			m_vFirSpec[firIdx].quantizeCoeffs();
+		}
+		catch (const string& str)
+		{
+			throw string("FIR[") + toString(firIdx) + "]: " + str;
+		}
+	}
+}
+
+// Number of frequencies (from 0 to Nyquist) at which the responses are reported
+static const unsigned s_NumResponsePoints = 256;
+
+// Response of the (real) ideal Coefficients, and of the quantized Coefficients, at numPoints frequencies
+static void _establishResponses(const FirSpec& firSpec, unsigned numPoints, vector<double>* pvIdealResponse, vector<double>* pvQuantizedResponse)
+{
+	vector<double> vQuantizedCoeff;
+	firSpec.establishQuantizedCoeffs(&vQuantizedCoeff);
+	FirCoeffQuantizer::establishFrequencyResponse(firSpec.m_vCoeff, numPoints, pvIdealResponse);
+	FirCoeffQuantizer::establishFrequencyResponse(vQuantizedCoeff, numPoints, pvQuantizedResponse);
+}
+
+static double _toDecibels(double magnitude)
+{
+	return 20.0 * log10(max(magnitude, 1e-10));
+}
+
+static string _formatDecibels(double decibels)
+{
+	char str[32];
+	sprintf(str, "%.1f dB", decibels);
+	return str;
 }
 
 void FirEngineSpec::generateHtmlReport(ostream& stream) const
@@ -158,6 +370,38 @@ void FirEngineSpec::generateHtmlReport(ostream& stream) const
 		stream << "	});\n";
 		stream << "\n";
 		stream << "	chart" << firIdx << ".render();\n";
+
+		// Response of the ideal and the quantized Coefficients (in dB)
+		vector<double> vIdealResponse;
+		vector<double> vQuantizedResponse;
+		_establishResponses(firSpec, s_NumResponsePoints, &vIdealResponse, &vQuantizedResponse);
+		stream << "	var response" << firIdx << " = new CanvasJS.Chart(\"fir" << firIdx << "Response\",\n";
+		stream << "	{\n";
+		stream << "		title:{\n";
+		stream << "			text: \"Frequency Response (dB, 0 to Nyquist)\"\n";
+		stream << "		},\n";
+		stream << "		data: [\n";
+		for (unsigned series = 0; series < 2; ++series)
+		{
+			const vector<double>& vResponse = (series == 0) ? vIdealResponse : vQuantizedResponse;
+			stream << "		{\n";
+			stream << "			type: \"line\",\n";
+			stream << "			showInLegend: true,\n";
+			stream << "			legendText: \"" << ((series == 0) ? "Ideal" : "Quantized") << "\",\n";
+			stream << "			dataPoints: [\n";
+			for (unsigned i = 0; i < vResponse.size(); ++i)
+			{
+				if (i > 0)
+					stream << ",\n";
+				stream << "				{ x: " << (double(i) / double(vResponse.size() - 1)) << ", y: " << _toDecibels(vResponse[i]) << " }";
+			}
+			stream << "\n";
+			stream << "			]\n";
+			stream << "		}" << ((series == 0) ? "," : "") << "\n";
+		}
+		stream << "		]\n";
+		stream << "	});\n";
+		stream << "	response" << firIdx << ".render();\n";
 	}
 	stream << "}\n";
 	stream << "</script>\n";
@@ -168,12 +412,46 @@ void FirEngineSpec::generateHtmlReport(ostream& stream) const
 		const FirSpec& firSpec = m_vFirSpec[firIdx];
 
 		stream << "<table class=\"t1\">\n";
-		stream << "<tr><th>Fir#</th><td>" << firIdx << "</td></tr>\n";
+		stream << "<tr><th>Fir#</th><td>" << getChannelName(firIdx) << "</td></tr>\n";
 		stream << "<tr><th>SampleFrequency</th><td>" << firSpec.m_SampleFreq << "</td></tr>\n";
+		stream << "<tr><th>Decimation</th><td>" << firSpec.m_Decimation << "</td></tr>\n";
+		stream << "<tr><th>Interpolation</th><td>" << firSpec.m_Interpolation << "</td></tr>\n";
+		if (!firSpec.hasOwnInput())
+			stream << "<tr><th>Input</th><td>FIR " << firSpec.m_InputFirIndex << "</td></tr>\n";
+		if (firSpec.isQuadrature())
+			stream << "<tr><th>QuadratureOf</th><td>FIR " << firSpec.m_InPhaseFirIndex << "</td></tr>\n";
+		else if (firSpec.m_IsComplex)
+			stream << "<tr><th>Complex</th><td>Quadrature FIR " << getChannelName(findQuadratureFirIndex(firIdx)) << ", " << (firSpec.hasImagCoeffs() ? "complex" : "real") << " Coefficients</td></tr>\n";
 		stream << "<tr><th>NumCoefficients</th><td>" << firSpec.m_vCoeff.size() << "</td></tr>\n";
+		vector<unsigned> vTapCoeffIndex;
+		firSpec.establishTapCoeffIndices(&vTapCoeffIndex);
+		stream << "<tr><th>ZeroThreshold</th><td>" << firSpec.m_ZeroThreshold << "</td></tr>\n";
+		stream << "<tr><th>NumZeroTaps</th><td>" << (firSpec.m_vCoeff.size() - vTapCoeffIndex.size()) << "</td></tr>\n";
+		FirSpec::Symmetry symmetry = firSpec.findSymmetry();
+		stream << "<tr><th>Symmetry</th><td>" << ((symmetry == FirSpec::Symmetry_Symmetric) ? "Symmetric" : (symmetry == FirSpec::Symmetry_AntiSymmetric) ? "AntiSymmetric" : "None") << "</td></tr>\n";
+
+		// Quantization of the Coefficients to the Coefficient words
+		vector<double> vQuantizedCoeff;
+		firSpec.establishQuantizedCoeffs(&vQuantizedCoeff);
+		vector<double> vIdealResponse;
+		vector<double> vQuantizedResponse;
+		_establishResponses(firSpec, max(s_NumResponsePoints, min(4096u, 8 * unsigned(firSpec.m_vCoeff.size()))), &vIdealResponse, &vQuantizedResponse);		// (fine enough to resolve the stopband ripples)
+		stream << "<tr><th>CoeffScale</th><td>2^" << firSpec.m_CoeffScale << "</td></tr>\n";
+		stream << "<tr><th>CoeffSNR</th><td>" << _formatDecibels(FirCoeffQuantizer::findSnr(firSpec.m_vCoeff, vQuantizedCoeff));
+		if (firSpec.hasImagCoeffs())
+		{
+			vector<double> vQuantizedImagCoeff;
+			firSpec.establishQuantizedImagCoeffs(&vQuantizedImagCoeff);
+			stream << " (imaginary " << _formatDecibels(FirCoeffQuantizer::findSnr(firSpec.m_vCoeffImag, vQuantizedImagCoeff)) << ")";
+		}
+		stream << "</td></tr>\n";
+		double idealAttenuation = FirCoeffQuantizer::findStopbandAttenuation(vIdealResponse, vIdealResponse);
+		if (idealAttenuation > 0.0)
+			stream << "<tr><th>StopbandAttenuation</th><td>" << _formatDecibels(FirCoeffQuantizer::findStopbandAttenuation(vIdealResponse, vQuantizedResponse)) << " (ideal " << _formatDecibels(idealAttenuation) << ")</td></tr>\n";
 		stream << "</table>\n\n";
 
 		stream << "<div id=\"fir" << firIdx << "Chart\" style=\"height: 300px; width: 80%;\"></div>\n";
+		stream << "<div id=\"fir" << firIdx << "Response\" style=\"height: 300px; width: 80%;\"></div>\n";
 		stream << "\n\n";
 	}
 }
@@ -19,12 +19,30 @@ class FirEngineSpec
 {
 public:
 	explicit FirEngineSpec(double clockFreq);
+	/// The same FIRs, on a FirEngine running at another clock frequency
+	FirEngineSpec(const FirEngineSpec&, double clockFreq);
 public:
-	double lookupCoeff(const FirCoeffRef&) const;
+	/// Coefficient-RAM word of a Coefficient
+	int lookupCoeffCode(const FirCoeffRef&) const;
+	/// Coefficient-RAM word of the imaginary part of a complex Coefficient
+	int lookupImagCoeffCode(const FirCoeffRef&) const;
+	/// FIRs filtering the same Input as FIR firIdx (firIdx first, then those with FIR[n].input = firIdx)
+	void establishFilterBankFirs(unsigned firIdx, vector<unsigned>* pOut) const;
+	/// Quadrature FIR of the complex FIR firIdx
+	unsigned findQuadratureFirIndex(unsigned firIdx) const;
+	/// Name of the Input/Output ports of a FIR ("n", or "nQ" for the Quadrature FIR of complex FIR n)
+	string getChannelName(unsigned firIdx) const;
 public:
 	void readFromFile(istream&);
+	/// Append the Quadrature FIR of each complex FIR (done once the spec has been read)
+	void appendQuadratureFirs();
+	/// Choose the Coefficient words of every FIR (done once the spec has been read)
+	void quantizeCoeffs();
 public:
 	void generateHtmlReport(ostream&) const;
+	/// Write the Coefficients of every real single-rate FIR as constexpr tables for FirKernel, to <firEngineName>_kernels.h
+	///   returns true if the file changed
+	bool generateKernelHeader(const string& firEngineName) const;
 public:
 	/// Clock frequency that the FirEngine will run at
 	const double 		m_ClockFreq;
@@ -0,0 +1,90 @@
+#include <assert.h>
+#include <ctype.h>
+#include <sstream>
+#include "stringutil.h"
+#include "firenginespec.h"
+
+
+// A C++ identifier from a name (other characters become '_', and a leading digit is preceded by one)
+static string _makeIdentifier(const string& name)
+{
+	string identifier;
+	for (unsigned i = 0; i < name.size(); ++i)
+		identifier += isalnum((unsigned char)name[i]) ? name[i] : '_';
+	if (identifier.empty() || isdigit((unsigned char)identifier[0]))
+		identifier = "_" + identifier;
+	return identifier;
+}
+
+bool FirEngineSpec::generateKernelHeader(const string& firEngineName) const
+{
+	string identifier = _makeIdentifier(firEngineName);
+	string guard;
+	for (unsigned i = 0; i < identifier.size(); ++i)
+		guard += char(toupper((unsigned char)identifier[i]));
+	guard += "_KERNELS_H";
+
+	ostringstream fStream;
+	fStream << "// Coefficients of the FIRs of " << firEngineName << ".fsp, for FirKernel (see firkernel.h)\n";
+	fStream << "//   generated by the FirEngine Builder: do not edit\n";
+	fStream << "#ifndef " << guard << "\n";
+	fStream << "#define " << guard << "\n";
+	fStream << "\n\n";
+	fStream << "#include <stdint.h>\n";
+	fStream << "#include \"firkernel.h\"\n";
+	fStream << "\n\n";
+	fStream << "namespace " << identifier << "\n";
+	fStream << "{\n";
+
+	for (unsigned firIdx = 0; firIdx < m_vFirSpec.size(); ++firIdx)
+	{
+		// A FirKernel filters real samples at one rate (interpolating and complex FIRs have none)
+		const FirSpec& firSpec = m_vFirSpec[firIdx];
+		fStream << "\n";
+		if (firSpec.m_Interpolation > 1)
+		{
+			fStream << "// FIR " << getChannelName(firIdx) << ": interpolating, so has no FirKernel\n";
+			continue;
+		}
+		if (firSpec.m_IsComplex)
+		{
+			if (!firSpec.isQuadrature())
+				fStream << "// FIR " << getChannelName(firIdx) << ": complex, so has no FirKernel\n";
+			continue;
+		}
+
+		assert(firSpec.m_vCoeffCode.size() == firSpec.m_vCoeff.size());		// (quantizeCoeffs must be called first)
+		unsigned numTaps = 0;
+		for (unsigned i = 0; i < firSpec.m_vCoeffCode.size(); ++i)
+		{
+			if (firSpec.m_vCoeffCode[i] != 0)
+				++numTaps;
+		}
+		string name = "Fir" + getChannelName(firIdx);
+		fStream << "/// FIR " << getChannelName(firIdx) << ": " << firSpec.m_vCoeffCode.size() << " Coefficients (" << numTaps << " taps) at " << firSpec.m_SampleFreq << " samples/s";
+		if (firSpec.m_Decimation > 1)
+			fStream << ", decimating by " << firSpec.m_Decimation;
+		if (!firSpec.hasOwnInput())
+			fStream << " (filtering the Input of FIR " << getChannelName(firSpec.m_InputFirIndex) << ")";
+		fStream << "\n";
+		fStream << "struct " << name << "Coeffs\n";
+		fStream << "{\n";
+		fStream << "\tstatic constexpr unsigned s_NumCoeffs = " << firSpec.m_vCoeffCode.size() << ";\n";
+		fStream << "\tstatic constexpr unsigned s_Decimation = " << firSpec.m_Decimation << ";\n";
+		fStream << "\tstatic constexpr int s_CoeffScale = " << firSpec.m_CoeffScale << ";\n";
+		fStream << "\tstatic constexpr int32_t s_vCoeff[s_NumCoeffs] =\n";
+		fStream << "\t{";
+		for (unsigned i = 0; i < firSpec.m_vCoeffCode.size(); ++i)
+			fStream << ((i > 0) ? "," : "") << (((i % 8) == 0) ? "\n\t\t" : " ") << firSpec.m_vCoeffCode[i];
+		fStream << "\n\t};\n";
+		fStream << "};\n";
+		fStream << "typedef FirKernel<" << name << "Coeffs> " << name << "Kernel;\n";
+	}
+
+	fStream << "\n";
+	fStream << "}\n";
+	fStream << "\n\n";
+	fStream << "#endif\n";
+
+	return writeFileIfChanged(firEngineName + "_kernels.h", fStream.str());
+}
@@ -0,0 +1,34 @@
+
+#include "firexactbindsearch.h"
+
+
+FirExactBindSearch::FirExactBindSearch(double timeLimitSeconds) :
+	m_vFirOrder					(),
+	m_vTimeSliceInterval		(),
+	m_vvFirMacSection			(),
+	m_vRemainingLoad			(),
+	m_LowerBoundNumFirMacs		(0),
+	m_vBestFirEngineMacDesc		(),
+	m_vBestFirBinding			(),
+	m_NumNodes					(0),
+	m_IsTimeUp					(false),
+	m_Deadline					(chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeLimitSeconds)))
+{
+}
+
+bool FirExactBindSearch::isTimeUp()
+{
+	++m_NumNodes;
+	if (!m_IsTimeUp && (chrono::steady_clock::now() >= m_Deadline))
+		m_IsTimeUp = true;
+	return m_IsTimeUp;
+}
+
+void FirExactBindSearch::offerBinding(const vector<FirEngineMacDesc>& vFirEngineMacDesc, const vector<FirBinding>& vFirBinding)
+{
+	if (vFirEngineMacDesc.size() < m_vBestFirEngineMacDesc.size())
+	{
+		m_vBestFirEngineMacDesc = vFirEngineMacDesc;
+		m_vBestFirBinding = vFirBinding;
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef FIREXACTBINDSEARCH_H
+#define FIREXACTBINDSEARCH_H
+
+
+#include <vector>
+#include <chrono>
+#include "firmacsection.h"
+#include "firbinding.h"
+#include "firenginemacdesc.h"
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// State shared by the branch-and-bound search for the binding
+///   which uses the fewest FirMacs
+///   (The search keeps the best binding found so far, so it can
+///   be stopped at any time and still produce a valid binding)
+/////////////////////////////////////////////////////////////
+
+class FirExactBindSearch
+{
+public:
+	explicit FirExactBindSearch(double timeLimitSeconds);
+public:
+	/// Has the time limit been reached (checked by every node of the search)
+	bool isTimeUp();
+	/// Record a complete binding if it uses fewer FirMacs than the best so far
+	void offerBinding(const vector<FirEngineMacDesc>&, const vector<FirBinding>&);
+public:
+	/// FIR indices, in the order in which they are bound (heaviest first)
+	vector<unsigned>				m_vFirOrder;
+	/// Per FIR (in spec order): TimeSliceInterval and sections, which do not depend on the binding
+	vector<unsigned>				m_vTimeSliceInterval;
+	vector<vector<FirMacSection> >	m_vvFirMacSection;
+	/// Per search depth: number of Coefficient-slots still to be bound
+	vector<unsigned>				m_vRemainingLoad;
+	/// The search stops early once it reaches this number of FirMacs
+	unsigned						m_LowerBoundNumFirMacs;
+	/// Best binding found so far
+	vector<FirEngineMacDesc>		m_vBestFirEngineMacDesc;
+	vector<FirBinding>				m_vBestFirBinding;
+	/// Search statistics (the number of nodes explored is reported with the binding)
+	unsigned						m_NumNodes;
+	bool							m_IsTimeUp;
+private:
+	chrono::steady_clock::time_point	m_Deadline;
+};
+
+
+#endif
@@ -0,0 +1,42 @@
+#include "firexplorepoint.h"
+#include "firresourcebudget.h"
+
+
+FirExplorePoint::FirExplorePoint() :
+	m_ClockFreq			(0.0),
+	m_NumTimeSlots		(0),
+	m_IsPortfolioBind	(false),
+	m_ErrMsg			(),
+	m_NumFirMacs		(0),
+	m_LowerBoundNumFirMacs	(0),
+	m_NumFifoMemWords	(0),
+	m_NumBram36			(0),
+	m_NumBram18			(0),
+	m_WorstCaseLatency	(0),
+	m_IsParetoOptimal	(false)
+{
+}
+
+bool FirExplorePoint::dominates(const FirExplorePoint& point) const
+{
+	if (!isBound() || !point.isBound())
+		return isBound();
+
+	double latency = getWorstCaseLatencySeconds();
+	double pointLatency = point.getWorstCaseLatencySeconds();
+	if ((m_NumFirMacs > point.m_NumFirMacs) || (m_NumFifoMemWords > point.m_NumFifoMemWords) || (latency > pointLatency))
+		return false;
+	return (m_NumFirMacs < point.m_NumFirMacs) || (m_NumFifoMemWords < point.m_NumFifoMemWords) || (latency < pointLatency);
+}
+
+bool FirExplorePoint::isEquivalent(const FirExplorePoint& point) const
+{
+	if (!isBound() || !point.isBound())
+		return false;
+	return (m_NumFirMacs == point.m_NumFirMacs) && (m_NumFifoMemWords == point.m_NumFifoMemWords) && (getWorstCaseLatencySeconds() == point.getWorstCaseLatencySeconds());
+}
+
+unsigned FirExplorePoint::getNumBram36Equivalents() const
+{
+	return FirResourceBudget::findNumBram36Equivalents(m_NumBram36, m_NumBram18);
+}
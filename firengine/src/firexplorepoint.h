@@ -0,0 +1,50 @@
+#ifndef FIREXPLOREPOINT_H
+#define FIREXPLOREPOINT_H
+
+
+#include <string>
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// One point of the design-space exploration
+///   The FIRs bound at a ClockFreq and NumTimeSlots (by the
+///   first-fit or portfolio binder), and the resources (MACs,
+///   Fifo words) and latency of the binding
+/////////////////////////////////////////////////////////////
+
+class FirExplorePoint
+{
+public:
+	FirExplorePoint();
+public:
+	bool isBound() const						{ return m_ErrMsg.empty(); }
+	/// Block RAMs counted as BRAM18s (a BRAM36 is two)
+	unsigned getNumBram18Equivalents() const	{ return (2 * m_NumBram36) + m_NumBram18; }
+	unsigned getNumBram36Equivalents() const;
+	double getWorstCaseLatencySeconds() const	{ return double(m_WorstCaseLatency) / m_ClockFreq; }
+	/// No worse in MACs, Fifo words and latency, and better in at least one of them
+	bool dominates(const FirExplorePoint&) const;
+	/// Same MACs, Fifo words and latency (only the first such point is kept on the frontier)
+	bool isEquivalent(const FirExplorePoint&) const;
+	string getBinderName() const				{ return m_IsPortfolioBind ? "portfolio" : "first-fit"; }
+public:
+	double			m_ClockFreq;
+	unsigned		m_NumTimeSlots;
+	bool			m_IsPortfolioBind;
+	/// Why the FIRs could not be bound at this point (empty if they were)
+	string			m_ErrMsg;
+	unsigned		m_NumFirMacs;
+	/// No binding at this point can use fewer MACs (see FirEngineDesc::establishLowerBoundNumFirMacs)
+	unsigned		m_LowerBoundNumFirMacs;
+	unsigned		m_NumFifoMemWords;
+	unsigned		m_NumBram36;
+	unsigned		m_NumBram18;
+	/// ClockCycles (see FirEngineDesc::getWorstCaseLatency)
+	unsigned		m_WorstCaseLatency;
+	/// Not dominated by any other point
+	bool			m_IsParetoOptimal;
+};
+
+
+#endif
@@ -0,0 +1,73 @@
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include "intutils.h"
+#include "firfft.h"
+
+
+FirFft::FirFft() :
+	m_NumPoints			(0)
+{
+}
+
+void FirFft::init(unsigned numPoints)
+{
+	assert(IntUtils::isPowerOfTwo(numPoints) && (numPoints >= 2));
+	m_NumPoints = numPoints;
+
+	unsigned numBits = IntUtils::findMostSignificantOne(numPoints);
+	m_vBitReversedIdx.resize(numPoints);
+	for (unsigned i = 0; i < numPoints; ++i)
+	{
+		unsigned reversedIdx = 0;
+		for (unsigned bit = 0; bit < numBits; ++bit)
+			reversedIdx |= ((i >> bit) & 1) << (numBits - 1 - bit);
+		m_vBitReversedIdx[i] = reversedIdx;
+	}
+
+	// (computed in double precision, so that the last stages' factors are as accurate as the first)
+	m_vTwiddle.clear();
+	for (unsigned len = 2; len <= numPoints; len *= 2)
+	{
+		for (unsigned j = 0; j < (len / 2); ++j)
+		{
+			double angle = -2.0 * M_PI * double(j) / double(len);
+			m_vTwiddle.push_back(complex<float>(float(cos(angle)), float(sin(angle))));
+		}
+	}
+}
+
+void FirFft::transform(complex<float>* pData, bool isInverse) const
+{
+	for (unsigned i = 0; i < m_NumPoints; ++i)
+	{
+		if (i < m_vBitReversedIdx[i])
+			swap(pData[i], pData[m_vBitReversedIdx[i]]);
+	}
+
+	// The inverse transform is that of the conjugate twiddle factors
+	const complex<float>* pTwiddle = &m_vTwiddle[0];
+	for (unsigned len = 2; len <= m_NumPoints; len *= 2)
+	{
+		unsigned halfLen = len / 2;
+		for (unsigned firstIdx = 0; firstIdx < m_NumPoints; firstIdx += len)
+		{
+			complex<float>* pLow = pData + firstIdx;
+			complex<float>* pHigh = pLow + halfLen;
+			for (unsigned j = 0; j < halfLen; ++j)
+			{
+				complex<float> twiddle = isInverse ? conj(pTwiddle[j]) : pTwiddle[j];
+				complex<float> product = multiply(pHigh[j], twiddle);
+				pHigh[j] = pLow[j] - product;
+				pLow[j] += product;
+			}
+		}
+		pTwiddle += halfLen;
+	}
+}
+
+double FirFft::findNumFlops(unsigned numPoints)
+{
+	return 5.0 * double(numPoints) * log2(double(numPoints));
+}
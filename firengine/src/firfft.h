@@ -0,0 +1,45 @@
+#ifndef FIRFFT_H
+#define FIRFFT_H
+
+
+#include <complex>
+#include <vector>
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// Fast Fourier transform of a power-of-2 number of points
+///   (iterative radix-2, in place, in single precision), the
+///   convolution engine of FirCpuFilter's overlap-save
+///   The twiddle factors of every stage are laid out one after
+///   the other, so that a butterfly stage reads them in order
+/////////////////////////////////////////////////////////////
+
+class FirFft
+{
+public:
+	FirFft();
+public:
+	/// numPoints must be a power of 2
+	void init(unsigned numPoints);
+	/// Forward (or inverse, not scaled by 1/NumPoints) transform of NumPoints words
+	void transform(complex<float>* pData, bool isInverse) const;
+public:
+	unsigned getNumPoints() const			{ return m_NumPoints; }
+	/// Real multiplies and adds of a transform (the usual 5 N log2(N) of radix 2)
+	static double findNumFlops(unsigned numPoints);
+	/// (written out, as complex<float>'s operator* handles infinities and NaNs at a cost that dominates a butterfly)
+	static complex<float> multiply(const complex<float>& a, const complex<float>& b)
+	{
+		return complex<float>((a.real() * b.real()) - (a.imag() * b.imag()), (a.real() * b.imag()) + (a.imag() * b.real()));
+	}
+private:
+	unsigned				m_NumPoints;
+	/// Index each point is swapped with (its bits reversed)
+	vector<unsigned>		m_vBitReversedIdx;
+	/// exp(-2*pi*i*j/len) for j < len/2, of each stage len = 2, 4, .., NumPoints in turn
+	vector<complex<float> >	m_vTwiddle;
+};
+
+
+#endif
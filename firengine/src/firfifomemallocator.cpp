@@ -0,0 +1,65 @@
+
+#include <assert.h>
+#include "intutils.h"
+#include "firfifomemallocator.h"
+
+
+FirFifoMemAllocator::FirFifoMemAllocator() :
+	m_vHoleAddress		(),
+	m_vHoleNumWords		(),
+	m_NumWords			(0)
+{
+}
+
+unsigned FirFifoMemAllocator::allocate(unsigned numWords, unsigned alignment)
+{
+	assert(numWords > 0);
+
+	// Find the hole with the fewest words left over
+	unsigned bestHoleIdx = m_vHoleAddress.size();
+	unsigned bestNumSpareWords = 0;
+	for (unsigned i = 0; i < m_vHoleAddress.size(); ++i)
+	{
+		unsigned address = IntUtils::alignAddressOnOrAfter(m_vHoleAddress[i], alignment);
+		unsigned holeEnd = m_vHoleAddress[i] + m_vHoleNumWords[i];
+		if ((address + numWords) > holeEnd)
+			continue;
+		unsigned numSpareWords = m_vHoleNumWords[i] - numWords;
+		if ((bestHoleIdx == m_vHoleAddress.size()) || (numSpareWords < bestNumSpareWords))
+		{
+			bestHoleIdx = i;
+			bestNumSpareWords = numSpareWords;
+		}
+	}
+
+	if (bestHoleIdx == m_vHoleAddress.size())
+	{
+		// No hole fits, so extend the memory (leaving a hole for the alignment)
+		unsigned address = IntUtils::alignAddressOnOrAfter(m_NumWords, alignment);
+		if (address > m_NumWords)
+		{
+			m_vHoleAddress.push_back(m_NumWords);
+			m_vHoleNumWords.push_back(address - m_NumWords);
+		}
+		m_NumWords = address + numWords;
+		return address;
+	}
+
+	// Split the hole into the words before and after the Region
+	unsigned holeAddress = m_vHoleAddress[bestHoleIdx];
+	unsigned holeEnd = holeAddress + m_vHoleNumWords[bestHoleIdx];
+	unsigned address = IntUtils::alignAddressOnOrAfter(holeAddress, alignment);
+	m_vHoleAddress.erase(m_vHoleAddress.begin() + bestHoleIdx);
+	m_vHoleNumWords.erase(m_vHoleNumWords.begin() + bestHoleIdx);
+	if (address > holeAddress)
+	{
+		m_vHoleAddress.push_back(holeAddress);
+		m_vHoleNumWords.push_back(address - holeAddress);
+	}
+	if ((address + numWords) < holeEnd)
+	{
+		m_vHoleAddress.push_back(address + numWords);
+		m_vHoleNumWords.push_back(holeEnd - (address + numWords));
+	}
+	return address;
+}
@@ -0,0 +1,31 @@
+#ifndef FIRFIFOMEMALLOCATOR_H
+#define FIRFIFOMEMALLOCATOR_H
+
+
+#include <vector>
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// Allocates the Fifo Regions of a FirMac within its Fifo memory
+///   (Best-fit: each Region goes into the free hole it fills most
+///   closely, otherwise it extends the memory. Allocating in
+///   descending size order keeps the memory as small as possible)
+/////////////////////////////////////////////////////////////
+
+class FirFifoMemAllocator
+{
+public:
+	FirFifoMemAllocator();
+public:
+	/// Allocate numWords starting on a multiple of alignment (a power of 2), returns the first address
+	unsigned allocate(unsigned numWords, unsigned alignment);
+private:
+	/// Free holes below m_NumWords (left by alignment)
+	vector<unsigned>	m_vHoleAddress;
+	vector<unsigned>	m_vHoleNumWords;
+	unsigned			m_NumWords;
+};
+
+
+#endif
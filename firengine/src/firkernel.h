@@ -0,0 +1,144 @@
+#ifndef FIRKERNEL_H
+#define FIRKERNEL_H
+
+
+#include <stdint.h>
+#include <utility>
+
+
+/////////////////////////////////////////////////////////////
+/// A FIR filtered by a kernel specialised at compile time on
+///   its Coefficients, for targets that run a few fixed FIRs
+///   in a tight loop (header-only, C++17)
+///   The Coefficients are a class of constexpr members (as
+///   written from a FirEngine-Specification by
+///   FirEngineSpec::generateKernelHeader):
+///     s_NumCoeffs, s_Decimation, s_CoeffScale and
+///     s_vCoeff[s_NumCoeffs] (the Coefficient words)
+///   Every tap is unrolled with its Coefficient a constant,
+///   zero taps are left out, and the taps of a symmetric (or
+///   anti-symmetric) FIR are folded in pairs (the two samples
+///   added, or subtracted, before the multiply)
+///   The arithmetic is that of the FirMacs (see
+///   FirEngineReference): 2.16 samples times 1.17 Coefficient
+///   words, summed in 48 bits, the Output taken CoeffScale bits
+///   higher and wrapped to 18 bits
+/////////////////////////////////////////////////////////////
+
+enum FirKernelSymmetry
+{
+	FirKernelSymmetry_None,
+	FirKernelSymmetry_Symmetric,			///< coeff[i] == coeff[N-1-i]
+	FirKernelSymmetry_AntiSymmetric			///< coeff[i] == -coeff[N-1-i]
+};
+
+template <typename Coeffs>
+constexpr FirKernelSymmetry findFirKernelSymmetry()
+{
+	constexpr unsigned numCoeffs = Coeffs::s_NumCoeffs;
+	bool isSymmetric = true;
+	bool isAntiSymmetric = true;
+	for (unsigned i = 0; i < numCoeffs; ++i)
+	{
+		isSymmetric = isSymmetric && (Coeffs::s_vCoeff[i] == Coeffs::s_vCoeff[numCoeffs - 1 - i]);
+		isAntiSymmetric = isAntiSymmetric && (Coeffs::s_vCoeff[i] == -Coeffs::s_vCoeff[numCoeffs - 1 - i]);
+	}
+	// (all-zero Coefficients are left unfolded, there being nothing to fold)
+	if (isSymmetric && isAntiSymmetric)
+		return FirKernelSymmetry_None;
+	return isSymmetric ? FirKernelSymmetry_Symmetric : isAntiSymmetric ? FirKernelSymmetry_AntiSymmetric : FirKernelSymmetry_None;
+}
+
+/// Number of Coefficients that are not zero
+template <typename Coeffs>
+constexpr unsigned findFirKernelNumTaps()
+{
+	unsigned numTaps = 0;
+	for (unsigned i = 0; i < Coeffs::s_NumCoeffs; ++i)
+	{
+		if (Coeffs::s_vCoeff[i] != 0)
+			++numTaps;
+	}
+	return numTaps;
+}
+
+template <typename Coeffs>
+class FirKernel
+{
+public:
+	static constexpr unsigned s_NumCoeffs = Coeffs::s_NumCoeffs;
+	static constexpr unsigned s_Decimation = Coeffs::s_Decimation;
+	static constexpr FirKernelSymmetry s_Symmetry = findFirKernelSymmetry<Coeffs>();
+	/// Samples before an Output's own that it reads
+	static constexpr unsigned s_NumHistorySamples = s_NumCoeffs - 1;
+	/// Multiplies of each Output (before folding)
+	static constexpr unsigned s_NumTaps = findFirKernelNumTaps<Coeffs>();
+public:
+	/// Output (2.16) of the NumCoeffs samples (2.16) of pWindow, oldest first (so pWindow[NumCoeffs - 1] is the Output's own sample)
+	static int32_t filter(const int32_t* pWindow)
+	{
+		int64_t accum;
+		if constexpr (s_Symmetry == FirKernelSymmetry_None)
+			accum = sumTaps(pWindow, std::make_integer_sequence<unsigned, s_NumCoeffs>());
+		else
+			accum = sumFoldedTaps(pWindow, std::make_integer_sequence<unsigned, s_NumCoeffs / 2>()) + sumMiddleTap(pWindow);
+		return findOutput(accum);
+	}
+	/// numOutputs Outputs, every Decimation-th: Output i is that of the window from pSample + (i * Decimation)
+	///   (so pSample starts with the NumHistorySamples before the first Output's own sample)
+	static void filterBlock(const int32_t* pSample, unsigned numOutputs, int32_t* pOutput)
+	{
+		for (unsigned i = 0; i < numOutputs; ++i)
+			pOutput[i] = filter(pSample + (i * s_Decimation));
+	}
+private:
+	/// Product of Coefficient coeffIdx (which multiplies the sample coeffIdx before the newest)
+	template <unsigned coeffIdx>
+	static int64_t multiplyTap(const int32_t* pWindow)
+	{
+		constexpr int32_t coeff = Coeffs::s_vCoeff[coeffIdx];
+		if constexpr (coeff == 0)
+			return 0;
+		else
+			return int64_t(coeff) * pWindow[s_NumCoeffs - 1 - coeffIdx];
+	}
+	/// Product of Coefficient coeffIdx with the sum (or difference) of its sample and that of its mirror Coefficient
+	template <unsigned coeffIdx>
+	static int64_t multiplyFoldedTap(const int32_t* pWindow)
+	{
+		constexpr int32_t coeff = Coeffs::s_vCoeff[coeffIdx];
+		if constexpr (coeff == 0)
+			return 0;
+		else if constexpr (s_Symmetry == FirKernelSymmetry_Symmetric)
+			return int64_t(coeff) * (int64_t(pWindow[s_NumCoeffs - 1 - coeffIdx]) + pWindow[coeffIdx]);
+		else
+			return int64_t(coeff) * (int64_t(pWindow[s_NumCoeffs - 1 - coeffIdx]) - pWindow[coeffIdx]);
+	}
+	template <unsigned... coeffIdx>
+	static int64_t sumTaps(const int32_t* pWindow, std::integer_sequence<unsigned, coeffIdx...>)
+	{
+		return (int64_t(0) + ... + multiplyTap<coeffIdx>(pWindow));
+	}
+	template <unsigned... coeffIdx>
+	static int64_t sumFoldedTaps(const int32_t* pWindow, std::integer_sequence<unsigned, coeffIdx...>)
+	{
+		return (int64_t(0) + ... + multiplyFoldedTap<coeffIdx>(pWindow));
+	}
+	/// The middle tap of an odd number of Coefficients has no mirror (and is zero when anti-symmetric)
+	static int64_t sumMiddleTap(const int32_t* pWindow)
+	{
+		if constexpr ((s_NumCoeffs % 2) == 1)
+			return multiplyTap<s_NumCoeffs / 2>(pWindow);
+		else
+			return 0;
+	}
+	/// The 48-bit result, sliced as the FirMac's Output ([33+CoeffScale:16+CoeffScale])
+	static int32_t findOutput(int64_t accum)
+	{
+		int64_t result = int64_t(uint64_t(accum) << 16) >> 16;
+		return int32_t(int64_t(uint64_t(result >> (16 + Coeffs::s_CoeffScale)) << 46) >> 46);
+	}
+};
+
+
+#endif
@@ -0,0 +1,43 @@
+
+#include <assert.h>
+#include "firmacsection.h"
+
+
+FirMacSection::FirMacSection() :
+	m_FirstCoeffIndex	(0),
+	m_vCoeffIndex		(),
+	m_FirstTapOffset	(0),
+	m_FifoDepth			(0),
+	m_IsCommitDelayed	(false),
+	m_NumFifoMemWords	(1),
+	m_Interpolation		(1),
+	m_vBankFirIndex		(),
+	m_vTapFirIndex		(),
+	m_PreAddMode		(0),
+	m_IsOddFold			(false),
+	m_IsQuadratureData	(false),
+	m_IsQuadratureOutput(false),
+	m_IsImagCoeffs		(false),
+	m_IsChainStart		(false),
+	m_IsCrossTerm		(false),
+	m_DataDelay			(0),
+	m_UpdateSlotMask	(),
+	m_CoeffSlotMask		()
+{
+}
+
+unsigned FirMacSection::getDataIndex(unsigned tapIdx) const
+{
+	assert(tapIdx < getNumTaps());
+	assert(m_vCoeffIndex[tapIdx] >= m_FirstCoeffIndex);
+	// phase p holds coefficients p, p+Interpolation, p+2*Interpolation, ... (each one Fifo entry older than the last)
+	return ((m_vCoeffIndex[tapIdx] - m_FirstCoeffIndex) / m_Interpolation);
+}
+
+unsigned FirMacSection::findTapFirIndex(unsigned tapIdx, unsigned firIndex) const
+{
+	assert(tapIdx < getNumTaps());
+	if (m_vTapFirIndex.empty())
+		return firIndex;
+	return m_vTapFirIndex[tapIdx];
+}
@@ -0,0 +1,87 @@
+#ifndef FIRMACSECTION_H
+#define FIRMACSECTION_H
+
+
+#include <vector>
+#include "slotmask.h"
+using namespace std;
+
+/////////////////////////////////////////////////////////////
+/// Describes the section of a FIR computed by a single FirMac
+///   A FIR with more coefficients than fit in its Output interval
+///   is split across a chain of consecutive FirMacs. Data is passed
+///   down the chain (ChainD) and partial sums are accumulated along
+///   it (ChainS), the last FirMac in the chain producing the output.
+///   A complex FIR is bound as two chains (one per Output) on
+///   consecutive FirMacs, the second starting a new chain.
+/////////////////////////////////////////////////////////////
+
+class FirMacSection
+{
+public:
+	FirMacSection();
+public:
+	unsigned getNumTaps() const				{ return m_vCoeffIndex.size(); }
+	int getLastTapOffset() const			{ return m_FirstTapOffset + int(getNumTaps()) - 1; }
+	/// Fifo entry (0 = newest) read by the n'th tap
+	unsigned getDataIndex(unsigned tapIdx) const;
+	/// Number of Fifo entries read by the taps (including those a delayed section may skip, see m_DataDelay)
+	unsigned getReadDepth() const			{ return getDataIndex(getNumTaps() - 1) + 1 + m_DataDelay; }
+	/// FIR computed by the n'th tap (firIndex, the bound FIR, unless this is a filter bank)
+	unsigned findTapFirIndex(unsigned tapIdx, unsigned firIndex) const;
+	/// Outputs are driven on the last tap of each phase (or of each FIR of a filter bank) rather than on the Update
+	bool hasPhaseOutputs() const			{ return (m_Interpolation > 1) || !m_vBankFirIndex.empty(); }
+	/// Number of Outputs driven by this section (when it is the last in its chain)
+	unsigned getNumOutputs() const			{ return 1 + m_vBankFirIndex.size(); }
+public:
+	/// Index of the first FIR Coefficient covered by this section (its Fifo entry 0)
+	unsigned			m_FirstCoeffIndex;
+	/// Coefficient used by each tap, one tap per consecutive TimeSlot
+	///   (zero taps are left out, so a section's Coefficients need not be consecutive)
+	///   (taps of a polyphase section are grouped by phase)
+	vector<unsigned>	m_vCoeffIndex;
+	/// TimeSlot of the first tap, relative to the Update TimeSlot (always <= 0)
+	int					m_FirstTapOffset;
+	/// Number of Entries required by the Data-Fifo of this section
+	///   (can exceed NumTaps when the next section in the chain reads its data an Update later)
+	unsigned			m_FifoDepth;
+	/// The next section in the chain reads its data an Update later than this one
+	///   so it commits the entries passed down to it an Update later too (only once this Fifo has moved on by the entry it passes)
+	bool				m_IsCommitDelayed;
+	/// Number of Words needed for this section's Fifo (power of 2, unless the Fifos are packed)
+	///   (a polyphase section's Coefficients for all phases must also fit)
+	unsigned			m_NumFifoMemWords;
+	/// Number of polyphase sub-filters sharing this section's Fifo (1 = not interpolating)
+	///   each phase produces its own Output, from the same data
+	unsigned			m_Interpolation;
+	/// Other FIRs filtering the same Input as the bound FIR (a filter bank), whose taps follow its own taps
+	///   every FIR of the bank reads this section's Fifo, and produces its own Output
+	vector<unsigned>	m_vBankFirIndex;
+	/// FIR computed by each tap of a filter bank (empty unless a filter bank)
+	vector<unsigned>	m_vTapFirIndex;
+	/// Pre-adder mode for a folded (anti-)symmetric FIR: 0=NoPreadder(B*A), 1=PreAdd((D+B)*A), 2=PreSub((D-B)*A)
+	unsigned			m_PreAddMode;
+	/// Folded FIR has an odd number of coefficients (mirrored data starts one entry later, skipping the middle tap)
+	bool				m_IsOddFold;
+	/// Section of a complex FIR reading the quadrature parts of its Input (the Fifo of its Quadrature FIR)
+	bool				m_IsQuadratureData;
+	/// Section of a complex FIR in the chain producing the quadrature parts of its Output
+	bool				m_IsQuadratureOutput;
+	/// Taps use the imaginary parts of the Coefficients (of a complex FIR with complex Coefficients)
+	bool				m_IsImagCoeffs;
+	/// First section of the second chain of a complex FIR (which starts with no partial sum)
+	bool				m_IsChainStart;
+	/// Section adding the cross terms of a complex product to its chain's partial sum (from the other Input's Fifo)
+	///   it takes its data from the FIR Input, like the first section of a chain
+	bool				m_IsCrossTerm;
+	/// Updates (0 or 1) seen by a cross-term section which the chain's first section has not yet seen
+	///   its first tap skips the entry committed by that Update (if the Update committed new data)
+	unsigned			m_DataDelay;
+	/// TimeSlots occupied by this section's Updates (and the Read-slots ahead of them) for a TimeSliceOrigin of 0
+	SlotMask			m_UpdateSlotMask;
+	/// TimeSlots occupied by this section's Coefficients for a TimeSliceOrigin of 0
+	SlotMask			m_CoeffSlotMask;
+};
+
+
+#endif
@@ -0,0 +1,45 @@
+#include <algorithm>
+#include "intutils.h"
+#include "stringutil.h"
+#include "firresourcebudget.h"
+
+
+FirResourceBudget::FirResourceBudget() :
+	m_MaxNumFirMacs		(0),
+	m_MaxNumBram36		(0)
+{
+}
+
+unsigned FirResourceBudget::findNumBram36Equivalents(unsigned numBram36, unsigned numBram18)
+{
+	return numBram36 + IntUtils::ceilDiv(numBram18, 2);
+}
+
+bool FirResourceBudget::isWithinBudget(unsigned numFirMacs, unsigned numBram36Equivalents) const
+{
+	if ((m_MaxNumFirMacs > 0) && (numFirMacs > m_MaxNumFirMacs))
+		return false;
+	if ((m_MaxNumBram36 > 0) && (numBram36Equivalents > m_MaxNumBram36))
+		return false;
+	return true;
+}
+
+double FirResourceBudget::findHeadroom(unsigned numFirMacs, unsigned numBram36Equivalents) const
+{
+	double headroom = 1.0;
+	if (m_MaxNumFirMacs > 0)
+		headroom = min(headroom, (double(m_MaxNumFirMacs) - double(numFirMacs)) / double(m_MaxNumFirMacs));
+	if (m_MaxNumBram36 > 0)
+		headroom = min(headroom, (double(m_MaxNumBram36) - double(numBram36Equivalents)) / double(m_MaxNumBram36));
+	return headroom;
+}
+
+string FirResourceBudget::getDescription() const
+{
+	string description;
+	if (m_MaxNumFirMacs > 0)
+		description += toString(m_MaxNumFirMacs) + " FirMacs";
+	if (m_MaxNumBram36 > 0)
+		description += (description.empty() ? "" : " and ") + toString(m_MaxNumBram36) + " BRAM36";
+	return description.empty() ? string("unlimited") : description;
+}
@@ -0,0 +1,35 @@
+#ifndef FIRRESOURCEBUDGET_H
+#define FIRRESOURCEBUDGET_H
+
+
+#include <string>
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// Resources of the target part given to the FirEngine
+///   (each FirMac is one DSP48 slice, and the Block RAMs of
+///   its Coefficient and Data RAMs are counted as BRAM36s)
+/////////////////////////////////////////////////////////////
+
+class FirResourceBudget
+{
+public:
+	FirResourceBudget();
+public:
+	bool isLimited() const			{ return (m_MaxNumFirMacs > 0) || (m_MaxNumBram36 > 0); }
+	/// Two BRAM18s share a BRAM36
+	static unsigned findNumBram36Equivalents(unsigned numBram36, unsigned numBram18);
+	bool isWithinBudget(unsigned numFirMacs, unsigned numBram36Equivalents) const;
+	/// Smallest fraction of a limited resource left unused (negative when over budget, 1 when nothing is limited)
+	double findHeadroom(unsigned numFirMacs, unsigned numBram36Equivalents) const;
+	string getDescription() const;
+public:
+	/// Most FirMacs (DSP48 slices) that may be used (0 = unlimited)
+	unsigned			m_MaxNumFirMacs;
+	/// Most Block RAMs (as BRAM36s) that may be used (0 = unlimited)
+	unsigned			m_MaxNumBram36;
+};
+
+
+#endif
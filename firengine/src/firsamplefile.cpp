@@ -0,0 +1,291 @@
+#ifdef WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <assert.h>
+#include <string.h>
+#include "stringutil.h"
+#include "firsamplefile.h"
+
+
+static const char s_Magic[4] = { 'F', 'S', 'M', 'P' };
+// Magic, Version, Format and NumChannels, then the SampleRate and NumSamples of each channel
+static const uint64_t s_NumFixedHeaderBytes = 16;
+static const uint64_t s_NumChannelHeaderBytes = 16;
+
+static uint64_t _roundUp(uint64_t x, uint64_t factor)
+{
+	return ((x + factor - 1) / factor) * factor;
+}
+
+#ifdef WIN32
+static intptr_t _openFile(const string& fname, bool isWritable)
+{
+	// (sequential scan: the cache manager reads ahead, and drops the pages read behind)
+	HANDLE hFile = CreateFileA(fname.c_str(), isWritable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, NULL,
+		isWritable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		throw string("Unable to open sample file '") + fname + "'";
+	return intptr_t(hFile);
+}
+
+static uint64_t _findFileSize(intptr_t file)
+{
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(HANDLE(file), &size))
+		return 0;
+	return uint64_t(size.QuadPart);
+}
+#else
+static intptr_t _openFile(const string& fname, bool isWritable)
+{
+	int fd = isWritable ? open(fname.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(fname.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw string("Unable to open sample file '") + fname + "'";
+	return intptr_t(fd);
+}
+
+static uint64_t _findFileSize(intptr_t file)
+{
+	struct stat fileStat;
+	if (fstat(int(file), &fileStat) != 0)
+		return 0;
+	return uint64_t(fileStat.st_size);
+}
+#endif
+
+FirSampleFile::FirSampleFile() :
+	m_Fname				(),
+	m_Format			(Format_Fixed),
+	m_vSampleRate		(),
+	m_vNumSamples		(),
+	m_vChannelOffset	(),
+	m_IsWritable		(false),
+	m_pData				(NULL),
+	m_NumBytes			(0),
+	m_File				(-1),
+	m_FileMapping		(-1)
+{
+}
+
+FirSampleFile::~FirSampleFile()
+{
+	close();
+}
+
+void FirSampleFile::openForReading(const string& fname)
+{
+	close();
+	m_Fname = fname;
+	m_IsWritable = false;
+	m_File = _openFile(fname, false);
+	uint64_t numBytes = _findFileSize(m_File);
+	if (numBytes < s_NumFixedHeaderBytes)
+	{
+		close();
+		throw string("'") + fname + "' is not a sample file";
+	}
+	mapFile(numBytes);
+
+	uint32_t vHeaderWord[4];
+	memcpy(vHeaderWord, m_pData, sizeof(vHeaderWord));
+	unsigned numChannels = vHeaderWord[3];
+	if ((memcmp(m_pData, s_Magic, sizeof(s_Magic)) != 0) || (vHeaderWord[1] != s_Version) || (vHeaderWord[2] > Format_Float) ||
+		(numBytes < (s_NumFixedHeaderBytes + (numChannels * s_NumChannelHeaderBytes))))
+	{
+		close();
+		throw string("'") + fname + "' is not a sample file";
+	}
+	m_Format = Format(vHeaderWord[2]);
+	m_vSampleRate.resize(numChannels);
+	m_vNumSamples.resize(numChannels);
+	for (unsigned channelIdx = 0; channelIdx < numChannels; ++channelIdx)
+	{
+		const uint8_t* pChannelHeader = m_pData + s_NumFixedHeaderBytes + (channelIdx * s_NumChannelHeaderBytes);
+		memcpy(&m_vSampleRate[channelIdx], pChannelHeader, sizeof(double));
+		memcpy(&m_vNumSamples[channelIdx], pChannelHeader + sizeof(double), sizeof(uint64_t));
+	}
+	if (establishChannelOffsets() > numBytes)
+	{
+		close();
+		throw string("Sample file '") + fname + "' is shorter than its header says";
+	}
+}
+
+void FirSampleFile::createForWriting(const string& fname, Format format, const vector<double>& vSampleRate, const vector<uint64_t>& vNumSamples)
+{
+	assert(vSampleRate.size() == vNumSamples.size());
+	close();
+	m_Fname = fname;
+	m_IsWritable = true;
+	m_Format = format;
+	m_vSampleRate = vSampleRate;
+	m_vNumSamples = vNumSamples;
+	uint64_t numBytes = establishChannelOffsets();
+	m_File = _openFile(fname, true);
+	mapFile(numBytes);
+
+	uint32_t vHeaderWord[4] = { 0, s_Version, uint32_t(format), uint32_t(vNumSamples.size()) };
+	memcpy(vHeaderWord, s_Magic, sizeof(s_Magic));
+	memcpy(m_pData, vHeaderWord, sizeof(vHeaderWord));
+	for (unsigned channelIdx = 0; channelIdx < vNumSamples.size(); ++channelIdx)
+	{
+		uint8_t* pChannelHeader = m_pData + s_NumFixedHeaderBytes + (channelIdx * s_NumChannelHeaderBytes);
+		memcpy(pChannelHeader, &vSampleRate[channelIdx], sizeof(double));
+		memcpy(pChannelHeader + sizeof(double), &vNumSamples[channelIdx], sizeof(uint64_t));
+	}
+}
+
+uint64_t FirSampleFile::establishChannelOffsets()
+{
+	// (every sample is 4 bytes, whatever the Format)
+	uint64_t offset = _roundUp(s_NumFixedHeaderBytes + (m_vNumSamples.size() * s_NumChannelHeaderBytes), s_ChannelAlignment);
+	m_vChannelOffset.resize(m_vNumSamples.size());
+	for (unsigned channelIdx = 0; channelIdx < m_vNumSamples.size(); ++channelIdx)
+	{
+		m_vChannelOffset[channelIdx] = offset;
+		offset = _roundUp(offset + (m_vNumSamples[channelIdx] * 4), s_ChannelAlignment);
+	}
+	return offset;
+}
+
+#ifdef WIN32
+void FirSampleFile::mapFile(uint64_t numBytes)
+{
+	// (mapping a file written to a size extends it to that size)
+	m_NumBytes = numBytes;
+	HANDLE hFileMapping = CreateFileMappingA(HANDLE(m_File), NULL, m_IsWritable ? PAGE_READWRITE : PAGE_READONLY, DWORD(numBytes >> 32), DWORD(numBytes), NULL);
+	if (hFileMapping == NULL)
+	{
+		close();
+		throw string("Unable to map sample file '") + m_Fname + "'";
+	}
+	m_FileMapping = intptr_t(hFileMapping);
+	m_pData = (uint8_t*)MapViewOfFile(hFileMapping, m_IsWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, SIZE_T(numBytes));
+	if (m_pData == NULL)
+	{
+		close();
+		throw string("Unable to map sample file '") + m_Fname + "'";
+	}
+}
+
+void FirSampleFile::close()
+{
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_FileMapping != -1)
+		CloseHandle(HANDLE(m_FileMapping));
+	if (m_File != -1)
+		CloseHandle(HANDLE(m_File));
+	m_pData = NULL;
+	m_FileMapping = -1;
+	m_File = -1;
+	m_NumBytes = 0;
+}
+#else
+void FirSampleFile::mapFile(uint64_t numBytes)
+{
+	m_NumBytes = numBytes;
+	if (m_IsWritable && (ftruncate(int(m_File), off_t(numBytes)) != 0))
+	{
+		close();
+		throw string("Unable to size sample file '") + m_Fname + "'";
+	}
+	void* pData = mmap(NULL, size_t(numBytes), m_IsWritable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, int(m_File), 0);
+	if (pData == MAP_FAILED)
+	{
+		close();
+		throw string("Unable to map sample file '") + m_Fname + "'";
+	}
+	m_pData = (uint8_t*)pData;
+
+	// The samples are read (and written) a block at a time from the start of each channel: the kernel reads ahead, and drops the pages read behind
+	madvise(m_pData, size_t(m_NumBytes), MADV_SEQUENTIAL);
+}
+
+void FirSampleFile::close()
+{
+	if (m_pData)
+		munmap(m_pData, size_t(m_NumBytes));
+	if (m_File != -1)
+		::close(int(m_File));
+	m_pData = NULL;
+	m_File = -1;
+	m_NumBytes = 0;
+}
+#endif
+
+const int32_t* FirSampleFile::getFixedSamples(unsigned channelIdx) const
+{
+	assert(isOpen() && (m_Format == Format_Fixed));
+	return (const int32_t*)(m_pData + m_vChannelOffset[channelIdx]);
+}
+
+const float* FirSampleFile::getFloatSamples(unsigned channelIdx) const
+{
+	assert(isOpen() && (m_Format == Format_Float));
+	return (const float*)(m_pData + m_vChannelOffset[channelIdx]);
+}
+
+int32_t* FirSampleFile::getFixedSamples(unsigned channelIdx)
+{
+	assert(isOpen() && m_IsWritable && (m_Format == Format_Fixed));
+	return (int32_t*)(m_pData + m_vChannelOffset[channelIdx]);
+}
+
+float* FirSampleFile::getFloatSamples(unsigned channelIdx)
+{
+	assert(isOpen() && m_IsWritable && (m_Format == Format_Float));
+	return (float*)(m_pData + m_vChannelOffset[channelIdx]);
+}
+
+uint64_t FirSampleFile::findPages(unsigned channelIdx, uint64_t firstSampleIdx, uint64_t numSamples, uint8_t** ppFirstPage) const
+{
+#ifdef WIN32
+	uint64_t pageSize = 4096;
+#else
+	uint64_t pageSize = uint64_t(sysconf(_SC_PAGESIZE));
+#endif
+	uint64_t firstSampleIdxClipped = min(firstSampleIdx, m_vNumSamples[channelIdx]);
+	uint64_t endSampleIdx = min(firstSampleIdx + numSamples, m_vNumSamples[channelIdx]);
+	uint64_t firstByte = ((m_vChannelOffset[channelIdx] + (firstSampleIdxClipped * 4)) / pageSize) * pageSize;
+	uint64_t endByte = min(_roundUp(m_vChannelOffset[channelIdx] + (endSampleIdx * 4), pageSize), m_NumBytes);
+	*ppFirstPage = m_pData + firstByte;
+	return (endByte > firstByte) ? (endByte - firstByte) : 0;
+}
+
+void FirSampleFile::willNeedSamples(unsigned channelIdx, uint64_t firstSampleIdx, uint64_t numSamples) const
+{
+	// (on Windows, the sequential scan of the file reads ahead)
+#ifndef WIN32
+	uint8_t* pFirstPage;
+	uint64_t numBytes = findPages(channelIdx, firstSampleIdx, numSamples, &pFirstPage);
+	if (numBytes > 0)
+		madvise(pFirstPage, size_t(numBytes), MADV_WILLNEED);
+#endif
+}
+
+void FirSampleFile::releaseSamples(unsigned channelIdx, uint64_t firstSampleIdx, uint64_t numSamples) const
+{
+	// Pages written are sent to be written back, then (as those read) unmapped, so that they are reclaimed before any still to be used
+	//   (a page shared with the next samples is kept)
+#ifndef WIN32
+	uint8_t* pFirstPage;
+	uint64_t numBytes = findPages(channelIdx, firstSampleIdx, numSamples, &pFirstPage);
+	uint64_t pageSize = uint64_t(sysconf(_SC_PAGESIZE));
+	if ((firstSampleIdx + numSamples) < m_vNumSamples[channelIdx])
+		numBytes = (numBytes > pageSize) ? (numBytes - pageSize) : 0;
+	if (numBytes == 0)
+		return;
+	if (m_IsWritable)
+		msync(pFirstPage, size_t(numBytes), MS_ASYNC);
+	madvise(pFirstPage, size_t(numBytes), MADV_DONTNEED);
+#endif
+}
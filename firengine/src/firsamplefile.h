@@ -0,0 +1,82 @@
+#ifndef FIRSAMPLEFILE_H
+#define FIRSAMPLEFILE_H
+
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// A file of samples, memory mapped (so that a recording far
+///   larger than the memory is read and written a block at a
+///   time, by the page cache, without copies)
+///   The header, then the samples of each channel in turn:
+///     "FSMP", Version, Format, NumChannels (uint32 each)
+///     SampleRate (double) and NumSamples (uint64) of each
+///     channel
+///   Each channel's samples start on a 4096-byte boundary of
+///   the file, and are either 2.16 words (int32) or float32 in
+///   full-scale units (1.0 = 2^16 LSBs)
+/////////////////////////////////////////////////////////////
+
+class FirSampleFile
+{
+public:
+	enum Format
+	{
+		Format_Fixed = 0,			///< int32 2.16 samples
+		Format_Float = 1			///< float32 samples
+	};
+	FirSampleFile();
+	~FirSampleFile();
+	FirSampleFile(const FirSampleFile&) = delete;
+	FirSampleFile& operator=(const FirSampleFile&) = delete;
+public:
+	/// Map a sample file for reading (throws if it can not be, or is not a sample file)
+	void openForReading(const string& fname);
+	/// Create (or replace) a sample file of channels of the given SampleRates and NumSamples, mapped for writing
+	void createForWriting(const string& fname, Format, const vector<double>& vSampleRate, const vector<uint64_t>& vNumSamples);
+	/// Unmap the file (whose samples written so far are then in the file)
+	void close();
+public:
+	bool isOpen() const								{ return m_pData != NULL; }
+	Format getFormat() const						{ return m_Format; }
+	unsigned getNumChannels() const					{ return m_vNumSamples.size(); }
+	double getSampleRate(unsigned channelIdx) const	{ return m_vSampleRate[channelIdx]; }
+	uint64_t getNumSamples(unsigned channelIdx) const	{ return m_vNumSamples[channelIdx]; }
+	/// Samples of a channel as mapped (of the Format)
+	const int32_t* getFixedSamples(unsigned channelIdx) const;
+	const float* getFloatSamples(unsigned channelIdx) const;
+	int32_t* getFixedSamples(unsigned channelIdx);
+	float* getFloatSamples(unsigned channelIdx);
+	/// Samples of a channel that will soon be read (so that they are read ahead of the sequential reads)
+	void willNeedSamples(unsigned channelIdx, uint64_t firstSampleIdx, uint64_t numSamples) const;
+	/// Samples of a channel that are done with (so that their pages are the first reclaimed, once written)
+	void releaseSamples(unsigned channelIdx, uint64_t firstSampleIdx, uint64_t numSamples) const;
+private:
+	/// Map the first numBytes of the open file
+	void mapFile(uint64_t numBytes);
+	/// Offset in the file of each channel's samples, and the size of the file
+	uint64_t establishChannelOffsets();
+	/// Whole pages of the mapping covering the bytes of a channel's samples (their start, returning their length)
+	uint64_t findPages(unsigned channelIdx, uint64_t firstSampleIdx, uint64_t numSamples, uint8_t** ppFirstPage) const;
+private:
+	static const uint32_t		s_Version = 1;
+	static const uint64_t		s_ChannelAlignment = 4096;
+	string						m_Fname;
+	Format						m_Format;
+	vector<double>				m_vSampleRate;
+	vector<uint64_t>			m_vNumSamples;
+	vector<uint64_t>			m_vChannelOffset;
+	bool						m_IsWritable;
+	uint8_t*					m_pData;
+	uint64_t					m_NumBytes;
+	/// File (and, on Windows, file mapping) handles
+	intptr_t					m_File;
+	intptr_t					m_FileMapping;
+};
+
+
+#endif
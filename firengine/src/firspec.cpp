@@ -1,9 +1,113 @@
 
+#include <math.h>
+#include <string>
+#include <algorithm>
 #include "firspec.h"
+#include "fircoeffquantizer.h"
 
 
 FirSpec::FirSpec() :
 	m_SampleFreq		(16000000),
-	m_vCoeff			()
+	m_Decimation		(1),
+	m_Interpolation		(1),
+	m_ZeroThreshold		(0.0),
+	m_vCoeff			(),
+	m_InputFirIndex		(s_NoFir),
+	m_IsComplex			(false),
+	m_vCoeffImag		(),
+	m_InPhaseFirIndex	(s_NoFir),
+	m_CoeffScale		(0),
+	m_vCoeffCode		(),
+	m_vCoeffImagCode	()
 {
 }
+
+FirSpec::Symmetry FirSpec::findSymmetry() const
+{
+	if (m_vCoeff.size() < 2)
+		return Symmetry_None;
+
+	bool isSymmetric = true;
+	bool isAntiSymmetric = true;
+	for (unsigned i = 0; i < m_vCoeff.size(); ++i)
+	{
+		double coeff = m_vCoeff[i];
+		double mirroredCoeff = m_vCoeff[m_vCoeff.size() - 1 - i];
+		if (coeff != mirroredCoeff)
+			isSymmetric = false;
+		if (coeff != -mirroredCoeff)
+			isAntiSymmetric = false;
+	}
+
+	if (isSymmetric)
+		return Symmetry_Symmetric;
+	else if (isAntiSymmetric)
+		return Symmetry_AntiSymmetric;
+	else
+		return Symmetry_None;
+}
+
+void FirSpec::establishTapCoeffIndices(vector<unsigned>* pvTapCoeffIndex) const
+{
+	pvTapCoeffIndex->clear();
+	for (unsigned i = 0; i < m_vCoeff.size(); ++i)
+	{
+		if (fabs(m_vCoeff[i]) > m_ZeroThreshold)
+			pvTapCoeffIndex->push_back(i);
+	}
+}
+
+void FirSpec::establishImagTapCoeffIndices(vector<unsigned>* pvTapCoeffIndex) const
+{
+	pvTapCoeffIndex->clear();
+	for (unsigned i = 0; i < m_vCoeffImag.size(); ++i)
+	{
+		if (fabs(m_vCoeffImag[i]) > m_ZeroThreshold)
+			pvTapCoeffIndex->push_back(i);
+	}
+}
+
+void FirSpec::quantizeCoeffs()
+{
+	// Both parts of complex Coefficients share a scale (their products are summed in the same chain)
+	double maxAbsCoeff = 0.0;
+	double sumAbsCoeff = 0.0;
+	for (unsigned i = 0; i < m_vCoeff.size(); ++i)
+	{
+		maxAbsCoeff = max(maxAbsCoeff, fabs(m_vCoeff[i]));
+		sumAbsCoeff += fabs(m_vCoeff[i]);
+	}
+	for (unsigned i = 0; i < m_vCoeffImag.size(); ++i)
+	{
+		maxAbsCoeff = max(maxAbsCoeff, fabs(m_vCoeffImag[i]));
+		sumAbsCoeff += fabs(m_vCoeffImag[i]);
+	}
+	if (!FirCoeffQuantizer::findCoeffScale(maxAbsCoeff, sumAbsCoeff, &m_CoeffScale))
+		throw string("Coefficients are too large for the Coefficient words, even when scaled down by 2^16");
+
+	FirCoeffQuantizer firCoeffQuantizer(m_vCoeff, m_ZeroThreshold, m_CoeffScale, findSymmetry());
+	firCoeffQuantizer.quantize();
+	m_vCoeffCode = firCoeffQuantizer.getCoeffCodes();
+
+	m_vCoeffImagCode.clear();
+	if (hasImagCoeffs())
+	{
+		FirCoeffQuantizer imagCoeffQuantizer(m_vCoeffImag, m_ZeroThreshold, m_CoeffScale, Symmetry_None);
+		imagCoeffQuantizer.quantize();
+		m_vCoeffImagCode = imagCoeffQuantizer.getCoeffCodes();
+	}
+}
+
+void FirSpec::establishQuantizedCoeffs(vector<double>* pvCoeff) const
+{
+	pvCoeff->clear();
+	for (unsigned i = 0; i < m_vCoeffCode.size(); ++i)
+		pvCoeff->push_back(FirCoeffQuantizer::decodeCoeffCode(m_vCoeffCode[i], m_CoeffScale));
+}
+
+void FirSpec::establishQuantizedImagCoeffs(vector<double>* pvCoeff) const
+{
+	pvCoeff->clear();
+	for (unsigned i = 0; i < m_vCoeffImagCode.size(); ++i)
+		pvCoeff->push_back(FirCoeffQuantizer::decodeCoeffCode(m_vCoeffImagCode[i], m_CoeffScale));
+}
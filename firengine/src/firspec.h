@@ -13,12 +13,62 @@ class FirSpec
 {
 public:
 	FirSpec();
+public:
+	/// FIR index of no FIR (see m_InputFirIndex and m_InPhaseFirIndex)
+	static const unsigned	s_NoFir = unsigned(-1);
+	enum Symmetry
+	{
+		Symmetry_None,
+		Symmetry_Symmetric,			///< coeff[i] == coeff[N-1-i]
+		Symmetry_AntiSymmetric		///< coeff[i] == -coeff[N-1-i]
+	};
+	/// Detect linear-phase coefficient sets (which can be folded using the pre-adder)
+	Symmetry findSymmetry() const;
+	/// Coefficients which need a tap (those no larger in magnitude than ZeroThreshold are left out)
+	void establishTapCoeffIndices(vector<unsigned>* pOut) const;
+	/// Imaginary Coefficients which need a tap (of a complex FIR with complex Coefficients)
+	void establishImagTapCoeffIndices(vector<unsigned>* pOut) const;
+	bool hasOwnInput() const		{ return m_InputFirIndex == s_NoFir; }
+	bool hasImagCoeffs() const		{ return !m_vCoeffImag.empty(); }
+	/// Is this the Quadrature FIR of a complex FIR
+	bool isQuadrature() const		{ return m_InPhaseFirIndex != s_NoFir; }
+	/// Choose the CoeffScale and the Coefficient words (see FirCoeffQuantizer)
+	///   throws if the Coefficients are too large for the Coefficient words
+	void quantizeCoeffs();
+	/// Coefficients as computed by the FirMacs (from the Coefficient words)
+	void establishQuantizedCoeffs(vector<double>* pOut) const;
+	void establishQuantizedImagCoeffs(vector<double>* pOut) const;
 public:
 	/// Rate at which samples will be processed by the FIR
-	///   (Currently only single rate FIRs are supported)
 	unsigned			m_SampleFreq;
+	/// Only every Decimation-th Output is computed (Output rate is SampleFreq / Decimation)
+	unsigned			m_Decimation;
+	/// Number of Outputs per Input (Output rate is SampleFreq * Interpolation)
+	///   computed by polyphase sub-filters: phase p uses coefficients p, p+Interpolation, p+2*Interpolation, ...
+	unsigned			m_Interpolation;
+	/// Coefficients no larger than this (in magnitude) are zero taps, and use neither a TimeSlot nor a Coefficient word
+	///   (their data still passes through the Fifo, so the taps either side read the right samples)
+	double				m_ZeroThreshold;
 	/// List of all FIR coefficients
 	vector<double>		m_vCoeff;
+	/// FIR whose Input is filtered by this FIR (s_NoFir for its own Input)
+	///   FIRs on the same Input form a filter bank, sharing one Fifo and one Update (each with its own Coefficients and Output)
+	unsigned			m_InputFirIndex;
+	/// Filters complex (I/Q) samples: its Input and Output carry the in-phase parts, and those of its Quadrature FIR
+	///   (appended to the FIRs of the spec, with the same Coefficients) the quadrature parts
+	bool				m_IsComplex;
+	/// Imaginary parts of the Coefficients of a complex FIR (empty for real Coefficients, otherwise as many as m_vCoeff)
+	vector<double>		m_vCoeffImag;
+	/// FIR whose quadrature parts are filtered by this FIR (s_NoFir unless this is the Quadrature FIR of a complex FIR)
+	///   the Quadrature FIR is computed by the sections of its in-phase FIR, and has none of its own
+	unsigned			m_InPhaseFirIndex;
+	/// Power of 2 by which the Coefficients are scaled in the Coefficient words
+	///   (the Output is taken CoeffScale bits higher in the FirMac's result, so the FIR's gain is unchanged)
+	int					m_CoeffScale;
+	/// Coefficient-RAM word of each Coefficient (1.17 once scaled, zero taps are 0)
+	vector<int>			m_vCoeffCode;
+	/// Coefficient-RAM word of each imaginary Coefficient (of a complex FIR with complex Coefficients)
+	vector<int>			m_vCoeffImagCode;
 };
 
 
@@ -3,6 +3,7 @@
 
 
 FirUpdateSlot::FirUpdateSlot() : 
-	m_FirIndex		(-1)
+	m_FirIndex		(-1),
+	m_IsOutput		(false)
 {
 }
@@ -17,6 +17,8 @@ public:
 public:
 	/// Which FIR is being updated (-1 if none)
 	unsigned			m_FirIndex;
+	/// Is an Output produced on this Update (every Update, unless the FIR is decimating)
+	bool				m_IsOutput;
 };
 
 
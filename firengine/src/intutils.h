@@ -2,6 +2,8 @@
 #define INTUTILS_H
 
 
+#include <stdint.h>
+
 namespace IntUtils
 {
 
@@ -36,6 +38,15 @@ inline unsigned findMostSignificantOne(unsigned bits)
 	return pos;
 }
 
+// Count the number of bits set (SWAR bit-count)
+inline unsigned countOnes(uint64_t bits)
+{
+	bits = bits - ((bits >> 1) & 0x5555555555555555ull);
+	bits = (bits & 0x3333333333333333ull) + ((bits >> 2) & 0x3333333333333333ull);
+	bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+	return unsigned((bits * 0x0101010101010101ull) >> 56);
+}
+
 // Find the number of bits needed to represent a value
 inline unsigned bitWidthToRepresentUnsignedValue(unsigned x)
 {
@@ -124,6 +135,15 @@ inline unsigned ceilDiv(unsigned a, unsigned b)
 	return (a + b-1) / b;
 }
 
+// division with round towards -infinity (also valid for negative numerators)
+inline int floorDiv(int a, unsigned b)
+{
+	if (a >= 0)
+		return a / int(b);
+	else
+		return -int((unsigned(-a) + b-1) / b);
+}
+
 
 inline unsigned modulo(int val, unsigned modulo)
 {
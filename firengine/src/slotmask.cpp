@@ -0,0 +1,79 @@
+#include <assert.h>
+#include "intutils.h"
+#include "slotmask.h"
+
+
+SlotMask::SlotMask() :
+	m_NumSlots			(0),
+	m_NumSetSlots		(0),
+	m_vWord				()
+{
+}
+
+SlotMask::SlotMask(unsigned numSlots) :
+	m_NumSlots			(numSlots),
+	m_NumSetSlots		(0),
+	m_vWord				(IntUtils::ceilDiv(numSlots, 64), 0)
+{
+}
+
+void SlotMask::setSlot(unsigned slot)
+{
+	if (!isSlotSet(slot))
+	{
+		m_vWord[slot / 64] |= (uint64_t(1) << (slot % 64));
+		++m_NumSetSlots;
+	}
+}
+
+uint64_t SlotMask::getBits(unsigned pos, unsigned len) const
+{
+	assert((pos + len) <= m_NumSlots);
+	assert(len <= 64);
+	if (len == 0)
+		return 0;
+
+	unsigned wordIdx = pos / 64;
+	unsigned shift = pos % 64;
+	uint64_t bits = m_vWord[wordIdx] >> shift;
+	if ((shift != 0) && ((wordIdx + 1) < m_vWord.size()))
+		bits |= m_vWord[wordIdx + 1] << (64 - shift);
+	if (len < 64)
+		bits &= (uint64_t(1) << len) - 1;
+	return bits;
+}
+
+uint64_t SlotMask::getRotatedWord(unsigned wordIdx, unsigned rotation) const
+{
+	// Slot p of the rotated mask is slot (p - rotation) of this mask
+	unsigned len = min(64u, m_NumSlots - (wordIdx * 64));
+	unsigned pos = IntUtils::modulo(int(wordIdx * 64) - int(rotation % m_NumSlots), m_NumSlots);
+	if ((pos + len) <= m_NumSlots)
+		return getBits(pos, len);
+
+	// wraps around the end of the mask
+	unsigned lenBeforeWrap = m_NumSlots - pos;
+	return getBits(pos, lenBeforeWrap) | (getBits(0, len - lenBeforeWrap) << lenBeforeWrap);
+}
+
+bool SlotMask::intersectsRotated(const SlotMask& other, unsigned rotation) const
+{
+	assert(other.m_NumSlots == m_NumSlots);
+	for (unsigned i = 0; i < m_vWord.size(); ++i)
+	{
+		if ((m_vWord[i] & other.getRotatedWord(i, rotation)) != 0)
+			return true;
+	}
+	return false;
+}
+
+void SlotMask::setRotated(const SlotMask& other, unsigned rotation)
+{
+	assert(other.m_NumSlots == m_NumSlots);
+	m_NumSetSlots = 0;
+	for (unsigned i = 0; i < m_vWord.size(); ++i)
+	{
+		m_vWord[i] |= other.getRotatedWord(i, rotation);
+		m_NumSetSlots += IntUtils::countOnes(m_vWord[i]);
+	}
+}
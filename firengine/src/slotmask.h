@@ -0,0 +1,45 @@
+#ifndef SLOTMASK_H
+#define SLOTMASK_H
+
+
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+
+/////////////////////////////////////////////////////////////
+/// One bit per TimeSlot, packed into 64-bit words
+///   TimeSlots wrap around (slot NumSlots is slot 0), so a mask
+///   can be tested/merged against another rotated by any number
+///   of slots a word at a time
+/////////////////////////////////////////////////////////////
+
+class SlotMask
+{
+public:
+	SlotMask();
+	explicit SlotMask(unsigned numSlots);
+public:
+	unsigned getNumSlots() const				{ return m_NumSlots; }
+	bool isSlotSet(unsigned slot) const			{ return ((m_vWord[slot / 64] >> (slot % 64)) & 1) != 0; }
+	void setSlot(unsigned slot);
+	unsigned countSetSlots() const				{ return m_NumSetSlots; }
+public:
+	/// Does this mask share any slot with 'other' rotated by 'rotation' slots (other's slot i is tested against slot i+rotation)
+	bool intersectsRotated(const SlotMask& other, unsigned rotation) const;
+	/// Set every slot of 'other' rotated by 'rotation' slots
+	void setRotated(const SlotMask& other, unsigned rotation);
+private:
+	/// Bits [pos, pos+len) (pos+len must not pass NumSlots, len must not exceed 64)
+	uint64_t getBits(unsigned pos, unsigned len) const;
+	/// Word 'wordIdx' of this mask rotated by 'rotation' slots
+	uint64_t getRotatedWord(unsigned wordIdx, unsigned rotation) const;
+private:
+	unsigned			m_NumSlots;
+	/// Number of slots set (kept up to date, as binders test it for every candidate)
+	unsigned			m_NumSetSlots;
+	vector<uint64_t>	m_vWord;
+};
+
+
+#endif
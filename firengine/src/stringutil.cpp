@@ -1,4 +1,6 @@
 
+#include <fstream>
+#include <iterator>
 #include "stringutil.h"
 
 
@@ -69,3 +71,19 @@ string toHexDigits(unsigned val, unsigned numDigits)
 	return str;
 }
 
+bool writeFileIfChanged(const string& fname, const string& contents)
+{
+	{
+		ifstream fStream(fname, ios::binary);
+		if (fStream.is_open())
+		{
+			string currentContents((istreambuf_iterator<char>(fStream)), istreambuf_iterator<char>());
+			if (currentContents == contents)
+				return false;
+		}
+	}
+
+	ofstream fStream(fname, ios::binary);
+	fStream << contents;
+	return true;
+}
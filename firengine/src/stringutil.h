@@ -24,6 +24,11 @@ istream& safeGetline(istream& is, string& t);
 string toHexDigits(unsigned val, unsigned numDigits);
 
 
+/// Write a file only if its contents would change (so that unchanged outputs keep their timestamps)
+///   returns true if the file was written
+bool writeFileIfChanged(const string& fname, const string& contents);
+
+
 
 #endif
 
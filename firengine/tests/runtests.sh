@@ -0,0 +1,47 @@
+#!/bin/sh
+# Regression tests of the FirEngine Builder
+#   Each FirEngine-Specification here (*.fsp) is built with the options on its '# feb:' line (which simulate it, and check the
+#   simulation against the functional reference), and the last line the builder prints must be that on its '# expect:' line
+#   (the builder must fail when an 'Error:' is expected, and succeed otherwise)
+# usage: runtests.sh firenginebuilder [name.fsp ...]
+
+if [ $# -lt 1 ]; then
+	echo "usage: $0 firenginebuilder [name.fsp ...]"
+	exit 2
+fi
+feb="$1"
+shift
+case "$feb" in
+	/*) ;;
+	*) feb="$PWD/$feb" ;;
+esac
+testDir=$(cd "$(dirname "$0")" && pwd)
+if [ $# -eq 0 ]; then
+	set -- "$testDir"/*.fsp
+fi
+
+workDir=$(mktemp -d)
+numFailed=0
+for fsp in "$@"; do
+	name=$(basename "$fsp" .fsp)
+	options=$(sed -n 's/^# feb: *//p' "$fsp" | tr -d '\r')
+	expected=$(sed -n 's/^# expect: *//p' "$fsp" | tr -d '\r')
+	cp "$fsp" "$workDir/$name.fsp"
+	(cd "$workDir" && "$feb" $options "$name" > "$name.log")
+	status=$?
+	actual=$(tail -n 1 "$workDir/$name.log" | tr -d '\r')
+	case "$expected" in
+		Error:*) isStatusExpected=$([ $status -ne 0 ] && echo 1) ;;
+		*) isStatusExpected=$([ $status -eq 0 ] && echo 1) ;;
+	esac
+	if [ "$actual" = "$expected" ] && [ -n "$isStatusExpected" ]; then
+		echo "PASS $name"
+	else
+		echo "FAIL $name (exit status $status): $actual"
+		numFailed=$((numFailed + 1))
+	fi
+done
+rm -rf "$workDir"
+
+echo "$# tests, $numFailed failed"
+[ $numFailed -eq 0 ]